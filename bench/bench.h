@@ -0,0 +1,102 @@
+#pragma once
+#include <stddef.h>   // for size_t
+#include <algorithm>  // for min, sort
+#include <chrono>     // for steady_clock, duration
+#include <random>     // for mt19937
+#include <string>     // for string
+#include <vector>     // for vector
+
+struct TestResults;
+
+// Benchmark entry points dispatched by bench_main.cpp; each returns a process exit code
+auto bench_stats_kernels(int argc, char* argv[]) -> int;
+auto bench_summary_load(int argc, char* argv[]) -> int;
+auto bench_hot_paths(int argc, char* argv[]) -> int;
+auto bench_http_framing(int argc, char* argv[]) -> int;
+
+// One measured case. Every benchmark records its cases; --report=PATH writes them as JSON.
+struct BenchResult
+{
+  std::string benchmark; // entry name, e.g. "hot-paths"
+  std::string name;      // case within it, e.g. "percentile p90"
+  size_t items = 0;      // work units per run (samples, bytes, files, ...)
+  double best_ms = 0;
+  double median_ms = 0;  // 0 when the benchmark only keeps the best run
+  long peak_rss_kb = 0;  // 0 when not measured
+};
+
+auto record_bench_result(BenchResult result) -> void;
+auto write_bench_report(const std::string& path) -> bool;
+
+// Synthetic inputs shared by the benchmarks (bench_corpus.cpp); deterministic for a given rng
+auto synthetic_test_results(std::mt19937& rng, int variant) -> TestResults;
+auto synthetic_locations_json(size_t count) -> std::string;
+auto synthetic_cdn_trace() -> std::string;
+
+struct BenchTiming
+{
+  double best_ms = 0;
+  double median_ms = 0;
+  long iterations = 1; // calls per sample; best/median are per call
+};
+
+// Keeps value (and every store it depends on) observable, so the compiler can neither drop the
+// computation nor hoist it out of a timing loop whose inputs do not change between calls
+template <typename T>
+inline void do_not_optimize(const T& value)
+{
+  asm volatile("" : : "r,m"(value) : "memory");
+}
+
+// Runs body `repetitions` times; best and median wall time in milliseconds
+template <typename Fn>
+auto time_runs(int repetitions, Fn&& body) -> BenchTiming
+{
+  std::vector<double> runs;
+  runs.reserve(static_cast<size_t>(repetitions));
+  for (int rep = 0; rep < repetitions; ++rep)
+  {
+    const auto start = std::chrono::steady_clock::now();
+    body();
+    const auto end = std::chrono::steady_clock::now();
+    runs.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+  }
+  std::sort(runs.begin(), runs.end());
+  return BenchTiming{runs.front(), runs[runs.size() / 2]};
+}
+
+inline constexpr double kMinSampleMs = 1.0; // well above steady_clock resolution and call cost
+
+// For bodies far shorter than a clock tick: doubles the calls per sample until one sample takes
+// at least kMinSampleMs, then times `repetitions` samples and divides each by the call count
+template <typename Fn>
+auto time_calibrated(int repetitions, Fn&& body) -> BenchTiming
+{
+  long iterations = 1;
+  for (;;)
+  {
+    const auto start = std::chrono::steady_clock::now();
+    for (long call = 0; call < iterations; ++call)
+    {
+      body();
+    }
+    const auto end = std::chrono::steady_clock::now();
+    if (std::chrono::duration<double, std::milli>(end - start).count() >= kMinSampleMs)
+    {
+      break;
+    }
+    iterations *= 2;
+  }
+  BenchTiming timing = time_runs(repetitions,
+                                 [&]
+                                 {
+                                   for (long call = 0; call < iterations; ++call)
+                                   {
+                                     body();
+                                   }
+                                 });
+  timing.best_ms /= static_cast<double>(iterations);
+  timing.median_ms /= static_cast<double>(iterations);
+  timing.iterations = iterations;
+  return timing;
+}
@@ -0,0 +1,64 @@
+// Synthetic, deterministic inputs for the benchmarks: result documents shaped like a default-plan
+// run, a Cloudflare /locations array and a /cdn-cgi/trace body.
+#include <random>           // for mt19937, lognormal_distribution
+#include <string>           // for string, to_string
+#include <vector>           // for vector
+#include "bench.h"          // for synthetic_test_results, synthetic_locations_json
+#include "sample_store.h"   // for SampleRecord
+#include "test_plan.h"      // for default_test_plan, PlanPhase
+#include "types.h"          // for TestResults, PhaseResult
+
+auto synthetic_test_results(std::mt19937& rng, int variant) -> TestResults
+{
+  std::lognormal_distribution<double> throughput(5.0, 0.4);
+  std::lognormal_distribution<double> latency(2.5, 0.3);
+  TestResults results;
+  results.city = "Frankfurt";
+  results.colo = "FRA";
+  results.ip = "192.0.2." + std::to_string(variant);
+  results.version = "bench";
+  results.test_plan = "full";
+  for (const PlanPhase& phase : default_test_plan().phases)
+  {
+    std::vector<SampleRecord> records(static_cast<size_t>(phase.num_iterations));
+    for (SampleRecord& record : records)
+    {
+      record.mbps = throughput(rng);
+      record.bytes = static_cast<uint32_t>(phase.num_bytes);
+    }
+    results.samples.add_phase(phase.direction, records, SampleFilter::mad);
+    results.phases.push_back(PhaseResult{phase, 0.0});
+  }
+  results.latency = {latency(rng), latency(rng), latency(rng), latency(rng), latency(rng)};
+  results.latency_histogram.record_all(results.latency);
+  results.download_histogram.record_all(
+      results.samples.direction_samples(TransferDirection::download).to_vector());
+  results.upload_histogram.record_all(
+      results.samples.direction_samples(TransferDirection::upload).to_vector());
+  return results;
+}
+
+// Same fields as the live endpoint; IATA codes are generated, cities include non-ASCII names
+auto synthetic_locations_json(size_t count) -> std::string
+{
+  const char* const cities[] = {"Frankfurt", "São Paulo", "Zürich", "Tōkyō", "Kraków", "Lima"};
+  std::string json = "[";
+  for (size_t index = 0; index < count; ++index)
+  {
+    std::string iata = "AAA";
+    iata[0] = static_cast<char>('A' + index / 676 % 26);
+    iata[1] = static_cast<char>('A' + index / 26 % 26);
+    iata[2] = static_cast<char>('A' + index % 26);
+    json += index == 0 ? "" : ",";
+    json += "{\"iata\":\"" + iata + "\",\"lat\":50.026," + "\"lon\":8.543,\"cca2\":\"DE\"," +
+            "\"region\":\"Europe\",\"city\":\"" + cities[index % 6] + "\"}";
+  }
+  return json + "]";
+}
+
+auto synthetic_cdn_trace() -> std::string
+{
+  return "fl=123f45\nh=speed.cloudflare.com\nip=192.0.2.17\nts=1760000000.123\n"
+         "visit_scheme=https\nuag=Boost.Beast/351\ncolo=FRA\nsliver=none\nhttp=http/1.1\n"
+         "loc=DE\ntls=TLSv1.3\nsni=plaintext\nwarp=off\ngateway=off\nrbi=off\nkex=X25519\n";
+}
@@ -0,0 +1,102 @@
+// Microbenchmark: CPU-bound paths of a run and of result handling on synthetic inputs.
+// Usage: SpeedCloudflareCli_bench hot-paths [repetitions]
+#include <algorithm>        // for max
+#include <cstdlib>          // for atoi
+#include <iomanip>          // for setw, setprecision
+#include <iostream>         // for cout
+#include <random>           // for mt19937, lognormal_distribution
+#include <string>           // for string
+#include <vector>           // for vector
+#include "bench.h"          // for bench_hot_paths, time_calibrated, do_not_optimize, etc.
+#include "json_helpers.h"   // for percentile, serialize_to_json, is_valid_utf8
+#include "network.h"        // for parse_locations_json, parse_cdn_trace
+#include "stats.h"          // for average, median, quartile, jitter, StreamingStats
+#include "types.h"          // for TestResults
+
+namespace
+{
+constexpr const char* kBenchName = "hot-paths";
+constexpr size_t kLocationCount = 330; // about the size of the live /locations array
+constexpr size_t kTextBytes = 1 << 20;
+constexpr double kUsPerMs = 1000.0;
+
+// Most cases take microseconds, below what one steady_clock sample resolves, so each sample
+// repeats body enough times to last kMinSampleMs and reports the time per call
+template <typename Fn>
+void run_case(const std::string& name, size_t items, int repetitions, Fn&& body)
+{
+  const BenchTiming timing = time_calibrated(repetitions, body);
+  std::cout << std::left << std::setw(30) << name << std::right << std::setw(10) << items
+            << std::setw(10) << timing.iterations << std::fixed << std::setprecision(3)
+            << std::setw(12) << timing.best_ms * kUsPerMs << std::setw(12)
+            << timing.median_ms * kUsPerMs << std::setprecision(0) << std::setw(16)
+            << static_cast<double>(items) / (timing.best_ms / 1000.0) << "\n";
+  record_bench_result(BenchResult{kBenchName, name, items, timing.best_ms, timing.median_ms, 0});
+}
+} // namespace
+
+auto bench_hot_paths(int argc, char* argv[]) -> int
+{
+  const int repetitions = argc > 1 ? std::max(1, std::atoi(argv[1])) : 15;
+  std::cout << "best/median per call over " << repetitions << " samples of >= " << kMinSampleMs
+            << " ms (us)\n";
+  std::cout << std::left << std::setw(30) << "case" << std::right << std::setw(10) << "items"
+            << std::setw(10) << "calls" << std::setw(12) << "best" << std::setw(12) << "median"
+            << std::setw(16) << "items/s\n";
+  std::mt19937 rng(42);
+  std::lognormal_distribution<double> dist(4.0, 0.6);
+  for (size_t count : {size_t{100}, size_t{10000}})
+  {
+    std::vector<double> values(count);
+    for (double& value : values)
+    {
+      value = dist(rng);
+    }
+    const std::string size = " n=" + std::to_string(count);
+    run_case("stats::average" + size, count, repetitions,
+             [&] { do_not_optimize(stats::average(values)); });
+    run_case("stats::median" + size, count, repetitions,
+             [&] { do_not_optimize(stats::median(values)); });
+    run_case("stats::quartile p90" + size, count, repetitions,
+             [&] { do_not_optimize(stats::quartile(values, 0.9)); });
+    run_case("stats::jitter" + size, count, repetitions,
+             [&] { do_not_optimize(stats::jitter(values)); });
+    run_case("StreamingStats::add" + size, count, repetitions,
+             [&]
+             {
+               stats::StreamingStats streaming;
+               for (const double value : values)
+               {
+                 streaming.add(value);
+               }
+               do_not_optimize(streaming.p90());
+             });
+    run_case("percentile p90" + size, count, repetitions,
+             [&] { do_not_optimize(percentile(values, 0.9)); });
+  }
+
+  const TestResults results = synthetic_test_results(rng, 0);
+  const std::string document = serialize_to_json(results);
+  run_case("serialize_to_json", document.size(), repetitions,
+           [&] { do_not_optimize(serialize_to_json(results).size()); });
+
+  const std::string locations = synthetic_locations_json(kLocationCount);
+  run_case("parse_locations_json", kLocationCount, repetitions,
+           [&] { do_not_optimize(parse_locations_json(locations).size()); });
+  const std::string trace = synthetic_cdn_trace();
+  run_case("parse_cdn_trace", trace.size(), repetitions,
+           [&] { do_not_optimize(parse_cdn_trace(trace).size()); });
+
+  // ASCII is the common case (IPs, colo codes); the mixed text exercises multi-byte sequences
+  const std::string ascii(kTextBytes, 'a');
+  std::string mixed;
+  while (mixed.size() < kTextBytes)
+  {
+    mixed += "Zürich São Paulo Tōkyō 東京 \xF0\x9F\x8C\x8D ";
+  }
+  run_case("is_valid_utf8 ascii", ascii.size(), repetitions,
+           [&] { do_not_optimize(is_valid_utf8(ascii)); });
+  run_case("is_valid_utf8 mixed", mixed.size(), repetitions,
+           [&] { do_not_optimize(is_valid_utf8(mixed)); });
+  return 0;
+}
@@ -0,0 +1,186 @@
+// Microbenchmark: HTTP/1.1 framing as done by network.cpp, over an in-memory stream, so only the
+// Beast serializer/parser and body copies are measured (no sockets, no TLS).
+// Usage: SpeedCloudflareCli_bench http-framing [repetitions]
+#include <algorithm>                // for max, min
+#include <cstdint>                  // for uint64_t
+#include <cstdlib>                  // for atoi
+#include <iomanip>                  // for setw, setprecision
+#include <iostream>                 // for cout
+#include <limits>                   // for numeric_limits
+#include <string>                   // for string, to_string
+#include <boost/asio/buffer.hpp>    // for buffer_copy, buffer_size, buffer
+#include <boost/asio/error.hpp>     // for error::eof
+#include <boost/beast/core.hpp>     // for flat_buffer, error_code, system_error
+#include <boost/beast/http.hpp>     // for read, write, request, response, buffer_body
+#include <boost/beast/version.hpp>  // for BOOST_BEAST_VERSION_STRING
+#include "bench.h"                  // for bench_http_framing, time_calibrated, etc.
+
+namespace
+{
+namespace beast = boost::beast;
+namespace http = beast::http;
+namespace net = boost::asio;
+
+constexpr const char* kBenchName = "http-framing";
+constexpr size_t kTlsRecordBytes = 16 * 1024; // reads hand out at most one TLS record at a time
+constexpr size_t kScratchBytes = 64 * 1024;   // as kTransferScratchBytes in memory_budget.h
+constexpr double kBytesPerMib = 1024.0 * 1024.0;
+
+volatile size_t g_sink = 0;
+
+// SyncReadStream/SyncWriteStream over memory: reads drain input, writes are counted and dropped
+class MemoryStream
+{
+public:
+  explicit MemoryStream(const std::string& input) : input_(input) {}
+
+  template <class MutableBufferSequence>
+  auto read_some(const MutableBufferSequence& buffers, beast::error_code& ec) -> size_t
+  {
+    if (offset_ == input_.size())
+    {
+      ec = net::error::eof;
+      return 0;
+    }
+    ec = {};
+    const size_t available = std::min(input_.size() - offset_, kTlsRecordBytes);
+    const size_t copied =
+        net::buffer_copy(buffers, net::buffer(input_.data() + offset_, available));
+    offset_ += copied;
+    return copied;
+  }
+
+  template <class MutableBufferSequence>
+  auto read_some(const MutableBufferSequence& buffers) -> size_t
+  {
+    beast::error_code ec;
+    const size_t copied = read_some(buffers, ec);
+    if (ec)
+    {
+      throw beast::system_error{ec};
+    }
+    return copied;
+  }
+
+  template <class ConstBufferSequence>
+  auto write_some(const ConstBufferSequence& buffers, beast::error_code& ec) -> size_t
+  {
+    ec = {};
+    const size_t size = net::buffer_size(buffers);
+    written_ += size;
+    return size;
+  }
+
+  template <class ConstBufferSequence>
+  auto write_some(const ConstBufferSequence& buffers) -> size_t
+  {
+    beast::error_code ec;
+    return write_some(buffers, ec);
+  }
+
+  auto written() const -> size_t { return written_; }
+
+private:
+  const std::string& input_;
+  size_t offset_ = 0;
+  size_t written_ = 0;
+};
+
+auto response_text(size_t body_bytes) -> std::string
+{
+  return "HTTP/1.1 200 OK\r\nDate: Sat, 18 Oct 2026 12:00:00 GMT\r\n"
+         "Content-Type: application/octet-stream\r\nContent-Length: " +
+         std::to_string(body_bytes) +
+         "\r\nConnection: keep-alive\r\nServer: cloudflare\r\n"
+         "CF-RAY: 8d0c0ffee0000000-FRA\r\n\r\n" +
+         std::string(body_bytes, '0');
+}
+
+template <typename Fn>
+void run_case(const std::string& name, size_t bytes, int repetitions, Fn&& body)
+{
+  const BenchTiming timing = time_calibrated(repetitions, body);
+  std::cout << std::left << std::setw(42) << name << std::right << std::setw(12) << bytes
+            << std::fixed << std::setprecision(3) << std::setw(12) << timing.best_ms
+            << std::setw(12) << timing.median_ms << std::setprecision(1) << std::setw(12)
+            << static_cast<double>(bytes) / kBytesPerMib / (timing.best_ms / 1000.0) << "\n";
+  record_bench_result(BenchResult{kBenchName, name, bytes, timing.best_ms, timing.median_ms, 0});
+}
+} // namespace
+
+auto bench_http_framing(int argc, char* argv[]) -> int
+{
+  const int repetitions = argc > 1 ? std::max(1, std::atoi(argv[1])) : 9;
+  std::cout << "best/median per call over " << repetitions << " samples of >= " << kMinSampleMs
+            << " ms (ms)\n";
+  std::cout << std::left << std::setw(42) << "case" << std::right << std::setw(12) << "bytes"
+            << std::setw(12) << "best" << std::setw(12) << "median" << std::setw(12)
+            << "MiB/s\n";
+  const std::string no_input;
+  auto write_get = [&]
+  {
+    MemoryStream stream(no_input);
+    http::request<http::string_body> request{http::verb::get, "/__down?bytes=101000", 11};
+    request.set(http::field::host, "speed.cloudflare.com");
+    request.set(http::field::user_agent, BOOST_BEAST_VERSION_STRING);
+    http::write(stream, request);
+    g_sink = stream.written();
+  };
+  write_get();
+  run_case("write GET request", g_sink, repetitions, write_get);
+  for (size_t upload_bytes : {size_t{101000}, size_t{1001000}})
+  {
+    const std::string upload_data(upload_bytes, '0');
+    run_case("write POST string_body " + std::to_string(upload_bytes), upload_bytes, repetitions,
+             [&]
+             {
+               MemoryStream stream(no_input);
+               http::request<http::string_body> request{http::verb::post, "/__up", 11};
+               request.set(http::field::host, "speed.cloudflare.com");
+               request.body() = upload_data; // http_post copies its payload the same way
+               request.prepare_payload();
+               http::write(stream, request);
+               g_sink = stream.written();
+             });
+  }
+  for (size_t body_bytes : {size_t{1001000}, size_t{25001000}})
+  {
+    const std::string input = response_text(body_bytes);
+    const std::string size = " " + std::to_string(body_bytes);
+    run_case("read string_body" + size, body_bytes, repetitions,
+             [&]
+             {
+               MemoryStream stream(input);
+               beast::flat_buffer buffer;
+               http::response_parser<http::string_body> parser;
+               parser.body_limit((std::numeric_limits<std::uint64_t>::max)());
+               http::read(stream, buffer, parser);
+               g_sink = parser.get().body().size();
+             });
+    run_case("read buffer_body 64 KiB scratch" + size, body_bytes, repetitions,
+             [&]
+             {
+               static char scratch[kScratchBytes];
+               MemoryStream stream(input);
+               beast::flat_buffer buffer;
+               http::response_parser<http::buffer_body> parser;
+               parser.body_limit((std::numeric_limits<std::uint64_t>::max)());
+               http::read_header(stream, buffer, parser);
+               size_t received = 0;
+               while (!parser.is_done())
+               {
+                 parser.get().body().data = scratch;
+                 parser.get().body().size = sizeof(scratch);
+                 beast::error_code ec;
+                 http::read(stream, buffer, parser, ec);
+                 if (ec && ec != http::error::need_buffer)
+                 {
+                   throw beast::system_error{ec};
+                 }
+                 received += sizeof(scratch) - parser.get().body().size;
+               }
+               g_sink = received;
+             });
+  }
+  return 0;
+}
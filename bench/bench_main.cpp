@@ -0,0 +1,70 @@
+// Usage: SpeedCloudflareCli_bench [--report=PATH] [NAME [args...]]
+// No NAME runs every benchmark with defaults; --report writes every recorded case as JSON.
+#include <cstring>   // for strcmp, strncmp
+#include <iostream>  // for cout, cerr
+#include <string>    // for string
+#include "bench.h"   // for bench_stats_kernels, bench_summary_load, write_bench_report
+
+namespace
+{
+struct BenchEntry
+{
+  const char* name;
+  int (*run)(int argc, char* argv[]);
+  const char* usage;
+};
+
+constexpr BenchEntry kBenchmarks[] = {
+    {"kernels", bench_stats_kernels, "kernels [repetitions]"},
+    {"summary-load", bench_summary_load, "summary-load [files] [repetitions]"},
+    {"hot-paths", bench_hot_paths, "hot-paths [repetitions]"},
+    {"http-framing", bench_http_framing, "http-framing [repetitions]"},
+};
+
+auto run_benchmarks(int argc, char* argv[]) -> int
+{
+  if (argc < 2)
+  {
+    int status = 0;
+    for (const auto& entry : kBenchmarks)
+    {
+      char* no_args[] = {const_cast<char*>(entry.name), nullptr};
+      std::cout << "== " << entry.name << " ==\n";
+      status |= entry.run(1, no_args);
+    }
+    return status;
+  }
+  for (const auto& entry : kBenchmarks)
+  {
+    if (std::strcmp(argv[1], entry.name) == 0)
+    {
+      return entry.run(argc - 1, argv + 1);
+    }
+  }
+  std::cerr << "Unknown benchmark '" << argv[1] << "'. Available:\n";
+  for (const auto& entry : kBenchmarks)
+  {
+    std::cerr << "  " << entry.usage << "\n";
+  }
+  return 1;
+}
+} // namespace
+
+auto main(int argc, char* argv[]) -> int
+{
+  std::string report_path;
+  if (argc > 1 && std::strncmp(argv[1], "--report=", 9) == 0)
+  {
+    report_path = argv[1] + 9;
+    argv[1] = argv[0];
+    --argc;
+    ++argv;
+  }
+  const int status = run_benchmarks(argc, argv);
+  if (!report_path.empty() && !write_bench_report(report_path))
+  {
+    std::cerr << "[ERROR] Could not write benchmark report " << report_path << std::endl;
+    return 1;
+  }
+  return status;
+}
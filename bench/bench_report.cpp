@@ -0,0 +1,62 @@
+// Machine-readable benchmark report (--report=PATH): one JSON document per bench invocation,
+// stable keys so runs on different builds and boards can be diffed.
+#include <sys/utsname.h>    // for utsname, uname
+#include <yyjson.h>         // for yyjson_mut_doc, yyjson_mut_write_file
+#include <utility>          // for move
+#include <vector>           // for vector
+#include "bench.h"          // for BenchResult, record_bench_result, write_bench_report
+#include "stats_kernels.h"  // for active_isa
+#include "types.h"          // for BUILD_VERSION
+
+namespace
+{
+auto recorded_results() -> std::vector<BenchResult>&
+{
+  static std::vector<BenchResult> results;
+  return results;
+}
+} // namespace
+
+auto record_bench_result(BenchResult result) -> void
+{
+  recorded_results().push_back(std::move(result));
+}
+
+auto write_bench_report(const std::string& path) -> bool
+{
+  yyjson_mut_doc* doc = yyjson_mut_doc_new(nullptr);
+  yyjson_mut_val* root = yyjson_mut_obj(doc);
+  yyjson_mut_doc_set_root(doc, root);
+  yyjson_mut_obj_add_str(doc, root, "version", BUILD_VERSION);
+  struct utsname uts
+  {
+  };
+  yyjson_mut_obj_add_strcpy(doc, root, "machine", uname(&uts) == 0 ? uts.machine : "unknown");
+  yyjson_mut_obj_add_str(doc, root, "isa", stats::kernels::active_isa());
+  yyjson_mut_val* results = yyjson_mut_obj_add_arr(doc, root, "results");
+  for (const BenchResult& result : recorded_results())
+  {
+    yyjson_mut_val* entry = yyjson_mut_arr_add_obj(doc, results);
+    yyjson_mut_obj_add_strcpy(doc, entry, "benchmark", result.benchmark.c_str());
+    yyjson_mut_obj_add_strcpy(doc, entry, "case", result.name.c_str());
+    yyjson_mut_obj_add_uint(doc, entry, "items", result.items);
+    yyjson_mut_obj_add_real(doc, entry, "best_ms", result.best_ms);
+    if (result.median_ms > 0)
+    {
+      yyjson_mut_obj_add_real(doc, entry, "median_ms", result.median_ms);
+    }
+    if (result.best_ms > 0)
+    {
+      yyjson_mut_obj_add_real(doc, entry, "items_per_s",
+                              static_cast<double>(result.items) / (result.best_ms / 1000.0));
+    }
+    if (result.peak_rss_kb > 0)
+    {
+      yyjson_mut_obj_add_int(doc, entry, "peak_rss_kb", result.peak_rss_kb);
+    }
+  }
+  const bool written =
+      yyjson_mut_write_file(path.c_str(), doc, YYJSON_WRITE_PRETTY, nullptr, nullptr);
+  yyjson_mut_doc_free(doc);
+  return written;
+}
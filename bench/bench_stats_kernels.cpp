@@ -0,0 +1,100 @@
+// Microbenchmark: dispatched stats kernels vs. the portable scalar loops.
+// Usage: SpeedCloudflareCli_bench kernels [repetitions]
+#include <chrono>           // for steady_clock, duration
+#include <cstdlib>          // for atoi
+#include <iomanip>          // for setw, setprecision
+#include <iostream>         // for cout
+#include <random>           // for mt19937, lognormal_distribution
+#include <string>           // for string
+#include <vector>           // for vector
+#include "bench.h"          // for bench_stats_kernels, record_bench_result
+#include "histogram.h"      // for LogHistogram
+#include "stats_kernels.h"  // for sum, min_max, abs_diff_sum, *_scalar, active_isa
+
+namespace
+{
+volatile double g_sink = 0.0; // keeps results observable so loops are not optimised away
+
+template <typename Fn>
+auto best_of_ms(int repetitions, Fn&& body) -> double
+{
+  double best = 1e300;
+  for (int rep = 0; rep < repetitions; ++rep)
+  {
+    const auto start = std::chrono::steady_clock::now();
+    body();
+    const auto end = std::chrono::steady_clock::now();
+    best = std::min(best, std::chrono::duration<double, std::milli>(end - start).count());
+  }
+  return best;
+}
+
+void report(const char* kernel, size_t count, double scalar_ms, double simd_ms)
+{
+  record_bench_result(BenchResult{"kernels", std::string(kernel) + " scalar", count, scalar_ms});
+  record_bench_result(BenchResult{"kernels", std::string(kernel) + " dispatched", count, simd_ms});
+  std::cout << std::left << std::setw(14) << kernel << std::right << std::setw(10) << count
+            << std::setw(12) << std::fixed << std::setprecision(3) << scalar_ms << std::setw(12)
+            << simd_ms << std::setw(9) << std::setprecision(2) << (scalar_ms / simd_ms) << "x\n";
+}
+} // namespace
+
+auto bench_stats_kernels(int argc, char* argv[]) -> int
+{
+  const int repetitions = argc > 1 ? std::max(1, std::atoi(argv[1])) : 7;
+  namespace k = stats::kernels;
+  std::cout << "ISA: " << k::active_isa() << ", best of " << repetitions << " runs (ms)\n";
+  std::cout << std::left << std::setw(14) << "kernel" << std::right << std::setw(10) << "samples"
+            << std::setw(12) << "scalar" << std::setw(12) << "dispatched" << std::setw(10)
+            << "speedup\n";
+  std::mt19937 rng(42);
+  std::lognormal_distribution<double> dist(4.0, 0.6);
+  for (size_t count : {size_t{100000}, size_t{1000000}, size_t{10000000}})
+  {
+    std::vector<double> values(count);
+    for (double& value : values)
+    {
+      value = dist(rng);
+    }
+    report("sum", count,
+           best_of_ms(repetitions, [&] { g_sink = k::sum_scalar(values.data(), count); }),
+           best_of_ms(repetitions, [&] { g_sink = k::sum(values.data(), count); }));
+    double low = 0.0;
+    double high = 0.0;
+    report("min_max", count,
+           best_of_ms(repetitions,
+                      [&]
+                      {
+                        k::min_max_scalar(values.data(), count, low, high);
+                        g_sink = low + high;
+                      }),
+           best_of_ms(repetitions,
+                      [&]
+                      {
+                        k::min_max(values.data(), count, low, high);
+                        g_sink = low + high;
+                      }));
+    report("abs_diff_sum", count,
+           best_of_ms(repetitions, [&] { g_sink = k::abs_diff_sum_scalar(values.data(), count); }),
+           best_of_ms(repetitions, [&] { g_sink = k::abs_diff_sum(values.data(), count); }));
+    report("histogram", count,
+           best_of_ms(repetitions,
+                      [&]
+                      {
+                        LogHistogram histogram;
+                        for (const double value : values)
+                        {
+                          histogram.record(value);
+                        }
+                        g_sink = static_cast<double>(histogram.total());
+                      }),
+           best_of_ms(repetitions,
+                      [&]
+                      {
+                        LogHistogram histogram;
+                        histogram.record_all(values);
+                        g_sink = static_cast<double>(histogram.total());
+                      }));
+  }
+  return 0;
+}
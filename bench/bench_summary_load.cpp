@@ -0,0 +1,156 @@
+// Benchmark: --summary-table loading over a synthetic result history.
+// Usage: SpeedCloudflareCli_bench summary-load [files] [repetitions]
+// Each loader runs in a forked child so its peak RSS (wait4 ru_maxrss) is measured in isolation.
+#include <stdlib.h>         // for mkdtemp
+#include <sys/resource.h>   // for rusage
+#include <sys/wait.h>       // for wait4
+#include <unistd.h>         // for fork, pipe, read, write, _exit
+#include <yyjson.h>         // for yyjson_read, yyjson_doc_free, yyjson_obj_get
+#include <algorithm>        // for max, min
+#include <chrono>           // for steady_clock, duration
+#include <cstdio>           // for remove
+#include <cstdlib>          // for atoi
+#include <fstream>          // IWYU pragma: keep  // for ifstream, ofstream
+#include <functional>       // for function
+#include <iomanip>          // for setw, setprecision
+#include <iostream>         // for cout, cerr
+#include <iterator>         // for istreambuf_iterator
+#include <random>           // for mt19937
+#include <string>           // for string, to_string
+#include <vector>           // for vector
+#include "bench.h"          // for bench_summary_load, synthetic_test_results, record_bench_result
+#include "json_helpers.h"   // for serialize_to_json
+#include "output.h"         // for load_summary_results
+#include "types.h"          // for TestResults, SummaryResult
+
+namespace
+{
+constexpr int kDistinctResults = 32; // synthetic files cycle through this many documents
+
+// The pre-mmap loader: whole file into a std::string, then a default-allocator yyjson_read
+auto load_with_streams(const std::vector<std::string>& files) -> size_t
+{
+  size_t loaded = 0;
+  for (const auto& file : files)
+  {
+    std::ifstream in(file);
+    const std::string json((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    yyjson_doc* doc = yyjson_read(json.c_str(), json.size(), 0);
+    if (doc == nullptr)
+    {
+      continue;
+    }
+    yyjson_val* root = yyjson_doc_get_root(doc);
+    loaded += yyjson_obj_get(root, "download_90pct") != nullptr ? 1 : 0;
+    yyjson_doc_free(doc);
+  }
+  return loaded;
+}
+
+// Runs loader `repetitions` times in a child; returns best wall time (ms) and child peak RSS (kB)
+template <typename Loader>
+auto measure_in_child(int repetitions, Loader&& loader, double& best_ms, long& peak_rss_kb) -> bool
+{
+  int result_pipe[2];
+  if (pipe(result_pipe) != 0)
+  {
+    return false;
+  }
+  const pid_t child = fork();
+  if (child < 0)
+  {
+    return false;
+  }
+  if (child == 0)
+  {
+    close(result_pipe[0]);
+    double best = 1e300;
+    for (int rep = 0; rep < repetitions; ++rep)
+    {
+      const auto start = std::chrono::steady_clock::now();
+      loader();
+      const auto end = std::chrono::steady_clock::now();
+      best = std::min(best, std::chrono::duration<double, std::milli>(end - start).count());
+    }
+    const ssize_t written = write(result_pipe[1], &best, sizeof(best));
+    _exit(written == static_cast<ssize_t>(sizeof(best)) ? 0 : 1);
+  }
+  close(result_pipe[1]);
+  const bool got_time = read(result_pipe[0], &best_ms, sizeof(best_ms)) ==
+                        static_cast<ssize_t>(sizeof(best_ms));
+  close(result_pipe[0]);
+  int status = 0;
+  struct rusage usage
+  {
+  };
+  wait4(child, &status, 0, &usage);
+  peak_rss_kb = usage.ru_maxrss;
+  return got_time && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+} // namespace
+
+auto bench_summary_load(int argc, char* argv[]) -> int
+{
+  const int file_count = argc > 1 ? std::max(1, std::atoi(argv[1])) : 10000;
+  const int repetitions = argc > 2 ? std::max(1, std::atoi(argv[2])) : 3;
+  char dir_template[] = "/tmp/scf_bench_XXXXXX";
+  if (mkdtemp(dir_template) == nullptr)
+  {
+    std::cerr << "[ERROR] Could not create a temporary directory" << std::endl;
+    return 1;
+  }
+  const std::string dir = dir_template;
+  std::mt19937 rng(7);
+  std::vector<std::string> documents;
+  for (int variant = 0; variant < kDistinctResults; ++variant)
+  {
+    documents.push_back(serialize_to_json(synthetic_test_results(rng, variant)));
+  }
+  std::vector<std::string> files;
+  files.reserve(static_cast<size_t>(file_count));
+  size_t corpus_bytes = 0;
+  for (int file_index = 0; file_index < file_count; ++file_index)
+  {
+    files.push_back(dir + "/result-" + std::to_string(file_index) + ".json");
+    const std::string& document = documents[static_cast<size_t>(file_index % kDistinctResults)];
+    std::ofstream(files.back()) << document;
+    corpus_bytes += document.size();
+  }
+  std::cout << "Corpus: " << file_count << " files, " << corpus_bytes / 1024 << " KiB, best of "
+            << repetitions << " runs (page cache warm after the first)\n";
+  std::cout << std::left << std::setw(26) << "loader" << std::right << std::setw(12) << "ms"
+            << std::setw(14) << "files/s" << std::setw(14) << "peak RSS MiB" << "\n";
+  struct Variant
+  {
+    const char* name;
+    std::function<void()> run;
+  };
+  const Variant variants[] = {
+      {"stream+yyjson_read (old)", [&] { (void)load_with_streams(files); }},
+      {"mmap+insitu+pool, threads", [&] { (void)load_summary_results(files); }},
+  };
+  int status = 0;
+  for (const auto& variant : variants)
+  {
+    double best_ms = 0;
+    long peak_rss_kb = 0;
+    if (!measure_in_child(repetitions, variant.run, best_ms, peak_rss_kb))
+    {
+      std::cerr << "[ERROR] " << variant.name << " failed" << std::endl;
+      status = 1;
+      continue;
+    }
+    record_bench_result(BenchResult{"summary-load", variant.name,
+                                    static_cast<size_t>(file_count), best_ms, 0, peak_rss_kb});
+    std::cout << std::left << std::setw(26) << variant.name << std::right << std::fixed
+              << std::setprecision(1) << std::setw(12) << best_ms << std::setw(14)
+              << std::setprecision(0) << file_count / (best_ms / 1000.0) << std::setw(14)
+              << std::setprecision(1) << peak_rss_kb / 1024.0 << "\n";
+  }
+  for (const auto& file : files)
+  {
+    (void)std::remove(file.c_str());
+  }
+  (void)std::remove(dir.c_str());
+  return status;
+}
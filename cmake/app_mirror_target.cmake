@@ -0,0 +1,19 @@
+# add_app_mirror_executable(TARGET SOURCE_DIR): an executable built from SOURCE_DIR/*.cpp plus
+# every application source except main.cpp, with the main target's include directories,
+# definitions and link libraries (yyjson, nlohmann, Boost/OpenSSL, pthread). Used by the
+# benchmark and test targets; include after all dependencies are set up.
+function(add_app_mirror_executable TARGET SOURCE_DIR)
+    file(GLOB MIRROR_SOURCES "${SOURCE_DIR}/*.cpp")
+    set(MIRROR_APP_SOURCES ${PROJECT_SOURCES})
+    list(FILTER MIRROR_APP_SOURCES EXCLUDE REGEX ".*/main\\.cpp$")
+    add_executable(${TARGET})
+    target_sources(${TARGET} PRIVATE ${MIRROR_SOURCES} ${MIRROR_APP_SOURCES})
+    get_target_property(APP_INCLUDE_DIRS SpeedCloudflareCli INCLUDE_DIRECTORIES)
+    get_target_property(APP_DEFINITIONS SpeedCloudflareCli COMPILE_DEFINITIONS)
+    get_target_property(APP_LINK_LIBRARIES SpeedCloudflareCli LINK_LIBRARIES)
+    target_include_directories(${TARGET} PRIVATE ${APP_INCLUDE_DIRS})
+    if(APP_DEFINITIONS)
+        target_compile_definitions(${TARGET} PRIVATE ${APP_DEFINITIONS})
+    endif()
+    target_link_libraries(${TARGET} PRIVATE ${APP_LINK_LIBRARIES})
+endfunction()
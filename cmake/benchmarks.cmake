@@ -0,0 +1,7 @@
+# Option to build the microbenchmark executable (not part of the default build)
+option(BUILD_BENCHMARKS "Build the SpeedCloudflareCli_bench microbenchmark target" OFF)
+if(BUILD_BENCHMARKS)
+    message(STATUS "Benchmarks enabled: adding SpeedCloudflareCli_bench target")
+    include(cmake/app_mirror_target.cmake)
+    add_app_mirror_executable(SpeedCloudflareCli_bench "${PROJECT_SOURCE_DIR}/bench")
+endif()
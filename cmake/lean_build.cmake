@@ -0,0 +1,39 @@
+# Lean router build for SpeedCloudflareCli (Entware ARMv7 and similar flash-constrained targets)
+#
+# Leaves out JSON Schema validation (nlohmann_json, json-schema-validator and both embedded
+# schemas) and the diagnostics helpers, which only the --summary-table and -vv paths use.
+# The binary is linked statically, optimised for size and stripped.
+# Must be included before cmake/boost_integration.cmake so the static library choices apply.
+option(LEAN_BUILD "Build without schema validation/diagnostics, static and size-optimised" OFF)
+if(LEAN_BUILD)
+    message(STATUS "Lean build: no schema validation or diagnostics, static, -Os")
+    # Globbed with the rest of src/, so excluded here rather than from PROJECT_SOURCES
+    set_source_files_properties(
+        "${USER_SRC_DIR}/schema_validation.cpp"
+        "${USER_SRC_DIR}/diagnostics.cpp"
+        PROPERTIES HEADER_FILE_ONLY ON
+    )
+    target_compile_definitions(SpeedCloudflareCli PRIVATE SPEEDCLOUDFLARE_LEAN)
+    target_compile_options(SpeedCloudflareCli PRIVATE -Os -ffunction-sections -fdata-sections)
+    target_link_options(SpeedCloudflareCli PRIVATE -static -Wl,--gc-sections -s)
+
+    set(Boost_USE_STATIC_LIBS ON)
+    # Toolchain files point at libssl.so/libcrypto.so; use the archives next to them
+    foreach(OPENSSL_PART SSL CRYPTO)
+        if(OPENSSL_${OPENSSL_PART}_LIBRARY MATCHES "\\.so$")
+            string(REGEX REPLACE "\\.so$" ".a" OPENSSL_STATIC_ARCHIVE
+                   "${OPENSSL_${OPENSSL_PART}_LIBRARY}")
+            if(EXISTS "${OPENSSL_STATIC_ARCHIVE}")
+                set(OPENSSL_${OPENSSL_PART}_LIBRARY "${OPENSSL_STATIC_ARCHIVE}")
+            else()
+                message(WARNING "LEAN_BUILD: ${OPENSSL_STATIC_ARCHIVE} not found; static link will fail")
+            endif()
+        endif()
+    endforeach()
+    # Static archives resolve left to right: libssl before libcrypto, which needs libdl
+    target_link_libraries(SpeedCloudflareCli PRIVATE
+        ${OPENSSL_SSL_LIBRARY}
+        ${OPENSSL_CRYPTO_LIBRARY}
+        ${CMAKE_DL_LIBS}
+    )
+endif()
@@ -0,0 +1,14 @@
+# Option to build the unit tests and register them with CTest (not part of the default build;
+# skipped when cross-compiling, as the binary cannot run here)
+option(BUILD_TESTS "Build the SpeedCloudflareCli_tests target and register it with CTest" OFF)
+if(BUILD_TESTS AND NOT CMAKE_CROSSCOMPILING)
+    message(STATUS "Tests enabled: adding SpeedCloudflareCli_tests target")
+    enable_testing()
+    include(cmake/app_mirror_target.cmake)
+    add_app_mirror_executable(SpeedCloudflareCli_tests "${PROJECT_SOURCE_DIR}/tests")
+    # One CTest case per entry of kTests in tests/tests_main.cpp
+    set(TEST_NAMES estimation histogram history-store metrics regression-gate stats test-plan utf8)
+    foreach(TEST_NAME ${TEST_NAMES})
+        add_test(NAME ${TEST_NAME} COMMAND SpeedCloudflareCli_tests ${TEST_NAME})
+    endforeach()
+endif()
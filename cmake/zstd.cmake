@@ -0,0 +1,15 @@
+# Option to compress full result-history blocks with zstd (see src/history_store.cpp)
+# Off by default: stores stay readable by builds without libzstd, e.g. most router toolchains
+option(ENABLE_ZSTD "Compress sealed --history blocks with zstd (requires libzstd)" OFF)
+if(ENABLE_ZSTD)
+    find_path(ZSTD_INCLUDE_DIR zstd.h)
+    find_library(ZSTD_LIBRARY NAMES zstd)
+    if(ZSTD_INCLUDE_DIR AND ZSTD_LIBRARY)
+        message(STATUS "zstd history compression enabled: ${ZSTD_LIBRARY}")
+        target_include_directories(SpeedCloudflareCli PRIVATE ${ZSTD_INCLUDE_DIR})
+        target_compile_definitions(SpeedCloudflareCli PRIVATE SPEEDCLOUDFLARE_WITH_ZSTD)
+        target_link_libraries(SpeedCloudflareCli PRIVATE ${ZSTD_LIBRARY})
+    else()
+        message(WARNING "ENABLE_ZSTD is ON but zstd.h/libzstd were not found; history blocks stay uncompressed")
+    endif()
+endif()
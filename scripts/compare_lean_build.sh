@@ -0,0 +1,89 @@
+#!/bin/bash
+# SpeedCloudflareCli full vs. lean build comparison
+# Builds both configurations (or takes two existing binaries) and reports binary size, shared
+# library dependencies, startup time and peak RSS of short runs that need no network.
+#
+# Usage:
+#   scripts/compare_lean_build.sh [extra cmake args]       # build both, then measure
+#   scripts/compare_lean_build.sh --measure FULL_BIN LEAN_BIN   # measure only (e.g. on the router)
+# Both configurations use CMAKE_BUILD_TYPE=$BUILD_TYPE (default Release), so the comparison shows
+# what LEAN_BUILD changes and not a Release build against an unoptimised one. The table is
+# Markdown; with RESULTS=FILE its rows are also appended there (docs/lean_build_measurements.md).
+# Cross builds: pass -DCMAKE_TOOLCHAIN_FILE=cmake/entware-armv7l-toolchain.cmake, copy the two
+# binaries to the device together with this script and run it there with --measure.
+
+set -e
+
+PROJECT_ROOT="$(cd "$(dirname "$0")/.." && pwd)"
+RUNS=${RUNS:-50}
+BUILD_TYPE=${BUILD_TYPE:-Release}
+
+if [[ "$1" == "--measure" ]]; then
+  FULL_BIN="$2"
+  LEAN_BIN="$3"
+  if [[ ! -x "$FULL_BIN" || ! -x "$LEAN_BIN" ]]; then
+    echo "[ERROR] --measure needs two executable binaries: FULL_BIN LEAN_BIN"
+    exit 1
+  fi
+else
+  echo "[INFO] Building full configuration in build-full"
+  cmake -B "$PROJECT_ROOT/build-full" -S "$PROJECT_ROOT" -DCMAKE_BUILD_TYPE="$BUILD_TYPE" "$@"
+  cmake --build "$PROJECT_ROOT/build-full" -j"$(nproc)" --target SpeedCloudflareCli
+  echo "[INFO] Building lean configuration in build-lean"
+  cmake -B "$PROJECT_ROOT/build-lean" -S "$PROJECT_ROOT" -DCMAKE_BUILD_TYPE="$BUILD_TYPE" \
+    -DLEAN_BUILD=ON "$@"
+  cmake --build "$PROJECT_ROOT/build-lean" -j"$(nproc)" --target SpeedCloudflareCli
+  FULL_BIN="$PROJECT_ROOT/build-full/SpeedCloudflareCli"
+  LEAN_BIN="$PROJECT_ROOT/build-lean/SpeedCloudflareCli"
+fi
+
+# Milliseconds for RUNS back-to-back starts; --help exits right after argument parsing, so this
+# is loader, relocation and static initialisation cost
+startup_ms() {
+  local bin="$1"
+  local start end
+  start=$(date +%s%N)
+  for ((run = 0; run < RUNS; run++)); do
+    "$bin" --help > /dev/null 2>&1 || true
+  done
+  end=$(date +%s%N)
+  echo $(( (end - start) / 1000000 ))
+}
+
+# Peak RSS in KB of one run with the given flags (needs GNU time or BusyBox time -v)
+peak_rss_kb() {
+  local bin="$1"
+  shift
+  if [[ -x /usr/bin/time ]] && /usr/bin/time -f %M true > /dev/null 2>&1; then
+    /usr/bin/time -f %M "$bin" "$@" 2>&1 > /dev/null | tail -n 1
+  elif command -v busybox > /dev/null 2>&1; then
+    busybox time -v "$bin" "$@" 2>&1 > /dev/null | awk -F': ' '/Maximum resident/ {print $2}'
+  else
+    echo "n/a"
+  fi
+}
+
+shared_libs() {
+  local bin="$1"
+  if command -v readelf > /dev/null 2>&1; then
+    readelf -d "$bin" 2>/dev/null | grep -c NEEDED || true
+  else
+    echo "n/a"
+  fi
+}
+
+MACHINE="$(uname -m)"
+DATE="$(date -u +%Y-%m-%d)"
+echo "| date | machine | build | size (B) | libs | startup (ms) | RSS help (KB) | RSS sysinfo (KB) |"
+echo "|---|---|---|---:|---:|---:|---:|---:|"
+for entry in "full:$FULL_BIN" "lean:$LEAN_BIN"; do
+  label="${entry%%:*}"
+  bin="${entry#*:}"
+  row="| $DATE | $MACHINE | $label | $(stat -c %s "$bin") | $(shared_libs "$bin") | \
+$(startup_ms "$bin") | $(peak_rss_kb "$bin" --help) | $(peak_rss_kb "$bin" --show-sysinfo-only) |"
+  echo "$row"
+  if [[ -n "$RESULTS" ]]; then
+    echo "$row" >> "$RESULTS"
+  fi
+done
+echo "[INFO] startup (ms) is the total of $RUNS runs of --help (set RUNS=N to change)"
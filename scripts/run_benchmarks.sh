@@ -68,6 +68,8 @@ SYSINFO_FLAGS="--show-sysinfo-only --mask-sensitive"
 $BIN $SYSINFO_FLAGS | tee "$OUTDIR/$SYSINFO_LABEL.txt"
 
 # Test matrix: (flagset, description)
+# One run per scenario; for repeated, interleaved runs with significance tests use
+# $BIN --matrix --repeat=N instead
 declare -a TESTS=(
   "'' 'default'"
   # "'--minimize-output' 'minout'"  # Less useful
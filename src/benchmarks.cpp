@@ -5,44 +5,64 @@
   #include <bits/chrono.h>  // for operator-, duration, high_resolution_clock
 #endif
 #include <cstring>        // for strerror
-#include <algorithm>      // for max_element, min, min_element
+#include <algorithm>      // for max, max_element, min, min_element
+#include <atomic>         // for atomic
+#include <ctime>          // for time
+#include <functional>     // for cref
 #include <future>         // for future, async, launch, launch::async
 #include <iostream>       // for operator<<, basic_ostream, basic_ostream<>:...
-#include <map>            // for map, map<>::mapped_type
 #include <ratio>          // for milli
 #include <string>         // for string, allocator, operator+, char_traits
 #include <thread>         // for thread
+#include <utility>        // for move
 #include <vector>         // for vector, vector<>::iterator
 #include <fstream>        // IWYU pragma: keep  // for logging errors
 #include <pthread.h> // for thread affinity
-#include "network.h"      // for http_get, HttpRequest, http_post, parse_cdn...
+#include "estimation.h"   // for filter_samples, estimate_samples, SampleFilter
+#include "event_stream.h" // for emit_sample_event, emit_phase_event, emit_start_event
+#include "histogram.h"    // for LogHistogram
+#include "instrumentation.h" // for OverheadRecorder
+#include "locations.h"    // for LocationIndex, load_location_cache, save_lo...
+#include "memory_budget.h" // for memory_budget_enabled, TransferScratch, check_memory_budget
+#include "network.h"      // for http_get, HttpRequest, http_post, http_download, ...
 #include "output.h"       // for log_speed_test_result, log_info, log_downlo...
-#include "stats.h"        // for average, jitter, median
-#include "sysinfo.h"      // for get_time_ms, yield_cpu, collect_sysinfo
-#include "types.h"        // for TestResults
+#include "sample_store.h" // for SampleStore, SampleRecord, SampleStatus
+#include "stats.h"        // for StreamingStats, median
+#include "host_monitor.h" // for HostMonitor, PhaseContention, saturation_text
+#include "interface_counters.h" // for InterfaceCounters, PhaseTraffic, summarise_traffic
+#include "sysinfo.h"      // for get_time_ms, yield_cpu, collect_sysinfo, host_snapshot
+#include "test_plan.h"    // for TestPlan, PlanPhase, default_test_plan, kMaxDurationIterations
+#include "trace.h"        // for record_trace_span
+#include "types.h"        // for TestResults, PhaseResult
 
 constexpr int kLatencySamples = 20;
-constexpr int kDownload100kB = 101000;
-constexpr int kDownload1MB = 1001000;
-constexpr int kDownload10MB = 10001000;
-constexpr int kDownload25MB = 25001000;
-constexpr int kDownload100MB = 100001000;
-constexpr int kUpload11kB = 11000;
-constexpr int kUpload100kB = 101000;
-constexpr int kUpload1MB = 1001000;
-constexpr int kDownloadIters1 = 10;
-constexpr int kDownloadIters2 = 8;
-constexpr int kDownloadIters3 = 6;
-constexpr int kDownloadIters4 = 4;
-constexpr int kDownloadIters5 = 1;
-constexpr int kUploadIters1 = 10;
-constexpr int kUploadIters2 = 10;
-constexpr int kUploadIters3 = 8;
 constexpr double kBitsPerByte = 8.0;
 constexpr double kMsPerSecond = 1000.0;
 constexpr double kMbpsDivisor = 1e6;
+constexpr double kForeignTrafficWarnShare = 0.1; // other traffic worth a warning
+constexpr double kPercent = 100.0;
 constexpr int kNumLatencyStats = 5;
 
+// Failed measured transfers since the last speed_test start, reported in TestResults
+std::atomic<int> g_download_failures{0};
+std::atomic<int> g_upload_failures{0};
+// Failed warmup transfers; never recorded, so kept out of the totals above and only used by the
+// traffic cross-check
+static std::atomic<int> g_warmup_failures{0};
+
+// Set once before the first request; read concurrently by the transfer threads afterwards
+static std::string g_speed_test_server = kDefaultSpeedTestServer;
+
+auto set_speed_test_server(const std::string& server) -> void
+{
+  g_speed_test_server = server;
+}
+
+auto speed_test_server() -> const std::string&
+{
+  return g_speed_test_server;
+}
+
 // Refactored measure_download, measure_upload, and measure_download_parallel to use BenchmarkParams
 
 void set_benchmark_cpu_affinity(int cpu_core) {
@@ -52,120 +72,218 @@ void set_benchmark_cpu_affinity(int cpu_core) {
     pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuset);
 }
 
-auto measure_download(const BenchmarkParams& params) -> std::vector<double>
+// Whether another measured transfer fits the phase limits (iterations and/or wall-clock budget)
+static auto phase_continues(const BenchmarkParams& params, int completed, double phase_start_ms)
+    -> bool
 {
-  set_benchmark_cpu_affinity(0); // Pin to core 0
-  std::vector<double> download_results;
-  download_results.reserve(params.num_iterations);
-  const std::string url = "/__down?bytes=" + std::to_string(params.num_bytes);
-  int failed_requests = 0;
-  for (int i = 0; i < params.num_iterations; ++i)
+  const int max_iterations =
+      params.num_iterations > 0 ? params.num_iterations : kMaxDurationIterations;
+  if (completed >= max_iterations)
   {
-    const auto start_time = std::chrono::high_resolution_clock::now();
-    const std::string response = http_get(HttpRequest{"speed.cloudflare.com", url});
-    const auto end_time = std::chrono::high_resolution_clock::now();
-    if (!response.empty())
+    return false;
+  }
+  return params.duration_ms <= 0 || get_time_ms() - phase_start_ms < params.duration_ms;
+}
+
+static auto wall_time_ms() -> double
+{
+  return std::chrono::duration<double, std::milli>(
+             std::chrono::system_clock::now().time_since_epoch())
+      .count();
+}
+
+// One timed transfer; a transport exception or empty response yields a failed record
+static auto timed_transfer(const BenchmarkParams& params, TransferDirection direction,
+                           const std::string& target, const std::string& upload_data)
+    -> SampleRecord
+{
+  SampleRecord record;
+  record.direction = direction;
+  record.bytes = static_cast<uint32_t>(params.num_bytes);
+  record.wall_ms = wall_time_ms();
+  record.monotonic_ms = get_time_ms();
+  std::string response;
+  size_t streamed_bytes = 0; // --memory-budget: bodies stream through an arena buffer instead
+  const auto start_time = std::chrono::high_resolution_clock::now();
+  try
+  {
+    if (memory_budget_enabled())
     {
-      const double milliseconds =
-          std::chrono::duration<double, std::milli>(end_time - start_time).count();
-      download_results.push_back(measure_speed(params.num_bytes, milliseconds));
+      const TransferScratch scratch;
+      streamed_bytes =
+          direction == TransferDirection::upload
+              ? http_upload(HttpRequest{speed_test_server(), target},
+                            static_cast<size_t>(params.num_bytes), scratch.data(), scratch.size())
+              : http_download(HttpRequest{speed_test_server(), target}, scratch.data(),
+                              scratch.size());
     }
-    else {
-      ++failed_requests;
-      std::ofstream errlog("results/download_errors.log", std::ios::app);
-      errlog << "Download failed for iteration " << i << "\n";
+    else
+    {
+      response = direction == TransferDirection::upload
+                     ? http_post(HttpRequest{speed_test_server(), target}, upload_data)
+                     : http_get(HttpRequest{speed_test_server(), target});
     }
   }
-  // Filter: remove first and slowest run
-  if (download_results.size() > 2) {
-    download_results.erase(download_results.begin()); // remove first
-    auto slowest = std::max_element(download_results.begin(), download_results.end());
-    download_results.erase(slowest);
+  catch (const std::exception& ex)
+  {
+    std::ofstream errlog(direction == TransferDirection::upload ? "results/upload_errors.log"
+                                                                : "results/download_errors.log",
+                         std::ios::app);
+    errlog << "[" << std::time(nullptr) << "] " << direction_name(direction)
+           << " failed: exception: " << ex.what() << "\n";
   }
-  return download_results;
+  const auto end_time = std::chrono::high_resolution_clock::now();
+  record.duration_ms = std::chrono::duration<double, std::milli>(end_time - start_time).count();
+  record.connection_id = last_connection_id();
+  if (response.empty() && streamed_bytes == 0)
+  {
+    record.status = SampleStatus::failed;
+    return record;
+  }
+  record.mbps = measure_speed(params.num_bytes, record.duration_ms);
+  return record;
 }
 
-auto measure_upload(const BenchmarkParams& params) -> std::vector<double>
+// A measured (non-warmup) transfer, announced on the event stream as soon as it completes
+static auto measured_transfer(const BenchmarkParams& params, TransferDirection direction,
+                              const std::string& target, const std::string& upload_data)
+    -> SampleRecord
 {
-  set_benchmark_cpu_affinity(0); // Pin to core 0
-  std::vector<double> upload_results;
-  upload_results.reserve(params.num_iterations);
-  static std::string upload_data(params.num_bytes, '0'); // Reuse buffer
-  int failed_requests = 0;
-  for (int iteration_index = 0; iteration_index < params.num_iterations; ++iteration_index)
+  SampleRecord record = timed_transfer(params, direction, target, upload_data);
+  record.phase = static_cast<uint16_t>(params.phase);
+  if (record.status == SampleStatus::failed)
   {
-    try {
-      const auto start_time = std::chrono::high_resolution_clock::now();
-      const std::string response = http_post(HttpRequest{"speed.cloudflare.com", "/__up"}, upload_data);
-      const auto end_time = std::chrono::high_resolution_clock::now();
-      const double milliseconds =
-          std::chrono::duration<double, std::milli>(end_time - start_time).count();
-      if (!response.empty())
+    ++(direction == TransferDirection::upload ? g_upload_failures : g_download_failures);
+  }
+  emit_sample_event(record);
+  check_memory_budget();
+  return record;
+}
+
+static void log_failed_transfer(TransferDirection direction, int iteration_index)
+{
+  if (direction == TransferDirection::download)
+  {
+    std::ofstream errlog("results/download_errors.log", std::ios::app);
+    errlog << "Download failed for iteration " << iteration_index << "\n";
+    return;
+  }
+  std::ofstream errlog("results/upload_errors.log", std::ios::app);
+  errlog << "[" << std::time(nullptr) << "] Upload failed for iteration " << iteration_index;
+  errlog << ", errno=" << errno << " (" << strerror(errno) << ")";
+  errlog << "\n";
+  std::cerr << "[DEBUG] Upload failed for iteration " << iteration_index << ", errno=" << errno << " (" << strerror(errno) << ")\n";
+}
+
+// Runs one phase: warmup transfers, then measured ones, sequentially or in batches of
+// params.concurrency simultaneous transfers. Returns every measured record, failures included.
+auto measure_transfers(const BenchmarkParams& params, TransferDirection direction)
+    -> std::vector<SampleRecord>
+{
+  const bool is_upload = direction == TransferDirection::upload;
+  const std::string target =
+      is_upload ? std::string("/__up") : "/__down?bytes=" + std::to_string(params.num_bytes);
+  // Sized per call: plans run several upload sizes in one process. Not needed with a memory
+  // budget, where uploads are sent from a fixed arena buffer.
+  const std::string upload_data(is_upload && !memory_budget_enabled() ? params.num_bytes : 0, '0');
+  const int num_threads = std::max(1, params.concurrency);
+  if (num_threads == 1)
+  {
+    set_benchmark_cpu_affinity(0); // Pin to core 0
+  }
+  for (int warmup_index = 0; warmup_index < params.warmup; ++warmup_index)
+  {
+    if (timed_transfer(params, direction, target, upload_data).status == SampleStatus::failed)
+    {
+      ++g_warmup_failures;
+    }
+  }
+  std::vector<SampleRecord> records;
+  records.reserve(static_cast<size_t>(params.num_iterations));
+  int launched = 0;
+  const double phase_start_ms = get_time_ms();
+  while (phase_continues(params, launched, phase_start_ms))
+  {
+    if (num_threads == 1)
+    {
+      records.push_back(measured_transfer(params, direction, target, upload_data));
+    }
+    else
+    {
+      const int batch = params.num_iterations > 0
+                            ? std::min(num_threads, params.num_iterations - launched)
+                            : num_threads;
+      std::vector<std::future<SampleRecord>> batch_futures;
+      batch_futures.reserve(batch);
+      for (int i = 0; i < batch; ++i)
       {
-        upload_results.push_back(measure_speed(params.num_bytes, milliseconds));
+        batch_futures.push_back(std::async(std::launch::async, measured_transfer,
+                                           std::cref(params), direction, std::cref(target),
+                                           std::cref(upload_data)));
       }
-      else {
-        ++failed_requests;
-        std::ofstream errlog("results/upload_errors.log", std::ios::app);
-        errlog << "[" << std::time(nullptr) << "] Upload failed for iteration " << iteration_index;
-        errlog << ", response='" << response << "'";
-        errlog << ", errno=" << errno << " (" << strerror(errno) << ")";
-        errlog << "\n";
-        std::cerr << "[DEBUG] Upload failed for iteration " << iteration_index << ", errno=" << errno << " (" << strerror(errno) << ")\n";
+      for (auto& fut : batch_futures)
+      {
+        records.push_back(fut.get());
       }
-    } catch (const std::exception& ex) {
-      std::ofstream errlog("results/upload_errors.log", std::ios::app);
-      errlog << "Upload failed for iteration " << iteration_index << ": exception: " << ex.what() << "\n";
+      launched += batch;
+      continue;
     }
+    ++launched;
   }
-  // Filter: remove first and slowest run
-  if (upload_results.size() > 2) {
-    upload_results.erase(upload_results.begin()); // remove first
-    auto slowest = std::max_element(upload_results.begin(), upload_results.end());
-    upload_results.erase(slowest);
+  if (num_threads == 1)
+  {
+    for (size_t index = 0; index < records.size(); ++index)
+    {
+      if (records[index].status == SampleStatus::failed)
+      {
+        log_failed_transfer(direction, static_cast<int>(index));
+      }
+    }
   }
-  return upload_results;
+  return records;
 }
 
-auto measure_download_parallel(const BenchmarkParams& params) -> std::vector<double>
+// Filtered throughput values of completed transfers (legacy vector interface)
+static auto completed_samples(const std::vector<SampleRecord>& records, SampleFilter filter)
+    -> std::vector<double>
 {
-  const int max_threads = 2;
-  int num_threads = std::min(max_threads, params.num_iterations);
-  std::vector<std::future<double>> futures;
-  futures.reserve(params.num_iterations);
-  const std::string url = "/__down?bytes=" + std::to_string(params.num_bytes);
-  int launched = 0;
-  std::vector<double> results;
-  results.reserve(params.num_iterations);
-  while (launched < params.num_iterations)
+  std::vector<double> samples;
+  samples.reserve(records.size());
+  for (const auto& record : records)
   {
-    int batch = std::min(num_threads, params.num_iterations - launched);
-    std::vector<std::future<double>> batch_futures;
-    batch_futures.reserve(batch);
-    for (int i = 0; i < batch; ++i)
+    if (record.status == SampleStatus::ok)
     {
-      batch_futures.push_back(std::async(
-          std::launch::async,
-          [&url, &params]()
-          {
-            auto start = std::chrono::high_resolution_clock::now();
-            std::string resp = http_get(HttpRequest{"speed.cloudflare.com", url});
-            auto end = std::chrono::high_resolution_clock::now();
-            if (!resp.empty())
-            {
-              auto milliseconds = std::chrono::duration<double, std::milli>(end - start).count();
-              return measure_speed(params.num_bytes, milliseconds);
-            }
-            return 0.0;
-          }));
+      samples.push_back(record.mbps);
     }
-    for (auto& fut : batch_futures)
-    {
-      results.push_back(fut.get());
-    }
-    launched += batch;
   }
-  return results;
+  return filter_samples(std::move(samples), filter);
+}
+
+auto measure_download(const BenchmarkParams& params) -> std::vector<double>
+{
+  BenchmarkParams sequential = params;
+  sequential.concurrency = 1;
+  return completed_samples(measure_transfers(sequential, TransferDirection::download),
+                           params.filter);
+}
+
+auto measure_upload(const BenchmarkParams& params) -> std::vector<double>
+{
+  BenchmarkParams sequential = params;
+  sequential.concurrency = 1;
+  return completed_samples(measure_transfers(sequential, TransferDirection::upload),
+                           params.filter);
+}
+
+auto measure_download_parallel(const BenchmarkParams& params) -> std::vector<double>
+{
+  return completed_samples(measure_transfers(params, TransferDirection::download),
+                           params.filter);
+}
+
+auto measure_upload_parallel(const BenchmarkParams& params) -> std::vector<double>
+{
+  return completed_samples(measure_transfers(params, TransferDirection::upload), params.filter);
 }
 
 // Wrapper for legacy interface: measure_download(int, int)
@@ -187,29 +305,35 @@ auto measure_download_parallel(int bytes, int iterations) -> std::vector<double>
 }
 
 // Use braced initializer list for vector return
-auto measure_latency() -> std::vector<double>
+auto measure_latency(LogHistogram* latency_histogram) -> std::vector<double>
 {
   std::vector<double> measurements;
   measurements.reserve(kLatencySamples);
+  stats::StreamingStats latency_stats;
   for (int sample_index = 0; sample_index < kLatencySamples; ++sample_index)
   {
     const auto start_time = std::chrono::high_resolution_clock::now();
-    const std::string response = http_get(HttpRequest{"speed.cloudflare.com", "/__down?bytes=1000"});
+    const std::string response = http_get(HttpRequest{speed_test_server(), "/__down?bytes=1000"});
     const auto end_time = std::chrono::high_resolution_clock::now();
     if (!response.empty())
     {
       const double milliseconds =
           std::chrono::duration<double, std::milli>(end_time - start_time).count();
       measurements.push_back(milliseconds);
+      latency_stats.add(milliseconds);
+      if (latency_histogram != nullptr)
+      {
+        latency_histogram->record(milliseconds);
+      }
     }
   }
   if (measurements.empty())
   {
     return {0.0, 0.0, 0.0, 0.0, 0.0};
   }
-  return {*std::min_element(measurements.begin(), measurements.end()),
-          *std::max_element(measurements.begin(), measurements.end()), stats::average(measurements),
-          stats::median(measurements), stats::jitter(measurements)};
+  // Exact median: only kLatencySamples values, the P-square estimate is not needed here
+  return {latency_stats.min(), latency_stats.max(), latency_stats.mean(),
+          stats::median(measurements), latency_stats.jitter()};
 }
 
 auto measure_speed(int num_bytes, double duration_ms) -> double
@@ -218,50 +342,100 @@ auto measure_speed(int num_bytes, double duration_ms) -> double
 }
 
 void speed_test(bool use_parallel, bool minimize_output, bool warmup, bool do_yield,
-                bool mask_sensitive, bool output_json, TestResults* json_results)
+                bool mask_sensitive, bool output_json, TestResults* json_results,
+                SampleFilter sample_filter, const TestPlan* plan)
 {
   auto start_time_ms = get_time_ms();
+  g_download_failures = 0;
+  g_upload_failures = 0;
+  g_warmup_failures = 0;
+  const TestPlan active_plan = plan != nullptr ? *plan : default_test_plan();
+  emit_start_event(active_plan);
+  // Self-overhead per phase, reported in the result JSON only
+  OverheadRecorder overhead(json_results != nullptr);
+  // Host-wide CPU, load and pressure while the phases run; saturated phases are flagged
+  HostMonitor host_monitor(true);
+  // Bootstrap: locations (unless cached) and trace run concurrently with each other and warmup
+  const std::string location_cache_path = std::string("results/") + LOCATION_CACHE_FILENAME;
+  overhead.begin();
+  auto t_boot = get_time_ms();
+  LocationIndex serverLocationData = load_location_cache(location_cache_path);
+  const bool locations_cached = !serverLocationData.empty();
+  auto fetch_locations = []()
+  { return parse_locations_json(http_get(HttpRequest{speed_test_server(), "/locations"})); };
+  std::future<LocationIndex> locations_future;
+  if (!locations_cached)
+  {
+    locations_future = std::async(std::launch::async, fetch_locations);
+  }
+  auto trace_future = std::async(
+      std::launch::async,
+      []() { return http_get(HttpRequest{speed_test_server(), "/cdn-cgi/trace"}); });
   if (warmup)
   {
     for (int warmup_index = 0; warmup_index < 3; ++warmup_index)
     {
-      http_get(HttpRequest{"speed.cloudflare.com", "/__down?bytes=1000"});
+      http_get(HttpRequest{speed_test_server(), "/__down?bytes=1000"});
       if (do_yield)
       {
         yield_cpu();
       }
     }
   }
-  // Fetch server location data
-  auto t_loc = get_time_ms();
-  std::string loc_json = http_get(HttpRequest{"speed.cloudflare.com", "/locations"});
-  if (!minimize_output && !output_json)
+  auto cfTrace = parse_cdn_trace(trace_future.get());
+  if (!locations_cached)
   {
-    std::cout << "[TIME] Fetch locations: " << (get_time_ms() - t_loc) << " ms\n";
+    serverLocationData = locations_future.get();
+    save_location_cache(location_cache_path, serverLocationData);
   }
-  auto locations = parse_locations_json(loc_json);
-  std::map<std::string, std::string> serverLocationData = {};
-  for (const auto& entry : locations)
+  else if (!cfTrace["colo"].empty() && serverLocationData.find_city(cfTrace["colo"]) == nullptr &&
+           location_refresh_due(location_cache_path))
   {
-    serverLocationData[entry.at("iata")] = entry.at("city");
+    // Unknown colo in a still-valid cache: a new PoP went live, refresh once per TTL. An empty
+    // colo is a failed trace, which a refresh cannot fix
+    mark_location_refresh(location_cache_path);
+    auto refreshed = fetch_locations();
+    if (!refreshed.empty())
+    {
+      serverLocationData = std::move(refreshed);
+      save_location_cache(location_cache_path, serverLocationData);
+    }
   }
-  // Fetch CDN trace
-  auto t_trace = get_time_ms();
-  std::string trace = http_get(HttpRequest{"speed.cloudflare.com", "/cdn-cgi/trace"});
+  const double bootstrap_ms = get_time_ms() - t_boot;
+  overhead.end("bootstrap");
+  host_monitor.mark_phase("bootstrap", t_boot, t_boot + bootstrap_ms);
+  record_trace_span("phase", "bootstrap", t_boot, bootstrap_ms);
   if (!minimize_output && !output_json)
   {
-    std::cout << "[TIME] Fetch trace: " << (get_time_ms() - t_trace) << " ms\n";
+    std::cout << "[TIME] Bootstrap (" << (locations_cached ? "cached" : "fetched")
+              << " locations, trace" << (warmup ? ", warmup" : "") << "): " << bootstrap_ms
+              << " ms\n";
   }
-  auto cfTrace = parse_cdn_trace(trace);
   // Measure latency
+  overhead.begin();
   auto t_ping = get_time_ms();
-  auto ping = measure_latency();
+  LogHistogram latency_histogram;
+  auto ping = measure_latency(&latency_histogram);
+  const double latency_ms = get_time_ms() - t_ping;
+  overhead.end("latency");
+  host_monitor.mark_phase("latency", t_ping, t_ping + latency_ms);
+  record_trace_span("phase", "latency", t_ping, latency_ms);
+  // Interface counters cross-check the transfer phases: the link the latency probes left on,
+  // else the default route
+  std::string test_interface = interface_for_address(last_local_address());
+  if (test_interface.empty())
+  {
+    test_interface = host_snapshot().tuning.interface;
+  }
+  InterfaceCounters link_counters(test_interface);
+  host_monitor.watch_interface(test_interface);
+  std::vector<PhaseTraffic> traffic;
   if (!minimize_output && !output_json)
   {
-    std::cout << "[TIME] Latency: " << (get_time_ms() - t_ping) << " ms\n";
+    std::cout << "[TIME] Latency: " << latency_ms << " ms\n";
   }
-  std::string city = serverLocationData.count(cfTrace["colo"]) ? serverLocationData[cfTrace["colo"]]
-                                                               : cfTrace["colo"];
+  const std::string* colo_city = serverLocationData.find_city(cfTrace["colo"]);
+  std::string city = colo_city != nullptr ? *colo_city : cfTrace["colo"];
   log_info("Server location", city + " (" + cfTrace["colo"] + ")", output_json);
   std::string ip_out = cfTrace["ip"];
   if (mask_sensitive && !ip_out.empty())
@@ -278,84 +452,140 @@ void speed_test(bool use_parallel, bool minimize_output, bool warmup, bool do_yi
   }
   log_info("Your IP", ip_out + " (" + cfTrace["loc"] + ")", output_json);
   log_latency(ping, output_json);
-  auto t_down = get_time_ms();
+  emit_latency_event(ping);
+  // Run the test plan in order; per-direction totals are logged after that direction's last phase
   int cpu_count = static_cast<int>(std::thread::hardware_concurrency());
-  auto download_func =
-      use_parallel && cpu_count > 1
-          ? static_cast<std::vector<double> (*)(int, int)>(measure_download_parallel)
-          : static_cast<std::vector<double> (*)(int, int)>(measure_download);
-  auto testDown1 = download_func(kDownload100kB, kDownloadIters1);
-  if (do_yield)
+  size_t last_download_phase = active_plan.phases.size();
+  size_t last_upload_phase = active_plan.phases.size();
+  for (size_t phase_index = 0; phase_index < active_plan.phases.size(); ++phase_index)
   {
-    yield_cpu();
+    (active_plan.phases[phase_index].direction == TransferDirection::upload ? last_upload_phase
+                                                                          : last_download_phase) =
+        phase_index;
   }
-  log_speed_test_result("100kB", testDown1, output_json);
-  auto testDown2 = download_func(kDownload1MB, kDownloadIters2);
-  if (do_yield)
+  std::vector<PhaseResult> phase_results;
+  phase_results.reserve(active_plan.phases.size());
+  SampleStore samples;
+  size_t planned_records[2] = {0, 0};
+  for (const PlanPhase& phase : active_plan.phases)
   {
-    yield_cpu();
+    planned_records[phase.direction == TransferDirection::upload ? 1 : 0] +=
+        static_cast<size_t>(phase.num_iterations > 0 ? phase.num_iterations
+                                                     : kMaxDurationIterations);
   }
-  log_speed_test_result("1MB", testDown2, output_json);
-  auto testDown3 = download_func(kDownload10MB, kDownloadIters3);
-  if (do_yield)
+  samples.reserve(TransferDirection::download, planned_records[0]);
+  samples.reserve(TransferDirection::upload, planned_records[1]);
+  double download_ms = 0;
+  double upload_ms = 0;
+  for (size_t phase_index = 0; phase_index < active_plan.phases.size(); ++phase_index)
   {
-    yield_cpu();
-  }
-  log_speed_test_result("10MB", testDown3, output_json);
-  auto testDown4 = download_func(kDownload25MB, kDownloadIters4);
-  if (do_yield)
-  {
-    yield_cpu();
-  }
-  log_speed_test_result("25MB", testDown4, output_json);
-  auto testDown5 = download_func(kDownload100MB, kDownloadIters5);
-  if (do_yield)
-  {
-    yield_cpu();
+    const PlanPhase& phase = active_plan.phases[phase_index];
+    const bool is_upload = phase.direction == TransferDirection::upload;
+    // Auto concurrency keeps the historical behaviour: two parallel downloads with --parallel
+    const int concurrency = phase.concurrency > 0 ? phase.concurrency
+                            : use_parallel && cpu_count > 1 && !is_upload ? 2
+                                                                         : 1;
+    const BenchmarkParams params{phase.num_bytes,   phase.num_iterations, sample_filter,
+                                 phase.duration_ms, concurrency,          phase.warmup,
+                                 static_cast<int>(phase_index)};
+    overhead.begin();
+    std::atomic<int>& phase_failures = is_upload ? g_upload_failures : g_download_failures;
+    const int failures_before = phase_failures + g_warmup_failures;
+    const HttpByteCounts http_before = http_byte_counts();
+    const InterfaceBytes link_before = link_counters.read();
+    const double t_phase = get_time_ms();
+    const std::vector<SampleRecord> records = measure_transfers(params, phase.direction);
+    const double phase_ms = get_time_ms() - t_phase;
+    const InterfaceBytes link_after = link_counters.read();
+    const HttpByteCounts http_after = http_byte_counts();
+    const std::string phase_name = std::string(direction_name(phase.direction)) + " " + phase.label;
+    overhead.end(phase_name);
+    host_monitor.mark_phase(phase_name, t_phase, t_phase + phase_ms);
+    // What the transfers actually moved, warmup and failed ones included
+    const uint64_t application_bytes = is_upload ? http_after.sent - http_before.sent
+                                                 : http_after.received - http_before.received;
+    traffic.push_back(summarise_traffic(phase_name, phase.direction, link_before, link_after,
+                                        application_bytes,
+                                        phase_failures + g_warmup_failures - failures_before,
+                                        host_snapshot().tuning.mtu));
+    traffic.back().interface = test_interface;
+    const size_t stored_phase = samples.add_phase(phase.direction, records, sample_filter);
+    record_trace_span("phase", phase_name, t_phase, phase_ms);
+    emit_phase_event(stored_phase, phase, samples, phase_ms);
+    if (do_yield)
+    {
+      yield_cpu();
+    }
+    (is_upload ? upload_ms : download_ms) += phase_ms;
+    if (!is_upload)
+    {
+      log_speed_test_result(phase.label, samples.phase_samples(stored_phase).to_vector(),
+                            output_json);
+    }
+    phase_results.push_back(PhaseResult{phase, phase_ms});
+    if (phase_index == last_download_phase)
+    {
+      if (!minimize_output && !output_json)
+      {
+        std::cout << "[TIME] Download tests: " << download_ms << " ms\n";
+      }
+      log_download_speed(samples.direction_samples(TransferDirection::download).to_vector(),
+                         output_json);
+    }
+    if (phase_index == last_upload_phase)
+    {
+      if (!minimize_output && !output_json)
+      {
+        std::cout << "[TIME] Upload tests: " << upload_ms << " ms\n";
+      }
+      log_upload_speed(samples.direction_samples(TransferDirection::upload).to_vector(),
+                       output_json);
+    }
   }
-  log_speed_test_result("100MB", testDown5, output_json);
   if (!minimize_output && !output_json)
   {
-    std::cout << "[TIME] Download tests: " << (get_time_ms() - t_down) << " ms\n";
-  }
-  std::vector<double> downloadTests;
-  downloadTests.insert(downloadTests.end(), testDown1.begin(), testDown1.end());
-  downloadTests.insert(downloadTests.end(), testDown2.begin(), testDown2.end());
-  downloadTests.insert(downloadTests.end(), testDown3.begin(), testDown3.end());
-  downloadTests.insert(downloadTests.end(), testDown4.begin(), testDown4.end());
-  downloadTests.insert(downloadTests.end(), testDown5.begin(), testDown5.end());
-  log_download_speed(downloadTests, output_json);
-  auto t_up = get_time_ms();
-  auto testUp1 = measure_upload(kUpload11kB, kUploadIters1);
-  if (do_yield)
-  {
-    yield_cpu();
-  }
-  auto testUp2 = measure_upload(kUpload100kB, kUploadIters2);
-  if (do_yield)
-  {
-    yield_cpu();
-  }
-  auto testUp3 = measure_upload(kUpload1MB, kUploadIters3);
-  if (do_yield)
-  {
-    yield_cpu();
+    std::cout << "[TIME] Total: " << (get_time_ms() - start_time_ms) << " ms\n";
   }
-  if (!minimize_output && !output_json)
+  record_trace_span("phase", "speed_test", start_time_ms, get_time_ms() - start_time_ms);
+  std::vector<PhaseContention> contention = host_monitor.take();
+  for (PhaseTraffic& phase_traffic : traffic)
   {
-    std::cout << "[TIME] Upload tests: " << (get_time_ms() - t_up) << " ms\n";
+    for (const PhaseContention& phase : contention)
+    {
+      if (phase.name == phase_traffic.name)
+      {
+        phase_traffic.peak_interface_mbps = std::max(
+            0.0, phase_traffic.direction == TransferDirection::upload ? phase.usage.tx_mbps
+                                                                      : phase.usage.rx_mbps);
+      }
+    }
   }
-  std::vector<double> uploadTests;
-  uploadTests.insert(uploadTests.end(), testUp1.begin(), testUp1.end());
-  uploadTests.insert(uploadTests.end(), testUp2.begin(), testUp2.end());
-  uploadTests.insert(uploadTests.end(), testUp3.begin(), testUp3.end());
-  log_upload_speed(uploadTests, output_json);
-  if (!minimize_output && !output_json)
+  if (!minimize_output)
   {
-    std::cout << "[TIME] Total: " << (get_time_ms() - start_time_ms) << " ms\n";
+    for (const PhaseTraffic& phase : traffic)
+    {
+      if (phase.cross_checked && phase.foreign_share >= kForeignTrafficWarnShare)
+      {
+        std::cerr << "[WARN] Other traffic on " << phase.interface << " during " << phase.name
+                  << ": " << static_cast<int>(phase.foreign_share * kPercent) << "% of "
+                  << static_cast<int>(phase.interface_mbps) << " Mbps was not ours ("
+                  << static_cast<int>(phase.application_mbps) << " Mbps)" << std::endl;
+      }
+    }
+    for (const PhaseContention& phase : contention)
+    {
+      if (!phase.saturation.empty())
+      {
+        std::cerr << "[WARN] Host saturated during " << phase.name << " ("
+                  << saturation_text(phase) << "): CPU " << static_cast<int>(phase.usage.busy_pct)
+                  << "%, busiest core " << static_cast<int>(phase.usage.max_core_busy_pct)
+                  << "% (softirq " << static_cast<int>(phase.usage.max_core_softirq_pct)
+                  << "%), steal " << static_cast<int>(phase.usage.steal_pct) << "%" << std::endl;
+      }
+    }
   }
-  // If JSON output requested, fill TestResults struct
-  if (output_json && json_results)
+  // Fill TestResults struct when the caller wants results (JSON output, metrics, daemon)
+  if (json_results)
   {
     json_results->city = city;
     json_results->colo = cfTrace["colo"];
@@ -364,16 +594,29 @@ void speed_test(bool use_parallel, bool minimize_output, bool warmup, bool do_yi
     // System info
     collect_sysinfo(*json_results, mask_sensitive);
     json_results->latency = ping;
-    json_results->download_100kB = testDown1;
-    json_results->download_1MB = testDown2;
-    json_results->download_10MB = testDown3;
-    json_results->download_25MB = testDown4;
-    json_results->download_100MB = testDown5;
-    json_results->all_downloads = downloadTests;
-    json_results->upload_11kB = testUp1;
-    json_results->upload_100kB = testUp2;
-    json_results->upload_1MB = testUp3;
-    json_results->all_uploads = uploadTests;
+    const std::vector<double> download_values =
+        samples.direction_samples(TransferDirection::download).to_vector();
+    const std::vector<double> upload_values =
+        samples.direction_samples(TransferDirection::upload).to_vector();
+    json_results->test_plan = active_plan.name;
+    json_results->phases = std::move(phase_results);
+    json_results->samples = std::move(samples);
+    json_results->latency_histogram = latency_histogram;
+    json_results->sample_filter = sample_filter_name(sample_filter);
+    json_results->download_estimate = estimate_samples(download_values);
+    json_results->upload_estimate = estimate_samples(upload_values);
+    json_results->download_histogram.record_all(download_values);
+    json_results->upload_histogram.record_all(upload_values);
     json_results->total_time_ms = get_time_ms() - start_time_ms;
+    json_results->bootstrap_ms = bootstrap_ms;
+    json_results->latency_ms = latency_ms;
+    json_results->download_ms = download_ms;
+    json_results->upload_ms = upload_ms;
+    json_results->download_failures = g_download_failures;
+    json_results->upload_failures = g_upload_failures;
+    json_results->overhead = overhead.take();
+    json_results->contention = std::move(contention);
+    json_results->traffic = std::move(traffic);
+    emit_summary_event(*json_results);
   }
 }
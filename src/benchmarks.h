@@ -1,21 +1,43 @@
 #pragma once
-#include <vector>  // for vector
+#include <string>       // for string
+#include <vector>       // for vector
+#include "estimation.h"   // for SampleFilter
+#include "sample_store.h" // for SampleRecord
+#include "test_plan.h"    // for TestPlan, TransferDirection
 
 // Forward declaration of TestResults struct
 struct TestResults;
+class LogHistogram;
 
 // Generic struct for all benchmark parameter sets
 struct BenchmarkParams {
     int num_bytes;
     int num_iterations;
+    SampleFilter filter = SampleFilter::mad;
+    double duration_ms = 0; // optional wall-clock budget, see PlanPhase
+    int concurrency = 2;    // simultaneous transfers for the *_parallel variants
+    int warmup = 0;         // unrecorded transfers before measuring
+    int phase = 0;          // plan phase index, stamped on records as they complete
 };
 
+inline constexpr const char* kDefaultSpeedTestServer = "speed.cloudflare.com";
+
+// Endpoint of every request (--server): HOST, HOST:PORT or [V6]:PORT serving the speed test
+// paths (/__down, /__up, /cdn-cgi/trace, /locations) over HTTPS, e.g. a local mock server
+auto set_speed_test_server(const std::string& server) -> void;
+auto speed_test_server() -> const std::string&;
+
 // Speed test helpers
+// measure_transfers keeps every record (timestamps, connection, failures); the vector variants
+// return filtered throughput values only
 // Modernized: trailing return types, descriptive parameter names
-auto measure_latency() -> std::vector<double>;
+auto measure_latency(LogHistogram* latency_histogram = nullptr) -> std::vector<double>;
+auto measure_transfers(const BenchmarkParams& params, TransferDirection direction)
+    -> std::vector<SampleRecord>;
 auto measure_download(const BenchmarkParams& params) -> std::vector<double>;
 auto measure_download_parallel(const BenchmarkParams& params) -> std::vector<double>;
 auto measure_upload(const BenchmarkParams& params) -> std::vector<double>;
+auto measure_upload_parallel(const BenchmarkParams& params) -> std::vector<double>;
 auto measure_download(int bytes, int iterations) -> std::vector<double>;
 auto measure_download_parallel(int bytes, int iterations) -> std::vector<double>;
 auto measure_upload(int bytes, int iterations) -> std::vector<double>;
@@ -24,4 +46,6 @@ auto measure_speed(int bytes, double duration_ms) -> double;
 // Main speed test
 auto speed_test(bool use_parallel = false, bool minimize_output = false, bool warmup = true,
                 bool do_yield = true, bool mask_sensitive = false, bool output_json = false,
-                TestResults* json_results = nullptr) -> void;
+                TestResults* json_results = nullptr,
+                SampleFilter sample_filter = SampleFilter::mad,
+                const TestPlan* plan = nullptr) -> void; // nullptr = default_test_plan()
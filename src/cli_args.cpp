@@ -11,8 +11,6 @@
 // Modernized: braces, descriptive variable names, trailing return types, auto, nullptr, one
 // declaration per statement, no implicit conversions
 
-auto expand_wildcards(const std::vector<std::string>& patterns) -> std::vector<std::string>;
-
 auto parse_cli_args(const std::vector<std::string>& arguments) -> CliArgs
 {
   CliArgs parsed_args;
@@ -85,6 +83,177 @@ auto parse_cli_args(const std::vector<std::string>& arguments) -> CliArgs
       parsed_args.used_flags.push_back(argument);
       continue;
     }
+    if (argument == "--ndjson" || argument.rfind("--ndjson=", 0) == 0)
+    {
+      // Default: stdout; otherwise an inherited descriptor, e.g. --ndjson=3 3>events.ndjson
+      int fd = argument.size() > 9 ? std::atoi(argument.c_str() + 9) : 1;
+      if (fd > 0)
+        parsed_args.ndjson_fd = fd;
+      else
+        std::cerr << "[WARN] Invalid --ndjson descriptor: " << argument.substr(9) << std::endl;
+      parsed_args.used_flags.push_back(argument);
+      continue;
+    }
+    if (argument.rfind("--memory-budget=", 0) == 0)
+    {
+      int megabytes = std::atoi(argument.c_str() + 16);
+      if (megabytes > 0)
+        parsed_args.memory_budget_mb = megabytes;
+      else
+        std::cerr << "[WARN] Invalid --memory-budget: " << argument.substr(16) << std::endl;
+      parsed_args.used_flags.push_back(argument);
+      continue;
+    }
+    if (argument.rfind("--trace=", 0) == 0)
+    {
+      parsed_args.trace_file = argument.substr(8);
+      parsed_args.used_flags.push_back(argument);
+      continue;
+    }
+    if (argument == "--daemon")
+    {
+      parsed_args.daemon_mode = true;
+      parsed_args.used_flags.push_back(argument);
+      continue;
+    }
+    if (argument.rfind("--interval=", 0) == 0)
+    {
+      int seconds = std::atoi(argument.c_str() + 11);
+      if (seconds > 0)
+        parsed_args.daemon_interval_s = seconds;
+      parsed_args.used_flags.push_back(argument);
+      continue;
+    }
+    if (argument.rfind("--jitter=", 0) == 0)
+    {
+      int seconds = std::atoi(argument.c_str() + 9);
+      if (seconds >= 0)
+        parsed_args.daemon_jitter_s = seconds;
+      parsed_args.used_flags.push_back(argument);
+      continue;
+    }
+    if (argument.rfind("--keep=", 0) == 0)
+    {
+      int keep = std::atoi(argument.c_str() + 7);
+      if (keep > 0)
+        parsed_args.daemon_keep = keep;
+      parsed_args.used_flags.push_back(argument);
+      continue;
+    }
+    if (argument.rfind("--output-dir=", 0) == 0)
+    {
+      parsed_args.daemon_output_dir = argument.substr(13);
+      parsed_args.used_flags.push_back(argument);
+      continue;
+    }
+    if (argument.rfind("--metrics-file=", 0) == 0)
+    {
+      parsed_args.metrics_file = argument.substr(15);
+      parsed_args.used_flags.push_back(argument);
+      continue;
+    }
+    if (argument.rfind("--metrics-port=", 0) == 0)
+    {
+      int port = std::atoi(argument.c_str() + 15);
+      if (port > 0 && port < 65536)
+        parsed_args.metrics_port = port;
+      parsed_args.used_flags.push_back(argument);
+      continue;
+    }
+    if (argument.rfind("--sample-filter=", 0) == 0)
+    {
+      if (!parse_sample_filter(argument.substr(16), parsed_args.sample_filter))
+        std::cerr << "[WARN] Unknown sample filter: " << argument.substr(16)
+                  << " (expected legacy, none, mad or iqr)" << std::endl;
+      parsed_args.used_flags.push_back(argument);
+      continue;
+    }
+    if (argument == "--no-summary-index")
+    {
+      parsed_args.use_summary_index = false;
+      parsed_args.used_flags.push_back(argument);
+      continue;
+    }
+    if (argument.rfind("--plan=", 0) == 0)
+    {
+      parsed_args.test_plan = argument.substr(7);
+      parsed_args.used_flags.push_back(argument);
+      continue;
+    }
+    if (argument.rfind("--server=", 0) == 0)
+    {
+      parsed_args.server = argument.substr(9);
+      parsed_args.used_flags.push_back(argument);
+      continue;
+    }
+    if (argument == "--matrix" || argument.rfind("--matrix=", 0) == 0)
+    {
+      parsed_args.matrix_mode = true;
+      // Comma-separated scenario names, checked against the known ones in main
+      std::string list = argument.size() > 9 ? argument.substr(9) : std::string();
+      size_t start = 0;
+      while (start < list.size())
+      {
+        size_t comma = list.find(',', start);
+        comma = comma == std::string::npos ? list.size() : comma;
+        if (comma > start)
+          parsed_args.matrix_scenarios.push_back(list.substr(start, comma - start));
+        start = comma + 1;
+      }
+      continue;
+    }
+    if (argument.rfind("--repeat=", 0) == 0)
+    {
+      int repeat = std::atoi(argument.c_str() + 9);
+      if (repeat >= 2)
+        parsed_args.matrix_repeat = repeat;
+      else
+        std::cerr << "[WARN] Invalid --repeat (at least 2): " << argument.substr(9) << std::endl;
+      continue;
+    }
+    if (argument.rfind("--history=", 0) == 0)
+    {
+      parsed_args.history_file = argument.substr(10);
+      parsed_args.used_flags.push_back(argument);
+      continue;
+    }
+    if (argument.rfind("--history-report=", 0) == 0)
+    {
+      parsed_args.history_report = argument.substr(17);
+      continue;
+    }
+    if (argument.rfind("--history-export=", 0) == 0)
+    {
+      parsed_args.history_export = argument.substr(17);
+      continue;
+    }
+    if (argument.rfind("--baseline=", 0) == 0)
+    {
+      parsed_args.baseline = argument.substr(11);
+      parsed_args.used_flags.push_back(argument);
+      continue;
+    }
+    if (argument.rfind("--check=", 0) == 0)
+    {
+      parsed_args.check_file = argument.substr(8);
+      continue;
+    }
+    if (argument.rfind("--tolerance=", 0) == 0)
+    {
+      parsed_args.tolerances = argument.substr(12);
+      parsed_args.used_flags.push_back(argument);
+      continue;
+    }
+    if (argument.rfind("--since=", 0) == 0)
+    {
+      parsed_args.history_since = argument.substr(8);
+      continue;
+    }
+    if (argument.rfind("--until=", 0) == 0)
+    {
+      parsed_args.history_until = argument.substr(8);
+      continue;
+    }
     if (argument == "--summary-table")
     {
       parsed_args.summary_table = true;
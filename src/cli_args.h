@@ -1,6 +1,7 @@
 #pragma once
 #include <string>
 #include <vector>
+#include "estimation.h"
 
 // Modernized: trailing return types, descriptive parameter names
 struct CliArgs
@@ -13,10 +14,35 @@ struct CliArgs
   bool do_nice = true;
   bool do_drop_caches = false;
   bool output_json = false;
+  int ndjson_fd = -1; // --ndjson[=FD]: live event stream target, -1 = off
+  int memory_budget_mb = 0; // --memory-budget: 0 = unbounded
+  std::string trace_file;   // --trace: Chrome trace-event JSON written at exit
   bool mask_sensitive = false;
   bool show_sysinfo = false;
   bool show_sysinfo_only = false;
   bool summary_table = false;
+  bool use_summary_index = true;
+  bool daemon_mode = false;
+  int daemon_interval_s = 3600;
+  int daemon_jitter_s = 300;
+  int daemon_keep = 168;
+  std::string daemon_output_dir = "results/daemon";
+  std::string metrics_file;
+  int metrics_port = 0;
+  SampleFilter sample_filter = SampleFilter::mad;
+  std::string test_plan; // preset name or JSON plan file; empty = default plan
+  std::string server;    // --server: HOST[:PORT] instead of speed.cloudflare.com
+  bool matrix_mode = false;
+  std::vector<std::string> matrix_scenarios; // --matrix=LIST; empty = every scenario
+  int matrix_repeat = 5;                     // --repeat: runs per scenario
+  std::string history_file;   // --history: binary store each run is appended to
+  std::string history_report; // --history-report: store to print a summary table from
+  std::string history_export; // --history-export: store to dump as JSON
+  std::string history_since;  // --since/--until: time range for report and export
+  std::string history_until;
+  std::string baseline;       // --baseline: history store or result JSON files to gate against
+  std::string check_file;     // --check: result file to gate instead of running a test
+  std::string tolerances;     // --tolerance: METRIC:PERCENT list, see GateTolerances
   bool is_debug = false;
   bool is_diagnostics = false;
   bool is_full_diagnostics = false;
@@ -26,3 +52,5 @@ struct CliArgs
 };
 
 auto parse_cli_args(const std::vector<std::string>& arguments) -> CliArgs;
+// Files matching each pattern's * and ? in its directory; patterns without them pass through
+auto expand_wildcards(const std::vector<std::string>& patterns) -> std::vector<std::string>;
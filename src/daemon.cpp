@@ -0,0 +1,191 @@
+#include "daemon.h"
+#include <dirent.h>        // for opendir, readdir, closedir, dirent
+#include <sys/stat.h>      // for mkdir
+#include <algorithm>       // for sort, min
+#include <array>           // for array
+#include <chrono>          // IWYU pragma: keep  // for seconds
+#include <csignal>         // for signal, sig_atomic_t, SIGINT, SIGTERM
+#include <cstdio>          // for rename, remove
+#include <ctime>           // for time, gmtime_r, strftime
+#include <exception>       // for exception
+#include <fstream>         // IWYU pragma: keep  // for ofstream
+#include <iostream>        // for operator<<, basic_ostream, cout, cerr
+#include <random>          // for mt19937, random_device, uniform_int_distribution
+#include <string>          // for string, operator+
+#include <thread>          // for sleep_for
+#include <vector>          // for vector
+#include "benchmarks.h"    // for speed_test
+#include "cli_args.h"      // for CliArgs
+#include "history_store.h" // for append_history_record, make_history_record
+#include "json_helpers.h"  // for serialize_to_json
+#include "metrics.h"       // for record_run_metrics, record_run_failure, write_metrics...
+#include "network.h"       // for set_network_keep_warm
+#include "sysinfo.h"       // for get_time_ms
+#include "test_plan.h"     // for TestPlan
+#include "types.h"         // for TestResults
+
+constexpr const char* kDaemonFilePrefix = "speedtest-";
+constexpr const char* kDaemonFileSuffix = ".json";
+constexpr size_t kTimestampLen = 32;
+constexpr double kMsPerSecond = 1000.0;
+
+namespace
+{
+volatile std::sig_atomic_t g_stop_requested = 0;
+
+void request_stop(int /*signal*/) { g_stop_requested = 1; }
+
+// UTC, so names keep sorting chronologically across DST changes and TZ edits
+auto timestamp_now() -> std::string
+{
+  std::array<char, kTimestampLen> stamp{};
+  const time_t now = time(nullptr);
+  struct tm time_info
+  {
+  };
+  gmtime_r(&now, &time_info);
+  (void)strftime(stamp.data(), stamp.size(), "%Y%m%dT%H%M%SZ", &time_info);
+  return stamp.data();
+}
+
+// Write via a temp file so readers never see a half-written result
+auto write_result_atomically(const std::string& path, const std::string& json) -> bool
+{
+  const std::string tmp_path = path + ".tmp";
+  {
+    std::ofstream out(tmp_path, std::ios::trunc);
+    if (!out)
+    {
+      return false;
+    }
+    out << json << '\n';
+    if (!out)
+    {
+      (void)std::remove(tmp_path.c_str());
+      return false;
+    }
+  }
+  return std::rename(tmp_path.c_str(), path.c_str()) == 0;
+}
+
+// Keep only the newest `keep` results; file names sort chronologically
+void rotate_results(const std::string& dir, int keep)
+{
+  DIR* dp = opendir(dir.c_str());
+  if (!dp)
+  {
+    return;
+  }
+  std::vector<std::string> names{};
+  struct dirent* ep = nullptr;
+  while ((ep = readdir(dp)))
+  {
+    const std::string name(static_cast<const char*>(ep->d_name));
+    const std::string suffix(kDaemonFileSuffix);
+    if (name.rfind(kDaemonFilePrefix, 0) == 0 && name.size() > suffix.size() &&
+        name.compare(name.size() - suffix.size(), suffix.size(), suffix) == 0)
+    {
+      names.push_back(name);
+    }
+  }
+  closedir(dp);
+  if (names.size() <= static_cast<size_t>(keep))
+  {
+    return;
+  }
+  std::sort(names.begin(), names.end());
+  const size_t excess = names.size() - static_cast<size_t>(keep);
+  for (size_t index = 0; index < excess; ++index)
+  {
+    (void)std::remove((dir + "/" + names[index]).c_str());
+  }
+}
+
+// Sleep in short slices so SIGTERM/SIGINT end the daemon promptly
+void sleep_until_ms(double deadline_ms)
+{
+  while (!g_stop_requested)
+  {
+    const double remaining_ms = deadline_ms - get_time_ms();
+    if (remaining_ms <= 0.0)
+    {
+      return;
+    }
+    std::this_thread::sleep_for(
+        std::chrono::milliseconds(static_cast<long>(std::min(remaining_ms, kMsPerSecond))));
+  }
+}
+} // namespace
+
+auto run_daemon(const CliArgs& args, const TestPlan& plan) -> int
+{
+  (void)mkdir(args.daemon_output_dir.c_str(), 0755);
+  std::signal(SIGINT, request_stop);
+  std::signal(SIGTERM, request_stop);
+  set_network_keep_warm(true);
+  if (args.metrics_port > 0)
+  {
+    start_metrics_listener(static_cast<unsigned short>(args.metrics_port));
+  }
+  std::mt19937 rng(std::random_device{}());
+  std::uniform_int_distribution<int> jitter_dist(0, std::max(0, args.daemon_jitter_s));
+  if (!args.minimize_output)
+  {
+    std::cout << "[DAEMON] Interval " << args.daemon_interval_s << " s (+0.." << args.daemon_jitter_s
+              << " s jitter), keeping " << args.daemon_keep << " results in "
+              << args.daemon_output_dir << ", plan " << plan.name << std::endl;
+  }
+  unsigned long run_count = 0;
+  while (!g_stop_requested)
+  {
+    const double run_start_ms = get_time_ms();
+    TestResults results;
+    results.flags = args.used_flags;
+    try
+    {
+      speed_test(args.use_parallel, true, args.warmup, args.do_yield, args.mask_sensitive, true,
+                 &results, args.sample_filter, &plan);
+      record_run_metrics(results);
+      std::string history_error;
+      if (!args.history_file.empty() &&
+          !append_history_record(args.history_file, make_history_record(results), history_error))
+      {
+        std::cerr << "[ERROR] " << history_error << std::endl;
+      }
+      const std::string path = args.daemon_output_dir + "/" + kDaemonFilePrefix +
+                               timestamp_now() + kDaemonFileSuffix;
+      if (write_result_atomically(path, serialize_to_json(results)))
+      {
+        rotate_results(args.daemon_output_dir, args.daemon_keep);
+        if (!args.minimize_output)
+        {
+          std::cout << "[DAEMON] Run " << ++run_count << " written to " << path << " ("
+                    << results.total_time_ms << " ms)" << std::endl;
+        }
+      }
+      else
+      {
+        std::cerr << "[ERROR] Could not write " << path << std::endl;
+      }
+    }
+    catch (const std::exception& ex)
+    {
+      // A failed run must not kill the monitor; try again at the next slot
+      std::cerr << "[ERROR] Daemon run failed: " << ex.what() << std::endl;
+      record_run_failure();
+    }
+    if (!args.metrics_file.empty() && !write_metrics_textfile(args.metrics_file))
+    {
+      std::cerr << "[ERROR] Could not write metrics file " << args.metrics_file << std::endl;
+    }
+    const double delay_ms =
+        (static_cast<double>(args.daemon_interval_s) + jitter_dist(rng)) * kMsPerSecond;
+    sleep_until_ms(run_start_ms + delay_ms);
+  }
+  set_network_keep_warm(false);
+  if (!args.minimize_output)
+  {
+    std::cout << "[DAEMON] Stopped after " << run_count << " runs" << std::endl;
+  }
+  return 0;
+}
@@ -0,0 +1,7 @@
+#pragma once
+
+struct CliArgs;
+struct TestPlan;
+
+// Continuous monitoring mode
+auto run_daemon(const CliArgs& args, const TestPlan& plan) -> int;
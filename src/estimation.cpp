@@ -0,0 +1,298 @@
+#include "estimation.h"
+#include <algorithm>  // for max_element, nth_element, sort, min, max
+#include <cmath>      // for ceil, erfc, fabs, floor, sqrt
+#include <cstddef>    // for size_t, ptrdiff_t
+#include <functional> // for cref
+#include <future>     // for async, future, launch
+#include <numeric>    // for iota
+#include <random>     // for mt19937, uniform_int_distribution
+#include <string>     // for string
+#include <thread>     // for thread
+#include <utility>    // for pair
+#include <vector>     // for vector
+#include "stats.h"    // for median, quartile
+
+constexpr double kMadScale = 1.4826;      // MAD -> standard deviation for normal data
+constexpr double kMadThreshold = 3.5;     // Iglewicz & Hoaglin modified z-score cut-off
+constexpr double kIqrFence = 1.5;         // Tukey fences
+constexpr double kQuartile1 = 0.25;
+constexpr double kQuartile3 = 0.75;
+constexpr double kMedianQuantile = 0.5;
+constexpr double kP90Quantile = 0.9;
+constexpr size_t kMinSamplesToFilter = 4; // below this there is no robust notion of outlier
+constexpr unsigned kBootstrapSeed = 0x5eedu;
+constexpr int kMinResamplesPerThread = 250;
+
+namespace
+{
+// Nearest-rank quantile (same definition as percentile() for download_90pct); reorders input
+auto nearest_rank(std::vector<double>& values, double quantile) -> double
+{
+  size_t rank = static_cast<size_t>(std::ceil(quantile * static_cast<double>(values.size())));
+  rank = rank == 0 ? 0 : rank - 1;
+  rank = std::min(rank, values.size() - 1);
+  const auto nth = values.begin() + static_cast<std::ptrdiff_t>(rank);
+  std::nth_element(values.begin(), nth, values.end());
+  return *nth;
+}
+
+auto resample_statistics(const std::vector<double>& samples, double quantile, int resamples,
+                         unsigned seed) -> std::vector<double>
+{
+  std::mt19937 rng(seed);
+  std::uniform_int_distribution<size_t> pick(0, samples.size() - 1);
+  std::vector<double> statistics;
+  statistics.reserve(static_cast<size_t>(resamples));
+  std::vector<double> resample(samples.size());
+  for (int iteration = 0; iteration < resamples; ++iteration)
+  {
+    for (double& value : resample)
+    {
+      value = samples[pick(rng)];
+    }
+    statistics.push_back(quantile == kMedianQuantile ? stats::median(resample)
+                                                     : nearest_rank(resample, quantile));
+  }
+  return statistics;
+}
+} // namespace
+
+auto parse_sample_filter(const std::string& name, SampleFilter& filter) -> bool
+{
+  if (name == "legacy")
+    filter = SampleFilter::legacy;
+  else if (name == "none")
+    filter = SampleFilter::none;
+  else if (name == "mad")
+    filter = SampleFilter::mad;
+  else if (name == "iqr")
+    filter = SampleFilter::iqr;
+  else
+    return false;
+  return true;
+}
+
+auto sample_filter_name(SampleFilter filter) -> const char*
+{
+  switch (filter)
+  {
+    case SampleFilter::legacy: return "legacy";
+    case SampleFilter::none: return "none";
+    case SampleFilter::mad: return "mad";
+    case SampleFilter::iqr: return "iqr";
+  }
+  return "unknown";
+}
+
+auto sample_filter_mask(const std::vector<double>& samples, SampleFilter filter)
+    -> std::vector<bool>
+{
+  std::vector<bool> keep(samples.size(), true);
+  if (filter == SampleFilter::legacy)
+  {
+    if (samples.size() > 2)
+    {
+      keep[0] = false;
+      keep[static_cast<size_t>(std::max_element(samples.begin() + 1, samples.end()) -
+                               samples.begin())] = false;
+    }
+    return keep;
+  }
+  if (filter == SampleFilter::none || samples.size() < kMinSamplesToFilter)
+  {
+    return keep;
+  }
+  double low_fence = 0.0;
+  double high_fence = 0.0;
+  if (filter == SampleFilter::mad)
+  {
+    const double center = stats::median(samples);
+    std::vector<double> deviations;
+    deviations.reserve(samples.size());
+    for (const double value : samples)
+    {
+      deviations.push_back(std::fabs(value - center));
+    }
+    const double mad = stats::median(deviations);
+    if (mad == 0.0)
+    {
+      // Over half the samples are identical; nothing can be called an outlier robustly
+      return keep;
+    }
+    low_fence = center - kMadThreshold * kMadScale * mad;
+    high_fence = center + kMadThreshold * kMadScale * mad;
+  }
+  else
+  {
+    const double q1 = stats::quartile(samples, kQuartile1);
+    const double q3 = stats::quartile(samples, kQuartile3);
+    low_fence = q1 - kIqrFence * (q3 - q1);
+    high_fence = q3 + kIqrFence * (q3 - q1);
+  }
+  for (size_t index = 0; index < samples.size(); ++index)
+  {
+    keep[index] = samples[index] >= low_fence && samples[index] <= high_fence;
+  }
+  return keep;
+}
+
+auto filter_samples(std::vector<double> samples, SampleFilter filter) -> std::vector<double>
+{
+  const std::vector<bool> keep = sample_filter_mask(samples, filter);
+  size_t kept = 0;
+  for (size_t index = 0; index < samples.size(); ++index)
+  {
+    if (keep[index])
+    {
+      samples[kept++] = samples[index];
+    }
+  }
+  samples.resize(kept);
+  return samples;
+}
+
+auto trimmed_mean(const std::vector<double>& samples, double trim_fraction) -> double
+{
+  if (samples.empty())
+  {
+    return 0.0;
+  }
+  std::vector<double> sorted(samples);
+  std::sort(sorted.begin(), sorted.end());
+  const auto trim =
+      static_cast<size_t>(std::floor(trim_fraction * static_cast<double>(sorted.size())));
+  double total = 0.0;
+  for (size_t index = trim; index < sorted.size() - trim; ++index)
+  {
+    total += sorted[index];
+  }
+  return total / static_cast<double>(sorted.size() - 2 * trim);
+}
+
+// Percentile bootstrap; resamples are split across cores with fixed per-thread seeds so the
+// interval is reproducible for a given input and core count.
+auto bootstrap_ci(const std::vector<double>& samples, double quantile, int resamples,
+                  double confidence) -> ConfidenceInterval
+{
+  ConfidenceInterval interval;
+  if (samples.empty())
+  {
+    return interval;
+  }
+  std::vector<double> scratch(samples);
+  interval.estimate =
+      quantile == kMedianQuantile ? stats::median(samples) : nearest_rank(scratch, quantile);
+  if (samples.size() < 2 || resamples <= 0)
+  {
+    interval.lower = interval.estimate;
+    interval.upper = interval.estimate;
+    return interval;
+  }
+  const int hardware_threads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+  const int workers = std::max(1, std::min(hardware_threads, resamples / kMinResamplesPerThread));
+  std::vector<std::future<std::vector<double>>> futures;
+  futures.reserve(static_cast<size_t>(workers));
+  for (int worker = 0; worker < workers; ++worker)
+  {
+    const int share = resamples / workers + (worker < resamples % workers ? 1 : 0);
+    futures.push_back(std::async(std::launch::async, resample_statistics, std::cref(samples),
+                                 quantile, share, kBootstrapSeed + static_cast<unsigned>(worker)));
+  }
+  std::vector<double> statistics;
+  statistics.reserve(static_cast<size_t>(resamples));
+  for (auto& future : futures)
+  {
+    const auto part = future.get();
+    statistics.insert(statistics.end(), part.begin(), part.end());
+  }
+  const double tail = (1.0 - confidence) / 2.0;
+  interval.lower = stats::quartile(statistics, tail);
+  interval.upper = stats::quartile(statistics, 1.0 - tail);
+  return interval;
+}
+
+auto estimate_samples(const std::vector<double>& samples) -> SampleEstimate
+{
+  SampleEstimate estimate;
+  estimate.samples = static_cast<int>(samples.size());
+  estimate.median = bootstrap_ci(samples, kMedianQuantile);
+  estimate.p90 = bootstrap_ci(samples, kP90Quantile);
+  estimate.trimmed_mean = trimmed_mean(samples);
+  return estimate;
+}
+
+// Ranks the pooled samples (ties get their average rank); the continuity-corrected z is compared
+// against the normal distribution, adequate from about five values per sample
+auto mann_whitney_test(const std::vector<double>& first, const std::vector<double>& second)
+    -> RankTest
+{
+  RankTest test;
+  if (first.empty() || second.empty())
+  {
+    return test;
+  }
+  std::vector<std::pair<double, bool>> pooled; // value, belongs to first
+  pooled.reserve(first.size() + second.size());
+  for (const double value : first)
+  {
+    pooled.emplace_back(value, true);
+  }
+  for (const double value : second)
+  {
+    pooled.emplace_back(value, false);
+  }
+  std::sort(pooled.begin(), pooled.end());
+  const auto pooled_size = static_cast<double>(pooled.size());
+  double first_rank_sum = 0.0;
+  double tie_term = 0.0; // sum of t^3 - t over groups of t tied values
+  for (size_t begin = 0; begin < pooled.size();)
+  {
+    size_t end = begin + 1;
+    while (end < pooled.size() && pooled[end].first == pooled[begin].first)
+    {
+      ++end;
+    }
+    const auto tied = static_cast<double>(end - begin);
+    const double average_rank = static_cast<double>(begin + end + 1) / 2.0;
+    for (size_t index = begin; index < end; ++index)
+    {
+      first_rank_sum += pooled[index].second ? average_rank : 0.0;
+    }
+    tie_term += tied * tied * tied - tied;
+    begin = end;
+  }
+  const auto first_size = static_cast<double>(first.size());
+  const auto second_size = static_cast<double>(second.size());
+  test.u = first_rank_sum - first_size * (first_size + 1.0) / 2.0;
+  const double mean_u = first_size * second_size / 2.0;
+  const double variance = first_size * second_size / 12.0 *
+                          (pooled_size + 1.0 - tie_term / (pooled_size * (pooled_size - 1.0)));
+  if (variance <= 0.0)
+  {
+    return test;
+  }
+  const double deviation = test.u - mean_u;
+  const double corrected = std::max(0.0, std::fabs(deviation) - 0.5);
+  test.z = (deviation < 0 ? -corrected : corrected) / std::sqrt(variance);
+  test.p_value = std::min(1.0, std::erfc(std::fabs(test.z) / std::sqrt(2.0)));
+  return test;
+}
+
+// The k-th smallest of m p-values is scaled by (m - k); running maxima keep the adjusted values
+// in the same order as the raw ones
+auto holm_adjust(const std::vector<double>& p_values) -> std::vector<double>
+{
+  std::vector<size_t> order(p_values.size());
+  std::iota(order.begin(), order.end(), size_t{0});
+  std::sort(order.begin(), order.end(),
+            [&](size_t left, size_t right) { return p_values[left] < p_values[right]; });
+  std::vector<double> adjusted(p_values.size());
+  double running_max = 0.0;
+  for (size_t rank = 0; rank < order.size(); ++rank)
+  {
+    const auto remaining = static_cast<double>(order.size() - rank);
+    running_max = std::max(running_max, std::min(1.0, remaining * p_values[order[rank]]));
+    adjusted[order[rank]] = running_max;
+  }
+  return adjusted;
+}
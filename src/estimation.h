@@ -0,0 +1,60 @@
+#pragma once
+#include <string>  // for string
+#include <vector>  // for vector
+
+// How raw per-size throughput samples are cleaned before aggregation
+enum class SampleFilter
+{
+  legacy, // drop the first and the highest sample (pre-estimation behaviour)
+  none,   // keep everything
+  mad,    // reject |modified z-score| > 3.5 (median absolute deviation)
+  iqr     // reject values outside [Q1 - 1.5 IQR, Q3 + 1.5 IQR]
+};
+
+struct ConfidenceInterval
+{
+  double estimate = 0;
+  double lower = 0;
+  double upper = 0;
+};
+
+// Robust summary of one direction's samples, written to the JSON "estimates" object
+struct SampleEstimate
+{
+  ConfidenceInterval median;
+  ConfidenceInterval p90;
+  double trimmed_mean = 0;
+  int samples = 0;
+};
+
+// Two-sided Mann-Whitney U test of two independent samples (normal approximation with tie
+// correction); used to compare repeated runs of two scenarios
+struct RankTest
+{
+  double u = 0;        // U statistic of the first sample
+  double z = 0;        // standardized U, positive when the first sample tends to be larger
+  double p_value = 1;  // 1 when either sample is empty or every value is tied
+};
+
+inline constexpr int kBootstrapResamples = 2000;
+inline constexpr double kBootstrapConfidence = 0.95;
+inline constexpr double kTrimFraction = 0.1;
+
+// Sample filtering and estimation
+auto parse_sample_filter(const std::string& name, SampleFilter& filter) -> bool;
+auto sample_filter_name(SampleFilter filter) -> const char*;
+auto filter_samples(std::vector<double> samples, SampleFilter filter) -> std::vector<double>;
+// Per-sample keep flags of filter_samples, for callers that must keep rejected samples around
+auto sample_filter_mask(const std::vector<double>& samples, SampleFilter filter)
+    -> std::vector<bool>;
+auto trimmed_mean(const std::vector<double>& samples, double trim_fraction = kTrimFraction)
+    -> double;
+auto bootstrap_ci(const std::vector<double>& samples, double quantile,
+                  int resamples = kBootstrapResamples,
+                  double confidence = kBootstrapConfidence) -> ConfidenceInterval;
+auto estimate_samples(const std::vector<double>& samples) -> SampleEstimate;
+auto mann_whitney_test(const std::vector<double>& first, const std::vector<double>& second)
+    -> RankTest;
+// Holm step-down adjustment of a family of p-values (same order); an adjusted p below alpha
+// keeps the family-wise error rate at alpha however many tests the family holds
+auto holm_adjust(const std::vector<double>& p_values) -> std::vector<double>;
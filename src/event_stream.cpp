@@ -0,0 +1,283 @@
+#include "event_stream.h"
+#include <errno.h>          // for errno, EINTR
+#include <unistd.h>         // for write, ssize_t
+#include <atomic>           // for atomic
+#include <chrono>           // for system_clock, duration
+#include <cmath>            // for isfinite
+#include <csignal>          // for signal, SIGPIPE, SIG_IGN
+#include <cstdio>           // for snprintf
+#include <cstring>          // for memcpy, strerror, strlen
+#include <iostream>         // for operator<<, basic_ostream, cerr
+#include <mutex>            // for mutex, lock_guard
+#include <ratio>            // for milli
+#include "json_helpers.h"   // for compute_result_metrics
+#include "test_plan.h"      // for TestPlan, PlanPhase, direction_name
+#include "types.h"          // for TestResults, ResultMetrics
+#include "utf8.h"           // for utf8_prefix_length
+
+// The longest event (a phase with a full-width label) fits well within this; an event that does
+// not fit is dropped rather than written as a broken line
+constexpr size_t kEventBufferSize = 512;
+constexpr size_t kMaxLabelBytes = 64;
+constexpr int kNumLatencyStats = 5; // min, max, mean, median, jitter (see measure_latency)
+
+namespace
+{
+std::atomic<int> g_event_fd{-1};
+std::mutex g_event_mutex; // one write(2) per event keeps lines whole across transfer threads
+
+// Fixed-capacity line builder; overflow is sticky and checked once in finish()
+class EventLine
+{
+public:
+  explicit EventLine(const char* event)
+  {
+    raw("{\"event\":\"");
+    raw(event);
+    raw("\"");
+  }
+
+  void str(const char* name, const char* value)
+  {
+    key(name);
+    raw("\"");
+    const size_t length = utf8_prefix_length(value, std::strlen(value), kMaxLabelBytes);
+    for (size_t index = 0; index < length; ++index)
+    {
+      const auto c = static_cast<unsigned char>(value[index]);
+      char escaped[8] = {static_cast<char>(c), '\0'};
+      if (c == '"' || c == '\\')
+      {
+        escaped[0] = '\\';
+        escaped[1] = static_cast<char>(c);
+        escaped[2] = '\0';
+      }
+      else if (c < 0x20)
+      {
+        std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+      }
+      raw(escaped);
+    }
+    raw("\"");
+  }
+
+  // NaN and infinity are not JSON numbers
+  void num(const char* name, double value)
+  {
+    key(name);
+    char text[32];
+    if (!std::isfinite(value))
+    {
+      raw("null");
+      return;
+    }
+    std::snprintf(text, sizeof(text), "%.3f", value);
+    raw(text);
+  }
+
+  void integer(const char* name, long long value)
+  {
+    key(name);
+    char text[24];
+    std::snprintf(text, sizeof(text), "%lld", value);
+    raw(text);
+  }
+
+  auto finish() -> bool
+  {
+    raw("}\n");
+    return !overflowed_;
+  }
+
+  auto data() const -> const char* { return data_; }
+  auto size() const -> size_t { return size_; }
+
+private:
+  void raw(const char* text)
+  {
+    const size_t length = std::strlen(text);
+    if (overflowed_ || length > kEventBufferSize - size_)
+    {
+      overflowed_ = true;
+      return;
+    }
+    std::memcpy(data_ + size_, text, length);
+    size_ += length;
+  }
+
+  void key(const char* name)
+  {
+    raw(",\"");
+    raw(name);
+    raw("\":");
+  }
+
+  char data_[kEventBufferSize];
+  size_t size_ = 0;
+  bool overflowed_ = false;
+};
+
+auto wall_time_ms() -> double
+{
+  return std::chrono::duration<double, std::milli>(
+             std::chrono::system_clock::now().time_since_epoch())
+      .count();
+}
+
+// A reader that went away (closed pipe, full disk) turns the stream off instead of failing the run
+void write_event(EventLine& line)
+{
+  if (!line.finish())
+  {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(g_event_mutex);
+  const int fd = g_event_fd.load();
+  if (fd < 0)
+  {
+    return;
+  }
+  size_t written = 0;
+  while (written < line.size())
+  {
+    const ssize_t result = ::write(fd, line.data() + written, line.size() - written);
+    if (result < 0 && errno == EINTR)
+    {
+      continue;
+    }
+    if (result <= 0)
+    {
+      std::cerr << "[WARN] Event stream closed: write to fd " << fd
+                << " failed: " << std::strerror(errno) << std::endl;
+      g_event_fd = -1;
+      return;
+    }
+    written += static_cast<size_t>(result);
+  }
+}
+} // namespace
+
+auto open_event_stream(int fd) -> void
+{
+  // Without this a consumer closing the pipe kills the process on the next event
+  std::signal(SIGPIPE, SIG_IGN);
+  g_event_fd = fd;
+}
+
+auto close_event_stream() -> void
+{
+  std::lock_guard<std::mutex> lock(g_event_mutex);
+  g_event_fd = -1;
+}
+
+auto event_stream_enabled() -> bool
+{
+  return g_event_fd.load() >= 0;
+}
+
+auto emit_start_event(const TestPlan& plan) -> void
+{
+  if (!event_stream_enabled())
+  {
+    return;
+  }
+  EventLine line("start");
+  line.num("wall_ms", wall_time_ms());
+  line.str("plan", plan.name.c_str());
+  line.integer("phases", static_cast<long long>(plan.phases.size()));
+  write_event(line);
+}
+
+auto emit_latency_event(const std::vector<double>& latency_stats) -> void
+{
+  if (!event_stream_enabled() || latency_stats.size() < kNumLatencyStats)
+  {
+    return;
+  }
+  EventLine line("latency");
+  line.num("wall_ms", wall_time_ms());
+  line.num("min_ms", latency_stats[0]);
+  line.num("max_ms", latency_stats[1]);
+  line.num("mean_ms", latency_stats[2]);
+  line.num("median_ms", latency_stats[3]);
+  line.num("jitter_ms", latency_stats[4]);
+  write_event(line);
+}
+
+auto emit_sample_event(const SampleRecord& record) -> void
+{
+  if (!event_stream_enabled())
+  {
+    return;
+  }
+  EventLine line("sample");
+  line.integer("phase", record.phase);
+  line.str("direction", direction_name(record.direction));
+  line.num("wall_ms", record.wall_ms);
+  line.num("duration_ms", record.duration_ms);
+  line.integer("bytes", record.bytes);
+  line.num("mbps", record.mbps);
+  line.integer("connection", record.connection_id);
+  line.str("status", record.status == SampleStatus::failed ? "failed" : "ok");
+  write_event(line);
+}
+
+auto emit_phase_event(size_t phase_index, const PlanPhase& phase, const SampleStore& samples,
+                      double elapsed_ms) -> void
+{
+  if (!event_stream_enabled())
+  {
+    return;
+  }
+  const SampleSpan kept = samples.phase_samples(phase_index);
+  double sum = 0;
+  for (const double mbps : kept)
+  {
+    sum += mbps;
+  }
+  // Dropped records of every phase share one table per direction; count this phase's in place
+  const SampleColumns& dropped = samples.dropped(phase.direction);
+  long long failed = 0;
+  long long rejected = 0;
+  for (size_t index = 0; index < dropped.size(); ++index)
+  {
+    if (dropped.phase()[index] != phase_index)
+    {
+      continue;
+    }
+    ++(dropped.status()[index] == static_cast<uint8_t>(SampleStatus::failed) ? failed
+                                                                              : rejected);
+  }
+  EventLine line("phase");
+  line.integer("phase", static_cast<long long>(phase_index));
+  line.str("label", phase.label.c_str());
+  line.str("direction", direction_name(phase.direction));
+  line.num("elapsed_ms", elapsed_ms);
+  line.integer("kept", static_cast<long long>(kept.size()));
+  line.integer("failed", failed);
+  line.integer("rejected", rejected);
+  line.num("mean_mbps", kept.empty() ? 0.0 : sum / static_cast<double>(kept.size()));
+  write_event(line);
+}
+
+auto emit_summary_event(const TestResults& results) -> void
+{
+  if (!event_stream_enabled())
+  {
+    return;
+  }
+  const ResultMetrics metrics = compute_result_metrics(results);
+  EventLine line("summary");
+  line.num("wall_ms", wall_time_ms());
+  line.str("colo", results.colo.c_str());
+  line.num("latency_ms", metrics.latency_avg);
+  line.num("jitter_ms", metrics.jitter);
+  line.num("download_50pct", metrics.download_50pct);
+  line.num("download_90pct", metrics.download_90pct);
+  line.num("upload_50pct", metrics.upload_50pct);
+  line.num("upload_90pct", metrics.upload_90pct);
+  line.integer("download_failures", results.download_failures);
+  line.integer("upload_failures", results.upload_failures);
+  line.num("total_time_ms", results.total_time_ms);
+  write_event(line);
+}
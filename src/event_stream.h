@@ -0,0 +1,24 @@
+#pragma once
+#include <stddef.h>       // for size_t
+#include <vector>         // for vector
+#include "sample_store.h" // for SampleRecord, SampleStore
+
+struct TestResults;
+struct TestPlan;
+struct PlanPhase;
+
+// NDJSON event stream: one JSON object per line, written with a single write(2) as each event
+// happens, so a collector sees samples live and keeps everything up to a killed run.
+//   {"event":"start"...}  {"event":"latency"...}  {"event":"sample"...} per measured transfer
+//   {"event":"phase"...} after each plan phase    {"event":"summary"...} at the end of a run
+// Events are formatted into a fixed stack buffer, so the per-sample path never allocates. All
+// emitters are no-ops while the stream is closed and are safe to call from transfer threads.
+auto open_event_stream(int fd) -> void;
+auto close_event_stream() -> void;
+auto event_stream_enabled() -> bool;
+auto emit_start_event(const TestPlan& plan) -> void;
+auto emit_latency_event(const std::vector<double>& latency_stats) -> void;
+auto emit_sample_event(const SampleRecord& record) -> void;
+auto emit_phase_event(size_t phase_index, const PlanPhase& phase, const SampleStore& samples,
+                      double elapsed_ms) -> void;
+auto emit_summary_event(const TestResults& results) -> void;
@@ -0,0 +1,115 @@
+#include "histogram.h"
+#include <algorithm>        // for min
+#include <cmath>            // for log, pow, ceil, isfinite
+#include "stats_kernels.h"  // for log_bucket_indices
+
+constexpr size_t kIndexBatch = 256;
+
+auto LogHistogram::inv_log_growth() -> double
+{
+  static const double inverse = 1.0 / std::log(kGrowth);
+  return inverse;
+}
+
+auto LogHistogram::bucket_index(double value) -> size_t
+{
+  if (!(value > kLowest))
+  {
+    return 0;
+  }
+  // Same expression as kernels::log_bucket_indices so batch and single records agree exactly
+  const double position = std::log(value / kLowest) * inv_log_growth();
+  const auto index = static_cast<size_t>(position);
+  return index < kBuckets ? index : kBuckets - 1;
+}
+
+// Geometric midpoint of the bucket
+auto LogHistogram::bucket_value(size_t index) -> double
+{
+  return kLowest * std::pow(kGrowth, static_cast<double>(index) + 0.5);
+}
+
+void LogHistogram::record(double value)
+{
+  if (!std::isfinite(value))
+  {
+    return;
+  }
+  ++counts_[bucket_index(value)];
+  ++total_;
+}
+
+// Batched: vectorisable index pass, then the scatter increment
+void LogHistogram::record_all(const std::vector<double>& values)
+{
+  uint16_t indices[kIndexBatch];
+  for (size_t offset = 0; offset < values.size(); offset += kIndexBatch)
+  {
+    const size_t batch = std::min(kIndexBatch, values.size() - offset);
+    stats::kernels::log_bucket_indices(values.data() + offset, batch, kLowest, inv_log_growth(),
+                                       static_cast<uint16_t>(kBuckets - 1), indices);
+    for (size_t index = 0; index < batch; ++index)
+    {
+      if (std::isfinite(values[offset + index]))
+      {
+        ++counts_[indices[index]];
+        ++total_;
+      }
+    }
+  }
+}
+
+void LogHistogram::merge(const LogHistogram& other)
+{
+  for (size_t index = 0; index < kBuckets; ++index)
+  {
+    counts_[index] += other.counts_[index];
+  }
+  total_ += other.total_;
+}
+
+void LogHistogram::merge(const SparseBuckets& sparse)
+{
+  for (const auto& bucket : sparse)
+  {
+    if (bucket.first < kBuckets)
+    {
+      counts_[bucket.first] += bucket.second;
+      total_ += bucket.second;
+    }
+  }
+}
+
+// Nearest-rank quantile, reported as the midpoint of the bucket holding that rank
+auto LogHistogram::quantile(double quantile) const -> double
+{
+  if (total_ == 0)
+  {
+    return 0.0;
+  }
+  auto rank = static_cast<uint64_t>(std::ceil(quantile * static_cast<double>(total_)));
+  rank = rank == 0 ? 1 : rank;
+  uint64_t seen = 0;
+  for (size_t index = 0; index < kBuckets; ++index)
+  {
+    seen += counts_[index];
+    if (seen >= rank)
+    {
+      return bucket_value(index);
+    }
+  }
+  return bucket_value(kBuckets - 1);
+}
+
+auto LogHistogram::sparse() const -> SparseBuckets
+{
+  SparseBuckets buckets;
+  for (size_t index = 0; index < kBuckets; ++index)
+  {
+    if (counts_[index] != 0)
+    {
+      buckets.emplace_back(static_cast<uint32_t>(index), counts_[index]);
+    }
+  }
+  return buckets;
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include <stddef.h>  // for size_t
+#include <stdint.h>  // for uint32_t, uint64_t
+#include <array>     // for array
+#include <utility>   // for pair
+#include <vector>    // for vector
+
+// Fixed-memory, log-bucketed histogram (HDR-style) for latency (ms) and throughput (Mbps).
+// Every histogram shares one bucket scheme, so merging is an exact per-bucket sum and fleet-wide
+// quantiles never need the raw samples. Relative error of a reported quantile is under 1%.
+class LogHistogram
+{
+public:
+  static constexpr double kLowest = 1e-3;  // values at or below land in bucket 0
+  static constexpr double kGrowth = 1.02;  // bucket upper bound / lower bound
+  static constexpr size_t kBuckets = 1048; // covers kLowest .. ~1e6
+  // Written next to the buckets; files with another scheme are not merged
+  static constexpr const char* kScheme = "log1.02@0.001";
+
+  using SparseBuckets = std::vector<std::pair<uint32_t, uint32_t>>; // (bucket index, count)
+
+  void record(double value);
+  void record_all(const std::vector<double>& values);
+  void merge(const LogHistogram& other);
+  void merge(const SparseBuckets& sparse);
+  auto quantile(double quantile) const -> double;
+  auto total() const -> uint64_t { return total_; }
+  auto sparse() const -> SparseBuckets;
+
+  static auto bucket_index(double value) -> size_t;
+  static auto inv_log_growth() -> double;
+  static auto bucket_value(size_t index) -> double;
+
+private:
+  std::array<uint32_t, kBuckets> counts_{};
+  uint64_t total_ = 0;
+};
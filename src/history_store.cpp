@@ -0,0 +1,738 @@
+#include "history_store.h"
+#include <fcntl.h>          // for open, O_RDWR, O_CREAT, O_DIRECTORY
+#include <sys/file.h>       // for flock, LOCK_EX
+#include <sys/stat.h>       // for fstat
+#include <time.h>           // for strptime, mktime, localtime_r, gmtime_r, strftime
+#include <unistd.h>         // for pread, pwrite, ftruncate, fdatasync, fsync, close
+#include <yyjson.h>         // for yyjson_mut_doc, yyjson_mut_write
+#include <algorithm>        // for min, max, all_of
+#include <array>            // for array
+#include <chrono>           // for system_clock, duration_cast
+#include <cstdio>           // for remove
+#include <cstdlib>          // for free, strtoll
+#include <cstring>          // for memcpy, memcmp, strnlen
+#include <memory>           // for unique_ptr
+#include <ostream>          // for ostream
+#include <string>           // for string, to_string
+#include <utility>          // for move, make_pair
+#include <vector>           // for vector
+#include "json_helpers.h"   // for compute_result_metrics, add_str, add_num
+#include "mapped_file.h"    // for MappedFile
+#include "types.h"          // for TestResults, ResultMetrics, SummaryResult
+#include "utf8.h"           // for utf8_prefix_length
+#ifdef SPEEDCLOUDFLARE_WITH_ZSTD
+#include <zstd.h>           // for ZSTD_compress, ZSTD_decompress, ZSTD_isError
+#endif
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "history_store.cpp writes little-endian records; add byte swapping for this target"
+#endif
+
+// Layout (little-endian, so a store copied off the router reads anywhere):
+//   file header  "SCFHIST1" | u16 version | u16 record size | u32 reserved
+//   block        u32 "BLK1" | u16 flags | u16 record count | i64 min wall_ms | i64 max wall_ms
+//                | u32 stored payload bytes | u32 CRC-32 of the stored payload | payload
+// The block headers double as the time index: readers hop from header to header and only touch
+// payloads whose [min, max] overlaps the query. The last block stays raw and grows in place
+// (payload first, then its header) until it holds kRecordsPerBlock records; with zstd it is
+// then compressed, so only full blocks are ever compressed.
+constexpr char kHistoryMagic[8] = {'S', 'C', 'F', 'H', 'I', 'S', 'T', '1'};
+constexpr uint16_t kHistoryVersion = 1;
+constexpr size_t kFileHeaderSize = 16;
+constexpr uint32_t kBlockMagic = 0x314B4C42; // "BLK1"
+constexpr size_t kBlockHeaderSize = 32;
+constexpr uint16_t kRecordsPerBlock = 64;
+constexpr uint16_t kBlockZstd = 1U << 0;
+constexpr int kZstdLevel = 9;
+// Fixed text field widths (bytes, NUL-padded, not NUL-terminated when full)
+constexpr size_t kColoWidth = 8;
+constexpr size_t kCityWidth = 32;
+constexpr size_t kIpWidth = 48;
+constexpr size_t kPlanWidth = 16;
+constexpr size_t kRecordSize = 8 + 7 * 8 + 6 * 8 + 2 * 4 + 2 * 2 + kColoWidth + kCityWidth +
+                               kIpWidth + kPlanWidth;
+constexpr size_t kTimeLabelLen = 32;
+
+namespace
+{
+// zlib-compatible CRC-32; pass the previous value to continue a running checksum
+auto crc32_update(uint32_t crc, const char* data, size_t size) -> uint32_t
+{
+  static const std::array<uint32_t, 256> kTable = []
+  {
+    std::array<uint32_t, 256> table{};
+    for (uint32_t index = 0; index < table.size(); ++index)
+    {
+      uint32_t value = index;
+      for (int bit = 0; bit < 8; ++bit)
+      {
+        value = (value & 1U) != 0 ? 0xEDB88320U ^ (value >> 1) : value >> 1;
+      }
+      table[index] = value;
+    }
+    return table;
+  }();
+  crc = ~crc;
+  for (size_t index = 0; index < size; ++index)
+  {
+    crc = kTable[(crc ^ static_cast<unsigned char>(data[index])) & 0xFFU] ^ (crc >> 8);
+  }
+  return ~crc;
+}
+
+struct BlockHeader
+{
+  uint16_t flags = 0;
+  uint16_t count = 0;
+  int64_t min_wall_ms = 0;
+  int64_t max_wall_ms = 0;
+  uint32_t stored_bytes = 0;
+  uint32_t crc = 0;
+};
+
+template <typename T>
+void put(char*& cursor, const T& value)
+{
+  std::memcpy(cursor, &value, sizeof(T));
+  cursor += sizeof(T);
+}
+
+template <typename T>
+void get(const char*& cursor, T& value)
+{
+  std::memcpy(&value, cursor, sizeof(T));
+  cursor += sizeof(T);
+}
+
+// Truncates on a UTF-8 character boundary so exported text stays valid JSON
+void put_text(char*& cursor, const std::string& text, size_t width)
+{
+  const size_t length = utf8_prefix_length(text.data(), text.size(), width);
+  std::memset(cursor, 0, width);
+  std::memcpy(cursor, text.data(), length);
+  cursor += width;
+}
+
+void get_text(const char*& cursor, std::string& text, size_t width)
+{
+  text.assign(cursor, strnlen(cursor, width));
+  cursor += width;
+}
+
+void encode_block_header(const BlockHeader& header, char* out)
+{
+  put(out, kBlockMagic);
+  put(out, header.flags);
+  put(out, header.count);
+  put(out, header.min_wall_ms);
+  put(out, header.max_wall_ms);
+  put(out, header.stored_bytes);
+  put(out, header.crc);
+}
+
+auto decode_block_header(const char* in, BlockHeader& header) -> bool
+{
+  uint32_t magic = 0;
+  get(in, magic);
+  get(in, header.flags);
+  get(in, header.count);
+  get(in, header.min_wall_ms);
+  get(in, header.max_wall_ms);
+  get(in, header.stored_bytes);
+  get(in, header.crc);
+  return magic == kBlockMagic && header.count > 0 && header.count <= kRecordsPerBlock &&
+         (header.flags & ~kBlockZstd) == 0 &&
+         ((header.flags & kBlockZstd) != 0 || header.stored_bytes == header.count * kRecordSize);
+}
+
+void encode_file_header(char* out)
+{
+  std::memcpy(out, kHistoryMagic, sizeof(kHistoryMagic));
+  out += sizeof(kHistoryMagic);
+  put(out, kHistoryVersion);
+  put(out, static_cast<uint16_t>(kRecordSize));
+  put(out, static_cast<uint32_t>(0));
+}
+
+auto valid_file_header(const char* in) -> bool
+{
+  if (std::memcmp(in, kHistoryMagic, sizeof(kHistoryMagic)) != 0)
+  {
+    return false;
+  }
+  in += sizeof(kHistoryMagic);
+  uint16_t version = 0;
+  uint16_t record_size = 0;
+  get(in, version);
+  get(in, record_size);
+  return version == kHistoryVersion && record_size == kRecordSize;
+}
+
+void encode_record(const HistoryRecord& record, char* out)
+{
+  put(out, record.wall_ms);
+  for (const double value : {record.total_time_ms, record.latency_ms, record.jitter_ms,
+                             record.download_mbps, record.upload_mbps, record.download_median,
+                             record.upload_median})
+  {
+    put(out, value);
+  }
+  for (const ConfidenceInterval* interval : {&record.download_ci, &record.upload_ci})
+  {
+    put(out, interval->estimate);
+    put(out, interval->lower);
+    put(out, interval->upper);
+  }
+  put(out, record.download_samples);
+  put(out, record.upload_samples);
+  put(out, record.download_failures);
+  put(out, record.upload_failures);
+  put_text(out, record.colo, kColoWidth);
+  put_text(out, record.city, kCityWidth);
+  put_text(out, record.ip, kIpWidth);
+  put_text(out, record.plan, kPlanWidth);
+}
+
+auto decode_record(const char* in) -> HistoryRecord
+{
+  HistoryRecord record;
+  get(in, record.wall_ms);
+  for (double* value : {&record.total_time_ms, &record.latency_ms, &record.jitter_ms,
+                        &record.download_mbps, &record.upload_mbps, &record.download_median,
+                        &record.upload_median})
+  {
+    get(in, *value);
+  }
+  for (ConfidenceInterval* interval : {&record.download_ci, &record.upload_ci})
+  {
+    get(in, interval->estimate);
+    get(in, interval->lower);
+    get(in, interval->upper);
+  }
+  get(in, record.download_samples);
+  get(in, record.upload_samples);
+  get(in, record.download_failures);
+  get(in, record.upload_failures);
+  get_text(in, record.colo, kColoWidth);
+  get_text(in, record.city, kCityWidth);
+  get_text(in, record.ip, kIpWidth);
+  get_text(in, record.plan, kPlanWidth);
+  return record;
+}
+
+// Closes the descriptor (releasing any flock held on it) on scope exit
+class ScopedFd
+{
+public:
+  explicit ScopedFd(int fd) : fd_(fd) {}
+  ~ScopedFd()
+  {
+    if (fd_ >= 0)
+    {
+      close(fd_);
+    }
+  }
+  ScopedFd(const ScopedFd&) = delete;
+  auto operator=(const ScopedFd&) -> ScopedFd& = delete;
+  auto get() const -> int { return fd_; }
+
+private:
+  int fd_;
+};
+
+auto pread_all(int fd, char* data, size_t size, off_t offset) -> bool
+{
+  return pread(fd, data, size, offset) == static_cast<ssize_t>(size);
+}
+
+auto pwrite_all(int fd, const char* data, size_t size, off_t offset) -> bool
+{
+  return pwrite(fd, data, size, offset) == static_cast<ssize_t>(size);
+}
+
+#ifdef SPEEDCLOUDFLARE_WITH_ZSTD
+// Sealing journal next to the store: u64 offset of the block being sealed, then the sealed block
+// (header and compressed payload). It is durable before the store is touched, so a power cut
+// while the block is rewritten in place is finished by the next append.
+auto seal_journal_path(const std::string& path) -> std::string
+{
+  return path + ".seal";
+}
+
+// Makes a create or unlink in the store's directory durable
+auto fsync_parent_dir(const std::string& path) -> bool
+{
+  const size_t slash = path.rfind('/');
+  const std::string dir = slash == std::string::npos ? "."
+                          : slash == 0               ? "/"
+                                                     : path.substr(0, slash);
+  const ScopedFd dir_fd(open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC));
+  return dir_fd.get() >= 0 && fsync(dir_fd.get()) == 0;
+}
+
+// Overwrites the raw block at block_offset with the sealed one and cuts the raw tail off. A no-op
+// when the block is already there, so a stale journal cannot cut off blocks appended since.
+auto write_sealed_block(int fd, off_t block_offset, const std::vector<char>& block) -> bool
+{
+  std::vector<char> current(block.size());
+  struct stat file_stat
+  {
+  };
+  if (fstat(fd, &file_stat) != 0)
+  {
+    return false;
+  }
+  const off_t block_end = block_offset + static_cast<off_t>(block.size());
+  if (file_stat.st_size < block_end)
+  {
+    return false; // the raw block is always longer than its sealed form
+  }
+  if (pread_all(fd, current.data(), current.size(), block_offset) && current == block)
+  {
+    return true;
+  }
+  return pwrite_all(fd, block.data(), block.size(), block_offset) &&
+         ftruncate(fd, block_end) == 0 && fdatasync(fd) == 0;
+}
+
+// Finishes a seal that a crash interrupted. A journal that is short or fails its CRC was cut off
+// before the store was touched, so it is only removed.
+auto replay_seal_journal(int fd, const std::string& path) -> bool
+{
+  const std::string journal_path = seal_journal_path(path);
+  std::vector<char> block;
+  uint64_t block_offset = 0;
+  {
+    const ScopedFd journal(open(journal_path.c_str(), O_RDONLY | O_CLOEXEC));
+    if (journal.get() < 0)
+    {
+      return true;
+    }
+    struct stat journal_stat
+    {
+    };
+    char header_bytes[kBlockHeaderSize];
+    BlockHeader header;
+    const auto journal_size = static_cast<off_t>(sizeof(block_offset) + kBlockHeaderSize);
+    bool complete = fstat(journal.get(), &journal_stat) == 0 &&
+                    journal_stat.st_size >= journal_size &&
+                    pread_all(journal.get(), reinterpret_cast<char*>(&block_offset),
+                              sizeof(block_offset), 0) &&
+                    pread_all(journal.get(), header_bytes, kBlockHeaderSize,
+                              sizeof(block_offset)) &&
+                    decode_block_header(header_bytes, header) &&
+                    journal_stat.st_size == journal_size + static_cast<off_t>(header.stored_bytes);
+    if (complete)
+    {
+      block.resize(kBlockHeaderSize + header.stored_bytes);
+      complete = pread_all(journal.get(), block.data(), block.size(), sizeof(block_offset)) &&
+                 crc32_update(0, block.data() + kBlockHeaderSize, header.stored_bytes) ==
+                     header.crc;
+    }
+    // A store shorter than the sealed block is not the one the journal was written for
+    struct stat store_stat
+    {
+    };
+    complete = complete && fstat(fd, &store_stat) == 0 &&
+               store_stat.st_size >= static_cast<off_t>(block_offset + block.size());
+    if (complete && !write_sealed_block(fd, static_cast<off_t>(block_offset), block))
+    {
+      return false;
+    }
+  }
+  return std::remove(journal_path.c_str()) == 0 && fsync_parent_dir(path);
+}
+
+// Replaces the full raw block at block_offset (the last one) with its zstd form, in place: only
+// that block is rewritten, through the sealing journal. Readers racing the rewrite may skip the
+// block once as corrupt; the store itself is never left without it.
+auto seal_last_block(int fd, const std::string& path, off_t block_offset,
+                     const BlockHeader& raw_header) -> bool
+{
+  std::vector<char> payload(raw_header.stored_bytes);
+  if (!pread_all(fd, payload.data(), payload.size(),
+                 block_offset + static_cast<off_t>(kBlockHeaderSize)))
+  {
+    return false;
+  }
+  std::vector<char> block(kBlockHeaderSize + ZSTD_compressBound(payload.size()));
+  const size_t compressed_size =
+      ZSTD_compress(block.data() + kBlockHeaderSize, block.size() - kBlockHeaderSize,
+                    payload.data(), payload.size(), kZstdLevel);
+  if (ZSTD_isError(compressed_size) || compressed_size >= payload.size())
+  {
+    return true; // incompressible: keeping the raw block is just as valid
+  }
+  block.resize(kBlockHeaderSize + compressed_size);
+  BlockHeader sealed = raw_header;
+  sealed.flags = kBlockZstd;
+  sealed.stored_bytes = static_cast<uint32_t>(compressed_size);
+  sealed.crc = crc32_update(0, block.data() + kBlockHeaderSize, compressed_size);
+  encode_block_header(sealed, block.data());
+
+  const std::string journal_path = seal_journal_path(path);
+  {
+    const ScopedFd journal(
+        open(journal_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644));
+    const auto offset = static_cast<uint64_t>(block_offset);
+    const bool written =
+        journal.get() >= 0 &&
+        pwrite_all(journal.get(), reinterpret_cast<const char*>(&offset), sizeof(offset), 0) &&
+        pwrite_all(journal.get(), block.data(), block.size(), sizeof(offset)) &&
+        fsync(journal.get()) == 0;
+    if (!written)
+    {
+      (void)std::remove(journal_path.c_str());
+      return false;
+    }
+  }
+  // The journal's directory entry must be durable before the store is overwritten, and its
+  // removal before anything is appended after the sealed block
+  return fsync_parent_dir(path) && write_sealed_block(fd, block_offset, block) &&
+         std::remove(journal_path.c_str()) == 0 && fsync_parent_dir(path);
+}
+#endif
+
+auto block_payload(const BlockHeader& header, const char* stored, std::vector<char>& scratch,
+                   std::string& error) -> const char*
+{
+  if ((header.flags & kBlockZstd) == 0)
+  {
+    return stored;
+  }
+#ifdef SPEEDCLOUDFLARE_WITH_ZSTD
+  scratch.resize(header.count * kRecordSize);
+  const size_t size = ZSTD_decompress(scratch.data(), scratch.size(), stored, header.stored_bytes);
+  if (ZSTD_isError(size) || size != scratch.size())
+  {
+    error = "corrupt compressed block";
+    return nullptr;
+  }
+  return scratch.data();
+#else
+  (void)stored;
+  (void)scratch;
+  error = "store has zstd-compressed blocks; rebuild with -DENABLE_ZSTD=ON to read them";
+  return nullptr;
+#endif
+}
+
+auto format_local_time(int64_t wall_ms, const char* format) -> std::string
+{
+  const time_t seconds = static_cast<time_t>(wall_ms / 1000);
+  struct tm time_info
+  {
+  };
+  localtime_r(&seconds, &time_info);
+  std::array<char, kTimeLabelLen> label{};
+  (void)strftime(label.data(), label.size(), format, &time_info);
+  return label.data();
+}
+} // namespace
+
+auto make_history_record(const TestResults& results) -> HistoryRecord
+{
+  const ResultMetrics metrics = compute_result_metrics(results);
+  const int64_t now_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                             std::chrono::system_clock::now().time_since_epoch())
+                             .count();
+  HistoryRecord record;
+  record.wall_ms = now_ms - static_cast<int64_t>(results.total_time_ms);
+  record.total_time_ms = results.total_time_ms;
+  record.latency_ms = metrics.latency_avg;
+  record.jitter_ms = metrics.jitter;
+  record.download_mbps = metrics.download_90pct;
+  record.upload_mbps = metrics.upload_90pct;
+  record.download_median = metrics.download_50pct;
+  record.upload_median = metrics.upload_50pct;
+  record.download_ci = results.download_estimate.p90;
+  record.upload_ci = results.upload_estimate.p90;
+  record.download_samples = static_cast<uint32_t>(
+      results.samples.direction_samples(TransferDirection::download).size());
+  record.upload_samples =
+      static_cast<uint32_t>(results.samples.direction_samples(TransferDirection::upload).size());
+  record.download_failures = static_cast<uint16_t>(std::min(results.download_failures, 0xFFFF));
+  record.upload_failures = static_cast<uint16_t>(std::min(results.upload_failures, 0xFFFF));
+  record.colo = results.colo;
+  record.city = results.city;
+  record.ip = results.ip;
+  record.plan = results.test_plan;
+  return record;
+}
+
+auto append_history_record(const std::string& path, const HistoryRecord& record,
+                           std::string& error) -> bool
+{
+  // Appenders (daemon, one-off runs, cron) serialise on a sidecar lock, which also covers the
+  // sealing journal
+  const ScopedFd lock_fd(open((path + ".lock").c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644));
+  if (lock_fd.get() < 0 || flock(lock_fd.get(), LOCK_EX) != 0)
+  {
+    error = "cannot lock " + path + ".lock";
+    return false;
+  }
+  const ScopedFd fd(open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644));
+  struct stat file_stat
+  {
+  };
+  if (fd.get() < 0 || fstat(fd.get(), &file_stat) != 0)
+  {
+    error = "cannot open " + path;
+    return false;
+  }
+#ifdef SPEEDCLOUDFLARE_WITH_ZSTD
+  if (!replay_seal_journal(fd.get(), path) || fstat(fd.get(), &file_stat) != 0)
+  {
+    error = "cannot finish interrupted block compression of " + path;
+    return false;
+  }
+#endif
+  off_t file_size = file_stat.st_size;
+  char file_header[kFileHeaderSize];
+  if (file_size < static_cast<off_t>(kFileHeaderSize))
+  {
+    encode_file_header(file_header);
+    if (ftruncate(fd.get(), 0) != 0 || !pwrite_all(fd.get(), file_header, kFileHeaderSize, 0))
+    {
+      error = "cannot write " + path;
+      return false;
+    }
+    file_size = kFileHeaderSize;
+  }
+  else if (!pread_all(fd.get(), file_header, kFileHeaderSize, 0) ||
+           !valid_file_header(file_header))
+  {
+    error = path + " is not a history store of this version";
+    return false;
+  }
+  // Walk the block chain to the last intact block. What follows it may only be dropped when it
+  // is a torn append: a header whose payload runs past EOF, or no more than one block header and
+  // record in all. Headers carry no checksum, so a bad header with blocks after it is corruption
+  // and truncating there would delete every later block
+  off_t offset = kFileHeaderSize;
+  off_t last_offset = -1;
+  BlockHeader last;
+  char header_bytes[kBlockHeaderSize];
+  while (offset + static_cast<off_t>(kBlockHeaderSize) <= file_size)
+  {
+    if (!pread_all(fd.get(), header_bytes, kBlockHeaderSize, offset))
+    {
+      error = "cannot read " + path;
+      return false;
+    }
+    BlockHeader header;
+    const bool decoded = decode_block_header(header_bytes, header);
+    if (!decoded || offset + static_cast<off_t>(kBlockHeaderSize + header.stored_bytes) > file_size)
+    {
+      const bool torn_tail = decoded || file_size - offset <=
+                                            static_cast<off_t>(kBlockHeaderSize + kRecordSize);
+      if (!torn_tail)
+      {
+        error = "corrupt block header at offset " + std::to_string(offset) + " of " + path +
+                "; not appending, as that would drop the blocks after it";
+        return false;
+      }
+      break;
+    }
+    last_offset = offset;
+    last = header;
+    offset += static_cast<off_t>(kBlockHeaderSize + header.stored_bytes);
+  }
+  if (offset != file_size && ftruncate(fd.get(), offset) != 0)
+  {
+    error = "cannot truncate torn tail of " + path;
+    return false;
+  }
+  char record_bytes[kRecordSize];
+  encode_record(record, record_bytes);
+  const bool extend_last =
+      last_offset >= 0 && (last.flags & kBlockZstd) == 0 && last.count < kRecordsPerBlock;
+  if (extend_last)
+  {
+    // Payload first: until the header is rewritten the new bytes are an ignorable torn tail
+    if (!pwrite_all(fd.get(), record_bytes, kRecordSize, offset) || fdatasync(fd.get()) != 0)
+    {
+      error = "cannot append to " + path;
+      return false;
+    }
+    ++last.count;
+    last.min_wall_ms = std::min(last.min_wall_ms, record.wall_ms);
+    last.max_wall_ms = std::max(last.max_wall_ms, record.wall_ms);
+    last.stored_bytes += kRecordSize;
+    last.crc = crc32_update(last.crc, record_bytes, kRecordSize);
+    encode_block_header(last, header_bytes);
+    if (!pwrite_all(fd.get(), header_bytes, kBlockHeaderSize, last_offset) ||
+        fdatasync(fd.get()) != 0)
+    {
+      error = "cannot append to " + path;
+      return false;
+    }
+  }
+  else
+  {
+    last = BlockHeader{0, 1, record.wall_ms, record.wall_ms, kRecordSize,
+                       crc32_update(0, record_bytes, kRecordSize)};
+    last_offset = offset;
+    char block[kBlockHeaderSize + kRecordSize];
+    encode_block_header(last, block);
+    std::memcpy(block + kBlockHeaderSize, record_bytes, kRecordSize);
+    if (!pwrite_all(fd.get(), block, sizeof(block), offset) || fdatasync(fd.get()) != 0)
+    {
+      error = "cannot append to " + path;
+      return false;
+    }
+  }
+#ifdef SPEEDCLOUDFLARE_WITH_ZSTD
+  if (last.count == kRecordsPerBlock && !seal_last_block(fd.get(), path, last_offset, last))
+  {
+    error = "cannot compress full block of " + path + " (record was appended)";
+    return false;
+  }
+#endif
+  return true;
+}
+
+auto read_history_records(const std::string& path, const HistoryRange& range,
+                          std::vector<HistoryRecord>& records, std::string& error) -> bool
+{
+  MappedFile file;
+  if (!file.open(path))
+  {
+    error = "cannot open " + path;
+    return false;
+  }
+  const char* data = file.data();
+  const size_t size = file.size();
+  if (size < kFileHeaderSize || !valid_file_header(data))
+  {
+    error = path + " is not a history store of this version";
+    return false;
+  }
+  std::vector<char> scratch;
+  size_t corrupt_blocks = 0;
+  size_t offset = kFileHeaderSize;
+  BlockHeader header;
+  while (offset + kBlockHeaderSize <= size && decode_block_header(data + offset, header) &&
+         offset + kBlockHeaderSize + header.stored_bytes <= size)
+  {
+    const char* stored = data + offset + kBlockHeaderSize;
+    offset += kBlockHeaderSize + header.stored_bytes;
+    if (header.max_wall_ms < range.since_ms || header.min_wall_ms > range.until_ms)
+    {
+      continue;
+    }
+    if (crc32_update(0, stored, header.stored_bytes) != header.crc)
+    {
+      ++corrupt_blocks;
+      continue;
+    }
+    const char* payload = block_payload(header, stored, scratch, error);
+    if (payload == nullptr)
+    {
+      return false;
+    }
+    for (uint16_t index = 0; index < header.count; ++index)
+    {
+      HistoryRecord record = decode_record(payload + index * kRecordSize);
+      if (record.wall_ms >= range.since_ms && record.wall_ms <= range.until_ms)
+      {
+        records.push_back(std::move(record));
+      }
+    }
+  }
+  if (corrupt_blocks > 0)
+  {
+    error = std::to_string(corrupt_blocks) + " corrupt block(s) in " + path + " skipped";
+  }
+  return true;
+}
+
+auto parse_history_time(const std::string& text, int64_t& wall_ms) -> bool
+{
+  if (!text.empty() && std::all_of(text.begin(), text.end(),
+                                   [](char digit) { return digit >= '0' && digit <= '9'; }))
+  {
+    wall_ms = std::strtoll(text.c_str(), nullptr, 10) * 1000;
+    return true;
+  }
+  for (const char* format : {"%Y-%m-%dT%H:%M:%S", "%Y-%m-%dT%H:%M", "%Y-%m-%d"})
+  {
+    struct tm time_info
+    {
+    };
+    const char* end = strptime(text.c_str(), format, &time_info);
+    if (end != nullptr && *end == '\0')
+    {
+      time_info.tm_isdst = -1;
+      wall_ms = static_cast<int64_t>(mktime(&time_info)) * 1000;
+      return true;
+    }
+  }
+  return false;
+}
+
+auto history_summary_result(const HistoryRecord& record) -> SummaryResult
+{
+  SummaryResult result{};
+  result.file = format_local_time(record.wall_ms, "%Y-%m-%d %H:%M");
+  result.server_city = record.city.empty() ? record.colo : record.city;
+  result.ip = record.ip;
+  result.latency = record.latency_ms;
+  result.jitter = record.jitter_ms;
+  result.download = record.download_mbps;
+  result.upload = record.upload_mbps;
+  result.download_ci = record.download_ci;
+  result.upload_ci = record.upload_ci;
+  return result;
+}
+
+auto export_history_json(const std::vector<HistoryRecord>& records, std::ostream& out) -> bool
+{
+  out << "{\"records\":[";
+  bool first = true;
+  for (const HistoryRecord& record : records)
+  {
+    yyjson_mut_doc* doc = yyjson_mut_doc_new(nullptr);
+    if (doc == nullptr)
+    {
+      return false;
+    }
+    yyjson_mut_val* obj = yyjson_mut_obj(doc);
+    yyjson_mut_obj_add_int(doc, obj, "wall_ms", record.wall_ms);
+    add_str(doc, obj, "time", format_local_time(record.wall_ms, "%Y-%m-%dT%H:%M:%S%z"));
+    add_str(doc, obj, "colo", record.colo);
+    add_str(doc, obj, "city", record.city);
+    add_str(doc, obj, "ip", record.ip);
+    add_str(doc, obj, "plan", record.plan);
+    add_num(doc, obj, "latency_ms", record.latency_ms);
+    add_num(doc, obj, "jitter_ms", record.jitter_ms);
+    add_num(doc, obj, "download_90pct", record.download_mbps);
+    add_num(doc, obj, "upload_90pct", record.upload_mbps);
+    add_num(doc, obj, "download_50pct", record.download_median);
+    add_num(doc, obj, "upload_50pct", record.upload_median);
+    for (const auto& [key, interval] : {std::make_pair("download_90pct_ci", &record.download_ci),
+                                        std::make_pair("upload_90pct_ci", &record.upload_ci)})
+    {
+      yyjson_mut_val* arr = yyjson_mut_obj_add_arr(doc, obj, key);
+      yyjson_mut_arr_add_real(doc, arr, interval->estimate);
+      yyjson_mut_arr_add_real(doc, arr, interval->lower);
+      yyjson_mut_arr_add_real(doc, arr, interval->upper);
+    }
+    yyjson_mut_obj_add_uint(doc, obj, "download_samples", record.download_samples);
+    yyjson_mut_obj_add_uint(doc, obj, "upload_samples", record.upload_samples);
+    yyjson_mut_obj_add_uint(doc, obj, "download_failures", record.download_failures);
+    yyjson_mut_obj_add_uint(doc, obj, "upload_failures", record.upload_failures);
+    add_num(doc, obj, "total_time_ms", record.total_time_ms);
+    yyjson_mut_doc_set_root(doc, obj);
+    std::unique_ptr<char, decltype(&free)> json(yyjson_mut_write(doc, 0, nullptr), &free);
+    yyjson_mut_doc_free(doc);
+    if (!json)
+    {
+      continue; // NaN figures from a failed run; the record stays in the store
+    }
+    out << (first ? "" : ",") << json.get();
+    first = false;
+  }
+  out << "]}\n";
+  return static_cast<bool>(out);
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include <stdint.h>      // for int64_t, uint32_t, uint16_t
+#include <iosfwd>        // for ostream
+#include <limits>        // for numeric_limits
+#include <string>        // for string
+#include <vector>        // for vector
+#include "estimation.h"  // for ConfidenceInterval
+
+struct TestResults;
+struct SummaryResult;
+
+// Headline figures of one run, as kept in the history store (fixed on-disk layout)
+struct HistoryRecord
+{
+  int64_t wall_ms = 0; // run start, Unix epoch milliseconds
+  double total_time_ms = 0;
+  double latency_ms = 0;
+  double jitter_ms = 0;
+  double download_mbps = 0; // p90, as in the result JSON
+  double upload_mbps = 0;
+  double download_median = 0;
+  double upload_median = 0;
+  ConfidenceInterval download_ci, upload_ci; // bootstrap CI of the p90
+  uint32_t download_samples = 0;
+  uint32_t upload_samples = 0;
+  uint16_t download_failures = 0;
+  uint16_t upload_failures = 0;
+  std::string colo, city, ip, plan; // truncated to their fixed field widths on append
+};
+
+struct HistoryRange
+{
+  int64_t since_ms = std::numeric_limits<int64_t>::min();
+  int64_t until_ms = std::numeric_limits<int64_t>::max();
+};
+
+auto make_history_record(const TestResults& results) -> HistoryRecord;
+// Appends to the open block at the end of the store, creating the store if needed
+auto append_history_record(const std::string& path, const HistoryRecord& record,
+                           std::string& error) -> bool;
+// Records with since_ms <= wall_ms <= until_ms, in append order; blocks entirely outside the
+// range are skipped by their header without being read or decompressed
+auto read_history_records(const std::string& path, const HistoryRange& range,
+                          std::vector<HistoryRecord>& records, std::string& error) -> bool;
+// "1760000000" (Unix seconds), "2026-10-18" or "2026-10-18T14:30[:00]" (local time)
+auto parse_history_time(const std::string& text, int64_t& wall_ms) -> bool;
+auto history_summary_result(const HistoryRecord& record) -> SummaryResult;
+// {"records":[...]} on out, one record at a time
+auto export_history_json(const std::vector<HistoryRecord>& records, std::ostream& out) -> bool;
@@ -0,0 +1,420 @@
+#include "host_monitor.h"
+#include <fcntl.h>    // for open, O_RDONLY, O_CLOEXEC
+#include <stdint.h>   // for uint64_t
+#include <unistd.h>   // for pread, close
+#include <algorithm>  // for max, min
+#include <array>      // for array
+#include <chrono>     // for steady_clock, duration
+#include <cstdlib>    // for strtod, strtol, strtoull
+#include <cstring>    // for strncmp, strstr
+#include <memory>     // for unique_ptr, make_unique
+#include <utility>    // for move, swap
+#include "interface_counters.h" // for InterfaceCounters, InterfaceBytes
+#include "sysinfo.h"  // for get_time_ms
+
+namespace
+{
+constexpr size_t kProcBufferBytes = 32768; // cpu lines of /proc/stat for ~500 cores
+constexpr double kPercent = 100.0;
+constexpr double kUsPerMs = 1000.0;
+constexpr double kBitsPerByte = 8.0;
+constexpr double kMbpsPerBitPerMs = 1e-3; // bits per ms to Mbps
+constexpr int kNumPressureSources = 3;
+// A phase is flagged saturated when, averaged over it, any of these is reached
+constexpr double kSaturatedBusyPct = 90.0;         // all cores together
+constexpr double kSaturatedCoreBusyPct = 95.0;     // the busiest core (a single-threaded loop)
+constexpr double kSaturatedCoreSoftirqPct = 50.0;  // NIC interrupt work pinned to one core
+constexpr double kSaturatedStealPct = 10.0;        // hypervisor took the vCPUs
+constexpr double kSaturatedCpuPressurePct = 50.0;  // runnable tasks waited for a CPU
+constexpr double kSaturatedMemoryPressurePct = 20.0;
+
+const char* const kPressurePaths[kNumPressureSources] = {
+    "/proc/pressure/cpu", "/proc/pressure/io", "/proc/pressure/memory"};
+
+// Jiffies of one /proc/stat cpu line
+struct CpuTimes
+{
+  uint64_t user = 0; // user + nice
+  uint64_t system = 0;
+  uint64_t irq = 0;
+  uint64_t softirq = 0;
+  uint64_t steal = 0;
+  uint64_t idle = 0; // idle + iowait
+  auto total() const -> uint64_t { return user + system + irq + softirq + steal + idle; }
+};
+
+struct Counters
+{
+  double time_ms = 0;
+  CpuTimes all;
+  std::vector<CpuTimes> cores;
+  double load1 = 0;
+  int runnable = 0;
+  uint64_t pressure_us[kNumPressureSources] = {0, 0, 0};
+  bool pressure_valid[kNumPressureSources] = {false, false, false};
+};
+
+auto next_number(const char*& cursor) -> uint64_t
+{
+  char* end = nullptr;
+  const uint64_t value = std::strtoull(cursor, &end, 10);
+  cursor = end;
+  return value;
+}
+
+auto share_pct(uint64_t part, uint64_t whole) -> double
+{
+  return whole == 0 ? 0.0 : static_cast<double>(part) * kPercent / static_cast<double>(whole);
+}
+
+// The files stay open for the whole run and are re-read from offset 0, so a tick costs one
+// pread per file and no path lookups
+class ProcSources
+{
+public:
+  ProcSources()
+      : stat_fd_(open("/proc/stat", O_RDONLY | O_CLOEXEC)),
+        loadavg_fd_(open("/proc/loadavg", O_RDONLY | O_CLOEXEC))
+  {
+    for (int index = 0; index < kNumPressureSources; ++index)
+    {
+      pressure_fds_[index] = open(kPressurePaths[index], O_RDONLY | O_CLOEXEC);
+    }
+  }
+  ~ProcSources()
+  {
+    for (const int fd : {stat_fd_, loadavg_fd_, pressure_fds_[0], pressure_fds_[1],
+                         pressure_fds_[2]})
+    {
+      if (fd >= 0)
+      {
+        close(fd);
+      }
+    }
+  }
+  ProcSources(const ProcSources&) = delete;
+  auto operator=(const ProcSources&) -> ProcSources& = delete;
+
+  auto usable() const -> bool { return stat_fd_ >= 0; }
+
+  auto read(Counters& counters) -> void
+  {
+    counters.time_ms = get_time_ms();
+    read_stat(counters);
+    if (read_text(loadavg_fd_))
+    {
+      // "0.52 0.58 0.59 2/345 12345"
+      const char* cursor = buffer_.data();
+      char* end = nullptr;
+      counters.load1 = std::strtod(cursor, &end);
+      cursor = end;
+      (void)std::strtod(cursor, &end);
+      cursor = end;
+      (void)std::strtod(cursor, &end);
+      counters.runnable = static_cast<int>(std::strtol(end, nullptr, 10));
+    }
+    for (int index = 0; index < kNumPressureSources; ++index)
+    {
+      // First line: "some avg10=0.00 avg60=0.00 avg300=0.00 total=12345"
+      const char* total = read_text(pressure_fds_[index]) ? std::strstr(buffer_.data(), "total=")
+                                                          : nullptr;
+      counters.pressure_valid[index] = total != nullptr;
+      if (total != nullptr)
+      {
+        total += 6;
+        counters.pressure_us[index] = next_number(total);
+      }
+    }
+  }
+
+private:
+  auto read_text(int fd) -> bool
+  {
+    if (fd < 0)
+    {
+      return false;
+    }
+    const ssize_t received = pread(fd, buffer_.data(), buffer_.size() - 1, 0);
+    buffer_[received > 0 ? static_cast<size_t>(received) : 0] = '\0';
+    return received > 0;
+  }
+
+  // "cpu  user nice system idle iowait irq softirq steal ..." then one "cpuN ..." line per core;
+  // parsing stops at the first line after them (or at a line cut off by the buffer)
+  auto read_stat(Counters& counters) -> void
+  {
+    counters.cores.clear();
+    if (!read_text(stat_fd_))
+    {
+      return;
+    }
+    const char* cursor = buffer_.data();
+    while (std::strncmp(cursor, "cpu", 3) == 0)
+    {
+      const char* line_end = std::strchr(cursor, '\n');
+      if (line_end == nullptr)
+      {
+        break;
+      }
+      const bool aggregate = cursor[3] == ' ';
+      cursor += 3;
+      if (!aggregate)
+      {
+        (void)next_number(cursor); // core index
+      }
+      CpuTimes times;
+      times.user = next_number(cursor);
+      times.user += next_number(cursor);
+      times.system = next_number(cursor);
+      times.idle = next_number(cursor);
+      times.idle += next_number(cursor);
+      times.irq = next_number(cursor);
+      times.softirq = next_number(cursor);
+      times.steal = next_number(cursor);
+      if (aggregate)
+      {
+        counters.all = times;
+      }
+      else
+      {
+        counters.cores.push_back(times);
+      }
+      cursor = line_end + 1;
+    }
+  }
+
+  int stat_fd_;
+  int loadavg_fd_;
+  int pressure_fds_[kNumPressureSources] = {-1, -1, -1};
+  std::array<char, kProcBufferBytes> buffer_{};
+};
+
+auto diff_sample(const Counters& before, const Counters& after) -> HostSample
+{
+  HostSample sample;
+  sample.start_ms = before.time_ms;
+  sample.end_ms = after.time_ms;
+  const uint64_t total = after.all.total() - before.all.total();
+  sample.user_pct = share_pct(after.all.user - before.all.user, total);
+  sample.system_pct = share_pct(after.all.system - before.all.system, total);
+  sample.softirq_pct = share_pct(after.all.softirq - before.all.softirq, total);
+  sample.steal_pct = share_pct(after.all.steal - before.all.steal, total);
+  sample.busy_pct = kPercent - share_pct(after.all.idle - before.all.idle, total);
+  // Cores that went offline in between make the lists differ; skip per-core values then
+  if (total > 0 && before.cores.size() == after.cores.size())
+  {
+    for (size_t core = 0; core < after.cores.size(); ++core)
+    {
+      const uint64_t core_total = after.cores[core].total() - before.cores[core].total();
+      sample.max_core_busy_pct =
+          std::max(sample.max_core_busy_pct,
+                   kPercent - share_pct(after.cores[core].idle - before.cores[core].idle,
+                                        core_total));
+      sample.max_core_softirq_pct = std::max(
+          sample.max_core_softirq_pct,
+          share_pct(after.cores[core].softirq - before.cores[core].softirq, core_total));
+    }
+  }
+  sample.load1 = after.load1;
+  sample.runnable = after.runnable;
+  const double elapsed_us = (after.time_ms - before.time_ms) * kUsPerMs;
+  double* const pressures[kNumPressureSources] = {
+      &sample.cpu_pressure_pct, &sample.io_pressure_pct, &sample.memory_pressure_pct};
+  for (int index = 0; index < kNumPressureSources; ++index)
+  {
+    if (before.pressure_valid[index] && after.pressure_valid[index] && elapsed_us > 0)
+    {
+      *pressures[index] = std::min(
+          kPercent, static_cast<double>(after.pressure_us[index] - before.pressure_us[index]) *
+                        kPercent / elapsed_us);
+    }
+  }
+  return sample;
+}
+
+auto summarise_phase(const std::string& name, double start_ms, double end_ms,
+                     const std::vector<HostSample>& samples) -> PhaseContention
+{
+  PhaseContention phase;
+  phase.name = name;
+  phase.wall_ms = end_ms - start_ms;
+  HostSample& usage = phase.usage;
+  double weight_sum = 0;
+  double pressure_weight_sum = 0;
+  double pressure_sums[kNumPressureSources] = {0, 0, 0};
+  for (const HostSample& sample : samples)
+  {
+    const double weight = std::min(end_ms, sample.end_ms) - std::max(start_ms, sample.start_ms);
+    if (weight <= 0)
+    {
+      continue;
+    }
+    ++phase.samples;
+    weight_sum += weight;
+    usage.busy_pct += sample.busy_pct * weight;
+    usage.user_pct += sample.user_pct * weight;
+    usage.system_pct += sample.system_pct * weight;
+    usage.softirq_pct += sample.softirq_pct * weight;
+    usage.steal_pct += sample.steal_pct * weight;
+    usage.max_core_busy_pct += sample.max_core_busy_pct * weight;
+    usage.max_core_softirq_pct += sample.max_core_softirq_pct * weight;
+    usage.load1 = std::max(usage.load1, sample.load1);
+    usage.runnable = std::max(usage.runnable, sample.runnable);
+    usage.rx_mbps = std::max(usage.rx_mbps, sample.rx_mbps);
+    usage.tx_mbps = std::max(usage.tx_mbps, sample.tx_mbps);
+    if (sample.cpu_pressure_pct >= 0)
+    {
+      pressure_weight_sum += weight;
+      pressure_sums[0] += sample.cpu_pressure_pct * weight;
+      pressure_sums[1] += std::max(0.0, sample.io_pressure_pct) * weight;
+      pressure_sums[2] += std::max(0.0, sample.memory_pressure_pct) * weight;
+    }
+  }
+  if (weight_sum <= 0)
+  {
+    return phase;
+  }
+  for (double* field : {&usage.busy_pct, &usage.user_pct, &usage.system_pct, &usage.softirq_pct,
+                        &usage.steal_pct, &usage.max_core_busy_pct, &usage.max_core_softirq_pct})
+  {
+    *field /= weight_sum;
+  }
+  if (pressure_weight_sum > 0)
+  {
+    usage.cpu_pressure_pct = pressure_sums[0] / pressure_weight_sum;
+    usage.io_pressure_pct = pressure_sums[1] / pressure_weight_sum;
+    usage.memory_pressure_pct = pressure_sums[2] / pressure_weight_sum;
+  }
+  const struct
+  {
+    const char* reason;
+    double value;
+    double limit;
+  } checks[] = {
+      {"cpu", usage.busy_pct, kSaturatedBusyPct},
+      {"core", usage.max_core_busy_pct, kSaturatedCoreBusyPct},
+      {"softirq", usage.max_core_softirq_pct, kSaturatedCoreSoftirqPct},
+      {"steal", usage.steal_pct, kSaturatedStealPct},
+      {"cpu_pressure", usage.cpu_pressure_pct, kSaturatedCpuPressurePct},
+      {"memory_pressure", usage.memory_pressure_pct, kSaturatedMemoryPressurePct},
+  };
+  for (const auto& check : checks)
+  {
+    if (check.value >= check.limit)
+    {
+      phase.saturation.emplace_back(check.reason);
+    }
+  }
+  return phase;
+}
+} // namespace
+
+HostMonitor::HostMonitor(bool enabled)
+{
+  if (!enabled)
+  {
+    return;
+  }
+  sampler_ = std::thread(
+      [this]()
+      {
+        ProcSources sources;
+        if (!sources.usable())
+        {
+          return; // not Linux, or /proc not mounted
+        }
+        Counters previous;
+        Counters current;
+        sources.read(previous);
+        std::unique_ptr<InterfaceCounters> link;
+        InterfaceBytes link_previous;
+        const auto interval = std::chrono::duration<double, std::milli>(kHostSampleIntervalMs);
+        auto next_tick = std::chrono::steady_clock::now();
+        std::unique_lock<std::mutex> lock(mutex_);
+        bool last_tick = false;
+        while (!last_tick)
+        {
+          next_tick += std::chrono::duration_cast<std::chrono::steady_clock::duration>(interval);
+          last_tick = wake_.wait_until(lock, next_tick, [this]() { return stopping_; });
+          const bool new_interface = !interface_.empty() && (!link || link->name() != interface_);
+          const std::string interface = interface_;
+          lock.unlock();
+          sources.read(current);
+          HostSample sample = diff_sample(previous, current);
+          std::swap(previous, current);
+          if (new_interface)
+          {
+            link = std::make_unique<InterfaceCounters>(interface);
+            link_previous = link->read();
+          }
+          else if (link)
+          {
+            const InterfaceBytes link_current = link->read();
+            const double elapsed_ms = link_current.time_ms - link_previous.time_ms;
+            if (link_previous.valid && link_current.valid && elapsed_ms > 0)
+            {
+              sample.rx_mbps = static_cast<double>(link_current.rx_bytes - link_previous.rx_bytes) *
+                               kBitsPerByte / elapsed_ms * kMbpsPerBitPerMs;
+              sample.tx_mbps = static_cast<double>(link_current.tx_bytes - link_previous.tx_bytes) *
+                               kBitsPerByte / elapsed_ms * kMbpsPerBitPerMs;
+            }
+            link_previous = link_current;
+          }
+          lock.lock();
+          samples_.push_back(sample);
+        }
+      });
+}
+
+HostMonitor::~HostMonitor() { stop(); }
+
+void HostMonitor::stop()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  wake_.notify_all();
+  if (sampler_.joinable())
+  {
+    sampler_.join();
+  }
+}
+
+void HostMonitor::watch_interface(const std::string& interface)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  interface_ = interface;
+}
+
+void HostMonitor::mark_phase(std::string name, double start_ms, double end_ms)
+{
+  phases_.push_back(PhaseWindow{std::move(name), start_ms, end_ms});
+}
+
+auto HostMonitor::take() -> std::vector<PhaseContention>
+{
+  stop(); // the final tick covers the tail of the last phase
+  std::vector<PhaseContention> contention;
+  if (samples_.empty())
+  {
+    return contention;
+  }
+  contention.reserve(phases_.size());
+  for (const PhaseWindow& window : phases_)
+  {
+    contention.push_back(summarise_phase(window.name, window.start_ms, window.end_ms, samples_));
+  }
+  phases_.clear();
+  return contention;
+}
+
+auto saturation_text(const PhaseContention& phase) -> std::string
+{
+  std::string text;
+  for (const std::string& reason : phase.saturation)
+  {
+    text += (text.empty() ? "" : ",") + reason;
+  }
+  return text;
+}
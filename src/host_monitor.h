@@ -0,0 +1,80 @@
+#pragma once
+#include <condition_variable>  // for condition_variable
+#include <mutex>               // for mutex
+#include <string>              // for string
+#include <thread>              // for thread
+#include <vector>              // for vector
+
+// Sampling period of the contention monitor; /proc/stat is re-read with one pread per tick
+inline constexpr double kHostSampleIntervalMs = 100.0;
+
+// Host-wide CPU usage between two ticks of the monitor. All percentages are of wall time; the
+// per-core ones come from the busiest core in that interval
+struct HostSample
+{
+  double start_ms = 0;
+  double end_ms = 0;
+  double busy_pct = 0; // all cores: user + system + irq + softirq + steal
+  double user_pct = 0;
+  double system_pct = 0;
+  double softirq_pct = 0;
+  double steal_pct = 0;
+  double max_core_busy_pct = 0;
+  double max_core_softirq_pct = 0;
+  double load1 = 0;
+  int runnable = 0;               // running tasks from /proc/loadavg
+  double cpu_pressure_pct = -1;   // PSI "some" stall share; -1 without /proc/pressure
+  double io_pressure_pct = -1;
+  double memory_pressure_pct = -1;
+  double rx_mbps = -1; // watched interface; -1 until watch_interface
+  double tx_mbps = -1;
+};
+
+// Host contention over one phase of a run: interval-weighted means of the samples overlapping it,
+// except load1, runnable, rx_mbps and tx_mbps, which are the highest seen
+struct PhaseContention
+{
+  std::string name; // same names as PhaseOverhead
+  double wall_ms = 0;
+  int samples = 0;
+  HostSample usage;
+  std::vector<std::string> saturation; // why the host was saturated; empty when it was not
+};
+
+// Background sampler of /proc/stat, /proc/loadavg and /proc/pressure/* while a test runs, so a
+// slow result can be told apart from a host that was busy with something else (or with itself)
+class HostMonitor
+{
+public:
+  explicit HostMonitor(bool enabled);
+  ~HostMonitor();
+  HostMonitor(const HostMonitor&) = delete;
+  auto operator=(const HostMonitor&) -> HostMonitor& = delete;
+
+  // Also samples this interface's byte counters from the next tick on
+  void watch_interface(const std::string& interface);
+  // Registers a phase by its get_time_ms window; summarised by take()
+  void mark_phase(std::string name, double start_ms, double end_ms);
+  // Stops sampling and returns one summary per marked phase, in marking order
+  auto take() -> std::vector<PhaseContention>;
+
+private:
+  struct PhaseWindow
+  {
+    std::string name;
+    double start_ms;
+    double end_ms;
+  };
+  void stop();
+
+  std::mutex mutex_; // guards samples_, stopping_ and interface_
+  std::condition_variable wake_;
+  bool stopping_ = false;
+  std::string interface_;
+  std::vector<HostSample> samples_;
+  std::vector<PhaseWindow> phases_;
+  std::thread sampler_;
+};
+
+// Comma-separated saturation reasons ("cpu,softirq") for log lines
+auto saturation_text(const PhaseContention& phase) -> std::string;
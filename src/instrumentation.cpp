@@ -0,0 +1,155 @@
+#include "instrumentation.h"
+#include <linux/perf_event.h> // for perf_event_attr, PERF_TYPE_HARDWARE, PERF_COUNT_HW_*
+#include <sys/syscall.h>      // for SYS_perf_event_open
+#include <unistd.h>           // for syscall, read, close
+#include <cerrno>             // for errno
+#include <cstring>            // for strerror
+#include <utility>            // for move
+#include "sysinfo.h"          // for get_time_ms
+
+constexpr double kMsPerSecond = 1000.0;
+constexpr double kUsPerMs = 1000.0;
+constexpr long kBytesPerKb = 1024;
+constexpr int kNumHardwareCounters = 3;
+
+namespace
+{
+// Counters opened once per process; inherit=1 makes them follow the transfer threads, and
+// user-space only keeps them usable under the default perf_event_paranoid=2
+struct PerfCounters
+{
+  int fds[kNumHardwareCounters] = {-1, -1, -1};
+  std::string source;
+
+  PerfCounters()
+  {
+    const uint64_t configs[kNumHardwareCounters] = {
+        PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES};
+    for (int index = 0; index < kNumHardwareCounters; ++index)
+    {
+      perf_event_attr attr{};
+      attr.type = PERF_TYPE_HARDWARE;
+      attr.size = sizeof(attr);
+      attr.config = configs[index];
+      attr.inherit = 1;
+      attr.exclude_kernel = 1;
+      attr.exclude_hv = 1;
+      fds[index] = static_cast<int>(
+          syscall(SYS_perf_event_open, &attr, 0, -1, -1, PERF_FLAG_FD_CLOEXEC));
+      if (fds[index] < 0)
+      {
+        // Containers, missing PMU (many router SoCs) or a stricter paranoid level
+        source = std::string("unavailable: perf_event_open: ") + std::strerror(errno);
+        close_all();
+        return;
+      }
+    }
+    source = "perf_event";
+  }
+
+  ~PerfCounters() { close_all(); }
+  PerfCounters(const PerfCounters&) = delete;
+  auto operator=(const PerfCounters&) -> PerfCounters& = delete;
+
+  void close_all()
+  {
+    for (int& fd : fds)
+    {
+      if (fd >= 0)
+      {
+        ::close(fd);
+        fd = -1;
+      }
+    }
+  }
+
+  auto read_all() const -> HardwareCounters
+  {
+    HardwareCounters counters;
+    uint64_t values[kNumHardwareCounters] = {0, 0, 0};
+    for (int index = 0; index < kNumHardwareCounters; ++index)
+    {
+      if (fds[index] < 0 || ::read(fds[index], &values[index], sizeof(uint64_t)) !=
+                                static_cast<ssize_t>(sizeof(uint64_t)))
+      {
+        return counters;
+      }
+    }
+    counters.valid = true;
+    counters.cycles = values[0];
+    counters.instructions = values[1];
+    counters.cache_misses = values[2];
+    return counters;
+  }
+};
+
+auto perf_counters() -> const PerfCounters&
+{
+  static const PerfCounters counters;
+  return counters;
+}
+
+auto timeval_ms(const timeval& value) -> double
+{
+  return static_cast<double>(value.tv_sec) * kMsPerSecond +
+         static_cast<double>(value.tv_usec) / kUsPerMs;
+}
+} // namespace
+
+OverheadRecorder::OverheadRecorder(bool enabled) : enabled_(enabled)
+{
+  if (enabled_)
+  {
+    enable_heap_counting();
+  }
+}
+
+auto OverheadRecorder::snapshot() -> Snapshot
+{
+  Snapshot state;
+  state.wall_ms = get_time_ms();
+  (void)getrusage(RUSAGE_SELF, &state.usage);
+  state.heap = heap_counters();
+  state.hardware = perf_counters().read_all();
+  return state;
+}
+
+void OverheadRecorder::begin()
+{
+  if (enabled_)
+  {
+    start_ = snapshot();
+  }
+}
+
+void OverheadRecorder::end(std::string name)
+{
+  if (!enabled_)
+  {
+    return;
+  }
+  const Snapshot stop = snapshot();
+  PhaseOverhead phase;
+  phase.name = std::move(name);
+  phase.wall_ms = stop.wall_ms - start_.wall_ms;
+  phase.cpu_user_ms = timeval_ms(stop.usage.ru_utime) - timeval_ms(start_.usage.ru_utime);
+  phase.cpu_system_ms = timeval_ms(stop.usage.ru_stime) - timeval_ms(start_.usage.ru_stime);
+  phase.peak_rss_delta_bytes = (stop.usage.ru_maxrss - start_.usage.ru_maxrss) * kBytesPerKb;
+  phase.allocations = stop.heap.allocations - start_.heap.allocations;
+  phase.allocated_bytes = stop.heap.allocated_bytes - start_.heap.allocated_bytes;
+  phase.voluntary_switches = stop.usage.ru_nvcsw - start_.usage.ru_nvcsw;
+  phase.involuntary_switches = stop.usage.ru_nivcsw - start_.usage.ru_nivcsw;
+  if (start_.hardware.valid && stop.hardware.valid)
+  {
+    phase.hardware.valid = true;
+    phase.hardware.cycles = stop.hardware.cycles - start_.hardware.cycles;
+    phase.hardware.instructions = stop.hardware.instructions - start_.hardware.instructions;
+    phase.hardware.cache_misses = stop.hardware.cache_misses - start_.hardware.cache_misses;
+  }
+  phases_.push_back(std::move(phase));
+}
+
+auto hardware_counter_source() -> const std::string&
+{
+  return perf_counters().source;
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include <stdint.h>        // for uint64_t
+#include <sys/resource.h>  // for rusage
+#include <string>          // for string
+#include <utility>         // for move
+#include <vector>          // for vector
+#include "memory_budget.h" // for HeapCounters
+
+// User-space hardware counters of this process; transfer threads are included once they exit
+struct HardwareCounters
+{
+  bool valid = false;
+  uint64_t cycles = 0;
+  uint64_t instructions = 0;
+  uint64_t cache_misses = 0;
+};
+
+// What the tool itself cost during one phase of a run
+struct PhaseOverhead
+{
+  std::string name; // "bootstrap", "latency", "download 10MB", ...
+  double wall_ms = 0;
+  double cpu_user_ms = 0;
+  double cpu_system_ms = 0;
+  long peak_rss_delta_bytes = 0; // growth of the peak resident set during the phase
+  uint64_t allocations = 0;      // operator new calls and their usable bytes
+  uint64_t allocated_bytes = 0;
+  long voluntary_switches = 0;
+  long involuntary_switches = 0;
+  HardwareCounters hardware;
+};
+
+// Collects one PhaseOverhead per begin()/end() pair; does nothing when disabled. Enabling it
+// turns on heap counting for the allocation columns
+class OverheadRecorder
+{
+public:
+  explicit OverheadRecorder(bool enabled);
+  void begin();
+  void end(std::string name);
+  auto take() -> std::vector<PhaseOverhead> { return std::move(phases_); }
+
+private:
+  struct Snapshot
+  {
+    double wall_ms = 0;
+    rusage usage{};
+    HeapCounters heap;
+    HardwareCounters hardware;
+  };
+  static auto snapshot() -> Snapshot;
+
+  bool enabled_;
+  Snapshot start_;
+  std::vector<PhaseOverhead> phases_;
+};
+
+// "perf_event" while hardware counters are read, otherwise why not ("unavailable: ...")
+auto hardware_counter_source() -> const std::string&;
@@ -0,0 +1,161 @@
+#include "interface_counters.h"
+#include <fcntl.h>      // for open, O_RDONLY, O_CLOEXEC
+#include <ifaddrs.h>    // for ifaddrs, getifaddrs, freeifaddrs
+#include <netdb.h>      // for getnameinfo, NI_MAXHOST, NI_NUMERICHOST
+#include <sys/socket.h> // for AF_INET, AF_INET6, sockaddr_in, sockaddr_in6
+#include <unistd.h>     // for pread, close
+#include <algorithm>    // for max
+#include <array>        // for array
+#include <cstdlib>      // for strtoull
+#include <cstring>      // for strchr, strncmp
+#include <utility>      // for move
+#include "sysinfo.h"    // for get_time_ms
+
+namespace
+{
+constexpr size_t kNetDevBufferBytes = 65536; // ~500 interfaces (container hosts with many veths)
+constexpr int kDefaultMtu = 1500;
+constexpr int kEthernetHeaderBytes = 14;     // counted by /proc/net/dev, FCS is not
+constexpr int kTcpIpHeaderBytes = 52;        // IPv4 + TCP with timestamps
+constexpr double kTlsRecordBytes = 16384.0;
+constexpr double kTlsRecordOverheadBytes = 22.0; // TLS 1.3: header, content type, AEAD tag
+constexpr double kBitsPerByte = 8.0;
+constexpr double kMsPerSecond = 1000.0;
+constexpr double kMbpsDivisor = 1e6;
+
+auto to_mbps(uint64_t bytes, double elapsed_ms) -> double
+{
+  if (elapsed_ms <= 0)
+  {
+    return 0.0;
+  }
+  return static_cast<double>(bytes) * kBitsPerByte / (elapsed_ms / kMsPerSecond) / kMbpsDivisor;
+}
+} // namespace
+
+InterfaceCounters::InterfaceCounters(std::string interface)
+    : interface_(std::move(interface)),
+      fd_(interface_.empty() ? -1 : open("/proc/net/dev", O_RDONLY | O_CLOEXEC))
+{
+  if (fd_ >= 0)
+  {
+    buffer_.resize(kNetDevBufferBytes);
+  }
+}
+
+InterfaceCounters::~InterfaceCounters()
+{
+  if (fd_ >= 0)
+  {
+    close(fd_);
+  }
+}
+
+// "  eth0: rx_bytes rx_packets errs drop fifo frame compressed multicast tx_bytes ..."
+auto InterfaceCounters::read() -> InterfaceBytes
+{
+  InterfaceBytes bytes;
+  bytes.time_ms = get_time_ms();
+  if (fd_ < 0)
+  {
+    return bytes;
+  }
+  const ssize_t received = pread(fd_, buffer_.data(), buffer_.size() - 1, 0);
+  buffer_[received > 0 ? static_cast<size_t>(received) : 0] = '\0';
+  for (const char* line = buffer_.data(); line != nullptr && *line != '\0';)
+  {
+    while (*line == ' ')
+    {
+      ++line;
+    }
+    const char* next = std::strchr(line, '\n');
+    if (std::strncmp(line, interface_.c_str(), interface_.size()) == 0 &&
+        line[interface_.size()] == ':')
+    {
+      const char* cursor = line + interface_.size() + 1;
+      char* end = nullptr;
+      bytes.rx_bytes = std::strtoull(cursor, &end, 10);
+      for (int field = 0; field < 8; ++field)
+      {
+        bytes.tx_bytes = std::strtoull(end, &end, 10);
+      }
+      bytes.valid = true;
+      break;
+    }
+    line = next != nullptr ? next + 1 : nullptr;
+  }
+  return bytes;
+}
+
+auto interface_for_address(const std::string& address) -> std::string
+{
+  std::string interface;
+  ifaddrs* addresses = nullptr;
+  if (address.empty() || getifaddrs(&addresses) != 0)
+  {
+    return interface;
+  }
+  for (const ifaddrs* entry = addresses; entry != nullptr && interface.empty();
+       entry = entry->ifa_next)
+  {
+    if (entry->ifa_addr == nullptr ||
+        (entry->ifa_addr->sa_family != AF_INET && entry->ifa_addr->sa_family != AF_INET6))
+    {
+      continue;
+    }
+    std::array<char, NI_MAXHOST> host{};
+    const socklen_t length = entry->ifa_addr->sa_family == AF_INET ? sizeof(sockaddr_in)
+                                                                   : sizeof(sockaddr_in6);
+    if (getnameinfo(entry->ifa_addr, length, host.data(), host.size(), nullptr, 0,
+                    NI_NUMERICHOST) != 0)
+    {
+      continue;
+    }
+    // Link-local IPv6 comes back as "fe80::1%eth0"; boost prints the same form
+    if (address == host.data())
+    {
+      interface = entry->ifa_name;
+    }
+  }
+  freeifaddrs(addresses);
+  return interface;
+}
+
+// Expected wire bytes are the HTTP bytes scaled by per-packet TCP/IP and Ethernet headers and
+// TLS record overhead; anything beyond that on the interface came from someone else.
+// Retransmissions and the TLS handshake are not modelled, so a clean run shows about 1%
+auto summarise_traffic(std::string name, TransferDirection direction, const InterfaceBytes& before,
+                       const InterfaceBytes& after, uint64_t application_bytes,
+                       int failed_transfers, int mtu) -> PhaseTraffic
+{
+  PhaseTraffic traffic;
+  traffic.name = std::move(name);
+  traffic.direction = direction;
+  traffic.application_bytes = application_bytes;
+  traffic.failed_transfers = failed_transfers;
+  traffic.wall_ms = after.time_ms - before.time_ms;
+  if (!before.valid || !after.valid)
+  {
+    return traffic;
+  }
+  const uint64_t received = after.rx_bytes - before.rx_bytes;
+  const uint64_t sent = after.tx_bytes - before.tx_bytes;
+  const bool is_upload = direction == TransferDirection::upload;
+  traffic.interface_bytes = is_upload ? sent : received;
+  traffic.reverse_bytes = is_upload ? received : sent;
+  traffic.interface_mbps = to_mbps(traffic.interface_bytes, traffic.wall_ms);
+  traffic.application_mbps = to_mbps(application_bytes, traffic.wall_ms);
+  const int link_mtu = mtu > kTcpIpHeaderBytes ? mtu : kDefaultMtu;
+  const double framing =
+      static_cast<double>(link_mtu + kEthernetHeaderBytes) /
+      static_cast<double>(link_mtu - kTcpIpHeaderBytes) *
+      (1.0 + kTlsRecordOverheadBytes / kTlsRecordBytes);
+  traffic.cross_checked = failed_transfers == 0;
+  if (traffic.cross_checked && traffic.interface_bytes > 0)
+  {
+    const double expected = static_cast<double>(application_bytes) * framing;
+    traffic.foreign_share =
+        std::max(0.0, 1.0 - expected / static_cast<double>(traffic.interface_bytes));
+  }
+  return traffic;
+}
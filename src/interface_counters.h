@@ -0,0 +1,62 @@
+#pragma once
+#include <stdint.h>      // for uint64_t
+#include <string>        // for string
+#include <vector>        // for vector
+#include "test_plan.h"   // for TransferDirection
+
+// Byte counters of one network interface at one get_time_ms instant
+struct InterfaceBytes
+{
+  bool valid = false;
+  double time_ms = 0;
+  uint64_t rx_bytes = 0;
+  uint64_t tx_bytes = 0;
+};
+
+// One interface's line of /proc/net/dev. The file stays open and is re-read from offset 0, so a
+// read costs one pread and no path lookup
+class InterfaceCounters
+{
+public:
+  explicit InterfaceCounters(std::string interface);
+  ~InterfaceCounters();
+  InterfaceCounters(const InterfaceCounters&) = delete;
+  auto operator=(const InterfaceCounters&) -> InterfaceCounters& = delete;
+
+  auto name() const -> const std::string& { return interface_; }
+  auto read() -> InterfaceBytes;
+
+private:
+  std::string interface_;
+  int fd_;
+  std::vector<char> buffer_;
+};
+
+// A transfer phase seen from the interface: what crossed the link against what the tool moved
+struct PhaseTraffic
+{
+  std::string name; // same names as PhaseOverhead
+  std::string interface;
+  TransferDirection direction = TransferDirection::download;
+  double wall_ms = 0;
+  uint64_t interface_bytes = 0;   // test direction: received for downloads, sent for uploads
+  uint64_t reverse_bytes = 0;     // the other direction (ACKs, requests)
+  uint64_t application_bytes = 0; // HTTP bytes the tool moved in the test direction, every
+                                  // transfer of the phase (warmup and failed ones) included
+  int failed_transfers = 0;       // warmup included
+  double interface_mbps = 0;
+  double application_mbps = 0;
+  double peak_interface_mbps = 0; // busiest monitor interval, 0 without samples
+  // Whether foreign_share was computed: both counter readings valid and no failed transfer. An
+  // aborted transfer leaves bytes in flight that reached the interface but were never read
+  bool cross_checked = false;
+  double foreign_share = 0;       // interface bytes beyond the tool's bytes plus framing, 0..1
+};
+
+// Interface holding this local IP address (getifaddrs); empty when none does
+auto interface_for_address(const std::string& address) -> std::string;
+// Compares counter readings taken around a phase with the bytes the tool transferred in it;
+// mtu sizes the expected TCP/IP and Ethernet framing (1500 when unknown)
+auto summarise_traffic(std::string name, TransferDirection direction, const InterfaceBytes& before,
+                       const InterfaceBytes& after, uint64_t application_bytes,
+                       int failed_transfers, int mtu) -> PhaseTraffic;
@@ -1,13 +1,26 @@
 #include "json_helpers.h"
 #include <stddef.h>    // for size_t
 #include <yyjson.h>    // for yyjson_mut_val, yyjson_mut_arr, yyjson_mut_obj...
-#include <algorithm>   // for sort
+#include <algorithm>   // for nth_element
 #include <cmath>       // for ceil
+#include <cstddef>     // for ptrdiff_t
+#include <cstdlib>     // for free
 #include <functional>  // for function
+#include <memory>      // for unique_ptr, make_unique
 #include <string>      // for string, allocator, basic_string
 #include <vector>      // for vector
-#include "types.h"     // for TestResults
+#include "estimation.h" // for SampleEstimate, kBootstrapConfidence
+#include "histogram.h" // for LogHistogram
+#include "host_monitor.h" // for PhaseContention, HostSample, kHostSampleIntervalMs
+#include "instrumentation.h" // for PhaseOverhead, hardware_counter_source
+#include "interface_counters.h" // for PhaseTraffic
+#include "memory_budget.h" // for JsonArenaLease, memory_budget_enabled, memory_budget_exceeded
+#include "sample_store.h" // for SampleStore, SampleSpan, SampleRecord
+#include "sysinfo.h"   // for HostTuning
+#include "test_plan.h" // for PlanPhase, TransferDirection, direction_name
+#include "types.h"     // for TestResults, ResultMetrics, PhaseResult
 
+constexpr double kPercentile50 = 0.5;
 constexpr double kPercentile90 = 0.9;
 
 // Modernized: braces, descriptive variable names, trailing return types, auto, nullptr, one
@@ -23,6 +36,70 @@ void add_num(yyjson_mut_doc* doc, yyjson_mut_val* obj, const char* key, double v
   yyjson_mut_obj_add_real(doc, obj, key, value);
 }
 
+// Sparse histogram as a flat [bucket, count, bucket, count, ...] array
+void add_histogram(yyjson_mut_doc* doc, yyjson_mut_val* obj, const char* key,
+                   const LogHistogram& histogram)
+{
+  yyjson_mut_val* arr = yyjson_mut_arr(doc);
+  for (const auto& bucket : histogram.sparse())
+  {
+    yyjson_mut_arr_add_uint(doc, arr, bucket.first);
+    yyjson_mut_arr_add_uint(doc, arr, bucket.second);
+  }
+  yyjson_mut_obj_add_val(doc, obj, key, arr);
+}
+
+// {"samples", "trimmed_mean", "median": [estimate, lower, upper], "p90": [...]}
+static void add_estimate(yyjson_mut_doc* doc, yyjson_mut_val* obj, const char* key,
+                         const SampleEstimate& estimate)
+{
+  yyjson_mut_val* est_obj = yyjson_mut_obj_add_obj(doc, obj, key);
+  yyjson_mut_obj_add_int(doc, est_obj, "samples", estimate.samples);
+  add_num(doc, est_obj, "trimmed_mean", estimate.trimmed_mean);
+  auto add_interval = [&](const char* name, const ConfidenceInterval& interval)
+  {
+    yyjson_mut_val* arr = yyjson_mut_arr(doc);
+    yyjson_mut_arr_add_real(doc, arr, interval.estimate);
+    yyjson_mut_arr_add_real(doc, arr, interval.lower);
+    yyjson_mut_arr_add_real(doc, arr, interval.upper);
+    yyjson_mut_obj_add_val(doc, est_obj, name, arr);
+  };
+  add_interval("median", estimate.median);
+  add_interval("p90", estimate.p90);
+}
+
+// Every transfer in start order as parallel arrays (one entry per sample):
+// {"t_ms", "wall_ms", "direction", "phase", "bytes", "duration_ms", "mbps", "connection", "status"}
+// t_ms is relative to the first transfer; status is "ok", "failed" or "rejected"
+static void add_sample_records(yyjson_mut_doc* doc, yyjson_mut_val* obj, const SampleStore& store)
+{
+  static constexpr const char* kStatusNames[] = {"ok", "failed", "rejected"};
+  const std::vector<SampleRecord> records = store.records_by_time();
+  const double origin_ms = records.empty() ? 0.0 : records.front().monotonic_ms;
+  yyjson_mut_val* records_obj = yyjson_mut_obj_add_obj(doc, obj, "samples");
+  yyjson_mut_val* t_arr = yyjson_mut_obj_add_arr(doc, records_obj, "t_ms");
+  yyjson_mut_val* wall_arr = yyjson_mut_obj_add_arr(doc, records_obj, "wall_ms");
+  yyjson_mut_val* direction_arr = yyjson_mut_obj_add_arr(doc, records_obj, "direction");
+  yyjson_mut_val* phase_arr = yyjson_mut_obj_add_arr(doc, records_obj, "phase");
+  yyjson_mut_val* bytes_arr = yyjson_mut_obj_add_arr(doc, records_obj, "bytes");
+  yyjson_mut_val* duration_arr = yyjson_mut_obj_add_arr(doc, records_obj, "duration_ms");
+  yyjson_mut_val* mbps_arr = yyjson_mut_obj_add_arr(doc, records_obj, "mbps");
+  yyjson_mut_val* connection_arr = yyjson_mut_obj_add_arr(doc, records_obj, "connection");
+  yyjson_mut_val* status_arr = yyjson_mut_obj_add_arr(doc, records_obj, "status");
+  for (const auto& record : records)
+  {
+    yyjson_mut_arr_add_real(doc, t_arr, record.monotonic_ms - origin_ms);
+    yyjson_mut_arr_add_real(doc, wall_arr, record.wall_ms);
+    yyjson_mut_arr_add_str(doc, direction_arr, direction_name(record.direction));
+    yyjson_mut_arr_add_uint(doc, phase_arr, record.phase);
+    yyjson_mut_arr_add_uint(doc, bytes_arr, record.bytes);
+    yyjson_mut_arr_add_real(doc, duration_arr, record.duration_ms);
+    yyjson_mut_arr_add_real(doc, mbps_arr, record.mbps);
+    yyjson_mut_arr_add_uint(doc, connection_arr, record.connection_id);
+    yyjson_mut_arr_add_str(doc, status_arr, kStatusNames[static_cast<int>(record.status)]);
+  }
+}
+
 // Overload for compatibility with output.cpp usage
 void add_str(yyjson_mut_doc* doc, yyjson_mut_val* obj, const char* key, const std::string& value)
 {
@@ -31,11 +108,171 @@ void add_str(yyjson_mut_doc* doc, yyjson_mut_val* obj, const char* key, const st
   yyjson_mut_obj_add_str(doc, obj, key, safe(value));
 }
 
+// "host_config": network stack and CPU frequency settings; unreadable values are left out
+static void add_host_config(yyjson_mut_doc* doc, yyjson_mut_val* obj, const HostTuning& tuning)
+{
+  yyjson_mut_val* config = yyjson_mut_obj_add_obj(doc, obj, "host_config");
+  auto add_known = [&](const char* key, const std::string& value)
+  {
+    if (!value.empty())
+    {
+      add_str(doc, config, key, value);
+    }
+  };
+  add_known("interface", tuning.interface);
+  if (tuning.link_speed_mbps > 0)
+  {
+    yyjson_mut_obj_add_int(doc, config, "link_speed_mbps", tuning.link_speed_mbps);
+  }
+  if (tuning.mtu > 0)
+  {
+    yyjson_mut_obj_add_int(doc, config, "mtu", tuning.mtu);
+  }
+  add_known("tcp_congestion_control", tuning.tcp_congestion_control);
+  add_known("tcp_rmem", tuning.tcp_rmem);
+  add_known("tcp_wmem", tuning.tcp_wmem);
+  add_known("cpu_governor", tuning.cpu_governor);
+  if (tuning.cpu_freq_khz > 0)
+  {
+    yyjson_mut_obj_add_int(doc, config, "cpu_freq_khz", tuning.cpu_freq_khz);
+  }
+}
+
+// "overhead": {"hardware_counters": source, "phases": [{...}]}; cycles/instructions/cache_misses
+// only where perf_event_open worked
+static void add_overhead(yyjson_mut_doc* doc, yyjson_mut_val* obj,
+                         const std::vector<PhaseOverhead>& phases)
+{
+  yyjson_mut_val* overhead_obj = yyjson_mut_obj_add_obj(doc, obj, "overhead");
+  yyjson_mut_obj_add_strcpy(doc, overhead_obj, "hardware_counters",
+                            hardware_counter_source().c_str());
+  yyjson_mut_val* phases_arr = yyjson_mut_obj_add_arr(doc, overhead_obj, "phases");
+  for (const PhaseOverhead& phase : phases)
+  {
+    yyjson_mut_val* entry = yyjson_mut_arr_add_obj(doc, phases_arr);
+    yyjson_mut_obj_add_strcpy(doc, entry, "name", phase.name.c_str());
+    add_num(doc, entry, "wall_ms", phase.wall_ms);
+    add_num(doc, entry, "cpu_user_ms", phase.cpu_user_ms);
+    add_num(doc, entry, "cpu_system_ms", phase.cpu_system_ms);
+    yyjson_mut_obj_add_int(doc, entry, "peak_rss_delta_bytes", phase.peak_rss_delta_bytes);
+    yyjson_mut_obj_add_uint(doc, entry, "allocations", phase.allocations);
+    yyjson_mut_obj_add_uint(doc, entry, "allocated_bytes", phase.allocated_bytes);
+    yyjson_mut_obj_add_int(doc, entry, "voluntary_ctx_switches", phase.voluntary_switches);
+    yyjson_mut_obj_add_int(doc, entry, "involuntary_ctx_switches", phase.involuntary_switches);
+    if (phase.hardware.valid)
+    {
+      yyjson_mut_obj_add_uint(doc, entry, "cycles", phase.hardware.cycles);
+      yyjson_mut_obj_add_uint(doc, entry, "instructions", phase.hardware.instructions);
+      yyjson_mut_obj_add_uint(doc, entry, "cache_misses", phase.hardware.cache_misses);
+    }
+  }
+}
+
+// "contention": {"interval_ms", "phases": [{...}]}; pressure fields only with /proc/pressure.
+// Left out when the monitor had no samples
+static void add_contention(yyjson_mut_doc* doc, yyjson_mut_val* obj,
+                           const std::vector<PhaseContention>& phases)
+{
+  if (phases.empty())
+  {
+    return;
+  }
+  yyjson_mut_val* contention_obj = yyjson_mut_obj_add_obj(doc, obj, "contention");
+  add_num(doc, contention_obj, "interval_ms", kHostSampleIntervalMs);
+  yyjson_mut_val* phases_arr = yyjson_mut_obj_add_arr(doc, contention_obj, "phases");
+  for (const PhaseContention& phase : phases)
+  {
+    const HostSample& usage = phase.usage;
+    yyjson_mut_val* entry = yyjson_mut_arr_add_obj(doc, phases_arr);
+    yyjson_mut_obj_add_strcpy(doc, entry, "name", phase.name.c_str());
+    add_num(doc, entry, "wall_ms", phase.wall_ms);
+    yyjson_mut_obj_add_int(doc, entry, "samples", phase.samples);
+    add_num(doc, entry, "cpu_busy_pct", usage.busy_pct);
+    add_num(doc, entry, "cpu_user_pct", usage.user_pct);
+    add_num(doc, entry, "cpu_system_pct", usage.system_pct);
+    add_num(doc, entry, "cpu_softirq_pct", usage.softirq_pct);
+    add_num(doc, entry, "cpu_steal_pct", usage.steal_pct);
+    add_num(doc, entry, "max_core_busy_pct", usage.max_core_busy_pct);
+    add_num(doc, entry, "max_core_softirq_pct", usage.max_core_softirq_pct);
+    add_num(doc, entry, "load1", usage.load1);
+    yyjson_mut_obj_add_int(doc, entry, "runnable", usage.runnable);
+    if (usage.cpu_pressure_pct >= 0)
+    {
+      add_num(doc, entry, "cpu_pressure_pct", usage.cpu_pressure_pct);
+      add_num(doc, entry, "io_pressure_pct", usage.io_pressure_pct);
+      add_num(doc, entry, "memory_pressure_pct", usage.memory_pressure_pct);
+    }
+    yyjson_mut_obj_add_bool(doc, entry, "saturated", !phase.saturation.empty());
+    yyjson_mut_val* reasons = yyjson_mut_obj_add_arr(doc, entry, "saturation");
+    for (const std::string& reason : phase.saturation)
+    {
+      yyjson_mut_arr_add_strcpy(doc, reasons, reason.c_str());
+    }
+  }
+}
+
+// "traffic": interface counters against the tool's own bytes, one entry per transfer phase.
+// Left out when the interface counters could not be read
+static void add_traffic(yyjson_mut_doc* doc, yyjson_mut_val* obj,
+                        const std::vector<PhaseTraffic>& phases)
+{
+  if (phases.empty() || phases.front().interface.empty())
+  {
+    return;
+  }
+  yyjson_mut_val* traffic_obj = yyjson_mut_obj_add_obj(doc, obj, "traffic");
+  yyjson_mut_obj_add_strcpy(doc, traffic_obj, "interface", phases.front().interface.c_str());
+  yyjson_mut_val* phases_arr = yyjson_mut_obj_add_arr(doc, traffic_obj, "phases");
+  for (const PhaseTraffic& phase : phases)
+  {
+    yyjson_mut_val* entry = yyjson_mut_arr_add_obj(doc, phases_arr);
+    yyjson_mut_obj_add_strcpy(doc, entry, "name", phase.name.c_str());
+    add_num(doc, entry, "wall_ms", phase.wall_ms);
+    yyjson_mut_obj_add_uint(doc, entry, "interface_bytes", phase.interface_bytes);
+    yyjson_mut_obj_add_uint(doc, entry, "reverse_bytes", phase.reverse_bytes);
+    yyjson_mut_obj_add_uint(doc, entry, "application_bytes", phase.application_bytes);
+    add_num(doc, entry, "interface_mbps", phase.interface_mbps);
+    add_num(doc, entry, "application_mbps", phase.application_mbps);
+    add_num(doc, entry, "peak_interface_mbps", phase.peak_interface_mbps);
+    yyjson_mut_obj_add_int(doc, entry, "failed_transfers", phase.failed_transfers);
+    // Not judged when a transfer failed: its unread in-flight bytes would count as foreign
+    if (phase.cross_checked)
+    {
+      add_num(doc, entry, "foreign_share", phase.foreign_share);
+    }
+  }
+}
+
+auto compute_result_metrics(const TestResults& results) -> ResultMetrics
+{
+  ResultMetrics metrics;
+  metrics.latency_avg = results.latency.size() > 2 ? results.latency[2] : 0.0;
+  metrics.jitter = results.latency.size() > 4 ? results.latency[4] : 0.0;
+  const SampleSpan downloads = results.samples.direction_samples(TransferDirection::download);
+  const SampleSpan uploads = results.samples.direction_samples(TransferDirection::upload);
+  metrics.download_50pct = percentile(downloads, kPercentile50);
+  metrics.download_90pct = percentile(downloads, kPercentile90);
+  metrics.upload_50pct = percentile(uploads, kPercentile50);
+  metrics.upload_90pct = percentile(uploads, kPercentile90);
+  return metrics;
+}
+
 auto serialize_to_json(const TestResults& results) -> std::string
 {
   auto safe = [](const std::string& input) -> const char*
   { return input.empty() ? "" : input.c_str(); };
-  yyjson_mut_doc* doc = yyjson_mut_doc_new(nullptr);
+  // With a memory budget the document and its text live in the arena, not on the heap
+  std::unique_ptr<JsonArenaLease> arena;
+  if (memory_budget_enabled())
+  {
+    arena = std::make_unique<JsonArenaLease>();
+  }
+  const yyjson_alc* allocator = arena ? arena->allocator() : nullptr;
+  yyjson_mut_doc* doc = yyjson_mut_doc_new(allocator);
+  if (doc == nullptr)
+  {
+    memory_budget_exceeded("JSON arena", kJsonArenaBytes);
+  }
   yyjson_mut_val* obj = yyjson_mut_obj(doc);
   yyjson_mut_doc_set_root(doc, obj);
   add_str(doc, obj, "sysinfo_date", results.sysinfo_date, safe);
@@ -50,7 +287,8 @@ auto serialize_to_json(const TestResults& results) -> std::string
   add_str(doc, obj, "mem_total", results.mem_total, safe);
   add_str(doc, obj, "version", results.version, safe);
   yyjson_mut_obj_add_int(doc, obj, "cpu_cores", results.cpu_cores);
-  auto add_vec = [&](const char* key, const std::vector<double>& values)
+  add_host_config(doc, obj, results.host_tuning);
+  auto add_vec = [&](const char* key, SampleSpan values)
   {
     yyjson_mut_val* arr = yyjson_mut_arr(doc);
     for (double value : values)
@@ -59,46 +297,129 @@ auto serialize_to_json(const TestResults& results) -> std::string
     }
     yyjson_mut_obj_add_val(doc, obj, key, arr);
   };
-  add_vec("latency", results.latency);
-  add_vec("download_100kB", results.download_100kB);
-  add_vec("download_1MB", results.download_1MB);
-  add_vec("download_10MB", results.download_10MB);
-  add_vec("download_25MB", results.download_25MB);
-  add_vec("download_100MB", results.download_100MB);
-  add_vec("all_downloads", results.all_downloads);
-  add_vec("upload_11kB", results.upload_11kB);
-  add_vec("upload_100kB", results.upload_100kB);
-  add_vec("upload_1MB", results.upload_1MB);
-  add_vec("all_uploads", results.all_uploads);
+  // Fixed per-size arrays of the result schema: every plan phase with that direction and label
+  auto add_size_vec = [&](const char* key, TransferDirection direction, const char* label)
+  {
+    yyjson_mut_val* arr = yyjson_mut_arr(doc);
+    for (size_t phase_index = 0; phase_index < results.phases.size(); ++phase_index)
+    {
+      const PlanPhase& phase = results.phases[phase_index].phase;
+      if (phase.direction != direction || phase.label != label)
+      {
+        continue;
+      }
+      for (double value : results.samples.phase_samples(phase_index))
+      {
+        yyjson_mut_arr_add_real(doc, arr, value);
+      }
+    }
+    yyjson_mut_obj_add_val(doc, obj, key, arr);
+  };
+  add_vec("latency", SampleSpan(results.latency));
+  add_size_vec("download_100kB", TransferDirection::download, "100kB");
+  add_size_vec("download_1MB", TransferDirection::download, "1MB");
+  add_size_vec("download_10MB", TransferDirection::download, "10MB");
+  add_size_vec("download_25MB", TransferDirection::download, "25MB");
+  add_size_vec("download_100MB", TransferDirection::download, "100MB");
+  add_vec("all_downloads", results.samples.direction_samples(TransferDirection::download));
+  add_size_vec("upload_11kB", TransferDirection::upload, "11kB");
+  add_size_vec("upload_100kB", TransferDirection::upload, "100kB");
+  add_size_vec("upload_1MB", TransferDirection::upload, "1MB");
+  add_vec("all_uploads", results.samples.direction_samples(TransferDirection::upload));
   add_num(doc, obj, "total_time_ms", results.total_time_ms);
-  add_num(doc, obj, "latency_avg", results.latency.size() > 2 ? results.latency[2] : 0.0);
-  add_num(doc, obj, "jitter", results.latency.size() > 4 ? results.latency[4] : 0.0);
-  add_num(doc, obj, "download_90pct", percentile(results.all_downloads, kPercentile90));
-  add_num(doc, obj, "upload_90pct", percentile(results.all_uploads, kPercentile90));
+  const ResultMetrics metrics = compute_result_metrics(results);
+  add_num(doc, obj, "latency_avg", metrics.latency_avg);
+  add_num(doc, obj, "jitter", metrics.jitter);
+  add_num(doc, obj, "download_90pct", metrics.download_90pct);
+  add_num(doc, obj, "upload_90pct", metrics.upload_90pct);
+  yyjson_mut_val* phase_obj = yyjson_mut_obj_add_obj(doc, obj, "phase_ms");
+  add_num(doc, phase_obj, "bootstrap", results.bootstrap_ms);
+  add_num(doc, phase_obj, "latency", results.latency_ms);
+  add_num(doc, phase_obj, "download", results.download_ms);
+  add_num(doc, phase_obj, "upload", results.upload_ms);
+  yyjson_mut_val* plan_obj = yyjson_mut_obj_add_obj(doc, obj, "plan");
+  add_str(doc, plan_obj, "name", results.test_plan, safe);
+  yyjson_mut_val* plan_phases = yyjson_mut_obj_add_arr(doc, plan_obj, "phases");
+  for (size_t phase_index = 0; phase_index < results.phases.size(); ++phase_index)
+  {
+    const PhaseResult& phase_result = results.phases[phase_index];
+    const PlanPhase& phase = phase_result.phase;
+    yyjson_mut_val* phase_entry = yyjson_mut_arr_add_obj(doc, plan_phases);
+    yyjson_mut_obj_add_str(doc, phase_entry, "direction", direction_name(phase.direction));
+    add_str(doc, phase_entry, "label", phase.label, safe);
+    yyjson_mut_obj_add_int(doc, phase_entry, "bytes", phase.num_bytes);
+    yyjson_mut_obj_add_int(doc, phase_entry, "iterations", phase.num_iterations);
+    add_num(doc, phase_entry, "duration_ms", phase.duration_ms);
+    yyjson_mut_obj_add_int(doc, phase_entry, "concurrency", phase.concurrency);
+    yyjson_mut_obj_add_int(doc, phase_entry, "warmup", phase.warmup);
+    add_num(doc, phase_entry, "elapsed_ms", phase_result.elapsed_ms);
+    yyjson_mut_val* samples_arr = yyjson_mut_obj_add_arr(doc, phase_entry, "samples");
+    for (double sample : results.samples.phase_samples(phase_index))
+    {
+      yyjson_mut_arr_add_real(doc, samples_arr, sample);
+    }
+  }
+  add_sample_records(doc, obj, results.samples);
+  yyjson_mut_val* failures_obj = yyjson_mut_obj_add_obj(doc, obj, "failures");
+  yyjson_mut_obj_add_int(doc, failures_obj, "download", results.download_failures);
+  yyjson_mut_obj_add_int(doc, failures_obj, "upload", results.upload_failures);
+  yyjson_mut_val* estimates_obj = yyjson_mut_obj_add_obj(doc, obj, "estimates");
+  add_str(doc, estimates_obj, "filter", results.sample_filter, safe);
+  add_num(doc, estimates_obj, "confidence", kBootstrapConfidence);
+  add_estimate(doc, estimates_obj, "download", results.download_estimate);
+  add_estimate(doc, estimates_obj, "upload", results.upload_estimate);
+  yyjson_mut_val* hist_obj = yyjson_mut_obj_add_obj(doc, obj, "histograms");
+  yyjson_mut_obj_add_str(doc, hist_obj, "scheme", LogHistogram::kScheme);
+  add_histogram(doc, hist_obj, "latency_ms", results.latency_histogram);
+  add_histogram(doc, hist_obj, "download_mbps", results.download_histogram);
+  add_histogram(doc, hist_obj, "upload_mbps", results.upload_histogram);
+  add_overhead(doc, obj, results.overhead);
+  add_contention(doc, obj, results.contention);
+  add_traffic(doc, obj, results.traffic);
   yyjson_mut_val* flags_arr = yyjson_mut_arr(doc);
   for (const auto& flag : results.flags)
   {
     yyjson_mut_arr_add_str(doc, flags_arr, flag.c_str());
   }
   yyjson_mut_obj_add_val(doc, obj, "flags", flags_arr);
-  std::string out = yyjson_mut_write(doc, 0, nullptr);
+  size_t length = 0;
+  char* text = yyjson_mut_write_opts(doc, 0, allocator, &length, nullptr);
+  if (text == nullptr && arena)
+  {
+    memory_budget_exceeded("JSON arena", kJsonArenaBytes);
+  }
+  std::string out = text != nullptr ? std::string(text, length) : std::string();
+  if (text != nullptr && allocator == nullptr)
+  {
+    std::free(text);
+  }
   yyjson_mut_doc_free(doc);
   return out;
 }
 
 auto percentile(const std::vector<double>& values, double percentile_value) -> double
+{
+  return percentile(SampleSpan(values), percentile_value);
+}
+
+auto percentile(SampleSpan values, double percentile_value) -> double
 {
   if (values.empty())
   {
     return 0.0;
   }
-  std::vector<double> sorted = values;
-  std::sort(sorted.begin(), sorted.end());
-  size_t sorted_index = static_cast<size_t>(std::ceil(percentile_value * static_cast<double>(sorted.size()))) - 1;  if (sorted_index >= sorted.size())
+  // Nearest-rank percentile; selection is enough, no need to sort the whole copy
+  std::vector<double> scratch = values.to_vector();
+  size_t rank_index =
+      static_cast<size_t>(std::ceil(percentile_value * static_cast<double>(scratch.size())));
+  rank_index = rank_index == 0 ? 0 : rank_index - 1;
+  if (rank_index >= scratch.size())
   {
-    sorted_index = sorted.size() - 1;
+    rank_index = scratch.size() - 1;
   }
-  return sorted[sorted_index];
+  const auto nth = scratch.begin() + static_cast<std::ptrdiff_t>(rank_index);
+  std::nth_element(scratch.begin(), nth, scratch.end());
+  return *nth;
 }
 
 auto is_valid_utf8(const std::string& input) -> bool
@@ -2,13 +2,20 @@
 #include <string>
 #include <vector>
 #include <yyjson.h>  // for yyjson_mut_doc, yyjson_mut_val
+#include "sample_store.h"  // for SampleSpan
 
 struct TestResults;
+struct ResultMetrics;
+class LogHistogram;
 
 // JSON helpers
 // Modernized: trailing return types, descriptive parameter names
 auto serialize_to_json(const TestResults& results) -> std::string;
+auto compute_result_metrics(const TestResults& results) -> ResultMetrics;
 auto percentile(const std::vector<double>& values, double percentile_value) -> double;
+auto percentile(SampleSpan values, double percentile_value) -> double;
 auto is_valid_utf8(const std::string& input) -> bool;
 void add_str(yyjson_mut_doc* doc, yyjson_mut_val* obj, const char* key, const std::string& value);
 void add_num(yyjson_mut_doc* doc, yyjson_mut_val* obj, const char* key, double value);
+void add_histogram(yyjson_mut_doc* doc, yyjson_mut_val* obj, const char* key,
+                   const LogHistogram& histogram);
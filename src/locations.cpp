@@ -0,0 +1,130 @@
+#include "locations.h"
+#include <sys/stat.h>  // for mkdir
+#include <algorithm>   // for stable_sort, unique, lower_bound
+#include <cstdio>      // for rename, remove
+#include <ctime>       // for time
+#include <fstream>     // IWYU pragma: keep  // for ifstream, ofstream
+#include <string>      // for string, getline
+#include <utility>     // for move
+#include <vector>      // for vector
+
+constexpr const char* kLocationCacheMagic = "SCFLOC1";
+
+// Cache layout (text, one entry per line, already sorted by IATA):
+//   SCFLOC1 <unix time written> <entry count>
+//   <IATA>\t<city>
+
+LocationIndex::LocationIndex(std::vector<LocationEntry> entries) : entries_(std::move(entries))
+{
+  std::stable_sort(entries_.begin(), entries_.end(),
+                   [](const LocationEntry& lhs, const LocationEntry& rhs)
+                   { return lhs.iata < rhs.iata; });
+  // Keep the first city seen for a duplicate code
+  entries_.erase(std::unique(entries_.begin(), entries_.end(),
+                             [](const LocationEntry& lhs, const LocationEntry& rhs)
+                             { return lhs.iata == rhs.iata; }),
+                 entries_.end());
+}
+
+auto LocationIndex::find_city(std::string_view iata) const -> const std::string*
+{
+  auto found = std::lower_bound(entries_.begin(), entries_.end(), iata,
+                                [](const LocationEntry& entry, std::string_view key)
+                                { return std::string_view(entry.iata) < key; });
+  if (found == entries_.end() || found->iata != iata)
+  {
+    return nullptr;
+  }
+  return &found->city;
+}
+
+auto load_location_cache(const std::string& path, long ttl_seconds) -> LocationIndex
+{
+  std::ifstream in(path);
+  if (!in)
+  {
+    return {};
+  }
+  std::string magic;
+  long written_at = 0;
+  size_t entry_count = 0;
+  if (!(in >> magic >> written_at >> entry_count) || magic != kLocationCacheMagic)
+  {
+    return {};
+  }
+  const long age_seconds = static_cast<long>(std::time(nullptr)) - written_at;
+  if (age_seconds < 0 || age_seconds > ttl_seconds)
+  {
+    return {};
+  }
+  in.ignore(1); // trailing newline of the header
+  std::vector<LocationEntry> entries;
+  entries.reserve(entry_count);
+  std::string line;
+  while (std::getline(in, line))
+  {
+    const auto tab_pos = line.find('\t');
+    if (tab_pos == std::string::npos)
+    {
+      continue;
+    }
+    entries.push_back(LocationEntry{line.substr(0, tab_pos), line.substr(tab_pos + 1)});
+  }
+  if (entries.size() != entry_count)
+  {
+    // Truncated or hand-edited file: treat as a miss and let the caller refresh it
+    return {};
+  }
+  return LocationIndex(std::move(entries));
+}
+
+auto save_location_cache(const std::string& path, const LocationIndex& index) -> bool
+{
+  if (index.empty())
+  {
+    return false;
+  }
+  const size_t slash = path.find_last_of('/');
+  if (slash != std::string::npos)
+  {
+    (void)mkdir(path.substr(0, slash).c_str(), 0755);
+  }
+  const std::string tmp_path = path + ".tmp";
+  {
+    std::ofstream out(tmp_path, std::ios::trunc);
+    if (!out)
+    {
+      return false;
+    }
+    out << kLocationCacheMagic << ' ' << static_cast<long>(std::time(nullptr)) << ' '
+        << index.size() << '\n';
+    for (const auto& entry : index.entries())
+    {
+      out << entry.iata << '\t' << entry.city << '\n';
+    }
+    if (!out)
+    {
+      (void)std::remove(tmp_path.c_str());
+      return false;
+    }
+  }
+  return std::rename(tmp_path.c_str(), path.c_str()) == 0;
+}
+
+auto location_refresh_due(const std::string& path, long ttl_seconds) -> bool
+{
+  std::ifstream in(path + ".refreshed");
+  long refreshed_at = 0;
+  if (!(in >> refreshed_at))
+  {
+    return true;
+  }
+  const long age_seconds = static_cast<long>(std::time(nullptr)) - refreshed_at;
+  return age_seconds < 0 || age_seconds > ttl_seconds;
+}
+
+auto mark_location_refresh(const std::string& path) -> void
+{
+  std::ofstream out(path + ".refreshed", std::ios::trunc);
+  out << static_cast<long>(std::time(nullptr)) << '\n';
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include <stddef.h>     // for size_t
+#include <string>       // for string
+#include <string_view>  // for string_view
+#include <vector>       // for vector
+
+inline constexpr const char* LOCATION_CACHE_FILENAME = "locations.cache";
+inline constexpr long kLocationCacheTtlSeconds = 7L * 24 * 60 * 60;
+
+struct LocationEntry
+{
+  std::string iata;
+  std::string city;
+};
+
+// Flat IATA -> city index, sorted by IATA code for binary-search lookups
+class LocationIndex
+{
+public:
+  LocationIndex() = default;
+  explicit LocationIndex(std::vector<LocationEntry> entries);
+
+  auto find_city(std::string_view iata) const -> const std::string*;
+  auto entries() const -> const std::vector<LocationEntry>& { return entries_; }
+  auto size() const -> size_t { return entries_.size(); }
+  auto empty() const -> bool { return entries_.empty(); }
+
+private:
+  std::vector<LocationEntry> entries_;
+};
+
+// On-disk cache helpers
+auto load_location_cache(const std::string& path, long ttl_seconds = kLocationCacheTtlSeconds)
+    -> LocationIndex;
+auto save_location_cache(const std::string& path, const LocationIndex& index) -> bool;
+// A valid cache that lacks the test's colo is refreshed at most once per TTL, even when the
+// refresh does not add it (a colo Cloudflare does not list); PATH.refreshed holds the time
+auto location_refresh_due(const std::string& path, long ttl_seconds = kLocationCacheTtlSeconds)
+    -> bool;
+auto mark_location_refresh(const std::string& path) -> void;
@@ -1,14 +1,29 @@
 #include "main.h"
-#include <iostream>        // for operator<<, ostream, cout, endl, basic_ost...
+#include <cstdlib>         // for atexit
+#include <iostream>        // for operator<<, ostream, cout, cerr, endl, basic_ost...
 #include <string>          // for string, basic_string, allocator, operator+
+#include <utility>         // for pair
 #include <vector>          // for vector
-#include "benchmarks.h"    // for speed_test
+#include "benchmarks.h"    // for speed_test, set_speed_test_server
 #include "cli_args.h"      // for CliArgs, parse_cli_args
-#include "diagnostics.h"   // for validate_json_schema, yyjson_minimal_test
+#include "daemon.h"        // for run_daemon
+#include "event_stream.h"  // for open_event_stream
+#include "history_store.h" // for append_history_record, read_history_records
+#include "memory_budget.h" // for enable_memory_budget, enable_heap_counting, etc.
 #include "json_helpers.h"  // for serialize_to_json
+#include "matrix.h"        // for resolve_matrix_scenarios, run_matrix
+#include "metrics.h"       // for record_run_metrics, write_metrics_textfile
 #include "output.h"        // for load_summary_results, print_summary_table
+#include "regression_gate.h" // for evaluate_gate, load_gate_baseline, kExitRegression
+#include "summary_index.h" // for SummaryIndex, FileIdentity, SUMMARY_INDEX_FILENAME
 #include "sysinfo.h"       // for print_sysinfo, drop_caches, pin_to_core
+#include "test_plan.h"     // for TestPlan, resolve_test_plan
+#include "trace.h"         // for enable_tracing, write_trace
 #include "types.h"         // for SUMMARY_JSON_FILENAME, TestResults
+#ifndef SPEEDCLOUDFLARE_LEAN
+#include "diagnostics.h"   // for validate_json_schema, yyjson_minimal_test
+#include "schema_validation.h" // for validate_json_files, JsonSchema
+#endif
 
 // Modernized: trailing return types, braces, descriptive variable names, auto, nullptr, one
 // declaration per statement, no implicit conversions
@@ -28,11 +43,121 @@ void print_help()
   std::cout << "  --show-sysinfo           Show basic host architecture, CPU, and memory info (default: off)\n";
   std::cout << "  --show-sysinfo-only      Only print system info and exit (supports --mask-sensitive)\n";
   std::cout << "  --json                   Output results as JSON to stdout (default: off)\n";
+  std::cout << "  --ndjson[=FD]            Stream one NDJSON event per sample, phase and run summary to stdout or descriptor FD\n";
   std::cout << "  --summary-table FILES    Print a summary table comparing multiple JSON result files\n";
+  std::cout << "  --no-summary-index       --summary-table: ignore and do not update results/summary.index\n";
+  std::cout << "  --history=PATH           Append each run (also in daemon mode) to a compact binary history store\n";
+  std::cout << "  --history-report=PATH    Print a summary table of the runs in a history store\n";
+  std::cout << "  --history-export=PATH    Write the runs in a history store as JSON to stdout\n";
+  std::cout << "  --since=TIME, --until=TIME  Time range for the history report/export (Unix seconds, YYYY-MM-DD or YYYY-MM-DDTHH:MM[:SS])\n";
+  std::cout << "  --baseline=PATH          Gate the run against a history store or result files (*.json); exit 4 on a regression\n";
+  std::cout << "  --check=FILE             Gate a result file against --baseline instead of running a test\n";
+  std::cout << "  --tolerance=LIST         Allowed degradation in percent, e.g. download:20,upload:20,latency:30,jitter:50 (defaults)\n";
+  std::cout << "  --daemon                 Run continuously, writing each result as JSON to the output directory\n";
+  std::cout << "  --interval=SECONDS       Daemon: time between run starts (default: 3600)\n";
+  std::cout << "  --jitter=SECONDS         Daemon: random extra delay added to each interval (default: 300)\n";
+  std::cout << "  --keep=N                 Daemon: number of result files to keep (default: 168)\n";
+  std::cout << "  --output-dir=DIR         Daemon: directory for result files (default: results/daemon)\n";
+  std::cout << "  --metrics-file=PATH      Write Prometheus metrics (node_exporter textfile collector) after each run\n";
+  std::cout << "  --metrics-port=PORT      Daemon: serve the latest Prometheus metrics on http://*:PORT/metrics\n";
+  std::cout << "  --trace=PATH             Write a Chrome trace-event timeline of phases and HTTP requests to PATH at exit\n";
+  std::cout << "  --memory-budget=MB       Bound the process memory: preallocated arena for transfers and JSON, exit 3 when exceeded\n";
+  std::cout << "  --sample-filter=NAME     Outlier rejection for throughput samples: mad (default), iqr, none, legacy\n";
+  std::cout << "  --server=HOST[:PORT]     Run against another HTTPS server with the same paths, e.g. a local mock server\n";
+  std::cout << "  --matrix[=LIST]          Compare tuning scenarios (default,single-core,no-yield,no-nice,drop-caches,parallel,no-warmup) against default\n";
+  std::cout << "  --repeat=N               Matrix: runs per scenario, interleaved (default: 5)\n";
+  std::cout << "  --plan=NAME|FILE         Test plan: full (default), quick, router-safe, or a JSON plan file\n";
   std::cout << "  -v, --verbose[=N]        Increase verbosity: -v or --verbose=1 for debug, -vv or --verbose=2 for diagnostics, -vvv or --verbose=3 for full diagnostics\n";
   std::cout << "  --help, -h               Show this help message\n";
 }
 
+// --since / --until, shared by the history commands and a history-store baseline
+static auto parse_history_range(const CliArgs& args, HistoryRange& range) -> bool
+{
+  const std::pair<const std::string*, int64_t*> bounds[] = {
+      {&args.history_since, &range.since_ms}, {&args.history_until, &range.until_ms}};
+  for (const auto& [text, wall_ms] : bounds)
+  {
+    if (!text->empty() && !parse_history_time(*text, *wall_ms))
+    {
+      std::cerr << "[ERROR] Invalid time '" << *text
+                << "' (expected Unix seconds, YYYY-MM-DD or YYYY-MM-DDTHH:MM[:SS])" << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+// --history-report / --history-export: query a history store instead of running a test
+static auto run_history_command(const CliArgs& args) -> int
+{
+  HistoryRange range;
+  if (!parse_history_range(args, range))
+  {
+    return 1;
+  }
+  const std::string& path =
+      args.history_report.empty() ? args.history_export : args.history_report;
+  std::vector<HistoryRecord> records;
+  std::string error;
+  if (!read_history_records(path, range, records, error))
+  {
+    std::cerr << "[ERROR] " << error << std::endl;
+    return 1;
+  }
+  if (!error.empty())
+  {
+    std::cerr << "[WARN] " << error << std::endl;
+  }
+  if (args.is_debug)
+  {
+    std::clog << "[DEBUG] History: " << records.size() << " runs in range from " << path
+              << std::endl;
+  }
+  if (!args.history_export.empty())
+  {
+    return export_history_json(records, std::cout) ? 0 : 1;
+  }
+  std::vector<SummaryResult> summary_results;
+  summary_results.reserve(records.size());
+  for (const HistoryRecord& record : records)
+  {
+    summary_results.push_back(history_summary_result(record));
+  }
+  print_summary_table(summary_results);
+  return 0;
+}
+
+// --baseline: one verdict line for the run on out; the gate's exit status (1 on a bad baseline)
+static auto run_regression_gate(const CliArgs& args, const GateTolerances& tolerances,
+                                const SummaryResult& run, std::ostream& out) -> int
+{
+  HistoryRange range;
+  if (!parse_history_range(args, range))
+  {
+    return 1;
+  }
+  std::vector<SummaryResult> baseline;
+  std::string error;
+  if (!load_gate_baseline(args.baseline, range, baseline, error))
+  {
+    std::cerr << "[ERROR] " << error << std::endl;
+    return 1;
+  }
+  if (!error.empty())
+  {
+    std::cerr << "[WARN] " << error << std::endl;
+  }
+  const GateVerdict verdict = evaluate_gate(run, baseline, tolerances);
+  if (args.is_debug)
+  {
+    std::clog << "[DEBUG] Baseline: " << verdict.baseline_runs << " of " << baseline.size()
+              << " runs (scope " << verdict.scope << ") from " << args.baseline << std::endl;
+  }
+  out << gate_verdict_json(verdict) << std::endl;
+  return verdict.regression ? kExitRegression : 0;
+}
+
 auto main(int argc, char* argv[]) -> int
 {
   std::vector<std::string> argument_vector(argv, argv + argc);
@@ -46,22 +171,99 @@ auto main(int argc, char* argv[]) -> int
                 << std::endl;
       return 1;
     }
+    // Files already in the index were validated and parsed when they were added
+    SummaryIndex summary_index;
+    const std::string index_path = std::string("results/") + SUMMARY_INDEX_FILENAME;
+    if (args.use_summary_index)
+    {
+      summary_index.load(index_path);
+    }
+    std::vector<std::string> unindexed_files;
     for (const auto& summary_file : args.summary_files)
     {
-      validate_json_schema(summary_file, "result.schema.json", args.is_diagnostics);
+      FileIdentity identity;
+      if (args.use_summary_index && stat_file_identity(summary_file, identity) &&
+          summary_index.find(summary_file, identity) != nullptr)
+      {
+        continue;
+      }
+      unindexed_files.push_back(summary_file);
+    }
+#ifndef SPEEDCLOUDFLARE_LEAN
+    const auto verdicts = validate_json_files(unindexed_files, JsonSchema::result);
+    size_t structural_passes = 0;
+    for (size_t file_index = 0; file_index < verdicts.size(); ++file_index)
+    {
+      structural_passes += verdicts[file_index].structural ? 1 : 0;
+      if (args.is_diagnostics)
+      {
+        std::cerr << "[SCHEMA] " << unindexed_files[file_index] << ": "
+                  << verdicts[file_index].message << "\n";
+      }
+    }
+    if (args.is_debug)
+    {
+      std::clog << "[DEBUG] Schema validation: " << verdicts.size() << " files, "
+                << structural_passes << " by structural check, "
+                << verdicts.size() - structural_passes << " by full validator" << std::endl;
+    }
+#else
+    if (args.is_diagnostics)
+    {
+      std::cerr << "[SCHEMA] " << unindexed_files.size()
+                << " files not validated: lean build without schema support" << std::endl;
     }
+#endif
     auto summary_results =
-        load_summary_results(args.summary_files, args.is_diagnostics, args.is_debug);
+        load_summary_results(args.summary_files, args.is_diagnostics, args.is_debug,
+                             args.use_summary_index ? &summary_index : nullptr);
+    if (args.use_summary_index)
+    {
+      summary_index.prune_missing();
+      if (summary_index.dirty() && !summary_index.save(index_path))
+      {
+        std::cerr << "[WARN] Could not write summary index " << index_path << std::endl;
+      }
+    }
     print_summary_table(summary_results);
     std::string summary_path = std::string("results/") + SUMMARY_JSON_FILENAME;
     write_summary_json(summary_results, summary_path, args.is_diagnostics, args.is_debug, args.is_full_diagnostics);
+#ifndef SPEEDCLOUDFLARE_LEAN
     validate_json_schema(summary_path, "summary.schema.json", args.is_diagnostics);
     if (args.is_diagnostics)
     {
       yyjson_minimal_test(args.is_diagnostics, args.is_debug);
     }
+#endif
     return 0;
   }
+  if (!args.history_report.empty() || !args.history_export.empty())
+  {
+    return run_history_command(args);
+  }
+  GateTolerances gate_tolerances;
+  std::string tolerance_error;
+  if (!parse_gate_tolerances(args.tolerances, gate_tolerances, tolerance_error))
+  {
+    std::cerr << "[ERROR] " << tolerance_error << std::endl;
+    return 1;
+  }
+  if (!args.check_file.empty())
+  {
+    if (args.baseline.empty())
+    {
+      std::cerr << "[ERROR] --check requires --baseline" << std::endl;
+      return 1;
+    }
+    const auto checked =
+        load_summary_results({args.check_file}, args.is_diagnostics, args.is_debug);
+    if (checked.empty())
+    {
+      std::cerr << "[ERROR] Could not read result file " << args.check_file << std::endl;
+      return 1;
+    }
+    return run_regression_gate(args, gate_tolerances, checked.front(), std::cout);
+  }
   if (args.show_sysinfo_only)
   {
     print_sysinfo(args.mask_sensitive);
@@ -71,6 +273,52 @@ auto main(int argc, char* argv[]) -> int
   {
     print_sysinfo(args.mask_sensitive);
   }
+  if (!args.server.empty())
+  {
+    set_speed_test_server(args.server);
+  }
+  TestPlan plan;
+  std::string plan_error;
+  if (!resolve_test_plan(args.test_plan, plan, plan_error))
+  {
+    std::cerr << "[ERROR] " << plan_error << std::endl;
+    return 1;
+  }
+  if (args.is_debug)
+  {
+    const size_t planned_bytes = planned_transfer_bytes(plan);
+    std::clog << "[DEBUG] Test plan '" << plan.name << "': " << plan.phases.size() << " phases, "
+              << (planned_bytes > 0 ? std::to_string(planned_bytes / 1000000) + " MB planned"
+                                    : std::string("duration-bounded"))
+              << std::endl;
+  }
+  if (args.memory_budget_mb > 0)
+  {
+    std::string budget_error;
+    if (!enable_memory_budget(static_cast<size_t>(args.memory_budget_mb) * 1024 * 1024,
+                              budget_error))
+    {
+      std::cerr << "[ERROR] " << budget_error << std::endl;
+      return 1;
+    }
+  }
+  if (args.memory_budget_mb > 0 || args.is_debug)
+  {
+    enable_heap_counting();
+    std::atexit(print_memory_report);
+  }
+  if (args.matrix_mode)
+  {
+    // Scenarios apply their own tuning flags, each in a child process
+    std::string matrix_error;
+    if (!resolve_matrix_scenarios(std::vector<std::string>(args.matrix_scenarios),
+                                  args.matrix_scenarios, matrix_error))
+    {
+      std::cerr << "[ERROR] " << matrix_error << std::endl;
+      return 1;
+    }
+    return run_matrix(args, plan);
+  }
   if (args.pin_single_core)
   {
     pin_to_core(0);
@@ -83,21 +331,74 @@ auto main(int argc, char* argv[]) -> int
   {
     drop_caches();
   }
+  // Events on stdout own it: human-readable progress and the --json document are switched off
+  const bool events_on_stdout = args.ndjson_fd == 1;
+  if (args.ndjson_fd >= 0)
+  {
+    if (events_on_stdout && args.output_json)
+    {
+      std::cerr << "[WARN] --json ignored: --ndjson writes to stdout (use --ndjson=FD)"
+                << std::endl;
+      args.output_json = false;
+    }
+    args.minimize_output = args.minimize_output || events_on_stdout;
+    open_event_stream(args.ndjson_fd);
+  }
+  if (args.daemon_mode)
+  {
+    if (!args.trace_file.empty())
+    {
+      std::cerr << "[WARN] --trace ignored in daemon mode" << std::endl;
+    }
+    return run_daemon(args, plan);
+  }
+  if (!args.trace_file.empty())
+  {
+    enable_tracing(args.trace_file);
+    std::atexit(write_trace);
+  }
+  const bool want_results = args.output_json || args.ndjson_fd >= 0 ||
+                            !args.metrics_file.empty() || !args.history_file.empty() ||
+                            !args.baseline.empty();
+  TestResults results;
+  speed_test(args.use_parallel, args.minimize_output, args.warmup, args.do_yield,
+             args.mask_sensitive, args.output_json || events_on_stdout,
+             want_results ? &results : nullptr, args.sample_filter, &plan);
   if (args.output_json)
   {
-    TestResults results;
-    speed_test(args.use_parallel, args.minimize_output, args.warmup, args.do_yield,
-               args.mask_sensitive, args.output_json, &results);
     std::cout << serialize_to_json(results) << std::endl;
   }
-  else
+  if (!args.metrics_file.empty())
+  {
+    record_run_metrics(results);
+    if (!write_metrics_textfile(args.metrics_file))
+    {
+      std::cerr << "[ERROR] Could not write metrics file " << args.metrics_file << std::endl;
+    }
+  }
+  // Gated before the run is appended, so a store used as both history and baseline does not
+  // compare the run with itself
+  int exit_status = 0;
+  if (!args.baseline.empty())
+  {
+    SummaryResult run = history_summary_result(make_history_record(results));
+    run.file.clear();
+    exit_status = run_regression_gate(args, gate_tolerances, run,
+                                      args.output_json || events_on_stdout ? std::cerr : std::cout);
+  }
+  if (!args.history_file.empty())
   {
-    speed_test(args.use_parallel, args.minimize_output, args.warmup, args.do_yield,
-               args.mask_sensitive, args.output_json);
+    std::string history_error;
+    if (!append_history_record(args.history_file, make_history_record(results), history_error))
+    {
+      std::cerr << "[ERROR] " << history_error << std::endl;
+    }
   }
+#ifndef SPEEDCLOUDFLARE_LEAN
   if (args.is_debug || args.is_diagnostics)
   {
     yyjson_minimal_test(args.is_diagnostics, args.is_debug);
   }
-  return 0;
+#endif
+  return exit_status;
 }
@@ -0,0 +1,93 @@
+#include "mapped_file.h"
+#include <fcntl.h>     // for open, O_RDONLY, O_CLOEXEC
+#include <sys/mman.h>  // for mmap, munmap, MAP_PRIVATE, PROT_READ, PROT_WRITE
+#include <sys/stat.h>  // for fstat, stat
+#include <unistd.h>    // for close, sysconf, _SC_PAGESIZE
+#include <utility>     // for exchange
+
+MappedFile::~MappedFile()
+{
+  close();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+    : data_(std::exchange(other.data_, nullptr)),
+      size_(std::exchange(other.size_, 0)),
+      mapped_size_(std::exchange(other.mapped_size_, 0)),
+      opened_empty_(std::exchange(other.opened_empty_, false))
+{
+}
+
+auto MappedFile::operator=(MappedFile&& other) noexcept -> MappedFile&
+{
+  if (this != &other)
+  {
+    close();
+    data_ = std::exchange(other.data_, nullptr);
+    size_ = std::exchange(other.size_, 0);
+    mapped_size_ = std::exchange(other.mapped_size_, 0);
+    opened_empty_ = std::exchange(other.opened_empty_, false);
+  }
+  return *this;
+}
+
+auto MappedFile::open(const std::string& path) -> bool
+{
+  close();
+  const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0)
+  {
+    return false;
+  }
+  struct stat file_stat
+  {
+  };
+  if (fstat(fd, &file_stat) != 0 || !S_ISREG(file_stat.st_mode))
+  {
+    ::close(fd);
+    return false;
+  }
+  size_ = static_cast<size_t>(file_stat.st_size);
+  if (size_ == 0)
+  {
+    // mmap rejects zero-length mappings; an empty file is still a successful open
+    ::close(fd);
+    opened_empty_ = true;
+    return true;
+  }
+  // MAP_PRIVATE + PROT_WRITE: in-place edits stay private (copy-on-write), the file is untouched
+  void* mapping = mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (mapping == MAP_FAILED)
+  {
+    size_ = 0;
+    return false;
+  }
+  data_ = static_cast<char*>(mapping);
+  mapped_size_ = size_;
+  return true;
+}
+
+void MappedFile::close()
+{
+  if (data_ != nullptr)
+  {
+    munmap(data_, mapped_size_);
+  }
+  data_ = nullptr;
+  size_ = 0;
+  mapped_size_ = 0;
+  opened_empty_ = false;
+}
+
+auto MappedFile::has_tail_padding(size_t padding_bytes) const -> bool
+{
+  if (data_ == nullptr)
+  {
+    return false;
+  }
+  // Bytes between EOF and the end of its page are mapped and read as zero
+  const auto page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+  const size_t tail = size_ % page_size;
+  return tail != 0 && tail + padding_bytes <= page_size;
+}
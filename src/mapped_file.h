@@ -0,0 +1,32 @@
+#pragma once
+#include <stddef.h>  // for size_t
+#include <string>    // for string
+
+// Read-only file view backed by mmap, with a private copy-on-write mapping so parsers may
+// modify the bytes in place (yyjson YYJSON_READ_INSITU). Move-only; unmaps on destruction.
+class MappedFile
+{
+public:
+  MappedFile() = default;
+  ~MappedFile();
+  MappedFile(const MappedFile&) = delete;
+  auto operator=(const MappedFile&) -> MappedFile& = delete;
+  MappedFile(MappedFile&& other) noexcept;
+  auto operator=(MappedFile&& other) noexcept -> MappedFile&;
+
+  auto open(const std::string& path) -> bool;
+  void close();
+  auto data() -> char* { return data_; }
+  auto data() const -> const char* { return data_; }
+  auto size() const -> size_t { return size_; }
+  auto is_open() const -> bool { return data_ != nullptr || opened_empty_; }
+  // True when at least padding_bytes past the end are mapped (zero-filled tail of the last
+  // page), so an in-situ parser that needs trailing padding can run on the mapping directly
+  auto has_tail_padding(size_t padding_bytes) const -> bool;
+
+private:
+  char* data_ = nullptr;
+  size_t size_ = 0;
+  size_t mapped_size_ = 0;
+  bool opened_empty_ = false;
+};
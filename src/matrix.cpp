@@ -0,0 +1,431 @@
+#include "matrix.h"
+#include <sys/types.h>     // for pid_t, ssize_t
+#include <sys/wait.h>      // for waitpid
+#include <unistd.h>        // for fork, pipe, read, write, close, _exit
+#include <yyjson.h>        // for yyjson_mut_doc, yyjson_mut_obj_add_*, yyjson_mut_write
+#include <algorithm>       // for find, find_if
+#include <array>           // for array
+#include <cerrno>          // for errno, EINTR
+#include <cmath>           // for isfinite
+#include <cstdlib>         // for free
+#include <exception>       // for exception
+#include <iomanip>         // for setw, setprecision
+#include <iostream>        // for operator<<, cout, cerr
+#include <string>          // for string
+#include <vector>          // for vector
+#include "benchmarks.h"    // for speed_test
+#include "cli_args.h"      // for CliArgs
+#include "estimation.h"    // for mann_whitney_test, holm_adjust, RankTest
+#include "json_helpers.h"  // for compute_result_metrics, add_num
+#include "stats.h"         // for median, quartile
+#include "sysinfo.h"       // for pin_to_core, set_nice, drop_caches, get_time_ms
+#include "test_plan.h"     // for TestPlan
+#include "types.h"         // for TestResults, ResultMetrics
+
+namespace
+{
+constexpr double kSignificanceLevel = 0.05;
+constexpr double kPercent = 100.0;
+
+// A scenario is the baseline flags with one tuning knob changed, as in run_benchmarks.sh
+struct MatrixScenario
+{
+  const char* name;
+  void (*apply)(CliArgs& args);
+};
+
+const MatrixScenario kScenarios[] = {
+    {"default", [](CliArgs& /*args*/) {}},
+    {"single-core", [](CliArgs& args) { args.pin_single_core = true; }},
+    {"no-yield", [](CliArgs& args) { args.do_yield = false; }},
+    {"no-nice", [](CliArgs& args) { args.do_nice = false; }},
+    {"drop-caches", [](CliArgs& args) { args.do_drop_caches = true; }},
+    {"parallel", [](CliArgs& args) { args.use_parallel = true; }},
+    {"no-warmup", [](CliArgs& args) { args.warmup = false; }},
+};
+
+struct MatrixMetric
+{
+  const char* name;
+  const char* unit;
+  bool higher_is_better;
+};
+
+const MatrixMetric kMetrics[] = {
+    {"download_p90", "Mbps", true}, {"upload_p90", "Mbps", true}, {"latency", "ms", false},
+    {"jitter", "ms", false},        {"run_time", "ms", false},
+};
+constexpr size_t kMetricCount = sizeof(kMetrics) / sizeof(kMetrics[0]);
+
+// Fixed-size result a child sends back through its pipe (well below PIPE_BUF, one write)
+struct MatrixRun
+{
+  double values[kMetricCount];
+  int failed_transfers;
+  int completed;
+};
+
+struct ScenarioRuns
+{
+  const MatrixScenario* scenario = nullptr;
+  std::vector<double> values[kMetricCount];
+  // Completed runs without a value for the metric (every transfer failed, no latency sample);
+  // left out of its test rather than ranked as the slowest run
+  int failed_values[kMetricCount] = {};
+  int failed_runs = 0;
+  int failed_transfers = 0;
+};
+
+// One cell of the matrix: a scenario against the baseline on one metric
+struct MatrixTest
+{
+  bool tested = false; // both sides have values
+  RankTest test;
+  double adjusted_p = 1; // Holm-adjusted over every tested cell of the matrix
+};
+
+using ScenarioTests = std::array<MatrixTest, kMetricCount>;
+
+auto find_scenario(const std::string& name) -> const MatrixScenario*
+{
+  const auto found = std::find_if(std::begin(kScenarios), std::end(kScenarios),
+                                  [&](const MatrixScenario& scenario)
+                                  { return name == scenario.name; });
+  return found == std::end(kScenarios) ? nullptr : &*found;
+}
+
+// Child side: apply the scenario like main() applies the flags, run once, report the metrics
+[[noreturn]] void run_child(const CliArgs& base_args, const MatrixScenario& scenario,
+                            const TestPlan& plan, int result_fd)
+{
+  CliArgs args = base_args;
+  scenario.apply(args);
+  if (args.pin_single_core)
+  {
+    pin_to_core(0);
+  }
+  if (args.do_nice)
+  {
+    set_nice();
+  }
+  if (args.do_drop_caches)
+  {
+    drop_caches();
+  }
+  MatrixRun run{};
+  try
+  {
+    const double start_ms = get_time_ms();
+    TestResults results;
+    speed_test(args.use_parallel, true, args.warmup, args.do_yield, args.mask_sensitive, true,
+               &results, args.sample_filter, &plan);
+    const ResultMetrics metrics = compute_result_metrics(results);
+    const double values[kMetricCount] = {metrics.download_90pct, metrics.upload_90pct,
+                                         metrics.latency_avg, metrics.jitter,
+                                         get_time_ms() - start_ms};
+    std::copy(std::begin(values), std::end(values), std::begin(run.values));
+    run.failed_transfers = results.download_failures + results.upload_failures;
+    run.completed = 1;
+  }
+  catch (const std::exception& ex)
+  {
+    std::cerr << "[ERROR] Matrix run (" << scenario.name << ") failed: " << ex.what()
+              << std::endl;
+  }
+  std::cout.flush();
+  const ssize_t written = write(result_fd, &run, sizeof(run));
+  _exit(written == static_cast<ssize_t>(sizeof(run)) ? 0 : 1);
+}
+
+// Parent side: fork, collect the child's MatrixRun and reap it. False when the run failed.
+auto run_scenario(const CliArgs& args, const MatrixScenario& scenario, const TestPlan& plan,
+                  MatrixRun& run) -> bool
+{
+  int fds[2];
+  if (pipe(fds) != 0)
+  {
+    return false;
+  }
+  std::cout.flush();
+  std::cerr.flush();
+  const pid_t pid = fork();
+  if (pid < 0)
+  {
+    close(fds[0]);
+    close(fds[1]);
+    return false;
+  }
+  if (pid == 0)
+  {
+    close(fds[0]);
+    run_child(args, scenario, plan, fds[1]);
+  }
+  close(fds[1]);
+  ssize_t received = 0;
+  do
+  {
+    received = read(fds[0], &run, sizeof(run));
+  } while (received < 0 && errno == EINTR);
+  close(fds[0]);
+  int status = 0;
+  while (waitpid(pid, &status, 0) < 0 && errno == EINTR)
+  {
+  }
+  return received == static_cast<ssize_t>(sizeof(run)) && run.completed != 0;
+}
+
+auto change_percent(double value, double baseline) -> double
+{
+  return baseline != 0.0 ? (value - baseline) / baseline * kPercent : 0.0;
+}
+
+// Every scenario against the baseline on every metric, then one Holm correction over all of
+// those cells: with 6 scenarios and 5 metrics, 30 uncorrected tests at 0.05 would flag about
+// one and a half differences on pure noise. Row 0 (the baseline itself) stays untested
+auto compare_scenarios(const std::vector<ScenarioRuns>& matrix, size_t& comparisons)
+    -> std::vector<ScenarioTests>
+{
+  std::vector<ScenarioTests> tests(matrix.size());
+  std::vector<MatrixTest*> family;
+  std::vector<double> p_values;
+  for (size_t scenario_index = 1; scenario_index < matrix.size(); ++scenario_index)
+  {
+    for (size_t metric_index = 0; metric_index < kMetricCount; ++metric_index)
+    {
+      const std::vector<double>& values = matrix[scenario_index].values[metric_index];
+      const std::vector<double>& baseline = matrix.front().values[metric_index];
+      MatrixTest& cell = tests[scenario_index][metric_index];
+      cell.tested = !values.empty() && !baseline.empty();
+      if (!cell.tested)
+      {
+        continue;
+      }
+      cell.test = mann_whitney_test(values, baseline);
+      family.push_back(&cell);
+      p_values.push_back(cell.test.p_value);
+    }
+  }
+  const std::vector<double> adjusted = holm_adjust(p_values);
+  for (size_t index = 0; index < family.size(); ++index)
+  {
+    family[index]->adjusted_p = adjusted[index];
+  }
+  comparisons = family.size();
+  return tests;
+}
+
+// "better"/"worse" when the adjusted p is below kSignificanceLevel, "-" otherwise
+auto verdict(const MatrixMetric& metric, const MatrixTest& cell) -> const char*
+{
+  if (!cell.tested || cell.adjusted_p >= kSignificanceLevel || cell.test.z == 0.0)
+  {
+    return "-";
+  }
+  return (cell.test.z > 0) == metric.higher_is_better ? "better" : "worse";
+}
+
+void print_matrix_table(const std::vector<ScenarioRuns>& matrix, int repeat)
+{
+  size_t comparisons = 0;
+  const std::vector<ScenarioTests> tests = compare_scenarios(matrix, comparisons);
+  std::cout << "[MATRIX] " << repeat << " runs per scenario, interleaved; each scenario vs "
+            << matrix.front().scenario->name << " (two-sided Mann-Whitney U, Holm-adjusted over "
+            << comparisons << " comparisons, alpha " << kSignificanceLevel << ")\n";
+  for (size_t metric_index = 0; metric_index < kMetricCount; ++metric_index)
+  {
+    const MatrixMetric& metric = kMetrics[metric_index];
+    const std::vector<double>& baseline = matrix.front().values[metric_index];
+    std::cout << "\n"
+              << metric.name << " (" << metric.unit << ")\n"
+              << std::setw(20) << "n" << std::setw(7) << "failed" << std::setw(11) << "median"
+              << std::setw(11) << "p25" << std::setw(11) << "p75" << std::setw(10) << "change"
+              << std::setw(9) << "p" << std::setw(9) << "p adj" << "  verdict\n";
+    for (size_t scenario_index = 0; scenario_index < matrix.size(); ++scenario_index)
+    {
+      const ScenarioRuns& runs = matrix[scenario_index];
+      const std::vector<double>& values = runs.values[metric_index];
+      std::cout << "  " << std::left << std::setw(14) << runs.scenario->name << std::right
+                << std::setw(4) << values.size() << std::setw(7)
+                << runs.failed_values[metric_index] << std::fixed << std::setprecision(2)
+                << std::setw(11) << stats::median(values) << std::setw(11)
+                << stats::quartile(values, 0.25) << std::setw(11)
+                << stats::quartile(values, 0.75);
+      if (scenario_index == 0)
+      {
+        std::cout << std::setw(10) << "base" << "\n";
+        continue;
+      }
+      const MatrixTest& cell = tests[scenario_index][metric_index];
+      if (!cell.tested)
+      {
+        std::cout << std::setw(10) << "n/a" << "\n";
+        continue;
+      }
+      std::cout << std::showpos << std::setprecision(1) << std::setw(9)
+                << change_percent(stats::median(values), stats::median(baseline)) << "%"
+                << std::noshowpos << std::setprecision(3) << std::setw(9) << cell.test.p_value
+                << std::setw(9) << cell.adjusted_p << "  " << verdict(metric, cell) << "\n";
+    }
+  }
+  std::cout.unsetf(std::ios::fixed);
+  for (const ScenarioRuns& runs : matrix)
+  {
+    if (runs.failed_runs > 0 || runs.failed_transfers > 0)
+    {
+      std::cout << "[MATRIX] " << runs.scenario->name << ": " << runs.failed_runs
+                << " failed runs, " << runs.failed_transfers << " failed transfers\n";
+    }
+  }
+  std::cout << std::flush;
+}
+
+void print_matrix_json(const std::vector<ScenarioRuns>& matrix, int repeat)
+{
+  size_t comparisons = 0;
+  const std::vector<ScenarioTests> tests = compare_scenarios(matrix, comparisons);
+  yyjson_mut_doc* doc = yyjson_mut_doc_new(nullptr);
+  yyjson_mut_val* root = yyjson_mut_obj(doc);
+  yyjson_mut_doc_set_root(doc, root);
+  yyjson_mut_obj_add_str(doc, root, "baseline", matrix.front().scenario->name);
+  yyjson_mut_obj_add_int(doc, root, "repeat", repeat);
+  add_num(doc, root, "alpha", kSignificanceLevel);
+  yyjson_mut_obj_add_str(doc, root, "correction", "holm");
+  yyjson_mut_obj_add_uint(doc, root, "comparisons", comparisons);
+  yyjson_mut_val* scenarios = yyjson_mut_obj_add_arr(doc, root, "scenarios");
+  for (size_t scenario_index = 0; scenario_index < matrix.size(); ++scenario_index)
+  {
+    const ScenarioRuns& runs = matrix[scenario_index];
+    yyjson_mut_val* entry = yyjson_mut_arr_add_obj(doc, scenarios);
+    yyjson_mut_obj_add_str(doc, entry, "name", runs.scenario->name);
+    yyjson_mut_obj_add_int(doc, entry, "failed_runs", runs.failed_runs);
+    yyjson_mut_obj_add_int(doc, entry, "failed_transfers", runs.failed_transfers);
+    yyjson_mut_val* metrics = yyjson_mut_obj_add_obj(doc, entry, "metrics");
+    for (size_t metric_index = 0; metric_index < kMetricCount; ++metric_index)
+    {
+      const std::vector<double>& values = runs.values[metric_index];
+      const std::vector<double>& baseline = matrix.front().values[metric_index];
+      yyjson_mut_val* metric = yyjson_mut_obj_add_obj(doc, metrics, kMetrics[metric_index].name);
+      yyjson_mut_val* array = yyjson_mut_obj_add_arr(doc, metric, "values");
+      for (const double value : values)
+      {
+        yyjson_mut_arr_add_real(doc, array, value);
+      }
+      yyjson_mut_obj_add_int(doc, metric, "failed_runs", runs.failed_values[metric_index]);
+      add_num(doc, metric, "median", stats::median(values));
+      add_num(doc, metric, "p25", stats::quartile(values, 0.25));
+      add_num(doc, metric, "p75", stats::quartile(values, 0.75));
+      const MatrixTest& cell = tests[scenario_index][metric_index];
+      if (!cell.tested)
+      {
+        continue;
+      }
+      add_num(doc, metric, "change_pct",
+              change_percent(stats::median(values), stats::median(baseline)));
+      add_num(doc, metric, "u", cell.test.u);
+      add_num(doc, metric, "p_value", cell.test.p_value);
+      add_num(doc, metric, "p_adjusted", cell.adjusted_p);
+      yyjson_mut_obj_add_str(doc, metric, "verdict", verdict(kMetrics[metric_index], cell));
+    }
+  }
+  char* json = yyjson_mut_write(doc, YYJSON_WRITE_PRETTY, nullptr);
+  if (json != nullptr)
+  {
+    std::cout << json << std::endl;
+    free(json);
+  }
+  yyjson_mut_doc_free(doc);
+}
+} // namespace
+
+auto matrix_scenario_names() -> std::vector<std::string>
+{
+  std::vector<std::string> names;
+  for (const MatrixScenario& scenario : kScenarios)
+  {
+    names.emplace_back(scenario.name);
+  }
+  return names;
+}
+
+auto resolve_matrix_scenarios(const std::vector<std::string>& names,
+                              std::vector<std::string>& scenarios, std::string& error) -> bool
+{
+  scenarios.assign(1, kScenarios[0].name);
+  for (const std::string& name : names.empty() ? matrix_scenario_names() : names)
+  {
+    if (find_scenario(name) == nullptr)
+    {
+      error = "Unknown matrix scenario '" + name + "' (expected";
+      for (const MatrixScenario& scenario : kScenarios)
+      {
+        error += std::string(" ") + scenario.name;
+      }
+      error += ")";
+      return false;
+    }
+    if (std::find(scenarios.begin(), scenarios.end(), name) == scenarios.end())
+    {
+      scenarios.push_back(name);
+    }
+  }
+  return true;
+}
+
+auto run_matrix(const CliArgs& args, const TestPlan& plan) -> int
+{
+  std::vector<ScenarioRuns> matrix;
+  for (const std::string& name : args.matrix_scenarios)
+  {
+    matrix.emplace_back();
+    matrix.back().scenario = find_scenario(name);
+  }
+  if (matrix.size() < 2)
+  {
+    std::cerr << "[ERROR] --matrix needs at least one scenario besides default" << std::endl;
+    return 1;
+  }
+  const size_t total_runs = matrix.size() * static_cast<size_t>(args.matrix_repeat);
+  size_t run_index = 0;
+  // Each repetition starts one scenario later, so every scenario takes every position in the
+  // order equally often and slow drifts (time of day, thermal state) hit all of them alike
+  for (int repetition = 0; repetition < args.matrix_repeat; ++repetition)
+  {
+    for (size_t slot = 0; slot < matrix.size(); ++slot)
+    {
+      ScenarioRuns& runs = matrix[(slot + static_cast<size_t>(repetition)) % matrix.size()];
+      if (!args.output_json && !args.minimize_output)
+      {
+        std::cout << "[MATRIX] Run " << ++run_index << "/" << total_runs << ": "
+                  << runs.scenario->name << std::endl;
+      }
+      MatrixRun run{};
+      if (!run_scenario(args, *runs.scenario, plan, run))
+      {
+        ++runs.failed_runs;
+        continue;
+      }
+      for (size_t metric_index = 0; metric_index < kMetricCount; ++metric_index)
+      {
+        const double value = run.values[metric_index];
+        if (std::isfinite(value) && value > 0)
+        {
+          runs.values[metric_index].push_back(value);
+        }
+        else
+        {
+          ++runs.failed_values[metric_index];
+        }
+      }
+      runs.failed_transfers += run.failed_transfers;
+    }
+  }
+  if (args.output_json)
+  {
+    print_matrix_json(matrix, args.matrix_repeat);
+  }
+  else
+  {
+    print_matrix_table(matrix, args.matrix_repeat);
+  }
+  return 0;
+}
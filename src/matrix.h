@@ -0,0 +1,16 @@
+#pragma once
+#include <string>  // for string
+#include <vector>  // for vector
+
+struct CliArgs;
+struct TestPlan;
+
+// Scenario matrix (--matrix): tuning scenarios (default, single-core, no-yield, ...) run
+// interleaved, --repeat times each, and every scenario is compared with "default" by a
+// Mann-Whitney U test per headline metric. Each run is a forked child so process-wide settings
+// such as nice and CPU affinity cannot carry over into the next scenario.
+auto matrix_scenario_names() -> std::vector<std::string>;
+// Known names, "default" first and without duplicates; false with error on an unknown name
+auto resolve_matrix_scenarios(const std::vector<std::string>& names,
+                              std::vector<std::string>& scenarios, std::string& error) -> bool;
+auto run_matrix(const CliArgs& args, const TestPlan& plan) -> int;
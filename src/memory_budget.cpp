@@ -0,0 +1,297 @@
+#include "memory_budget.h"
+#include <fcntl.h>            // for open, O_RDONLY, O_CLOEXEC
+#include <malloc.h>           // for malloc_usable_size
+#include <stddef.h>           // for ptrdiff_t
+#include <stdint.h>           // for uint32_t
+#include <sys/mman.h>         // for mmap, MAP_ANONYMOUS, MAP_PRIVATE, MAP_POPULATE, PROT_READ
+#include <unistd.h>           // for close, read, sysconf, write, _SC_PAGESIZE
+#include <algorithm>          // for max
+#include <atomic>             // for atomic, memory_order_relaxed
+#include <condition_variable> // for condition_variable
+#include <cstdio>             // for snprintf
+#include <cstdlib>            // for malloc, free, strtol, _Exit
+#include <iomanip>            // for setprecision
+#include <iostream>           // for operator<<, basic_ostream, clog, fixed
+#include <new>                // for bad_alloc, nothrow_t
+#include "sysinfo.h"          // for get_self_usage, SelfUsage
+#include "test_plan.h"        // for kMaxPlanConcurrency
+
+constexpr double kBytesPerMb = 1024.0 * 1024.0;
+constexpr size_t kScratchSlots = kMaxPlanConcurrency;
+constexpr size_t kArenaBytes = kScratchSlots * kTransferScratchBytes + kJsonArenaBytes;
+static_assert(kScratchSlots <= 32, "scratch slots are tracked in a 32-bit mask");
+
+namespace
+{
+// Heap accounting of the replaced operator new; usable sizes, so new and delete agree. Live is
+// signed: a block allocated before counting started is subtracted when it is freed
+std::atomic<bool> g_heap_counting{false};
+std::atomic<ptrdiff_t> g_heap_live{0};
+std::atomic<ptrdiff_t> g_heap_peak{0};
+std::atomic<size_t> g_heap_allocations{0};
+std::atomic<size_t> g_heap_allocated{0};
+// 0 = no budget; otherwise the heap may use the budget minus the arena
+std::atomic<ptrdiff_t> g_heap_limit{0};
+size_t g_budget_bytes = 0;
+
+// The arena: kScratchSlots transfer buffers followed by the JSON region
+char* g_arena = nullptr;
+std::mutex g_scratch_mutex;
+std::condition_variable g_scratch_released;
+uint32_t g_scratch_in_use = 0; // bit per slot
+size_t g_scratch_count = 0;
+size_t g_scratch_peak = 0;
+std::mutex g_json_mutex;
+
+auto counted_malloc(size_t size) -> void*
+{
+  void* pointer = std::malloc(size == 0 ? 1 : size);
+  if (pointer == nullptr || !g_heap_counting.load(std::memory_order_relaxed))
+  {
+    return pointer;
+  }
+  const size_t usable = malloc_usable_size(pointer);
+  const auto signed_usable = static_cast<ptrdiff_t>(usable);
+  const ptrdiff_t live =
+      g_heap_live.fetch_add(signed_usable, std::memory_order_relaxed) + signed_usable;
+  g_heap_allocations.fetch_add(1, std::memory_order_relaxed);
+  g_heap_allocated.fetch_add(usable, std::memory_order_relaxed);
+  ptrdiff_t peak = g_heap_peak.load(std::memory_order_relaxed);
+  while (live > peak &&
+         !g_heap_peak.compare_exchange_weak(peak, live, std::memory_order_relaxed))
+  {
+  }
+  const ptrdiff_t limit = g_heap_limit.load(std::memory_order_relaxed);
+  if (limit != 0 && live > limit)
+  {
+    memory_budget_exceeded("heap", static_cast<size_t>(live) + kArenaBytes);
+  }
+  return pointer;
+}
+
+void counted_free(void* pointer)
+{
+  if (pointer != nullptr && g_heap_counting.load(std::memory_order_relaxed))
+  {
+    g_heap_live.fetch_sub(static_cast<ptrdiff_t>(malloc_usable_size(pointer)),
+                          std::memory_order_relaxed);
+  }
+  std::free(pointer);
+}
+
+// Resident set from /proc/self/statm, read without allocating (called from transfer threads)
+auto resident_bytes() -> size_t
+{
+  const int fd = ::open("/proc/self/statm", O_RDONLY | O_CLOEXEC);
+  if (fd < 0)
+  {
+    return 0;
+  }
+  char text[128];
+  const ssize_t length = ::read(fd, text, sizeof(text) - 1);
+  ::close(fd);
+  if (length <= 0)
+  {
+    return 0;
+  }
+  text[length] = '\0';
+  char* cursor = nullptr;
+  (void)std::strtol(text, &cursor, 10); // total program size
+  const long resident_pages = std::strtol(cursor, nullptr, 10);
+  return static_cast<size_t>(resident_pages) * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+}
+} // namespace
+
+// Replaced global allocation functions: count once enabled, enforce the budget when set.
+// The aligned (std::align_val_t) forms keep their library definitions and are not counted.
+auto operator new(size_t size) -> void*
+{
+  void* pointer = counted_malloc(size);
+  if (pointer == nullptr)
+  {
+    throw std::bad_alloc();
+  }
+  return pointer;
+}
+
+auto operator new[](size_t size) -> void*
+{
+  return operator new(size);
+}
+
+auto operator new(size_t size, const std::nothrow_t& /*tag*/) noexcept -> void*
+{
+  return counted_malloc(size);
+}
+
+auto operator new[](size_t size, const std::nothrow_t& /*tag*/) noexcept -> void*
+{
+  return counted_malloc(size);
+}
+
+void operator delete(void* pointer) noexcept
+{
+  counted_free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept
+{
+  counted_free(pointer);
+}
+
+void operator delete(void* pointer, size_t /*size*/) noexcept
+{
+  counted_free(pointer);
+}
+
+void operator delete[](void* pointer, size_t /*size*/) noexcept
+{
+  counted_free(pointer);
+}
+
+void operator delete(void* pointer, const std::nothrow_t& /*tag*/) noexcept
+{
+  counted_free(pointer);
+}
+
+void operator delete[](void* pointer, const std::nothrow_t& /*tag*/) noexcept
+{
+  counted_free(pointer);
+}
+
+auto heap_counters() -> HeapCounters
+{
+  HeapCounters counters;
+  counters.allocations = g_heap_allocations.load(std::memory_order_relaxed);
+  counters.allocated_bytes = g_heap_allocated.load(std::memory_order_relaxed);
+  counters.live_bytes =
+      static_cast<size_t>(std::max<ptrdiff_t>(0, g_heap_live.load(std::memory_order_relaxed)));
+  counters.peak_live_bytes = static_cast<size_t>(g_heap_peak.load(std::memory_order_relaxed));
+  return counters;
+}
+
+auto enable_heap_counting() -> void
+{
+  g_heap_counting.store(true, std::memory_order_relaxed);
+}
+
+auto heap_counting_enabled() -> bool
+{
+  return g_heap_counting.load(std::memory_order_relaxed);
+}
+
+auto memory_budget_exceeded(const char* what, size_t used_bytes) -> void
+{
+  char message[160];
+  const int length = std::snprintf(
+      message, sizeof(message), "[ERROR] Memory budget exceeded: %s at %.1f MB of %.1f MB\n",
+      what, static_cast<double>(used_bytes) / kBytesPerMb,
+      static_cast<double>(g_budget_bytes) / kBytesPerMb);
+  if (length > 0)
+  {
+    (void)::write(STDERR_FILENO, message, static_cast<size_t>(length));
+  }
+  std::_Exit(kExitMemoryBudget);
+}
+
+auto enable_memory_budget(size_t budget_bytes, std::string& error) -> bool
+{
+  // Heap in use before counting starts is not known here; the resident set check covers it
+  if (budget_bytes <= kArenaBytes)
+  {
+    error = "Memory budget must be larger than " +
+            std::to_string(kArenaBytes / (1024 * 1024) + 1) +
+            " MB (transfer buffers and JSON arena)";
+    return false;
+  }
+  // Populated up front: the arena is resident from the start and can never fault in later
+  void* arena = ::mmap(nullptr, kArenaBytes, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+  if (arena == MAP_FAILED)
+  {
+    error = "Could not reserve the " + std::to_string(kArenaBytes / 1024) + " KB memory arena";
+    return false;
+  }
+  g_arena = static_cast<char*>(arena);
+  g_budget_bytes = budget_bytes;
+  enable_heap_counting();
+  g_heap_limit = static_cast<ptrdiff_t>(budget_bytes - kArenaBytes);
+  return true;
+}
+
+auto memory_budget_enabled() -> bool
+{
+  return g_arena != nullptr;
+}
+
+auto check_memory_budget() -> void
+{
+  if (g_arena == nullptr)
+  {
+    return;
+  }
+  const size_t resident = resident_bytes();
+  if (resident > g_budget_bytes)
+  {
+    memory_budget_exceeded("resident set", resident);
+  }
+}
+
+auto print_memory_report() -> void
+{
+  const SelfUsage usage = get_self_usage();
+  std::clog << std::fixed << std::setprecision(1);
+  std::clog << "[MEM] Peak RSS: " << static_cast<double>(usage.max_rss_bytes) / kBytesPerMb
+            << " MB";
+  if (g_budget_bytes != 0)
+  {
+    std::clog << " (budget " << static_cast<double>(g_budget_bytes) / kBytesPerMb << " MB)";
+  }
+  std::clog << "\n";
+  if (heap_counting_enabled())
+  {
+    const HeapCounters heap = heap_counters();
+    std::clog << "[MEM] Heap: " << heap.allocations << " allocations, "
+              << static_cast<double>(heap.allocated_bytes) / kBytesPerMb << " MB in total, "
+              << static_cast<double>(heap.peak_live_bytes) / kBytesPerMb << " MB peak live\n";
+  }
+  if (g_arena != nullptr)
+  {
+    std::lock_guard<std::mutex> lock(g_scratch_mutex);
+    std::clog << "[MEM] Arena: " << static_cast<double>(kArenaBytes) / kBytesPerMb << " MB ("
+              << kScratchSlots << " x " << kTransferScratchBytes / 1024
+              << " KB transfer buffers, peak " << g_scratch_peak << " in use; "
+              << static_cast<double>(kJsonArenaBytes) / kBytesPerMb << " MB JSON)\n";
+  }
+  std::clog << std::defaultfloat << std::flush;
+}
+
+TransferScratch::TransferScratch()
+{
+  std::unique_lock<std::mutex> lock(g_scratch_mutex);
+  // Plans cap concurrency at kMaxPlanConcurrency, so this only waits on a caller's own excess
+  g_scratch_released.wait(lock, [] { return g_scratch_count < kScratchSlots; });
+  while ((g_scratch_in_use & (1U << slot_)) != 0)
+  {
+    ++slot_;
+  }
+  g_scratch_in_use |= 1U << slot_;
+  g_scratch_peak = std::max(g_scratch_peak, ++g_scratch_count);
+  data_ = g_arena + slot_ * kTransferScratchBytes;
+}
+
+TransferScratch::~TransferScratch()
+{
+  {
+    std::lock_guard<std::mutex> lock(g_scratch_mutex);
+    g_scratch_in_use &= ~(1U << slot_);
+    --g_scratch_count;
+  }
+  g_scratch_released.notify_one();
+}
+
+JsonArenaLease::JsonArenaLease() : lock_(g_json_mutex)
+{
+  char* region = g_arena + kScratchSlots * kTransferScratchBytes;
+  (void)yyjson_alc_pool_init(&allocator_, region, kJsonArenaBytes);
+}
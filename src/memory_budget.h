@@ -0,0 +1,75 @@
+#pragma once
+#include <stddef.h>  // for size_t
+#include <mutex>     // for unique_lock, mutex
+#include <string>    // for string
+#include <yyjson.h>  // for yyjson_alc
+
+// Opt-in memory budget (--memory-budget) for small routers. Enabling it reserves one arena up
+// front that backs the transfer buffers and the result JSON document, so neither grows with the
+// test plan. Live C++ heap is accounted in the replaced global operator new and the resident set
+// is checked after every measured transfer; crossing the budget ends the process at once with
+// kExitMemoryBudget instead of letting the kernel OOM killer pick a victim later.
+// Allocation counting is off until something needs it (the budget, the per-phase overhead of a
+// JSON run or the -v report); until then operator new costs one relaxed atomic load over malloc.
+constexpr int kExitMemoryBudget = 3;
+constexpr size_t kTransferScratchBytes = 64 * 1024; // one streaming buffer per transfer
+constexpr size_t kJsonArenaBytes = 4 * 1024 * 1024; // result document and its serialized text
+
+// Totals of the replaced operator new since enable_heap_counting (usable sizes). Live bytes are
+// relative to that point too: frees of older blocks count against them, floored at 0
+struct HeapCounters
+{
+  size_t allocations = 0;
+  size_t allocated_bytes = 0;
+  size_t live_bytes = 0;
+  size_t peak_live_bytes = 0;
+};
+
+auto heap_counters() -> HeapCounters;
+// Starts counting; stays on for the rest of the process. Idempotent and thread-safe
+auto enable_heap_counting() -> void;
+auto heap_counting_enabled() -> bool;
+// Fails (error set) when the arena cannot be mapped or the budget does not leave room for it;
+// enables heap counting, which the heap limit needs
+auto enable_memory_budget(size_t budget_bytes, std::string& error) -> bool;
+auto memory_budget_enabled() -> bool;
+// Resident set check; exits with kExitMemoryBudget when it is over the budget
+auto check_memory_budget() -> void;
+// [MEM] lines on std::clog: peak RSS, heap allocation counts (when counted) and arena use
+auto print_memory_report() -> void;
+
+// Fixed transfer buffer leased from the arena for one transfer (budget mode only)
+class TransferScratch
+{
+public:
+  TransferScratch();
+  ~TransferScratch();
+  TransferScratch(const TransferScratch&) = delete;
+  auto operator=(const TransferScratch&) -> TransferScratch& = delete;
+
+  auto data() const -> char* { return data_; }
+  auto size() const -> size_t { return kTransferScratchBytes; }
+
+private:
+  size_t slot_ = 0;
+  char* data_ = nullptr;
+};
+
+// yyjson pool allocator over the arena's JSON region, reset for every lease; one document at a
+// time (budget mode only)
+class JsonArenaLease
+{
+public:
+  JsonArenaLease();
+  JsonArenaLease(const JsonArenaLease&) = delete;
+  auto operator=(const JsonArenaLease&) -> JsonArenaLease& = delete;
+
+  auto allocator() const -> const yyjson_alc* { return &allocator_; }
+
+private:
+  std::unique_lock<std::mutex> lock_;
+  yyjson_alc allocator_{};
+};
+
+// Ends the process with kExitMemoryBudget; writes its message without allocating
+[[noreturn]] auto memory_budget_exceeded(const char* what, size_t used_bytes) -> void;
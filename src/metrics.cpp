@@ -0,0 +1,276 @@
+#include "metrics.h"
+#include <sys/socket.h>            // for setsockopt, SOL_SOCKET, SO_RCVTIMEO
+#include <sys/time.h>              // for timeval
+#include <cstdio>                  // for rename, remove
+#include <ctime>                   // for time
+#include <exception>               // for exception
+#include <fstream>                 // IWYU pragma: keep  // for ofstream
+#include <iomanip>                 // for setprecision
+#include <iostream>                // for operator<<, basic_ostream, cerr
+#include <memory>                  // for make_shared, shared_ptr
+#include <mutex>                   // for mutex, lock_guard
+#include <sstream>                 // for ostringstream
+#include <string>                  // for string, operator+
+#include <thread>                  // for thread
+#include <boost/asio/ip/tcp.hpp>   // for tcp::acceptor, tcp::socket
+#include <boost/beast/core.hpp>    // for flat_buffer, error_code
+#include <boost/beast/http.hpp>    // for request, response, read, write
+#include <boost/beast/version.hpp> // for BOOST_BEAST_VERSION_STRING
+#include "json_helpers.h"          // for compute_result_metrics
+#include "sysinfo.h"               // for get_self_usage, SelfUsage
+#include "types.h"                 // for TestResults, ResultMetrics
+
+// Prometheus text exposition 0.0.4: what the node_exporter textfile collector parses
+constexpr const char* kMetricsContentType = "text/plain; version=0.0.4; charset=utf-8";
+constexpr double kMsPerSecond = 1000.0;
+constexpr int kListenerReadTimeoutSec = 5;
+constexpr int kMetricsPrecision = 12;
+
+namespace
+{
+// Figures from the most recent run plus counters accumulated over the process lifetime
+struct MetricsSnapshot
+{
+  bool has_run = false;
+  std::string city, colo;
+  ResultMetrics metrics;
+  double latency_min = 0, latency_max = 0, latency_median = 0;
+  double bootstrap_ms = 0, latency_ms = 0, download_ms = 0, upload_ms = 0, total_ms = 0;
+  long last_run_time = 0;
+  long runs_total = 0;
+  long run_failures_total = 0;
+  long download_failures_total = 0;
+  long upload_failures_total = 0;
+};
+
+std::mutex g_metrics_mutex;
+MetricsSnapshot g_snapshot;
+
+auto escape_label(const std::string& value) -> std::string
+{
+  std::string escaped;
+  escaped.reserve(value.size());
+  for (const char c : value)
+  {
+    if (c == '\\' || c == '"')
+    {
+      escaped += '\\';
+      escaped += c;
+    }
+    else if (c == '\n')
+    {
+      escaped += "\\n";
+    }
+    else
+    {
+      escaped += c;
+    }
+  }
+  return escaped;
+}
+
+// HELP and TYPE name exactly the samples that follow (counters keep their _total suffix)
+void add_family(std::ostringstream& out, const char* name, const char* type, const char* help)
+{
+  out << "# HELP " << name << ' ' << help << '\n' << "# TYPE " << name << ' ' << type << '\n';
+}
+
+void serve_metrics_request(boost::asio::ip::tcp::socket& socket)
+{
+  namespace beast = boost::beast;
+  namespace http = beast::http;
+  // Bound how long a stalled client can hold the single listener thread
+  struct timeval read_timeout
+  {
+  };
+  read_timeout.tv_sec = kListenerReadTimeoutSec;
+  (void)setsockopt(socket.native_handle(), SOL_SOCKET, SO_RCVTIMEO, &read_timeout,
+                   sizeof(read_timeout));
+  beast::flat_buffer buffer;
+  http::request<http::string_body> request;
+  beast::error_code ec;
+  http::read(socket, buffer, request, ec);
+  if (ec)
+  {
+    return;
+  }
+  http::response<http::string_body> response;
+  response.version(request.version());
+  response.set(http::field::server, BOOST_BEAST_VERSION_STRING);
+  response.keep_alive(false);
+  const bool is_read = request.method() == http::verb::get || request.method() == http::verb::head;
+  if (is_read && request.target() == "/metrics")
+  {
+    response.result(http::status::ok);
+    response.set(http::field::content_type, kMetricsContentType);
+    response.body() = render_prometheus_text();
+  }
+  else
+  {
+    response.result(http::status::not_found);
+    response.set(http::field::content_type, "text/plain");
+    response.body() = "Not Found\n";
+  }
+  response.prepare_payload();
+  if (request.method() == http::verb::head)
+  {
+    response.body().clear();
+  }
+  http::write(socket, response, ec);
+  socket.shutdown(boost::asio::ip::tcp::socket::shutdown_send, ec);
+}
+} // namespace
+
+auto record_run_metrics(const TestResults& results) -> void
+{
+  const ResultMetrics metrics = compute_result_metrics(results);
+  std::lock_guard<std::mutex> lock(g_metrics_mutex);
+  g_snapshot.has_run = true;
+  g_snapshot.city = results.city;
+  g_snapshot.colo = results.colo;
+  g_snapshot.metrics = metrics;
+  g_snapshot.latency_min = results.latency.size() > 0 ? results.latency[0] : 0.0;
+  g_snapshot.latency_max = results.latency.size() > 1 ? results.latency[1] : 0.0;
+  g_snapshot.latency_median = results.latency.size() > 3 ? results.latency[3] : 0.0;
+  g_snapshot.bootstrap_ms = results.bootstrap_ms;
+  g_snapshot.latency_ms = results.latency_ms;
+  g_snapshot.download_ms = results.download_ms;
+  g_snapshot.upload_ms = results.upload_ms;
+  g_snapshot.total_ms = results.total_time_ms;
+  g_snapshot.last_run_time = static_cast<long>(std::time(nullptr));
+  ++g_snapshot.runs_total;
+  g_snapshot.download_failures_total += results.download_failures;
+  g_snapshot.upload_failures_total += results.upload_failures;
+}
+
+auto record_run_failure() -> void
+{
+  std::lock_guard<std::mutex> lock(g_metrics_mutex);
+  ++g_snapshot.run_failures_total;
+}
+
+auto render_prometheus_text() -> std::string
+{
+  MetricsSnapshot snap;
+  {
+    std::lock_guard<std::mutex> lock(g_metrics_mutex);
+    snap = g_snapshot;
+  }
+  const SelfUsage usage = get_self_usage();
+  std::ostringstream out;
+  out << std::setprecision(kMetricsPrecision);
+  if (snap.has_run)
+  {
+    add_family(out, "speedcloudflare_server_info", "gauge", "Cloudflare colo used by the last run");
+    out << "speedcloudflare_server_info{colo=\"" << escape_label(snap.colo) << "\",city=\""
+        << escape_label(snap.city) << "\"} 1\n";
+    add_family(out, "speedcloudflare_download_mbps", "gauge",
+               "Download throughput percentiles of the last run");
+    out << "speedcloudflare_download_mbps{percentile=\"p50\"} " << snap.metrics.download_50pct
+        << '\n';
+    out << "speedcloudflare_download_mbps{percentile=\"p90\"} " << snap.metrics.download_90pct
+        << '\n';
+    add_family(out, "speedcloudflare_upload_mbps", "gauge",
+               "Upload throughput percentiles of the last run");
+    out << "speedcloudflare_upload_mbps{percentile=\"p50\"} " << snap.metrics.upload_50pct
+        << '\n';
+    out << "speedcloudflare_upload_mbps{percentile=\"p90\"} " << snap.metrics.upload_90pct
+        << '\n';
+    add_family(out, "speedcloudflare_latency_seconds", "gauge", "Latency of the last run");
+    out << "speedcloudflare_latency_seconds{stat=\"min\"} " << snap.latency_min / kMsPerSecond
+        << '\n';
+    out << "speedcloudflare_latency_seconds{stat=\"avg\"} "
+        << snap.metrics.latency_avg / kMsPerSecond << '\n';
+    out << "speedcloudflare_latency_seconds{stat=\"median\"} "
+        << snap.latency_median / kMsPerSecond << '\n';
+    out << "speedcloudflare_latency_seconds{stat=\"max\"} " << snap.latency_max / kMsPerSecond
+        << '\n';
+    add_family(out, "speedcloudflare_jitter_seconds", "gauge", "Latency jitter of the last run");
+    out << "speedcloudflare_jitter_seconds " << snap.metrics.jitter / kMsPerSecond << '\n';
+    add_family(out, "speedcloudflare_phase_duration_seconds", "gauge",
+               "Wall-clock duration of each phase of the last run");
+    out << "speedcloudflare_phase_duration_seconds{phase=\"bootstrap\"} "
+        << snap.bootstrap_ms / kMsPerSecond << '\n';
+    out << "speedcloudflare_phase_duration_seconds{phase=\"latency\"} "
+        << snap.latency_ms / kMsPerSecond << '\n';
+    out << "speedcloudflare_phase_duration_seconds{phase=\"download\"} "
+        << snap.download_ms / kMsPerSecond << '\n';
+    out << "speedcloudflare_phase_duration_seconds{phase=\"upload\"} "
+        << snap.upload_ms / kMsPerSecond << '\n';
+    out << "speedcloudflare_phase_duration_seconds{phase=\"total\"} "
+        << snap.total_ms / kMsPerSecond << '\n';
+    add_family(out, "speedcloudflare_last_run_timestamp_seconds", "gauge",
+               "Unix time the last run finished");
+    out << "speedcloudflare_last_run_timestamp_seconds " << snap.last_run_time << '\n';
+  }
+  add_family(out, "speedcloudflare_runs_total", "counter", "Completed runs");
+  out << "speedcloudflare_runs_total " << snap.runs_total << '\n';
+  add_family(out, "speedcloudflare_run_failures_total", "counter", "Runs aborted by an error");
+  out << "speedcloudflare_run_failures_total " << snap.run_failures_total << '\n';
+  add_family(out, "speedcloudflare_request_failures_total", "counter", "Failed transfer requests");
+  out << "speedcloudflare_request_failures_total{direction=\"download\"} "
+      << snap.download_failures_total << '\n';
+  out << "speedcloudflare_request_failures_total{direction=\"upload\"} "
+      << snap.upload_failures_total << '\n';
+  add_family(out, "process_cpu_seconds_total", "counter", "User and system CPU time of this tool");
+  out << "process_cpu_seconds_total " << usage.cpu_seconds << '\n';
+  add_family(out, "process_resident_memory_bytes", "gauge", "Resident memory of this tool");
+  out << "process_resident_memory_bytes " << usage.rss_bytes << '\n';
+  add_family(out, "process_max_resident_memory_bytes", "gauge",
+             "Peak resident memory of this tool");
+  out << "process_max_resident_memory_bytes " << usage.max_rss_bytes << '\n';
+  return out.str();
+}
+
+auto write_metrics_textfile(const std::string& path) -> bool
+{
+  // node_exporter may read at any moment: write a sibling temp file and rename it into place
+  const std::string tmp_path = path + ".tmp";
+  {
+    std::ofstream out(tmp_path, std::ios::trunc);
+    if (!out)
+    {
+      return false;
+    }
+    out << render_prometheus_text();
+    if (!out)
+    {
+      (void)std::remove(tmp_path.c_str());
+      return false;
+    }
+  }
+  return std::rename(tmp_path.c_str(), path.c_str()) == 0;
+}
+
+auto start_metrics_listener(unsigned short port) -> bool
+{
+  namespace net = boost::asio;
+  using tcp = net::ip::tcp;
+  try
+  {
+    auto ioc = std::make_shared<net::io_context>();
+    auto acceptor = std::make_shared<tcp::acceptor>(*ioc, tcp::endpoint(tcp::v4(), port));
+    std::thread(
+        [ioc, acceptor]()
+        {
+          for (;;)
+          {
+            tcp::socket socket(*ioc);
+            boost::beast::error_code ec;
+            acceptor->accept(socket, ec);
+            if (!ec)
+            {
+              serve_metrics_request(socket);
+            }
+          }
+        })
+        .detach();
+    return true;
+  }
+  catch (const std::exception& ex)
+  {
+    std::cerr << "[ERROR] Could not start metrics listener on port " << port << ": " << ex.what()
+              << std::endl;
+    return false;
+  }
+}
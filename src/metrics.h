@@ -0,0 +1,13 @@
+#pragma once
+#include <string>  // for string
+
+struct TestResults;
+
+// Prometheus text export (format 0.0.4): node_exporter textfile collector and an optional
+// /metrics listener.
+// Both only render the snapshot recorded after the last run; scraping never starts a test.
+auto record_run_metrics(const TestResults& results) -> void;
+auto record_run_failure() -> void;
+auto render_prometheus_text() -> std::string;
+auto write_metrics_textfile(const std::string& path) -> bool;
+auto start_metrics_listener(unsigned short port) -> bool;
@@ -1,8 +1,18 @@
 #include "network.h"
 #include <stddef.h>
+#include <openssl/ssl.h>
+#include <atomic>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <limits>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <sstream>
 #include <string>
+#include <utility>
 #include <vector>
 #include <yyjson.h>
 #include <boost/beast/core.hpp>
@@ -13,40 +23,265 @@
 #include <boost/asio/ip/tcp.hpp>
 #include <boost/asio/ssl/error.hpp>
 #include <boost/asio/ssl/stream.hpp>
+#include "trace.h"
 
 // Modernized: braces, descriptive variable names, trailing return types, auto, nullptr, one
 // declaration per statement, no implicit conversions
 
+namespace
+{
+namespace beast = boost::beast;
+namespace http = beast::http;
+namespace net = boost::asio;
+using tcp = net::ip::tcp;
+
+constexpr std::chrono::seconds kDnsCacheTtl{300};
+
+using CachedEndpoints =
+    std::pair<tcp::resolver::results_type, std::chrono::steady_clock::time_point>;
+
+// Every connect_stream gets a new id; the calling thread remembers the last one it used
+std::atomic<unsigned> g_next_connection_id{1};
+thread_local unsigned t_last_connection_id = 0;
+thread_local std::string t_last_local_address;
+// Counted as the parser consumes and the serializer writes, so an aborted transfer still adds
+// what it moved before the error
+std::atomic<uint64_t> g_http_bytes_received{0};
+std::atomic<uint64_t> g_http_bytes_sent{0};
+
+// Connection state kept between requests while warm mode is enabled (daemon mode): one shared
+// TLS context, resolved endpoints per host and the last TLS session per host for resumption.
+struct WarmState
+{
+  std::mutex mutex;
+  bool enabled = false;
+  std::shared_ptr<net::ssl::context> ssl_ctx;
+  std::map<std::string, CachedEndpoints> dns_cache;
+  std::map<std::string, SSL_SESSION*> tls_sessions;
+};
+
+auto warm_state() -> WarmState&
+{
+  static WarmState state;
+  return state;
+}
+
+auto acquire_ssl_context() -> std::shared_ptr<net::ssl::context>
+{
+  auto& warm = warm_state();
+  std::lock_guard<std::mutex> lock(warm.mutex);
+  if (warm.enabled)
+  {
+    return warm.ssl_ctx;
+  }
+  return std::make_shared<net::ssl::context>(net::ssl::context::sslv23_client);
+}
+
+auto resolve_host(net::io_context& ioc, const std::string& hostname)
+    -> tcp::resolver::results_type
+{
+  auto& warm = warm_state();
+  {
+    std::lock_guard<std::mutex> lock(warm.mutex);
+    if (warm.enabled)
+    {
+      auto cached = warm.dns_cache.find(hostname);
+      if (cached != warm.dns_cache.end() &&
+          std::chrono::steady_clock::now() - cached->second.second < kDnsCacheTtl)
+      {
+        return cached->second.first;
+      }
+    }
+  }
+  tcp::resolver resolver(ioc);
+  // "host", "host:port" or "[v6]:port"; the full authority is also what goes into Host
+  std::string host = hostname;
+  std::string port = "443";
+  const size_t colon = hostname.rfind(':');
+  if (colon != std::string::npos && colon > 0 && hostname.find(']') == colon - 1)
+  {
+    host = hostname.substr(1, colon - 2);
+    port = hostname.substr(colon + 1);
+  }
+  else if (colon != std::string::npos && hostname.find(':') == colon)
+  {
+    host = hostname.substr(0, colon);
+    port = hostname.substr(colon + 1);
+  }
+  auto results = resolver.resolve(host, port);
+  std::lock_guard<std::mutex> lock(warm.mutex);
+  if (warm.enabled)
+  {
+    warm.dns_cache[hostname] = {results, std::chrono::steady_clock::now()};
+  }
+  return results;
+}
+
+// Resolve, connect and handshake; offers the cached TLS session for resumption in warm mode
+void connect_stream(net::io_context& ioc, beast::ssl_stream<beast::tcp_stream>& stream,
+                    const std::string& hostname)
+{
+  // Cleared first so a request that fails before connecting is not charged to the previous one
+  t_last_connection_id = 0;
+  tcp::resolver::results_type results;
+  {
+    const TraceScope span("net", "resolve");
+    results = resolve_host(ioc, hostname);
+  }
+  t_last_connection_id = g_next_connection_id++;
+  {
+    TraceScope span("net", "connect");
+    span.set_connection(t_last_connection_id);
+    beast::get_lowest_layer(stream).connect(results);
+  }
+  boost::system::error_code endpoint_error;
+  const tcp::endpoint local =
+      beast::get_lowest_layer(stream).socket().local_endpoint(endpoint_error);
+  if (!endpoint_error)
+  {
+    t_last_local_address = local.address().to_string();
+  }
+  {
+    auto& warm = warm_state();
+    std::lock_guard<std::mutex> lock(warm.mutex);
+    auto session = warm.tls_sessions.find(hostname);
+    if (warm.enabled && session != warm.tls_sessions.end())
+    {
+      SSL_set_session(stream.native_handle(), session->second);
+    }
+  }
+  TraceScope span("net", "handshake");
+  span.set_connection(t_last_connection_id);
+  stream.handshake(net::ssl::stream_base::client);
+}
+
+// Called after the response is read so TLS 1.3 session tickets have arrived
+void remember_tls_session(beast::ssl_stream<beast::tcp_stream>& stream,
+                          const std::string& hostname)
+{
+  auto& warm = warm_state();
+  std::lock_guard<std::mutex> lock(warm.mutex);
+  if (!warm.enabled)
+  {
+    return;
+  }
+  SSL_SESSION* session = SSL_get1_session(stream.native_handle());
+  if (session == nullptr)
+  {
+    return;
+  }
+  SSL_SESSION*& slot = warm.tls_sessions[hostname];
+  if (slot != nullptr)
+  {
+    SSL_SESSION_free(slot);
+  }
+  slot = session;
+}
+using TlsStream = beast::ssl_stream<beast::tcp_stream>;
+
+// Adds bytes to a process-wide counter and rethrows a transport error
+void count_bytes(std::atomic<uint64_t>& counter, size_t bytes, const beast::error_code& ec)
+{
+  counter += bytes;
+  if (ec)
+  {
+    throw beast::system_error{ec};
+  }
+}
+
+template <class Body>
+void traced_write(TlsStream& stream, http::request<Body>& request)
+{
+  const TraceScope span("http", "write");
+  beast::error_code ec;
+  const size_t written = http::write(stream, request, ec);
+  count_bytes(g_http_bytes_sent, written, ec);
+}
+
+// Header and body are read separately so the wait for the first byte shows on the timeline
+auto traced_read(TlsStream& stream, beast::flat_buffer& buffer)
+    -> http::response<http::string_body>
+{
+  http::response_parser<http::string_body> parser;
+  beast::error_code ec;
+  {
+    const TraceScope span("http", "first byte");
+    const size_t header_bytes = http::read_header(stream, buffer, parser, ec);
+    count_bytes(g_http_bytes_received, header_bytes, ec);
+  }
+  const TraceScope span("http", "body");
+  const size_t body_bytes = http::read(stream, buffer, parser, ec);
+  count_bytes(g_http_bytes_received, body_bytes, ec);
+  return parser.release();
+}
+
+void traced_shutdown(TlsStream& stream)
+{
+  const TraceScope span("net", "shutdown");
+  beast::error_code ec;
+  stream.shutdown(ec);
+}
+} // namespace
+
+auto last_connection_id() -> unsigned
+{
+  return t_last_connection_id;
+}
+
+auto last_local_address() -> std::string
+{
+  return t_last_local_address;
+}
+
+auto http_byte_counts() -> HttpByteCounts
+{
+  return HttpByteCounts{g_http_bytes_received.load(), g_http_bytes_sent.load()};
+}
+
+void set_network_keep_warm(bool enabled)
+{
+  auto& warm = warm_state();
+  std::lock_guard<std::mutex> lock(warm.mutex);
+  warm.enabled = enabled;
+  if (enabled && !warm.ssl_ctx)
+  {
+    warm.ssl_ctx = std::make_shared<net::ssl::context>(net::ssl::context::sslv23_client);
+  }
+  if (!enabled)
+  {
+    for (auto& entry : warm.tls_sessions)
+    {
+      SSL_SESSION_free(entry.second);
+    }
+    warm.tls_sessions.clear();
+    warm.dns_cache.clear();
+    warm.ssl_ctx.reset();
+  }
+}
+
 // Refactored HTTP GET using Boost.Beast
 // Only accept HttpRequest struct to avoid swappable parameters
 auto http_get(const HttpRequest& req) -> std::string
 {
-    namespace beast = boost::beast;
-    namespace http = beast::http;
-    namespace net = boost::asio;
-    using tcp = net::ip::tcp;
-
+    TraceScope request_span("http", "GET", req.path);
     net::io_context ioc;
-    net::ssl::context ctx(net::ssl::context::sslv23_client);
-    tcp::resolver resolver(ioc);
-    beast::ssl_stream<beast::tcp_stream> stream(ioc, ctx);
+    auto ctx = acquire_ssl_context();
+    beast::ssl_stream<beast::tcp_stream> stream(ioc, *ctx);
 
-    auto const results = resolver.resolve(req.hostname, "443");
-    beast::get_lowest_layer(stream).connect(results);
-    stream.handshake(net::ssl::stream_base::client);
+    connect_stream(ioc, stream, req.hostname);
+    request_span.set_connection(t_last_connection_id);
 
     http::request<http::string_body> request{http::verb::get, req.path, 11};
     request.set(http::field::host, req.hostname);
     request.set(http::field::user_agent, BOOST_BEAST_VERSION_STRING);
 
-    http::write(stream, request);
+    traced_write(stream, request);
 
     beast::flat_buffer buffer;
-    http::response<http::string_body> response;
-    http::read(stream, buffer, response);
+    http::response<http::string_body> response = traced_read(stream, buffer);
+    remember_tls_session(stream, req.hostname);
 
-    beast::error_code ec;
-    stream.shutdown(ec);
+    traced_shutdown(stream);
 
     if (response.result() == http::status::ok) {
         return response.body();
@@ -57,19 +292,13 @@ auto http_get(const HttpRequest& req) -> std::string
 // Refactored HTTP POST using Boost.Beast
 auto http_post(const HttpRequest& req, const std::string& data) -> std::string
 {
-    namespace beast = boost::beast;
-    namespace http = beast::http;
-    namespace net = boost::asio;
-    using tcp = net::ip::tcp;
-
+    TraceScope request_span("http", "POST", req.path);
     net::io_context ioc;
-    net::ssl::context ctx(net::ssl::context::sslv23_client);
-    tcp::resolver resolver(ioc);
-    beast::ssl_stream<beast::tcp_stream> stream(ioc, ctx);
+    auto ctx = acquire_ssl_context();
+    beast::ssl_stream<beast::tcp_stream> stream(ioc, *ctx);
 
-    auto const results = resolver.resolve(req.hostname, "443");
-    beast::get_lowest_layer(stream).connect(results);
-    stream.handshake(net::ssl::stream_base::client);
+    connect_stream(ioc, stream, req.hostname);
+    request_span.set_connection(t_last_connection_id);
 
     http::request<http::string_body> request{http::verb::post, req.path, 11};
     request.set(http::field::host, req.hostname);
@@ -78,14 +307,13 @@ auto http_post(const HttpRequest& req, const std::string& data) -> std::string
     request.body() = data;
     request.prepare_payload();
 
-    http::write(stream, request);
+    traced_write(stream, request);
 
     beast::flat_buffer buffer;
-    http::response<http::string_body> response;
-    http::read(stream, buffer, response);
+    http::response<http::string_body> response = traced_read(stream, buffer);
+    remember_tls_session(stream, req.hostname);
 
-    beast::error_code ec;
-    stream.shutdown(ec);
+    traced_shutdown(stream);
 
     std::string debug_info;
     debug_info += "[UPLOAD] HTTP response code: " + std::to_string(response.result_int()) + "\n";
@@ -94,40 +322,128 @@ auto http_post(const HttpRequest& req, const std::string& data) -> std::string
     return debug_info;
 }
 
-auto parse_locations_json(const std::string& json)
-    -> std::vector<std::map<std::string, std::string>>
+auto http_download(const HttpRequest& req, char* scratch, size_t scratch_size) -> size_t
+{
+  TraceScope request_span("http", "GET", req.path);
+  net::io_context ioc;
+  auto ctx = acquire_ssl_context();
+  beast::ssl_stream<beast::tcp_stream> stream(ioc, *ctx);
+  connect_stream(ioc, stream, req.hostname);
+  request_span.set_connection(t_last_connection_id);
+  http::request<http::empty_body> request{http::verb::get, req.path, 11};
+  request.set(http::field::host, req.hostname);
+  request.set(http::field::user_agent, BOOST_BEAST_VERSION_STRING);
+  traced_write(stream, request);
+
+  // Only the header lands in the flat_buffer; the body is parsed into scratch piece by piece
+  beast::flat_buffer buffer;
+  http::response_parser<http::buffer_body> parser;
+  parser.body_limit((std::numeric_limits<std::uint64_t>::max)());
+  {
+    const TraceScope span("http", "first byte");
+    beast::error_code ec;
+    const size_t header_bytes = http::read_header(stream, buffer, parser, ec);
+    count_bytes(g_http_bytes_received, header_bytes, ec);
+  }
+  size_t received = 0;
+  {
+    const TraceScope span("http", "body");
+    while (!parser.is_done())
+    {
+      parser.get().body().data = scratch;
+      parser.get().body().size = scratch_size;
+      beast::error_code ec;
+      const size_t parsed = http::read(stream, buffer, parser, ec);
+      count_bytes(g_http_bytes_received, parsed,
+                  ec == http::error::need_buffer ? beast::error_code{} : ec);
+      received += scratch_size - parser.get().body().size;
+    }
+  }
+  remember_tls_session(stream, req.hostname);
+  traced_shutdown(stream);
+  return parser.get().result() == http::status::ok ? received : 0;
+}
+
+auto http_upload(const HttpRequest& req, size_t num_bytes, char* scratch, size_t scratch_size)
+    -> size_t
+{
+  TraceScope request_span("http", "POST", req.path);
+  net::io_context ioc;
+  auto ctx = acquire_ssl_context();
+  beast::ssl_stream<beast::tcp_stream> stream(ioc, *ctx);
+  connect_stream(ioc, stream, req.hostname);
+  request_span.set_connection(t_last_connection_id);
+  http::request<http::buffer_body> request{http::verb::post, req.path, 11};
+  request.set(http::field::host, req.hostname);
+  request.set(http::field::user_agent, BOOST_BEAST_VERSION_STRING);
+  request.set(http::field::content_type, "application/json");
+  request.content_length(num_bytes);
+  request.body().data = nullptr;
+  request.body().more = true;
+
+  // Same payload as http_post ('0' bytes), sent from one scratch buffer over and over
+  std::memset(scratch, '0', std::min(scratch_size, num_bytes));
+  http::request_serializer<http::buffer_body> serializer{request};
+  {
+    const TraceScope span("http", "write");
+    beast::error_code header_ec;
+    const size_t header_bytes = http::write_header(stream, serializer, header_ec);
+    count_bytes(g_http_bytes_sent, header_bytes, header_ec);
+    size_t remaining = num_bytes;
+    while (remaining > 0)
+    {
+      const size_t chunk = std::min(remaining, scratch_size);
+      request.body().data = scratch;
+      request.body().size = chunk;
+      request.body().more = remaining > chunk;
+      beast::error_code ec;
+      const size_t written = http::write(stream, serializer, ec);
+      count_bytes(g_http_bytes_sent, written,
+                  ec == http::error::need_buffer ? beast::error_code{} : ec);
+      remaining -= chunk;
+    }
+  }
+
+  beast::flat_buffer buffer;
+  http::response<http::string_body> response = traced_read(stream, buffer);
+  remember_tls_session(stream, req.hostname);
+  traced_shutdown(stream);
+  return response.result() == http::status::ok ? num_bytes : 0;
+}
+
+auto parse_locations_json(const std::string& json) -> LocationIndex
 {
-  std::vector<std::map<std::string, std::string>> locations_result = {};
+  std::vector<LocationEntry> entries = {};
   yyjson_doc* json_doc = nullptr;
   yyjson_val* json_array = nullptr;
   yyjson_val* json_value = nullptr;
   json_doc = yyjson_read(json.c_str(), json.size(), 0);
   if (json_doc == nullptr)
   {
-    return locations_result;
+    return {};
   }
   json_array = yyjson_doc_get_root(json_doc);
   if (!yyjson_is_arr(json_array))
   {
     yyjson_doc_free(json_doc);
-    return locations_result;
+    return {};
   }
+  entries.reserve(yyjson_arr_size(json_array));
   size_t array_index = 0;
   size_t array_max = 0;
   yyjson_arr_foreach(json_array, array_index, array_max, json_value)
   {
-    std::map<std::string, std::string> entry{};
     yyjson_val* iata_val = yyjson_obj_get(json_value, "iata");
     yyjson_val* city_val = yyjson_obj_get(json_value, "city");
-    if (iata_val != nullptr && city_val != nullptr)
+    if (yyjson_is_str(iata_val) && yyjson_is_str(city_val))
     {
-      entry["iata"] = yyjson_get_str(iata_val);
-      entry["city"] = yyjson_get_str(city_val);
-      locations_result.push_back(entry);
+      entries.push_back(
+          LocationEntry{std::string(yyjson_get_str(iata_val), yyjson_get_len(iata_val)),
+                        std::string(yyjson_get_str(city_val), yyjson_get_len(city_val))});
     }
   }
   yyjson_doc_free(json_doc);
-  return locations_result;
+  return LocationIndex(std::move(entries));
 }
 
 auto parse_cdn_trace(const std::string& text) -> std::map<std::string, std::string>
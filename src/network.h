@@ -1,7 +1,10 @@
 #pragma once
+#include <cstddef>
+#include <cstdint>
 #include <map>
 #include <string>
 #include <vector>
+#include "locations.h"
 
 // HTTP request helpers
 struct HttpRequest {
@@ -10,10 +13,30 @@ struct HttpRequest {
 };
 auto http_get(const HttpRequest& req) -> std::string;
 auto http_post(const HttpRequest& req, const std::string& data) -> std::string;
+// Bounded-memory variants (--memory-budget): bodies stream through the caller's scratch buffer
+// instead of a std::string, whatever the transfer size. Return body bytes moved, 0 unless 200 OK
+auto http_download(const HttpRequest& req, char* scratch, size_t scratch_size) -> size_t;
+auto http_upload(const HttpRequest& req, size_t num_bytes, char* scratch, size_t scratch_size)
+    -> size_t;
+// Id of the connection behind this thread's last request; 0 before the first one and when
+// that request failed before connecting (e.g. while resolving)
+auto last_connection_id() -> unsigned;
+// Local IP address of that connection, which names the interface the test traffic uses
+auto last_local_address() -> std::string;
+// HTTP bytes (headers and bodies) read and written by every request of the process so far,
+// failed and warmup ones included. Read around a phase, like interface counters
+struct HttpByteCounts
+{
+  uint64_t received = 0;
+  uint64_t sent = 0;
+};
+auto http_byte_counts() -> HttpByteCounts;
+// Keep TLS context, DNS answers and TLS sessions between requests (daemon mode). Connections
+// themselves are not reused: each request still connects and does a (resumed) TLS handshake
+void set_network_keep_warm(bool enabled);
 
 // JSON parsing helpers
-auto parse_locations_json(const std::string& json)
-    -> std::vector<std::map<std::string, std::string>>;
+auto parse_locations_json(const std::string& json) -> LocationIndex;
 auto parse_cdn_trace(const std::string& text) -> std::map<std::string, std::string>;
 
 void set_benchmark_cpu_affinity(int cpu_core);
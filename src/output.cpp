@@ -1,19 +1,26 @@
 #include "output.h"
 #include <yyjson.h>        // for yyjson_mut_doc_free, yyjson_mut_obj, yyjson_mut_arr, etc.
 #include <algorithm>       // for max, min
+#include <atomic>          // for atomic
 #include <cmath>           // for NAN
+#include <cstdio>          // for rename, remove
 #include <cstdlib>         // for free, size_t
-#include <fstream>         // IWYU pragma: keep  // for ifstream
+#include <fstream>         // IWYU pragma: keep  // for ofstream
+#include <future>          // for async, future
 #include <iomanip>         // for operator<<, setw, setfill, setprecision
 #include <iostream>        // for operator<<, basic_ostream, endl, ostream
-#include <iterator>        // for istreambuf_iterator, operator!=
 #include <memory>          // for allocator_traits<>::value_type, unique_ptr
-#include <regex>           // for regex_search, match_results<>::_Unchecked
 #include <string>          // for string, operator<<, basic_string, char_traits
+#include <thread>          // for thread
+#include <utility>         // for pair
 #include <vector>          // for vector
 #include "chalk.h"         // for bold, green, magenta, blue, yellow
+#include "estimation.h"    // for ConfidenceInterval
+#include "histogram.h"     // for LogHistogram
 #include "json_helpers.h"  // for add_num, add_str, is_valid_utf8
-#include "stats.h"         // for quartile, median
+#include "mapped_file.h"   // for MappedFile
+#include "stats.h"         // for quartile, median, StreamingStats
+#include "summary_index.h" // for SummaryIndex, FileIdentity, stat_file_identity
 #include "types.h"         // for SummaryResult
 
 // Helper: print human-readable explanation for yyjson error codes
@@ -37,10 +44,13 @@ constexpr int kFieldWidthLatency = 10;
 constexpr int kFieldWidthJitter = 10;
 constexpr int kFieldWidthDownload = 12;
 constexpr int kFieldWidthUpload = 12;
+constexpr int kFieldWidthCi = 20;
 constexpr int kFieldWidthDivider = 6;
 constexpr int kSummaryDividerLen = kFieldWidthFile + kFieldWidthCity + kFieldWidthIP +
                                    kFieldWidthLatency + kFieldWidthJitter + kFieldWidthDownload +
-                                   kFieldWidthUpload + kFieldWidthDivider;
+                                   kFieldWidthUpload + 2 * kFieldWidthCi + kFieldWidthDivider;
+constexpr double kPercentile50 = 0.5;
+constexpr double kPercentile99 = 0.99;
 constexpr int kLogInfoPad = 15;
 constexpr int kLogSpeedPad = 9;
 constexpr double kPercentile90 = 0.9;
@@ -49,10 +59,34 @@ constexpr int kPrintableAsciiMax = 126;
 constexpr int kHexDumpPreviewLen = 64;
 constexpr int kHexDumpLastLen = 64;
 constexpr int kAsciiDelete = 127;
+constexpr size_t kFilesPerWorker = 16; // below this a thread costs more than it saves
 
 // Modernized: braces, descriptive variable names, trailing return types, auto, nullptr, one
 // declaration per statement, no implicit conversions
 
+// Flat [bucket, count, ...] array written by add_histogram
+static auto read_sparse_histogram(yyjson_val* arr) -> LogHistogram::SparseBuckets
+{
+  LogHistogram::SparseBuckets buckets;
+  if (!yyjson_is_arr(arr))
+  {
+    return buckets;
+  }
+  const size_t value_count = yyjson_arr_size(arr);
+  buckets.reserve(value_count / 2);
+  for (size_t index = 0; index + 1 < value_count; index += 2)
+  {
+    yyjson_val* bucket = yyjson_arr_get(arr, index);
+    yyjson_val* count = yyjson_arr_get(arr, index + 1);
+    if (yyjson_is_uint(bucket) && yyjson_is_uint(count))
+    {
+      buckets.emplace_back(static_cast<uint32_t>(yyjson_get_uint(bucket)),
+                           static_cast<uint32_t>(yyjson_get_uint(count)));
+    }
+  }
+  return buckets;
+}
+
 auto fmt(double value) -> std::string
 {
   std::ostringstream oss;
@@ -60,6 +94,28 @@ auto fmt(double value) -> std::string
   return oss.str();
 }
 
+static auto format_ci(const ConfidenceInterval& interval) -> std::string
+{
+  if (interval.lower == 0.0 && interval.upper == 0.0)
+  {
+    return "-";
+  }
+  return "[" + fmt(interval.lower) + ", " + fmt(interval.upper) + "]";
+}
+
+// [estimate, lower, upper] array written by add_estimate
+static auto read_interval(yyjson_val* arr) -> ConfidenceInterval
+{
+  ConfidenceInterval interval;
+  if (yyjson_is_arr(arr) && yyjson_arr_size(arr) == 3)
+  {
+    interval.estimate = yyjson_get_num(yyjson_arr_get(arr, 0));
+    interval.lower = yyjson_get_num(yyjson_arr_get(arr, 1));
+    interval.upper = yyjson_get_num(yyjson_arr_get(arr, 2));
+  }
+  return interval;
+}
+
 void log_info(const std::string& label, const std::string& data, bool output_json)
 {
   if (output_json)
@@ -132,61 +188,140 @@ void print_summary_table(const std::vector<SummaryResult>& results)
             << "Server City" << std::setw(kFieldWidthIP) << "IP" << std::setw(kFieldWidthLatency)
             << "Latency" << std::setw(kFieldWidthJitter) << "Jitter"
             << std::setw(kFieldWidthDownload) << "Download" << std::setw(kFieldWidthUpload)
-            << "Upload" << std::endl;
+            << "Upload" << std::setw(kFieldWidthCi) << "Download p90 95%CI"
+            << std::setw(kFieldWidthCi) << "Upload p90 95%CI" << std::endl;
   std::cout << std::string(kSummaryDividerLen, '-') << std::endl;
-  double sum_latency = 0.0, sum_jitter = 0.0, sum_download = 0.0, sum_upload = 0.0;
+  stats::StreamingStats latency_stats;
+  stats::StreamingStats jitter_stats;
+  stats::StreamingStats download_stats;
+  stats::StreamingStats upload_stats;
+  // Fleet-wide distributions: exact bucket sums over every file that carries histograms
+  LogHistogram latency_hist;
+  LogHistogram download_hist;
+  LogHistogram upload_hist;
   for (const auto& r : results)
   {
     std::cout << std::left << std::setw(kFieldWidthFile) << r.file << std::setw(kFieldWidthCity)
               << r.server_city << std::setw(kFieldWidthIP) << r.ip << std::setw(kFieldWidthLatency)
               << r.latency << std::setw(kFieldWidthJitter) << r.jitter
               << std::setw(kFieldWidthDownload) << r.download << std::setw(kFieldWidthUpload)
-              << r.upload << std::endl;
-    sum_latency += r.latency;
-    sum_jitter += r.jitter;
-    sum_download += r.download;
-    sum_upload += r.upload;
+              << r.upload << std::setw(kFieldWidthCi) << format_ci(r.download_ci)
+              << std::setw(kFieldWidthCi) << format_ci(r.upload_ci) << std::endl;
+    latency_stats.add(r.latency);
+    jitter_stats.add(r.jitter);
+    download_stats.add(r.download);
+    upload_stats.add(r.upload);
+    latency_hist.merge(r.latency_histogram);
+    download_hist.merge(r.download_histogram);
+    upload_hist.merge(r.upload_histogram);
   }
-  size_t n = results.size();
-  if (n > 0)
+  std::cout << std::string(kSummaryDividerLen, '=') << std::endl;
+  std::cout << std::left << std::setw(kFieldWidthFile) << "AVERAGE" << std::setw(kFieldWidthCity)
+            << "-" << std::setw(kFieldWidthIP) << "-" << std::setw(kFieldWidthLatency)
+            << latency_stats.mean() << std::setw(kFieldWidthJitter) << jitter_stats.mean()
+            << std::setw(kFieldWidthDownload) << download_stats.mean()
+            << std::setw(kFieldWidthUpload) << upload_stats.mean() << std::endl;
+  if (results.size() > 1)
   {
-    std::cout << std::string(kSummaryDividerLen, '=') << std::endl;
-    std::cout << std::left << std::setw(kFieldWidthFile) << "AVERAGE" << std::setw(kFieldWidthCity)
+    std::cout << std::left << std::setw(kFieldWidthFile) << "STDDEV" << std::setw(kFieldWidthCity)
               << "-" << std::setw(kFieldWidthIP) << "-" << std::setw(kFieldWidthLatency)
-              << (sum_latency / static_cast<double>(n)) << std::setw(kFieldWidthJitter)
-              << (sum_jitter / static_cast<double>(n)) << std::setw(kFieldWidthDownload)
-              << (sum_download / static_cast<double>(n)) << std::setw(kFieldWidthUpload)
-              << (sum_upload / static_cast<double>(n)) << std::endl;
+              << latency_stats.stddev() << std::setw(kFieldWidthJitter) << jitter_stats.stddev()
+              << std::setw(kFieldWidthDownload) << download_stats.stddev()
+              << std::setw(kFieldWidthUpload) << upload_stats.stddev() << std::endl;
+  }
+  if (latency_hist.total() + download_hist.total() + upload_hist.total() == 0)
+  {
+    return;
+  }
+  const std::pair<const char*, double> fleet_rows[] = {
+      {"ALL SAMPLES p50", kPercentile50},
+      {"ALL SAMPLES p90", kPercentile90},
+      {"ALL SAMPLES p99", kPercentile99}};
+  for (const auto& row : fleet_rows)
+  {
+    std::cout << std::left << std::setw(kFieldWidthFile) << row.first
+              << std::setw(kFieldWidthCity) << "-" << std::setw(kFieldWidthIP) << "-"
+              << std::setw(kFieldWidthLatency) << latency_hist.quantile(row.second)
+              << std::setw(kFieldWidthJitter) << "-" << std::setw(kFieldWidthDownload)
+              << download_hist.quantile(row.second) << std::setw(kFieldWidthUpload)
+              << upload_hist.quantile(row.second) << std::endl;
   }
 }
 
-std::vector<SummaryResult> load_summary_results(const std::vector<std::string>& files,
-                                                bool is_diagnostics, bool is_debug)
+// Per-worker parse buffers, reused across files so steady-state loading does not allocate
+struct SummaryParseScratch
 {
-  std::vector<SummaryResult> results{};
-  for (const auto& file : files)
+  std::vector<char> copy;  // padded copy when the mapping has no room for yyjson padding
+  std::vector<char> pool;  // yyjson pool allocator backing store
+};
+
+// In-situ parse of a mapped file into a pool sized for the worst case; the document (and any
+// string it returns) lives in scratch/mapped and is only valid until the next parse
+static auto parse_summary_document(MappedFile& mapped, SummaryParseScratch& scratch)
+    -> yyjson_doc*
+{
+  char* input = mapped.data();
+  if (!mapped.has_tail_padding(YYJSON_PADDING_SIZE))
+  {
+    scratch.copy.assign(mapped.data(), mapped.data() + mapped.size());
+    scratch.copy.resize(mapped.size() + YYJSON_PADDING_SIZE, '\0');
+    input = scratch.copy.data();
+  }
+  const size_t pool_size = yyjson_read_max_memory_usage(mapped.size(), YYJSON_READ_INSITU);
+  if (scratch.pool.size() < pool_size)
+  {
+    scratch.pool.resize(pool_size);
+  }
+  yyjson_alc pool_alc;
+  if (!yyjson_alc_pool_init(&pool_alc, scratch.pool.data(), scratch.pool.size()))
+  {
+    return nullptr;
+  }
+  return yyjson_read_opts(input, mapped.size(), YYJSON_READ_INSITU, &pool_alc, nullptr);
+}
+
+static auto load_summary_file(const std::string& file, bool is_diagnostics, bool is_debug,
+                              SummaryParseScratch& scratch, SummaryResult& r) -> bool
+{
+  MappedFile mapped;
+  if (!mapped.open(file))
   {
-    std::ifstream in(file);
-    if (!in)
+    if (is_debug)
+      std::clog << "[DEBUG] Skipping " << file << ": could not open file" << std::endl;
+    return false;
+  }
+  const char* json = mapped.size() > 0 ? mapped.data() : "";
+  size_t file_size = mapped.size();
+  if (is_diagnostics)
+  {
+    std::clog << "[DIAG] File: " << file << std::endl;
+    std::clog << "[DIAG]   Size: " << file_size << " bytes" << std::endl;
+    size_t print_len = std::min<size_t>(kHexDumpPreviewLen, file_size);
+    std::clog << "[DIAG]   First " << print_len << " bytes (hex): ";
+    for (size_t i = 0; i < print_len; ++i)
+      std::clog << std::hex << std::uppercase << std::setw(2) << std::setfill('0')
+                << (unsigned int)(unsigned char)json[i] << " ";
+    std::clog << std::dec << std::endl;
+    std::clog << "[DIAG]   First " << print_len << " bytes (text): ";
+    for (size_t i = 0; i < print_len; ++i)
     {
-      if (is_debug)
-        std::clog << "[DEBUG] Skipping " << file << ": could not open file" << std::endl;
-      continue;
+      char c = json[i];
+      if (c >= kPrintableAsciiMin && c <= kPrintableAsciiMax)
+        std::clog << c;
+      else
+        std::clog << '.';
     }
-    std::string json((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
-    size_t file_size = json.size();
-    if (is_diagnostics)
+    std::clog << std::endl;
+    if (file_size > kHexDumpLastLen)
     {
-      std::clog << "[DIAG] File: " << file << std::endl;
-      std::clog << "[DIAG]   Size: " << file_size << " bytes" << std::endl;
-      size_t print_len = std::min<size_t>(kHexDumpPreviewLen, file_size);
-      std::clog << "[DIAG]   First " << print_len << " bytes (hex): ";
-      for (size_t i = 0; i < print_len; ++i)
+      size_t start = file_size - kHexDumpLastLen;
+      std::clog << "[DIAG]   Last 64 bytes (hex): ";
+      for (size_t i = start; i < file_size; ++i)
         std::clog << std::hex << std::uppercase << std::setw(2) << std::setfill('0')
                   << (unsigned int)(unsigned char)json[i] << " ";
       std::clog << std::dec << std::endl;
-      std::clog << "[DIAG]   First " << print_len << " bytes (text): ";
-      for (size_t i = 0; i < print_len; ++i)
+      std::clog << "[DIAG]   Last 64 bytes (text): ";
+      for (size_t i = start; i < file_size; ++i)
       {
         char c = json[i];
         if (c >= kPrintableAsciiMin && c <= kPrintableAsciiMax)
@@ -195,438 +330,287 @@ std::vector<SummaryResult> load_summary_results(const std::vector<std::string>&
           std::clog << '.';
       }
       std::clog << std::endl;
-      if (file_size > kHexDumpLastLen)
+    }
+    bool has_null = false, has_nonprint = false;
+    for (size_t i = 0; i < file_size; ++i)
+    {
+      unsigned char c = json[i];
+      if (c == 0)
+        has_null = true;
+      if ((c < kPrintableAsciiMin && c != '\n' && c != '\r' && c != '\t') || c == kAsciiDelete)
+        has_nonprint = true;
+    }
+    if (has_null)
+      std::clog << "[DIAG]   WARNING: File contains null (\\0) bytes!" << std::endl;
+    if (has_nonprint)
+      std::clog << "[DIAG]   WARNING: File contains suspicious "
+                   "non-printable characters!"
+                << std::endl;
+  }
+  yyjson_doc* doc = parse_summary_document(mapped, scratch);
+  if (!doc)
+  {
+    if (is_debug)
+      std::clog << "[DEBUG] Skipping " << file << ": failed to parse JSON" << std::endl;
+    return false;
+  }
+  yyjson_val* root = yyjson_doc_get_root(doc);
+  if (!yyjson_is_obj(root))
+  {
+    if (is_debug)
+      std::clog << "[DEBUG] Skipping " << file << ": root is not a JSON object" << std::endl;
+    yyjson_doc_free(doc);
+    return false;
+  }
+  size_t pos = file.find_last_of("/\\");
+  r.file = (pos == std::string::npos) ? file : file.substr(pos + 1);
+  yyjson_val* v;
+  v = yyjson_obj_get(root, "server_city");
+  r.server_city = (v && yyjson_is_str(v) && yyjson_get_str(v)) ? yyjson_get_str(v) : "";
+  v = yyjson_obj_get(root, "ip");
+  r.ip = (v && yyjson_is_str(v) && yyjson_get_str(v)) ? yyjson_get_str(v) : "";
+  v = yyjson_obj_get(root, "latency_avg");
+  r.latency = v && yyjson_is_num(v) ? yyjson_get_real(v) : 0.0;
+  v = yyjson_obj_get(root, "jitter");
+  r.jitter = v && yyjson_is_num(v) ? yyjson_get_real(v) : 0.0;
+  v = yyjson_obj_get(root, "download_90pct");
+  r.download = v && yyjson_is_num(v) ? yyjson_get_real(v) : 0.0;
+  v = yyjson_obj_get(root, "upload_90pct");
+  r.upload = v && yyjson_is_num(v) ? yyjson_get_real(v) : 0.0;
+  v = yyjson_obj_get(root, "estimates");
+  if (yyjson_is_obj(v))
+  {
+    yyjson_val* download_est = yyjson_obj_get(v, "download");
+    yyjson_val* upload_est = yyjson_obj_get(v, "upload");
+    r.download_ci = read_interval(download_est ? yyjson_obj_get(download_est, "p90") : nullptr);
+    r.upload_ci = read_interval(upload_est ? yyjson_obj_get(upload_est, "p90") : nullptr);
+  }
+  v = yyjson_obj_get(root, "histograms");
+  yyjson_val* scheme = v ? yyjson_obj_get(v, "scheme") : nullptr;
+  if (yyjson_is_str(scheme) && std::string(yyjson_get_str(scheme)) == LogHistogram::kScheme)
+  {
+    r.latency_histogram = read_sparse_histogram(yyjson_obj_get(v, "latency_ms"));
+    r.download_histogram = read_sparse_histogram(yyjson_obj_get(v, "download_mbps"));
+    r.upload_histogram = read_sparse_histogram(yyjson_obj_get(v, "upload_mbps"));
+  }
+  if (is_debug)
+    std::clog << "[DEBUG] Loaded: " << r.file << " | server_city='" << r.server_city << "' ip='"
+              << r.ip << "' latency=" << r.latency << " jitter=" << r.jitter
+              << " download=" << r.download << " upload=" << r.upload << std::endl;
+  yyjson_doc_free(doc);
+  return true;
+}
+
+// Files are mapped and parsed on a small worker pool; results keep the input order. Debug and
+// diagnostics output is per file, so those modes stay sequential to keep the log readable.
+// With an index, files whose size and mtime match an entry are not opened at all, and newly
+// parsed files are added to it (the caller saves it).
+std::vector<SummaryResult> load_summary_results(const std::vector<std::string>& files,
+                                                bool is_diagnostics, bool is_debug,
+                                                SummaryIndex* index)
+{
+  enum : char
+  {
+    kNotLoaded,
+    kParsed,
+    kFromIndex
+  };
+  std::vector<SummaryResult> loaded(files.size());
+  std::vector<char> loaded_ok(files.size(), kNotLoaded);
+  std::vector<FileIdentity> identities(files.size());
+  std::vector<char> has_identity(files.size(), 0);
+  std::atomic<size_t> next_file{0};
+  auto worker = [&]()
+  {
+    SummaryParseScratch scratch;
+    for (size_t file_index = next_file++; file_index < files.size(); file_index = next_file++)
+    {
+      const std::string& file = files[file_index];
+      if (index != nullptr && stat_file_identity(file, identities[file_index]))
       {
-        size_t start = file_size - kHexDumpLastLen;
-        std::clog << "[DIAG]   Last 64 bytes (hex): ";
-        for (size_t i = start; i < file_size; ++i)
-          std::clog << std::hex << std::uppercase << std::setw(2) << std::setfill('0')
-                    << (unsigned int)(unsigned char)json[i] << " ";
-        std::clog << std::dec << std::endl;
-        std::clog << "[DIAG]   Last 64 bytes (text): ";
-        for (size_t i = start; i < file_size; ++i)
+        has_identity[file_index] = 1;
+        if (const SummaryResult* cached = index->find(file, identities[file_index]))
         {
-          char c = json[i];
-          if (c >= kPrintableAsciiMin && c <= kPrintableAsciiMax)
-            std::clog << c;
-          else
-            std::clog << '.';
+          loaded[file_index] = *cached;
+          loaded_ok[file_index] = kFromIndex;
+          continue;
         }
-        std::clog << std::endl;
       }
-      bool has_null = false, has_nonprint = false;
-      for (size_t i = 0; i < file_size; ++i)
-      {
-        unsigned char c = json[i];
-        if (c == 0)
-          has_null = true;
-        if ((c < kPrintableAsciiMin && c != '\n' && c != '\r' && c != '\t') || c == kAsciiDelete)
-          has_nonprint = true;
-      }
-      if (has_null)
-        std::clog << "[DIAG]   WARNING: File contains null (\\0) bytes!" << std::endl;
-      if (has_nonprint)
-        std::clog << "[DIAG]   WARNING: File contains suspicious "
-                     "non-printable characters!"
-                  << std::endl;
+      loaded_ok[file_index] =
+          load_summary_file(file, is_diagnostics, is_debug, scratch, loaded[file_index])
+              ? kParsed
+              : kNotLoaded;
     }
-    yyjson_doc* doc = yyjson_read(json.c_str(), json.size(), 0);
-    if (!doc)
+  };
+  const size_t hardware_threads = std::max(1U, std::thread::hardware_concurrency());
+  const size_t worker_count = (is_diagnostics || is_debug)
+                                  ? 1
+                                  : std::min(hardware_threads, files.size() / kFilesPerWorker + 1);
+  std::vector<std::future<void>> workers;
+  for (size_t worker_index = 1; worker_index < worker_count; ++worker_index)
+  {
+    workers.push_back(std::async(std::launch::async, worker));
+  }
+  worker();
+  for (auto& pending : workers)
+  {
+    pending.get();
+  }
+  std::vector<SummaryResult> results{};
+  results.reserve(files.size());
+  size_t from_index = 0;
+  for (size_t file_index = 0; file_index < files.size(); ++file_index)
+  {
+    if (loaded_ok[file_index] == kNotLoaded)
     {
-      if (is_debug)
-        std::clog << "[DEBUG] Skipping " << file << ": failed to parse JSON" << std::endl;
       continue;
     }
-    yyjson_val* root = yyjson_doc_get_root(doc);
-    if (!yyjson_is_obj(root))
+    if (loaded_ok[file_index] == kFromIndex)
     {
-      if (is_debug)
-        std::clog << "[DEBUG] Skipping " << file << ": root is not a JSON object" << std::endl;
-      yyjson_doc_free(doc);
-      continue;
+      ++from_index;
     }
-    SummaryResult r;
-    size_t pos = file.find_last_of("/\\");
-    r.file = (pos == std::string::npos) ? file : file.substr(pos + 1);
-    yyjson_val* v;
-    v = yyjson_obj_get(root, "server_city");
-    r.server_city = (v && yyjson_is_str(v) && yyjson_get_str(v)) ? yyjson_get_str(v) : "";
-    v = yyjson_obj_get(root, "ip");
-    r.ip = (v && yyjson_is_str(v) && yyjson_get_str(v)) ? yyjson_get_str(v) : "";
-    v = yyjson_obj_get(root, "latency_avg");
-    r.latency = v && yyjson_is_num(v) ? yyjson_get_real(v) : 0.0;
-    v = yyjson_obj_get(root, "jitter");
-    r.jitter = v && yyjson_is_num(v) ? yyjson_get_real(v) : 0.0;
-    v = yyjson_obj_get(root, "download_90pct");
-    r.download = v && yyjson_is_num(v) ? yyjson_get_real(v) : 0.0;
-    v = yyjson_obj_get(root, "upload_90pct");
-    r.upload = v && yyjson_is_num(v) ? yyjson_get_real(v) : 0.0;
-    if (is_debug)
-      std::clog << "[DEBUG] Loaded: " << r.file << " | server_city='" << r.server_city << "' ip='"
-                << r.ip << "' latency=" << r.latency << " jitter=" << r.jitter
-                << " download=" << r.download << " upload=" << r.upload << std::endl;
-    results.push_back(r);
-    yyjson_doc_free(doc);
+    else if (index != nullptr && has_identity[file_index] != 0)
+    {
+      index->store(files[file_index], identities[file_index], loaded[file_index]);
+    }
+    results.push_back(std::move(loaded[file_index]));
+  }
+  if (is_debug && index != nullptr)
+  {
+    std::clog << "[DEBUG] Summary index: " << from_index << " cached, "
+              << results.size() - from_index << " parsed" << std::endl;
   }
   return results;
 }
 
-void write_summary_json(const std::vector<SummaryResult>& results, const std::string& filename,
-                        bool is_diagnostics, bool is_debug, bool is_full_diagnostics)
+// Per-field UTF-8 check with hex and printable dumps, for tracking down unserializable entries
+static void log_summary_entry(size_t entry_index, const SummaryResult& entry)
 {
-  if (is_full_diagnostics) {
-    // Print full/incremental diagnostics for all entries
-    for (size_t n = 1; n <= results.size(); ++n)
+  const std::pair<const char*, const std::string*> fields[] = {
+      {"file", &entry.file}, {"server_city", &entry.server_city}, {"ip", &entry.ip}};
+  for (const auto& [name, value] : fields)
+  {
+    std::clog << "[DIAG] Entry " << entry_index << ", field '" << name << "' (file: " << entry.file
+              << "): " << (is_valid_utf8(*value) ? "valid UTF-8" : "INVALID UTF-8")
+              << ", len: " << value->size() << std::endl;
+    std::clog << "[DIAG]   Value (hex): ";
+    for (const unsigned char byte : *value)
     {
-      yyjson_mut_doc* test_doc = yyjson_mut_doc_new(nullptr);
-      std::clog << "[DIAG] test_doc ptr: " << (void*)test_doc << std::endl;
-      yyjson_mut_val* test_arr = yyjson_mut_arr(test_doc);
-      std::clog << "[DIAG] test_arr ptr: " << (void*)test_arr << std::endl;
-      std::regex label_re(R"(^(.*)\\.json$)");
-      bool ok = true;
-      std::vector<void*> obj_ptrs;
-      for (size_t i = 0; i < n; ++i)
-      {
-        const auto& entry = results[i];
-        std::string label = entry.file;
-        std::smatch m;
-        if (std::regex_search(entry.file, m, label_re) && m.size() > 1)
-          label = m[1].str();
-        struct FieldCheck
-        {
-          const char* name;
-          const std::string& value;
-        };
-        std::vector<FieldCheck> fields = {
-            {"file", entry.file},
-            {"server_city", entry.server_city},
-            {"ip", entry.ip}
-        };
-        // Check all string fields for UTF-8 validity and print hex/text
-        for (const auto& f : fields)
-        {
-          bool valid = is_valid_utf8(f.value);
-          std::clog << "[DIAG] Entry " << i << ", field '" << f.name
-                    << "' (file: " << entry.file.c_str()
-                    << "): " << (valid ? "valid UTF-8" : "INVALID UTF-8")
-                    << ", ptr: " << (const void*)f.value.c_str() << ", len: " << f.value.size()
-                    << std::endl;
-          std::clog << "[DIAG]   Value (hex): ";
-          for (unsigned char c : f.value)
-            std::clog << std::hex << std::uppercase << std::setw(2) << std::setfill('0') << (int)c << " ";
-          std::clog << std::dec << std::endl;
-          std::clog << "[DIAG]   Value (text): ";
-          for (unsigned char c : f.value)
-            std::clog << (c >= 32 && c <= 126 ? (char)c : '.');
-          std::clog << std::endl;
-        }
-        std::clog << "[DIAG] Entry " << i << ", label (used in output): '" << label.c_str()
-                  << "', ptr: " << (const void*)label.c_str() << ", len: " << label.size()
-                  << std::endl;
-        std::clog << "[DIAG]   Label (hex): ";
-        for (unsigned char c : label)
-          std::clog << std::hex << std::uppercase << std::setw(2) << std::setfill('0') << c;
-        std::clog << std::dec << std::endl;
-        yyjson_mut_val* test_obj = yyjson_mut_obj(test_doc);
-        std::clog << "[DIAG] test_obj[" << i << "] ptr: " << (void*)test_obj << std::endl;
-        obj_ptrs.push_back((void*)test_obj);
-        if (!test_obj)
-        {
-          ok = false;
-          break;
-        }
-        auto safe = [](const std::string& s) -> const char* { return s.empty() ? "" : s.c_str(); };
-        add_str(test_doc, test_obj, "label", label);
-        add_str(test_doc, test_obj, "server_city", entry.server_city);
-        add_str(test_doc, test_obj, "ip", entry.ip);
-        add_num(test_doc, test_obj, "latency", entry.latency);
-        add_num(test_doc, test_obj, "jitter", entry.jitter);
-        add_num(test_doc, test_obj, "download", entry.download);
-        add_num(test_doc, test_obj, "upload", entry.upload);
-        int arr_add_ret = yyjson_mut_arr_add_val(test_arr, test_obj);
-        std::clog << "[DIAG] Added test_obj[" << i << "] ptr: " << (void*)test_obj
-                  << " to test_arr ptr: " << (void*)test_arr
-                  << ", arr_add_ret: " << arr_add_ret << std::endl;
-        // Explicit parent-child relationship
-        std::clog << "[DIAG] Parent-child: test_arr (" << (void*)test_arr << ") <- test_obj[" << i << "] (" << (void*)test_obj << ")" << std::endl;
-      }
-      if (ok)
-      {
-        yyjson_mut_val* test_root = yyjson_mut_obj(test_doc);
-        std::clog << "[DIAG] test_root ptr: " << (void*)test_root << std::endl;
-        int obj_add_ret = yyjson_mut_obj_add_val(test_doc, test_root, "results", test_arr);
-        std::clog << "[DIAG] yyjson_mut_obj_add_val (results) ret: " << obj_add_ret << std::endl;
-        yyjson_mut_doc_set_root(test_doc, test_root);
-        yyjson_write_err err;
-        char* test_out = yyjson_mut_write_opts(test_doc, 0, nullptr, nullptr, &err);
-        std::unique_ptr<char, decltype(&free)> test_out_ptr(test_out, &free);
-        if (!test_out_ptr)
-        {
-          std::clog << "[DIAG] Serialization failed at n=" << n << " (label='"
-                    << results[n - 1].file.c_str()
-                    << "'): yyjson error: " << err.msg << " (code " << err.code << ")" << std::endl;
-          print_yyjson_error_explanation(err.code);
-          // Print all object pointers and their parent relationships
-          std::clog << "[DIAG] Dumping all object pointers, field values, and parent relationships for this run:" << std::endl;
-          for (size_t j = 0; j < obj_ptrs.size(); ++j) {
-            std::clog << "[DIAG]   obj_ptrs[" << j << "]: " << obj_ptrs[j] << std::endl;
-            const auto& entry = results[j];
-            std::clog << "[DIAG]     file: " << entry.file << std::endl;
-            std::clog << "[DIAG]     server_city: " << entry.server_city << std::endl;
-            std::clog << "[DIAG]     ip: " << entry.ip << std::endl;
-            std::clog << "[DIAG]     latency: " << entry.latency << std::endl;
-            std::clog << "[DIAG]     jitter: " << entry.jitter << std::endl;
-            std::clog << "[DIAG]     download: " << entry.download << std::endl;
-            std::clog << "[DIAG]     upload: " << entry.upload << std::endl;
-            // Print parent (test_arr) pointer for each object
-            std::clog << "[DIAG]     parent array ptr: " << (void*)test_arr << std::endl;
-          }
-          yyjson_mut_doc* single_doc = yyjson_mut_doc_new(nullptr);
-          yyjson_mut_val* single_obj = yyjson_mut_obj(single_doc);
-          std::clog << "[DIAG] single_doc ptr: " << (void*)single_doc
-                    << ", single_obj ptr: " << (void*)single_obj << std::endl;
-          std::string label = results[n - 1].file;
-          std::smatch m;
-          if (std::regex_search(results[n - 1].file, m, label_re) && m.size() > 1)
-            label = m[1].str();
-          auto safe = [](const std::string& s) -> const char*
-          { return s.empty() ? "" : s.c_str(); };
-          add_str(single_doc, single_obj, "label", label);
-          add_str(single_doc, single_obj, "server_city", results[n - 1].server_city);
-          add_str(single_doc, single_obj, "ip", results[n - 1].ip);
-          add_num(single_doc, single_obj, "latency", results[n - 1].latency);
-          add_num(single_doc, single_obj, "jitter", results[n - 1].jitter);
-          add_num(single_doc, single_obj, "download", results[n - 1].download);
-          add_num(single_doc, single_obj, "upload", results[n - 1].upload);
-          yyjson_mut_doc_set_root(single_doc, single_obj);
-          char* single_json = yyjson_mut_write(single_doc, 0, nullptr);
-          std::unique_ptr<char, decltype(&free)> single_json_ptr(single_json, &free);
-          if (single_json_ptr)
-          {
-            std::clog << "[DIAG] Problematic entry JSON: " << single_json_ptr.get() << std::endl;
-          }
-          else
-          {
-            std::clog << "[DIAG] Problematic entry could not be serialized individually!"
-                      << std::endl;
-          }
-          yyjson_mut_doc_free(single_doc);
-          yyjson_mut_doc_free(test_doc);
-          std::clog << "[DIAG] Created " << obj_ptrs.size() << " objects in this run" << std::endl;
-          break;
-        }
-        else
-        {
-          // Serialization succeeded
-        }
-      }
-      yyjson_mut_doc_free(test_doc);
+      std::clog << std::hex << std::uppercase << std::setw(2) << std::setfill('0')
+                << static_cast<int>(byte) << " ";
     }
-  } else if (is_diagnostics) {
-    // Only print diagnostics for the failing entry (if any)
-    for (size_t n = 1; n <= results.size(); ++n)
+    std::clog << std::dec << std::endl;
+    std::clog << "[DIAG]   Value (text): ";
+    for (const unsigned char byte : *value)
     {
-      yyjson_mut_doc* test_doc = yyjson_mut_doc_new(nullptr);
-      std::clog << "[DIAG] test_doc ptr: " << (void*)test_doc << std::endl;
-      yyjson_mut_val* test_arr = yyjson_mut_arr(test_doc);
-      std::clog << "[DIAG] test_arr ptr: " << (void*)test_arr << std::endl;
-      std::regex label_re(R"(^(.*)\\.json$)");
-      bool ok = true;
-      std::vector<void*> obj_ptrs;
-      for (size_t i = 0; i < n; ++i)
-      {
-        const auto& entry = results[i];
-        std::string label = entry.file;
-        std::smatch m;
-        if (std::regex_search(entry.file, m, label_re) && m.size() > 1)
-          label = m[1].str();
-        struct FieldCheck
-        {
-          const char* name;
-          const std::string& value;
-        };
-        std::vector<FieldCheck> fields = {
-            {"file", entry.file},
-            {"server_city", entry.server_city},
-            {"ip", entry.ip}
-        };
-        // Check all string fields for UTF-8 validity and print hex/text
-        for (const auto& f : fields)
-        {
-          bool valid = is_valid_utf8(f.value);
-          std::clog << "[DIAG] Entry " << i << ", field '" << f.name
-                    << "' (file: " << entry.file.c_str()
-                    << "): " << (valid ? "valid UTF-8" : "INVALID UTF-8")
-                    << ", ptr: " << (const void*)f.value.c_str() << ", len: " << f.value.size()
-                    << std::endl;
-          std::clog << "[DIAG]   Value (hex): ";
-          for (unsigned char c : f.value)
-            std::clog << std::hex << std::uppercase << std::setw(2) << std::setfill('0') << (int)c << " ";
-          std::clog << std::dec << std::endl;
-          std::clog << "[DIAG]   Value (text): ";
-          for (unsigned char c : f.value)
-            std::clog << (c >= 32 && c <= 126 ? (char)c : '.');
-          std::clog << std::endl;
-        }
-        std::clog << "[DIAG] Entry " << i << ", label (used in output): '" << label.c_str()
-                  << "', ptr: " << (const void*)label.c_str() << ", len: " << label.size()
-                  << std::endl;
-        std::clog << "[DIAG]   Label (hex): ";
-        for (unsigned char c : label)
-          std::clog << std::hex << std::uppercase << std::setw(2) << std::setfill('0') << c;
-        std::clog << std::dec << std::endl;
-        yyjson_mut_val* test_obj = yyjson_mut_obj(test_doc);
-        std::clog << "[DIAG] test_obj[" << i << "] ptr: " << (void*)test_obj << std::endl;
-        obj_ptrs.push_back((void*)test_obj);
-        if (!test_obj)
-        {
-          ok = false;
-          break;
-        }
-        auto safe = [](const std::string& s) -> const char* { return s.empty() ? "" : s.c_str(); };
-        add_str(test_doc, test_obj, "label", label);
-        add_str(test_doc, test_obj, "server_city", entry.server_city);
-        add_str(test_doc, test_obj, "ip", entry.ip);
-        add_num(test_doc, test_obj, "latency", entry.latency);
-        add_num(test_doc, test_obj, "jitter", entry.jitter);
-        add_num(test_doc, test_obj, "download", entry.download);
-        add_num(test_doc, test_obj, "upload", entry.upload);
-        int arr_add_ret = yyjson_mut_arr_add_val(test_arr, test_obj);
-        std::clog << "[DIAG] Added test_obj[" << i << "] ptr: " << (void*)test_obj << " to test_arr ptr: " << (void*)test_arr << ", arr_add_ret: " << arr_add_ret << std::endl;
-      }
-      if (ok)
-      {
-        yyjson_mut_val* test_root = yyjson_mut_obj(test_doc);
-        std::clog << "[DIAG] test_root ptr: " << (void*)test_root << std::endl;
-        int obj_add_ret = yyjson_mut_obj_add_val(test_doc, test_root, "results", test_arr);
-        std::clog << "[DIAG] yyjson_mut_obj_add_val (results) ret: " << obj_add_ret << std::endl;
-        yyjson_mut_doc_set_root(test_doc, test_root);
-        yyjson_write_err err;
-        char* test_out = yyjson_mut_write_opts(test_doc, 0, nullptr, nullptr, &err);
-        std::unique_ptr<char, decltype(&free)> test_out_ptr(test_out, &free);
-        if (!test_out_ptr)
-        {
-          std::clog << "[DIAG] Serialization failed at n=" << n << " (label='"
-                    << results[n - 1].file.c_str()
-                    << "'): yyjson error: " << err.msg << " (code " << err.code << ")" << std::endl;
-          print_yyjson_error_explanation(err.code);
-          // Print all object pointers and their parent relationships
-          std::clog << "[DIAG] Dumping all object pointers, field values, and parent relationships for this run:" << std::endl;
-          for (size_t j = 0; j < obj_ptrs.size(); ++j) {
-            std::clog << "[DIAG]   obj_ptrs[" << j << "]: " << obj_ptrs[j] << std::endl;
-            const auto& entry = results[j];
-            std::clog << "[DIAG]     file: " << entry.file << std::endl;
-            std::clog << "[DIAG]     server_city: " << entry.server_city << std::endl;
-            std::clog << "[DIAG]     ip: " << entry.ip << std::endl;
-            std::clog << "[DIAG]     latency: " << entry.latency << std::endl;
-            std::clog << "[DIAG]     jitter: " << entry.jitter << std::endl;
-            std::clog << "[DIAG]     download: " << entry.download << std::endl;
-            std::clog << "[DIAG]     upload: " << entry.upload << std::endl;
-            // Print parent (test_arr) pointer for each object
-            std::clog << "[DIAG]     parent array ptr: " << (void*)test_arr << std::endl;
-          }
-          yyjson_mut_doc* single_doc = yyjson_mut_doc_new(nullptr);
-          yyjson_mut_val* single_obj = yyjson_mut_obj(single_doc);
-          std::clog << "[DIAG] single_doc ptr: " << (void*)single_doc
-                    << ", single_obj ptr: " << (void*)single_obj << std::endl;
-          std::string label = results[n - 1].file;
-          std::smatch m;
-          if (std::regex_search(results[n - 1].file, m, label_re) && m.size() > 1)
-            label = m[1].str();
-          auto safe = [](const std::string& s) -> const char*
-          { return s.empty() ? "" : s.c_str(); };
-          add_str(single_doc, single_obj, "label", label);
-          add_str(single_doc, single_obj, "server_city", results[n - 1].server_city);
-          add_str(single_doc, single_obj, "ip", results[n - 1].ip);
-          add_num(single_doc, single_obj, "latency", results[n - 1].latency);
-          add_num(single_doc, single_obj, "jitter", results[n - 1].jitter);
-          add_num(single_doc, single_obj, "download", results[n - 1].download);
-          add_num(single_doc, single_obj, "upload", results[n - 1].upload);
-          yyjson_mut_doc_set_root(single_doc, single_obj);
-          char* single_json = yyjson_mut_write(single_doc, 0, nullptr);
-          std::unique_ptr<char, decltype(&free)> single_json_ptr(single_json, &free);
-          if (single_json_ptr)
-          {
-            std::clog << "[DIAG] Problematic entry JSON: " << single_json_ptr.get() << std::endl;
-          }
-          else
-          {
-            std::clog << "[DIAG] Problematic entry could not be serialized individually!"
-                      << std::endl;
-          }
-          yyjson_mut_doc_free(single_doc);
-          yyjson_mut_doc_free(test_doc);
-          std::clog << "[DIAG] Created " << obj_ptrs.size() << " objects in this run" << std::endl;
-          break;
-        }
-        else
-        {
-          // Serialization succeeded
-        }
-      }
-      yyjson_mut_doc_free(test_doc);
+      std::clog << (byte >= kPrintableAsciiMin && byte <= kPrintableAsciiMax
+                        ? static_cast<char>(byte)
+                        : '.');
     }
+    std::clog << std::endl;
   }
-  // Full serialization
+  std::clog << "[DIAG]   latency: " << entry.latency << ", jitter: " << entry.jitter
+            << ", download: " << entry.download << ", upload: " << entry.upload << std::endl;
+}
+
+// One compact {"label", ...} object; fails on values yyjson cannot write (invalid UTF-8, NaN)
+static auto summary_entry_json(const SummaryResult& entry, std::string& json,
+                               yyjson_write_err& error) -> bool
+{
   yyjson_mut_doc* doc = yyjson_mut_doc_new(nullptr);
-  if (!doc)
+  if (doc == nullptr)
   {
-    if (is_diagnostics || is_debug)
-      std::cerr << "[ERROR] Failed to create yyjson_mut_doc!" << std::endl;
-    return;
+    error.code = 2;
+    error.msg = "memory allocation failed";
+    return false;
   }
-  yyjson_mut_val* arr = yyjson_mut_arr(doc);
-  if (!arr)
+  yyjson_mut_val* obj = yyjson_mut_obj(doc);
+  add_str(doc, obj, "label", entry.file);
+  add_str(doc, obj, "server_city", entry.server_city);
+  add_str(doc, obj, "ip", entry.ip);
+  add_num(doc, obj, "latency", entry.latency);
+  add_num(doc, obj, "jitter", entry.jitter);
+  add_num(doc, obj, "download", entry.download);
+  add_num(doc, obj, "upload", entry.upload);
+  yyjson_mut_doc_set_root(doc, obj);
+  size_t json_length = 0;
+  std::unique_ptr<char, decltype(&free)> written(
+      yyjson_mut_write_opts(doc, 0, nullptr, &json_length, &error), &free);
+  yyjson_mut_doc_free(doc);
+  if (!written)
+  {
+    return false;
+  }
+  json.assign(written.get(), json_length);
+  return true;
+}
+
+// Entries are serialized one at a time and streamed to filename.tmp, which replaces filename
+// only once complete, so memory does not grow with the number of results and readers never
+// see a partial file. An entry yyjson cannot write is skipped (and dumped with diagnostics)
+// rather than failing the whole summary.
+void write_summary_json(const std::vector<SummaryResult>& results, const std::string& filename,
+                        bool is_diagnostics, bool is_debug, bool is_full_diagnostics)
+{
+  const std::string tmp_path = filename + ".tmp";
+  std::ofstream out(tmp_path, std::ios::binary | std::ios::trunc);
+  if (!out)
   {
     if (is_diagnostics || is_debug)
-      std::cerr << "[ERROR] Failed to create yyjson_mut_arr!" << std::endl;
-    yyjson_mut_doc_free(doc);
+    {
+      std::cerr << "[ERROR] Could not open " << tmp_path << " for writing!" << std::endl;
+    }
     return;
   }
-  std::regex label_re(R"(^(.*)\\.json$)");
-  for (const auto& r : results)
+  out << "{\"results\":[";
+  std::string entry_json;
+  size_t written = 0;
+  size_t skipped = 0;
+  for (size_t entry_index = 0; entry_index < results.size(); ++entry_index)
   {
-    yyjson_mut_val* obj = yyjson_mut_obj(doc);
-    if (!obj)
+    const SummaryResult& entry = results[entry_index];
+    if (is_full_diagnostics)
     {
-      if (is_diagnostics || is_debug)
-        std::cerr << "[ERROR] Failed to create yyjson_mut_obj!" << std::endl;
+      log_summary_entry(entry_index, entry);
+    }
+    yyjson_write_err error{};
+    if (!summary_entry_json(entry, entry_json, error))
+    {
+      ++skipped;
+      if (is_diagnostics)
+      {
+        if (!is_full_diagnostics)
+        {
+          log_summary_entry(entry_index, entry);
+        }
+        std::clog << "[DIAG] Serialization failed for entry " << entry_index << " (file: '"
+                  << entry.file << "'): yyjson error: " << (error.msg ? error.msg : "unknown")
+                  << " (code " << error.code << ")" << std::endl;
+        print_yyjson_error_explanation(error.code);
+      }
       continue;
     }
-    std::string label = r.file;
-    std::smatch m;
-    if (std::regex_search(r.file, m, label_re) && m.size() > 1)
-      label = m[1].str();
-    add_str(doc, obj, "label", label);
-    add_str(doc, obj, "server_city", r.server_city);
-    add_str(doc, obj, "ip", r.ip);
-    add_num(doc, obj, "latency", r.latency);
-    add_num(doc, obj, "jitter", r.jitter);
-    add_num(doc, obj, "download", r.download);
-    add_num(doc, obj, "upload", r.upload);
-    yyjson_mut_arr_add_val(arr, obj);
-  }
-  yyjson_mut_val* root_obj = yyjson_mut_obj(doc);
-  yyjson_mut_obj_add_val(doc, root_obj, "results", arr);
-  yyjson_mut_doc_set_root(doc, root_obj);
-  char* out_cstr = yyjson_mut_write(doc, 0, nullptr);
-  std::unique_ptr<char, decltype(&free)> out_cstr_ptr(out_cstr, &free);
-  if (!out_cstr_ptr)
+    out << (written++ > 0 ? "," : "") << entry_json;
+  }
+  out << "]}";
+  out.close();
+  if (!out || std::rename(tmp_path.c_str(), filename.c_str()) != 0)
   {
+    (void)std::remove(tmp_path.c_str());
     if (is_diagnostics || is_debug)
-      std::cerr << "[ERROR] Failed to serialize JSON: yyjson_mut_write returned nullptr!"
-                << std::endl;
-    yyjson_mut_doc_free(doc);
+    {
+      std::cerr << "[ERROR] Could not write " << filename << std::endl;
+    }
     return;
   }
-  yyjson_mut_doc_free(doc);
-  std::ofstream f(filename);
-  if (!f)
+  if (skipped > 0)
   {
-    if (is_diagnostics || is_debug)
-      std::cerr << "[ERROR] Could not open " << filename << " for writing!" << std::endl;
-    return;
+    std::cerr << "[WARN] " << skipped << " summary entries could not be serialized and were "
+              << "left out of " << filename << (is_diagnostics ? "" : " (-vv for details)")
+              << std::endl;
+  }
+  if (is_debug)
+  {
+    std::clog << "[DEBUG] Wrote " << written << " summary entries to " << filename << std::endl;
   }
-  f << out_cstr_ptr.get();
-  // No manual free needed
 }
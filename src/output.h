@@ -3,6 +3,7 @@
 #include <vector>  // for vector
 
 struct SummaryResult;
+class SummaryIndex;
 
 // Output helpers
 // Modernized: trailing return types, descriptive parameter names
@@ -14,7 +15,8 @@ void log_speed_test_result(const std::string& size_label, const std::vector<doub
 void log_download_speed(const std::vector<double>& download_tests, bool output_json);
 void log_upload_speed(const std::vector<double>& upload_tests, bool output_json);
 auto load_summary_results(const std::vector<std::string>& files, bool is_diagnostics = false,
-                          bool is_debug = false) -> std::vector<SummaryResult>;
+                          bool is_debug = false, SummaryIndex* index = nullptr)
+    -> std::vector<SummaryResult>;
 void write_summary_json(const std::vector<SummaryResult>& results, const std::string& filename,
                         bool is_diagnostics = false, bool is_debug = false,
                         bool is_full_diagnostics = false);
@@ -0,0 +1,222 @@
+#include "regression_gate.h"
+#include <yyjson.h>         // for yyjson_mut_doc, yyjson_mut_obj, yyjson_mut_write
+#include <cmath>            // for isfinite
+#include <cstdlib>          // for free, strtod
+#include <memory>           // for unique_ptr
+#include <string>           // for string, operator+
+#include <vector>           // for vector
+#include "cli_args.h"       // for expand_wildcards
+#include "history_store.h"  // for read_history_records, history_summary_result, HistoryRange
+#include "json_helpers.h"   // for add_num, add_str
+#include "output.h"         // for load_summary_results
+#include "stats.h"          // for median, quartile
+#include "types.h"          // for SummaryResult
+
+namespace
+{
+constexpr double kPercent = 100.0;
+constexpr double kWorstDecileLow = 0.1;  // throughput: lower is worse
+constexpr double kWorstDecileHigh = 0.9; // latency, jitter: higher is worse
+
+struct GateMetricSpec
+{
+  const char* name;
+  double SummaryResult::*field;
+  double GateTolerances::*tolerance;
+  bool higher_is_better;
+};
+
+const GateMetricSpec kGateMetrics[] = {
+    {"download", &SummaryResult::download, &GateTolerances::download_pct, true},
+    {"upload", &SummaryResult::upload, &GateTolerances::upload_pct, true},
+    {"latency", &SummaryResult::latency, &GateTolerances::latency_pct, false},
+    {"jitter", &SummaryResult::jitter, &GateTolerances::jitter_pct, false},
+};
+
+auto ends_with(const std::string& text, const std::string& suffix) -> bool
+{
+  return text.size() >= suffix.size() &&
+         text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+// A value is only flagged when it is worse than the tolerance allows and also worse than the
+// baseline's own worst decile, so a host with noisy history does not alert on its usual spread.
+// A run with no value (every transfer failed, or no latency sample) fails outright; only a
+// baseline without values makes the metric unjudgeable
+auto evaluate_metric(const GateMetricSpec& spec, const SummaryResult& run,
+                     const std::vector<const SummaryResult*>& baseline,
+                     const GateTolerances& tolerances) -> GateMetric
+{
+  GateMetric metric;
+  metric.name = spec.name;
+  metric.value = run.*spec.field;
+  std::vector<double> values;
+  values.reserve(baseline.size());
+  for (const SummaryResult* entry : baseline)
+  {
+    if (std::isfinite(entry->*spec.field) && entry->*spec.field > 0)
+    {
+      values.push_back(entry->*spec.field);
+    }
+  }
+  if (values.empty())
+  {
+    metric.skipped = true;
+    return metric;
+  }
+  metric.baseline_median = stats::median(values);
+  if (!std::isfinite(metric.value) || metric.value <= 0)
+  {
+    metric.failed = true;
+    metric.regressed = true;
+    return metric;
+  }
+  const double allowed = tolerances.*spec.tolerance / kPercent;
+  metric.baseline_bound =
+      stats::quartile(values, spec.higher_is_better ? kWorstDecileLow : kWorstDecileHigh);
+  metric.limit = metric.baseline_median * (spec.higher_is_better ? 1.0 - allowed : 1.0 + allowed);
+  metric.change_pct = (metric.value - metric.baseline_median) / metric.baseline_median * kPercent;
+  metric.regressed = spec.higher_is_better
+                         ? metric.value < metric.limit && metric.value < metric.baseline_bound
+                         : metric.value > metric.limit && metric.value > metric.baseline_bound;
+  return metric;
+}
+} // namespace
+
+auto parse_gate_tolerances(const std::string& text, GateTolerances& tolerances,
+                           std::string& error) -> bool
+{
+  size_t start = 0;
+  while (start < text.size())
+  {
+    size_t comma = text.find(',', start);
+    comma = comma == std::string::npos ? text.size() : comma;
+    const std::string entry = text.substr(start, comma - start);
+    start = comma + 1;
+    const size_t colon = entry.find(':');
+    const std::string name = entry.substr(0, colon);
+    const GateMetricSpec* spec = nullptr;
+    for (const GateMetricSpec& candidate : kGateMetrics)
+    {
+      spec = name == candidate.name ? &candidate : spec;
+    }
+    char* end = nullptr;
+    const double percent =
+        colon == std::string::npos ? -1.0 : std::strtod(entry.c_str() + colon + 1, &end);
+    if (spec == nullptr || percent < 0 || end == nullptr || *end != '\0')
+    {
+      error = "Invalid tolerance '" + entry +
+              "' (expected download, upload, latency or jitter:PERCENT)";
+      return false;
+    }
+    tolerances.*spec->tolerance = percent;
+  }
+  return true;
+}
+
+auto load_gate_baseline(const std::string& path, const HistoryRange& range,
+                        std::vector<SummaryResult>& baseline, std::string& error) -> bool
+{
+  if (ends_with(path, ".json") || path.find_first_of("*?") != std::string::npos)
+  {
+    const std::vector<std::string> files = expand_wildcards({path});
+    baseline = load_summary_results(files);
+    if (baseline.empty())
+    {
+      error = "No readable result files in baseline " + path;
+      return false;
+    }
+    return true;
+  }
+  std::vector<HistoryRecord> records;
+  if (!read_history_records(path, range, records, error))
+  {
+    return false;
+  }
+  baseline.clear();
+  baseline.reserve(records.size());
+  for (const HistoryRecord& record : records)
+  {
+    baseline.push_back(history_summary_result(record));
+  }
+  return true;
+}
+
+// The baseline is narrowed to runs against the same server city (one per colo) when it holds
+// enough of them; otherwise every run is used and the verdict says so in "scope"
+auto evaluate_gate(const SummaryResult& run, const std::vector<SummaryResult>& baseline,
+                   const GateTolerances& tolerances) -> GateVerdict
+{
+  GateVerdict verdict;
+  verdict.server_city = run.server_city;
+  std::vector<const SummaryResult*> matching;
+  std::vector<const SummaryResult*> everything;
+  for (const SummaryResult& entry : baseline)
+  {
+    // A --check file that is also part of a JSON baseline must not vouch for itself
+    if (!run.file.empty() && entry.file == run.file)
+    {
+      continue;
+    }
+    everything.push_back(&entry);
+    if (entry.server_city == run.server_city)
+    {
+      matching.push_back(&entry);
+    }
+  }
+  const bool same_server = matching.size() >= kMinBaselineRuns;
+  const std::vector<const SummaryResult*>& selected = same_server ? matching : everything;
+  verdict.scope = same_server ? "server" : "all";
+  verdict.baseline_runs = selected.size();
+  for (const GateMetricSpec& spec : kGateMetrics)
+  {
+    verdict.metrics.push_back(evaluate_metric(spec, run, selected, tolerances));
+    verdict.regression = verdict.regression || verdict.metrics.back().regressed;
+  }
+  return verdict;
+}
+
+auto gate_verdict_json(const GateVerdict& verdict) -> std::string
+{
+  yyjson_mut_doc* doc = yyjson_mut_doc_new(nullptr);
+  yyjson_mut_val* root = yyjson_mut_obj(doc);
+  yyjson_mut_doc_set_root(doc, root);
+  yyjson_mut_obj_add_str(doc, root, "verdict", verdict.regression ? "regression" : "pass");
+  add_str(doc, root, "server_city", verdict.server_city);
+  yyjson_mut_obj_add_str(doc, root, "scope", verdict.scope.c_str());
+  yyjson_mut_obj_add_uint(doc, root, "baseline_runs", verdict.baseline_runs);
+  yyjson_mut_val* metrics = yyjson_mut_obj_add_obj(doc, root, "metrics");
+  for (const GateMetric& metric : verdict.metrics)
+  {
+    yyjson_mut_val* entry = yyjson_mut_obj_add_obj(doc, metrics, metric.name);
+    const char* status = metric.regressed ? "regression" : "pass";
+    status = metric.failed ? "failed" : status;
+    status = metric.skipped ? "skipped" : status;
+    yyjson_mut_obj_add_str(doc, entry, "status", status);
+    if (metric.skipped)
+    {
+      continue;
+    }
+    // NaN has no JSON form; a failed metric carries its value only when it is a number
+    if (std::isfinite(metric.value))
+    {
+      add_num(doc, entry, "value", metric.value);
+    }
+    add_num(doc, entry, "baseline_median", metric.baseline_median);
+    if (metric.failed)
+    {
+      continue;
+    }
+    add_num(doc, entry, "baseline_bound", metric.baseline_bound);
+    add_num(doc, entry, "limit", metric.limit);
+    add_num(doc, entry, "change_pct", metric.change_pct);
+  }
+  std::string json;
+  std::unique_ptr<char, decltype(&free)> written(yyjson_mut_write(doc, 0, nullptr), &free);
+  if (written)
+  {
+    json = written.get();
+  }
+  yyjson_mut_doc_free(doc);
+  return json;
+}
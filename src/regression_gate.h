@@ -0,0 +1,57 @@
+#pragma once
+#include <stddef.h>  // for size_t
+#include <string>    // for string
+#include <vector>    // for vector
+
+struct SummaryResult;
+struct HistoryRange;
+
+// Exit status of a run or --check that regressed against its baseline
+inline constexpr int kExitRegression = 4;
+// Fewer matching runs than this and the baseline falls back to every run it holds
+inline constexpr size_t kMinBaselineRuns = 5;
+
+// Allowed degradation per metric, in percent of the baseline median (--tolerance)
+struct GateTolerances
+{
+  double download_pct = 20;
+  double upload_pct = 20;
+  double latency_pct = 30;
+  double jitter_pct = 50;
+};
+
+// One metric of a run against the baseline distribution
+struct GateMetric
+{
+  const char* name = "";
+  double value = 0;
+  double baseline_median = 0;
+  double baseline_bound = 0; // worst decile of the baseline: p10 for throughput, p90 for delays
+  double limit = 0;          // median moved by the tolerance in the "worse" direction
+  double change_pct = 0;     // against the median, positive = higher
+  bool skipped = false;      // no baseline values for this metric
+  bool failed = false;       // run has no value (0 or non-finite) while the baseline does
+  bool regressed = false;    // failed, or worse than both limit and baseline_bound
+};
+
+struct GateVerdict
+{
+  std::string server_city;
+  std::string scope; // "server" (same server city) or "all" (fallback)
+  size_t baseline_runs = 0;
+  std::vector<GateMetric> metrics;
+  bool regression = false;
+};
+
+// Baseline and regression gate (--baseline, --check)
+// "download:15,latency:40" updates the named tolerances; false with error on a bad entry
+auto parse_gate_tolerances(const std::string& text, GateTolerances& tolerances,
+                           std::string& error) -> bool;
+// A history store (runs in range), or result JSON files when path is a *.json name or pattern
+auto load_gate_baseline(const std::string& path, const HistoryRange& range,
+                        std::vector<SummaryResult>& baseline, std::string& error) -> bool;
+auto evaluate_gate(const SummaryResult& run, const std::vector<SummaryResult>& baseline,
+                   const GateTolerances& tolerances) -> GateVerdict;
+// Single-line JSON document: {"verdict":"pass"|"regression","metrics":{...},...}; a metric's
+// status is "pass", "regression", "failed" or "skipped"
+auto gate_verdict_json(const GateVerdict& verdict) -> std::string;
@@ -0,0 +1,130 @@
+#include "sample_store.h"
+#include <algorithm>    // for stable_sort
+#include <vector>       // for vector
+#include "estimation.h" // for sample_filter_mask
+
+void SampleColumns::push_back(const SampleRecord& record)
+{
+  monotonic_ms_.push_back(record.monotonic_ms);
+  wall_ms_.push_back(record.wall_ms);
+  duration_ms_.push_back(record.duration_ms);
+  mbps_.push_back(record.mbps);
+  bytes_.push_back(record.bytes);
+  connection_id_.push_back(record.connection_id);
+  phase_.push_back(record.phase);
+  status_.push_back(static_cast<uint8_t>(record.status));
+}
+
+void SampleColumns::reserve(size_t records)
+{
+  monotonic_ms_.reserve(records);
+  wall_ms_.reserve(records);
+  duration_ms_.reserve(records);
+  mbps_.reserve(records);
+  bytes_.reserve(records);
+  connection_id_.reserve(records);
+  phase_.reserve(records);
+  status_.reserve(records);
+}
+
+auto SampleColumns::record(size_t index) const -> SampleRecord
+{
+  SampleRecord record;
+  record.monotonic_ms = monotonic_ms_[index];
+  record.wall_ms = wall_ms_[index];
+  record.duration_ms = duration_ms_[index];
+  record.mbps = mbps_[index];
+  record.bytes = bytes_[index];
+  record.connection_id = connection_id_[index];
+  record.phase = phase_[index];
+  record.status = static_cast<SampleStatus>(status_[index]);
+  return record;
+}
+
+auto SampleColumns::mbps(size_t begin, size_t end) const -> SampleSpan
+{
+  return SampleSpan(mbps_.data() + begin, end - begin);
+}
+
+void SampleStore::reserve(TransferDirection direction, size_t records)
+{
+  kept_[slot(direction)].reserve(records);
+}
+
+auto SampleStore::add_phase(TransferDirection direction, const std::vector<SampleRecord>& records,
+                            SampleFilter filter) -> size_t
+{
+  const size_t phase = phase_ranges_.size();
+  std::vector<double> completed;
+  completed.reserve(records.size());
+  for (const auto& record : records)
+  {
+    if (record.status == SampleStatus::ok)
+    {
+      completed.push_back(record.mbps);
+    }
+  }
+  const std::vector<bool> keep = sample_filter_mask(completed, filter);
+  SampleColumns& kept_columns = kept_[slot(direction)];
+  SampleColumns& dropped_columns = dropped_[slot(direction)];
+  const size_t begin = kept_columns.size();
+  size_t completed_index = 0;
+  for (SampleRecord record : records)
+  {
+    record.phase = static_cast<uint16_t>(phase);
+    record.direction = direction;
+    if (record.status == SampleStatus::ok && !keep[completed_index++])
+    {
+      record.status = SampleStatus::rejected;
+    }
+    (record.status == SampleStatus::ok ? kept_columns : dropped_columns).push_back(record);
+  }
+  phase_ranges_.push_back(PhaseRange{direction, begin, kept_columns.size()});
+  return phase;
+}
+
+auto SampleStore::phase_direction(size_t phase) const -> TransferDirection
+{
+  return phase_ranges_[phase].direction;
+}
+
+auto SampleStore::phase_samples(size_t phase) const -> SampleSpan
+{
+  const PhaseRange& range = phase_ranges_[phase];
+  return kept_[slot(range.direction)].mbps(range.begin, range.end);
+}
+
+auto SampleStore::direction_samples(TransferDirection direction) const -> SampleSpan
+{
+  return SampleSpan(kept_[slot(direction)].mbps());
+}
+
+auto SampleStore::kept(TransferDirection direction) const -> const SampleColumns&
+{
+  return kept_[slot(direction)];
+}
+
+auto SampleStore::dropped(TransferDirection direction) const -> const SampleColumns&
+{
+  return dropped_[slot(direction)];
+}
+
+auto SampleStore::records_by_time() const -> std::vector<SampleRecord>
+{
+  std::vector<SampleRecord> records;
+  for (const TransferDirection direction : {TransferDirection::download, TransferDirection::upload})
+  {
+    for (const SampleColumns* columns : {&kept_[slot(direction)], &dropped_[slot(direction)]})
+    {
+      for (size_t index = 0; index < columns->size(); ++index)
+      {
+        records.push_back(columns->record(index));
+        records.back().direction = direction;
+      }
+    }
+  }
+  std::stable_sort(records.begin(), records.end(),
+                   [](const SampleRecord& lhs, const SampleRecord& rhs)
+                   { return lhs.monotonic_ms < rhs.monotonic_ms; });
+  return records;
+}
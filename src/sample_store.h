@@ -0,0 +1,114 @@
+#pragma once
+#include <stddef.h>     // for size_t
+#include <stdint.h>     // for uint8_t, uint16_t, uint32_t
+#include <vector>       // for vector
+#include "estimation.h" // for SampleFilter
+#include "test_plan.h"  // for TransferDirection
+
+enum class SampleStatus : uint8_t
+{
+  ok,       // completed and kept for aggregation
+  failed,   // empty response or transport error
+  rejected  // completed but dropped by the sample filter
+};
+
+// One timed transfer, as produced by the measurement loops
+struct SampleRecord
+{
+  double monotonic_ms = 0; // transfer start, CLOCK_MONOTONIC (same clock as get_time_ms)
+  double wall_ms = 0;      // transfer start, Unix epoch
+  double duration_ms = 0;
+  double mbps = 0;         // 0 for failed transfers
+  uint32_t bytes = 0;
+  uint32_t connection_id = 0;
+  uint16_t phase = 0;      // index into the executed test plan
+  TransferDirection direction = TransferDirection::download;
+  SampleStatus status = SampleStatus::ok;
+};
+
+// Non-owning view of contiguous throughput values (Mbps)
+class SampleSpan
+{
+public:
+  SampleSpan() = default;
+  SampleSpan(const double* data, size_t size) : data_(data), size_(size) {}
+  explicit SampleSpan(const std::vector<double>& values)
+      : data_(values.data()), size_(values.size())
+  {
+  }
+
+  auto begin() const -> const double* { return data_; }
+  auto end() const -> const double* { return data_ + size_; }
+  auto data() const -> const double* { return data_; }
+  auto size() const -> size_t { return size_; }
+  auto empty() const -> bool { return size_ == 0; }
+  auto operator[](size_t index) const -> double { return data_[index]; }
+  // Owning copy, for consumers that reorder their input (estimators, filters)
+  auto to_vector() const -> std::vector<double> { return {data_, data_ + size_}; }
+
+private:
+  const double* data_ = nullptr;
+  size_t size_ = 0;
+};
+
+// Struct-of-arrays sample table; each column holds one field of every record
+class SampleColumns
+{
+public:
+  void push_back(const SampleRecord& record);
+  void reserve(size_t records);
+  auto size() const -> size_t { return mbps_.size(); }
+  auto record(size_t index) const -> SampleRecord;
+  auto mbps(size_t begin, size_t end) const -> SampleSpan;
+
+  auto monotonic_ms() const -> const std::vector<double>& { return monotonic_ms_; }
+  auto wall_ms() const -> const std::vector<double>& { return wall_ms_; }
+  auto duration_ms() const -> const std::vector<double>& { return duration_ms_; }
+  auto mbps() const -> const std::vector<double>& { return mbps_; }
+  auto bytes() const -> const std::vector<uint32_t>& { return bytes_; }
+  auto connection_id() const -> const std::vector<uint32_t>& { return connection_id_; }
+  auto phase() const -> const std::vector<uint16_t>& { return phase_; }
+  auto status() const -> const std::vector<uint8_t>& { return status_; }
+
+private:
+  std::vector<double> monotonic_ms_, wall_ms_, duration_ms_, mbps_;
+  std::vector<uint32_t> bytes_, connection_id_;
+  std::vector<uint16_t> phase_;
+  std::vector<uint8_t> status_;
+};
+
+// All transfer samples of a run. Kept samples are stored per direction in plan order, so the
+// per-phase and per-direction views are plain subranges; failed and filtered samples live in a
+// separate table per direction with the same columns.
+class SampleStore
+{
+public:
+  // Sizes the kept columns for a whole plan up front, so they are allocated once
+  void reserve(TransferDirection direction, size_t records);
+  // Filters one phase's records and appends them; returns the phase index
+  auto add_phase(TransferDirection direction, const std::vector<SampleRecord>& records,
+                 SampleFilter filter) -> size_t;
+  auto phase_count() const -> size_t { return phase_ranges_.size(); }
+  auto phase_direction(size_t phase) const -> TransferDirection;
+  auto phase_samples(size_t phase) const -> SampleSpan;
+  auto direction_samples(TransferDirection direction) const -> SampleSpan;
+  auto kept(TransferDirection direction) const -> const SampleColumns&;
+  auto dropped(TransferDirection direction) const -> const SampleColumns&;
+  // Every record (kept, failed, rejected) ordered by transfer start time
+  auto records_by_time() const -> std::vector<SampleRecord>;
+
+private:
+  struct PhaseRange
+  {
+    TransferDirection direction;
+    size_t begin;
+    size_t end;
+  };
+  static auto slot(TransferDirection direction) -> size_t
+  {
+    return direction == TransferDirection::upload ? 1 : 0;
+  }
+  SampleColumns kept_[2];
+  SampleColumns dropped_[2];
+  std::vector<PhaseRange> phase_ranges_;
+};
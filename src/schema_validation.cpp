@@ -0,0 +1,526 @@
+#include "schema_validation.h"
+#include <yyjson.h>                   // for yyjson_read, yyjson_obj_foreach, yyjson_get_type
+#include <algorithm>                  // for lower_bound, max, min, sort
+#include <atomic>                     // for atomic
+#include <cstring>                    // for strlen
+#include <exception>                  // for exception
+#include <future>                     // for async, future
+#include <nlohmann/json-schema.hpp>   // for json_validator
+#include <nlohmann/json.hpp>          // for basic_json
+#include <string>                     // for string
+#include <string_view>                // for string_view
+#include <thread>                     // for thread
+#include <utility>                    // for move, pair
+#include <vector>                     // for vector
+#include "embedded_result_schema.h"   // for embedded_result_schema
+#include "embedded_summary_schema.h"  // for embedded_summary_schema
+#include "mapped_file.h"              // for MappedFile
+
+constexpr size_t kFilesPerWorker = 8; // below this a thread costs more than it saves
+
+namespace
+{
+// Subset of draft-07 that the embedded schemas use, evaluated directly on a yyjson tree.
+// Compilation fails on any other keyword, in which case every file takes the nlohmann path.
+// The check may reject documents the full validator would accept (e.g. 2.0 for an integer),
+// but never the reverse: a pass is a pass under the full validator too.
+class StructuralSchema
+{
+public:
+  auto compile(const char* schema_text) -> bool;
+  auto usable() const -> bool { return root_ >= 0; }
+  auto check(yyjson_val* value) const -> bool { return check(root_, value); }
+
+private:
+  enum TypeBit : unsigned
+  {
+    kObject = 1U << 0,
+    kArray = 1U << 1,
+    kString = 1U << 2,
+    kInteger = 1U << 3,
+    kNumber = 1U << 4,
+    kBoolean = 1U << 5,
+    kNull = 1U << 6
+  };
+  static constexpr int kAnyAdditional = -1;
+  static constexpr int kNoAdditional = -2;
+
+  struct Node
+  {
+    unsigned types = 0; // 0 = any type
+    bool has_minimum = false;
+    double minimum = 0;
+    bool has_min_items = false;
+    bool has_max_items = false;
+    size_t min_items = 0;
+    size_t max_items = 0;
+    bool has_enum = false;
+    std::vector<std::string> enum_values;
+    std::vector<std::pair<std::string, int>> properties; // sorted by name
+    std::vector<std::string> required;
+    int additional = kAnyAdditional;
+    int items = -1;
+  };
+
+  auto compile_node(yyjson_val* schema) -> int;
+  auto resolve_ref(yyjson_val* ref) -> int;
+  auto check(int node_index, yyjson_val* value) const -> bool;
+  static auto type_bit(yyjson_val* type_name) -> unsigned;
+
+  std::vector<Node> nodes_;
+  std::vector<std::pair<std::string, int>> definitions_;
+  yyjson_val* definitions_val_ = nullptr;
+  int root_ = -1;
+};
+
+auto StructuralSchema::compile(const char* schema_text) -> bool
+{
+  yyjson_doc* doc = yyjson_read(schema_text, std::strlen(schema_text), 0);
+  if (doc == nullptr)
+  {
+    return false;
+  }
+  yyjson_val* root = yyjson_doc_get_root(doc);
+  definitions_val_ = yyjson_obj_get(root, "definitions");
+  root_ = compile_node(root);
+  definitions_val_ = nullptr;
+  yyjson_doc_free(doc);
+  if (root_ < 0)
+  {
+    nodes_.clear();
+  }
+  return usable();
+}
+
+auto StructuralSchema::type_bit(yyjson_val* type_name) -> unsigned
+{
+  static constexpr std::pair<const char*, unsigned> kTypeNames[] = {
+      {"object", kObject},   {"array", kArray},     {"string", kString}, {"integer", kInteger},
+      {"number", kNumber},   {"boolean", kBoolean}, {"null", kNull}};
+  for (const auto& [name, bit] : kTypeNames)
+  {
+    if (yyjson_equals_str(type_name, name))
+    {
+      return bit;
+    }
+  }
+  return 0;
+}
+
+// "#/definitions/<name>" only; each definition is compiled once and may refer to itself
+auto StructuralSchema::resolve_ref(yyjson_val* ref) -> int
+{
+  constexpr std::string_view kPrefix = "#/definitions/";
+  if (!yyjson_is_str(ref))
+  {
+    return -1;
+  }
+  const std::string_view target(yyjson_get_str(ref), yyjson_get_len(ref));
+  if (target.substr(0, kPrefix.size()) != kPrefix)
+  {
+    return -1;
+  }
+  const std::string name(target.substr(kPrefix.size()));
+  for (const auto& [defined, index] : definitions_)
+  {
+    if (defined == name)
+    {
+      return index;
+    }
+  }
+  yyjson_val* definition = yyjson_obj_getn(definitions_val_, name.data(), name.size());
+  if (definition == nullptr)
+  {
+    return -1;
+  }
+  const int index = static_cast<int>(nodes_.size());
+  nodes_.emplace_back();
+  definitions_.emplace_back(name, index);
+  const int compiled = compile_node(definition);
+  if (compiled < 0)
+  {
+    return -1;
+  }
+  nodes_[static_cast<size_t>(index)] = nodes_[static_cast<size_t>(compiled)];
+  return index;
+}
+
+auto StructuralSchema::compile_node(yyjson_val* schema) -> int
+{
+  if (yyjson_is_true(schema))
+  {
+    nodes_.emplace_back();
+    return static_cast<int>(nodes_.size()) - 1;
+  }
+  if (!yyjson_is_obj(schema))
+  {
+    return -1;
+  }
+  if (yyjson_val* ref = yyjson_obj_get(schema, "$ref"))
+  {
+    return resolve_ref(ref); // draft-07: siblings of $ref are ignored
+  }
+  Node node;
+  size_t key_index = 0;
+  size_t key_count = 0;
+  yyjson_val* key = nullptr;
+  yyjson_val* value = nullptr;
+  yyjson_obj_foreach(schema, key_index, key_count, key, value)
+  {
+    const std::string_view keyword(yyjson_get_str(key), yyjson_get_len(key));
+    if (keyword == "type")
+    {
+      if (yyjson_is_str(value))
+      {
+        node.types = type_bit(value);
+        if (node.types == 0)
+        {
+          return -1;
+        }
+        continue;
+      }
+      if (!yyjson_is_arr(value))
+      {
+        return -1;
+      }
+      size_t type_index = 0;
+      size_t type_count = 0;
+      yyjson_val* type_name = nullptr;
+      yyjson_arr_foreach(value, type_index, type_count, type_name)
+      {
+        const unsigned bit = type_bit(type_name);
+        if (bit == 0)
+        {
+          return -1;
+        }
+        node.types |= bit;
+      }
+    }
+    else if (keyword == "properties")
+    {
+      if (!yyjson_is_obj(value))
+      {
+        return -1;
+      }
+      size_t property_index = 0;
+      size_t property_count = 0;
+      yyjson_val* property = nullptr;
+      yyjson_val* property_schema = nullptr;
+      yyjson_obj_foreach(value, property_index, property_count, property, property_schema)
+      {
+        const int child = compile_node(property_schema);
+        if (child < 0)
+        {
+          return -1;
+        }
+        node.properties.emplace_back(
+            std::string(yyjson_get_str(property), yyjson_get_len(property)), child);
+      }
+      std::sort(node.properties.begin(), node.properties.end());
+    }
+    else if (keyword == "required")
+    {
+      size_t name_index = 0;
+      size_t name_count = 0;
+      yyjson_val* name = nullptr;
+      yyjson_arr_foreach(value, name_index, name_count, name)
+      {
+        if (!yyjson_is_str(name))
+        {
+          return -1;
+        }
+        node.required.emplace_back(yyjson_get_str(name), yyjson_get_len(name));
+      }
+    }
+    else if (keyword == "additionalProperties")
+    {
+      if (yyjson_is_bool(value))
+      {
+        node.additional = yyjson_get_bool(value) ? kAnyAdditional : kNoAdditional;
+        continue;
+      }
+      node.additional = compile_node(value);
+      if (node.additional < 0)
+      {
+        return -1;
+      }
+    }
+    else if (keyword == "items")
+    {
+      node.items = compile_node(value); // tuple form (array) is not supported
+      if (node.items < 0)
+      {
+        return -1;
+      }
+    }
+    else if (keyword == "minimum" && yyjson_is_num(value))
+    {
+      node.has_minimum = true;
+      node.minimum = yyjson_get_num(value);
+    }
+    else if (keyword == "minItems" && yyjson_is_uint(value))
+    {
+      node.has_min_items = true;
+      node.min_items = static_cast<size_t>(yyjson_get_uint(value));
+    }
+    else if (keyword == "maxItems" && yyjson_is_uint(value))
+    {
+      node.has_max_items = true;
+      node.max_items = static_cast<size_t>(yyjson_get_uint(value));
+    }
+    else if (keyword == "enum" && yyjson_is_arr(value))
+    {
+      node.has_enum = true;
+      size_t enum_index = 0;
+      size_t enum_count = 0;
+      yyjson_val* allowed = nullptr;
+      yyjson_arr_foreach(value, enum_index, enum_count, allowed)
+      {
+        if (!yyjson_is_str(allowed))
+        {
+          return -1;
+        }
+        node.enum_values.emplace_back(yyjson_get_str(allowed), yyjson_get_len(allowed));
+      }
+    }
+    else if (keyword != "$schema" && keyword != "title" && keyword != "description" &&
+             keyword != "$comment" && keyword != "definitions")
+    {
+      return -1; // a keyword this check does not implement
+    }
+  }
+  nodes_.push_back(std::move(node));
+  return static_cast<int>(nodes_.size()) - 1;
+}
+
+auto StructuralSchema::check(int node_index, yyjson_val* value) const -> bool
+{
+  const Node& node = nodes_[static_cast<size_t>(node_index)];
+  unsigned value_type = 0;
+  switch (yyjson_get_type(value))
+  {
+  case YYJSON_TYPE_OBJ: value_type = kObject; break;
+  case YYJSON_TYPE_ARR: value_type = kArray; break;
+  case YYJSON_TYPE_STR: value_type = kString; break;
+  case YYJSON_TYPE_NUM: value_type = yyjson_is_int(value) ? (kInteger | kNumber) : kNumber; break;
+  case YYJSON_TYPE_BOOL: value_type = kBoolean; break;
+  case YYJSON_TYPE_NULL: value_type = kNull; break;
+  default: return false;
+  }
+  if (node.types != 0 && (node.types & value_type) == 0)
+  {
+    return false;
+  }
+  if (node.has_enum)
+  {
+    const std::string_view text(yyjson_get_str(value), yyjson_get_len(value));
+    if (!yyjson_is_str(value) ||
+        std::find(node.enum_values.begin(), node.enum_values.end(), text) ==
+            node.enum_values.end())
+    {
+      return false;
+    }
+  }
+  if (node.has_minimum && yyjson_is_num(value) && yyjson_get_num(value) < node.minimum)
+  {
+    return false;
+  }
+  if (value_type == kArray)
+  {
+    const size_t item_count = yyjson_arr_size(value);
+    if ((node.has_min_items && item_count < node.min_items) ||
+        (node.has_max_items && item_count > node.max_items))
+    {
+      return false;
+    }
+    if (node.items >= 0)
+    {
+      size_t item_index = 0;
+      size_t item_total = 0;
+      yyjson_val* item = nullptr;
+      yyjson_arr_foreach(value, item_index, item_total, item)
+      {
+        if (!check(node.items, item))
+        {
+          return false;
+        }
+      }
+    }
+  }
+  if (value_type == kObject)
+  {
+    for (const auto& name : node.required)
+    {
+      if (yyjson_obj_getn(value, name.data(), name.size()) == nullptr)
+      {
+        return false;
+      }
+    }
+    size_t member_index = 0;
+    size_t member_count = 0;
+    yyjson_val* key = nullptr;
+    yyjson_val* member = nullptr;
+    yyjson_obj_foreach(value, member_index, member_count, key, member)
+    {
+      const std::string_view name(yyjson_get_str(key), yyjson_get_len(key));
+      const auto property = std::lower_bound(
+          node.properties.begin(), node.properties.end(), name,
+          [](const std::pair<std::string, int>& entry, std::string_view wanted)
+          { return entry.first < wanted; });
+      int member_schema = node.additional;
+      if (property != node.properties.end() && property->first == name)
+      {
+        member_schema = property->second;
+      }
+      if (member_schema == kNoAdditional ||
+          (member_schema >= 0 && !check(member_schema, member)))
+      {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+class CompiledSchema
+{
+public:
+  explicit CompiledSchema(const char* schema_text)
+  {
+    (void)structural_.compile(schema_text);
+    try
+    {
+      validator_.set_root_schema(nlohmann::json::parse(schema_text));
+      usable_ = true;
+    }
+    catch (const std::exception& exception)
+    {
+      error_ = exception.what();
+    }
+  }
+
+  auto validate(const std::string& json_path) const -> SchemaVerdict
+  {
+    SchemaVerdict verdict;
+    MappedFile file;
+    if (!file.open(json_path))
+    {
+      verdict.message = "Could not open JSON file: " + json_path;
+      return verdict;
+    }
+    if (structural_.usable() && file.size() > 0)
+    {
+      yyjson_doc* doc = yyjson_read_opts(file.data(), file.size(), 0, nullptr, nullptr);
+      const bool passed = doc != nullptr && structural_.check(yyjson_doc_get_root(doc));
+      yyjson_doc_free(doc);
+      if (passed)
+      {
+        verdict.valid = true;
+        verdict.structural = true;
+        verdict.message = "JSON is valid according to schema.";
+        return verdict;
+      }
+    }
+    if (!usable_)
+    {
+      verdict.message = "Invalid schema: " + error_;
+      return verdict;
+    }
+    // Slow path: the full validator decides and reports the first violation
+    nlohmann::json data_json;
+    try
+    {
+      const char* begin = file.size() > 0 ? file.data() : "";
+      data_json = nlohmann::json::parse(begin, begin + file.size());
+    }
+    catch (const std::exception& exception)
+    {
+      verdict.message = std::string("Failed to parse JSON or schema: ") + exception.what();
+      return verdict;
+    }
+    try
+    {
+      validator_.validate(data_json);
+      verdict.valid = true;
+      verdict.message = "JSON is valid according to schema.";
+    }
+    catch (const std::exception& exception)
+    {
+      verdict.message = std::string("JSON validation failed: ") + exception.what();
+    }
+    return verdict;
+  }
+
+private:
+  StructuralSchema structural_;
+  nlohmann::json_schema::json_validator validator_;
+  bool usable_ = false;
+  std::string error_;
+};
+
+// Built on first use; static locals make concurrent first calls safe
+auto compiled_schema(JsonSchema schema) -> const CompiledSchema&
+{
+  if (schema == JsonSchema::summary)
+  {
+    static const CompiledSchema summary_schema(embedded_summary_schema);
+    return summary_schema;
+  }
+  static const CompiledSchema result_schema(embedded_result_schema);
+  return result_schema;
+}
+} // namespace
+
+auto schema_for_path(const std::string& schema_path, JsonSchema& schema) -> bool
+{
+  if (schema_path.find("result.schema.json") != std::string::npos)
+  {
+    schema = JsonSchema::result;
+    return true;
+  }
+  if (schema_path.find("summary.schema.json") != std::string::npos)
+  {
+    schema = JsonSchema::summary;
+    return true;
+  }
+  return false;
+}
+
+auto validate_json_file(const std::string& json_path, JsonSchema schema) -> SchemaVerdict
+{
+  return compiled_schema(schema).validate(json_path);
+}
+
+auto validate_json_files(const std::vector<std::string>& json_paths, JsonSchema schema)
+    -> std::vector<SchemaVerdict>
+{
+  std::vector<SchemaVerdict> verdicts(json_paths.size());
+  if (json_paths.empty())
+  {
+    return verdicts;
+  }
+  const CompiledSchema& compiled = compiled_schema(schema); // compile before fanning out
+  std::atomic<size_t> next_file{0};
+  auto worker = [&]()
+  {
+    for (size_t file_index = next_file++; file_index < json_paths.size();
+         file_index = next_file++)
+    {
+      verdicts[file_index] = compiled.validate(json_paths[file_index]);
+    }
+  };
+  const size_t hardware_threads = std::max(1U, std::thread::hardware_concurrency());
+  const size_t worker_count =
+      std::min(hardware_threads, json_paths.size() / kFilesPerWorker + 1);
+  std::vector<std::future<void>> workers;
+  for (size_t worker_index = 1; worker_index < worker_count; ++worker_index)
+  {
+    workers.push_back(std::async(std::launch::async, worker));
+  }
+  worker();
+  for (auto& pending : workers)
+  {
+    pending.get();
+  }
+  return verdicts;
+}
@@ -0,0 +1,27 @@
+#pragma once
+#include <string>  // for string
+#include <vector>  // for vector
+
+// Embedded JSON schemas (schemas/*.schema.json)
+enum class JsonSchema
+{
+  result,
+  summary
+};
+
+struct SchemaVerdict
+{
+  bool valid = false;
+  bool structural = false; // decided by the yyjson structural check alone
+  std::string message;     // human-readable outcome, for [SCHEMA] diagnostics
+};
+
+// Maps a schema file name ("result.schema.json", "summary.schema.json") to its embedded schema
+auto schema_for_path(const std::string& schema_path, JsonSchema& schema) -> bool;
+// Each file is first checked against a yyjson-compiled form of the schema; only files that do
+// not pass that check (or schemas using keywords it does not implement) go through the full
+// nlohmann validator. Both compiled forms are built once per schema and shared by all callers.
+auto validate_json_file(const std::string& json_path, JsonSchema schema) -> SchemaVerdict;
+// Validates files on a worker pool; verdicts are in input order
+auto validate_json_files(const std::vector<std::string>& json_paths, JsonSchema schema)
+    -> std::vector<SchemaVerdict>;
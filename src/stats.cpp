@@ -1,8 +1,9 @@
 #include "stats.h"
-#include <bits/std_abs.h>  // for abs
-#include <stddef.h>        // for size_t
-#include <algorithm>       // for sort
-#include <cmath>           // for floor
+#include <stddef.h>   // for size_t
+#include <algorithm>  // for nth_element, min_element, sort, min, max
+#include <cmath>      // for floor, fabs, sqrt, copysign
+#include <cstddef>    // for ptrdiff_t
+#include "stats_kernels.h"  // for sum, abs_diff_sum
 
 namespace stats
 {
@@ -16,44 +17,48 @@ auto average(const std::vector<double>& values) -> double
   {
     return 0.0;
   }
-  double total = 0.0;
-  for (const double value : values)
-  {
-    total += value;
-  }
-  return total / static_cast<double>(values.size());
+  return kernels::sum(values.data(), values.size()) / static_cast<double>(values.size());
 }
 
-auto median(std::vector<double> values) -> double
+// Selection instead of a full sort: one partial pass per order statistic
+auto median(const std::vector<double>& values) -> double
 {
   const size_t value_count = values.size();
   if (value_count == 0)
   {
     return 0.0;
   }
-  std::sort(values.begin(), values.end());
+  std::vector<double> scratch(values);
+  const auto upper = scratch.begin() + static_cast<std::ptrdiff_t>(value_count / 2);
+  std::nth_element(scratch.begin(), upper, scratch.end());
   if (value_count % 2)
   {
-    return values[value_count / 2];
+    return *upper;
   }
-  return (values[value_count / 2 - 1] + values[value_count / 2]) / kTwo;
+  // Lower middle is the largest element of the left partition
+  const double lower = *std::max_element(scratch.begin(), upper);
+  return (lower + *upper) / kTwo;
 }
 
-auto quartile(std::vector<double> values, double percentile) -> double
+auto quartile(const std::vector<double>& values, double percentile) -> double
 {
   if (values.empty())
   {
     return 0.0;
   }
-  std::sort(values.begin(), values.end());
-  const double position = static_cast<double>(values.size() - 1) * percentile;
+  std::vector<double> scratch(values);
+  const double position = static_cast<double>(scratch.size() - 1) * percentile;
   const size_t base_index = static_cast<size_t>(std::floor(position));
   const double remainder = position - static_cast<double>(base_index);
-  if (base_index + 1 < values.size())
+  const auto base = scratch.begin() + static_cast<std::ptrdiff_t>(base_index);
+  std::nth_element(scratch.begin(), base, scratch.end());
+  if (base_index + 1 < scratch.size())
   {
-    return values[base_index] + remainder * (values[base_index + 1] - values[base_index]);
+    // Next order statistic is the smallest element of the right partition
+    const double next = *std::min_element(base + 1, scratch.end());
+    return *base + remainder * (next - *base);
   }
-  return values[base_index];
+  return *base;
 }
 
 auto jitter(const std::vector<double>& values) -> double
@@ -62,11 +67,133 @@ auto jitter(const std::vector<double>& values) -> double
   {
     return 0.0;
   }
-  std::vector<double> jitters{};
-  for (size_t index = 0; index + 1 < values.size(); ++index)
+  return kernels::abs_diff_sum(values.data(), values.size()) /
+         static_cast<double>(values.size() - 1);
+}
+
+P2Quantile::P2Quantile(double quantile) : quantile_(quantile)
+{
+  desired_ = {0.0, kTwo * quantile, 4.0 * quantile, kTwo + kTwo * quantile, 4.0};
+  increments_ = {0.0, quantile / kTwo, quantile, (1.0 + quantile) / kTwo, 1.0};
+}
+
+void P2Quantile::add(double value)
+{
+  if (count_ < kMarkers)
+  {
+    heights_[count_++] = value;
+    if (count_ == kMarkers)
+    {
+      std::sort(heights_.begin(), heights_.end());
+      positions_ = {0.0, 1.0, 2.0, 3.0, 4.0};
+    }
+    return;
+  }
+  ++count_;
+  // Locate the cell containing the value, widening the extremes if needed
+  size_t cell = 0;
+  if (value < heights_[0])
+  {
+    heights_[0] = value;
+  }
+  else if (value >= heights_[kMarkers - 1])
+  {
+    heights_[kMarkers - 1] = value;
+    cell = kMarkers - 2;
+  }
+  else
+  {
+    while (cell + 1 < kMarkers - 1 && value >= heights_[cell + 1])
+    {
+      ++cell;
+    }
+  }
+  for (size_t marker = cell + 1; marker < kMarkers; ++marker)
+  {
+    positions_[marker] += 1.0;
+  }
+  for (size_t marker = 0; marker < kMarkers; ++marker)
+  {
+    desired_[marker] += increments_[marker];
+  }
+  // Nudge the three middle markers towards their desired positions
+  for (size_t marker = 1; marker < kMarkers - 1; ++marker)
+  {
+    const double offset = desired_[marker] - positions_[marker];
+    if ((offset >= 1.0 && positions_[marker + 1] - positions_[marker] > 1.0) ||
+        (offset <= -1.0 && positions_[marker - 1] - positions_[marker] < -1.0))
+    {
+      const double step = std::copysign(1.0, offset);
+      const double below = positions_[marker] - positions_[marker - 1];
+      const double above = positions_[marker + 1] - positions_[marker];
+      const double span = positions_[marker + 1] - positions_[marker - 1];
+      // Piecewise-parabolic prediction, falling back to linear if it breaks monotonicity
+      const double parabolic =
+          heights_[marker] +
+          step / span *
+              ((below + step) * (heights_[marker + 1] - heights_[marker]) / above +
+               (above - step) * (heights_[marker] - heights_[marker - 1]) / below);
+      if (heights_[marker - 1] < parabolic && parabolic < heights_[marker + 1])
+      {
+        heights_[marker] = parabolic;
+      }
+      else
+      {
+        const size_t neighbour = step > 0 ? marker + 1 : marker - 1;
+        heights_[marker] += step * (heights_[neighbour] - heights_[marker]) /
+                            (positions_[neighbour] - positions_[marker]);
+      }
+      positions_[marker] += step;
+    }
+  }
+}
+
+auto P2Quantile::value() const -> double
+{
+  if (count_ == 0)
+  {
+    return 0.0;
+  }
+  if (count_ <= kMarkers)
   {
-    jitters.push_back(std::abs(values[index] - values[index + 1]));
+    // Few samples: exact interpolated quantile, same definition as stats::quartile
+    std::vector<double> initial(heights_.begin(), heights_.begin() + count_);
+    return quartile(initial, quantile_);
   }
-  return average(jitters);
+  return heights_[2];
+}
+
+void StreamingStats::add(double value)
+{
+  ++count_;
+  if (count_ == 1)
+  {
+    min_ = value;
+    max_ = value;
+  }
+  else
+  {
+    min_ = std::min(min_, value);
+    max_ = std::max(max_, value);
+    abs_diff_sum_ += std::fabs(value - previous_);
+  }
+  previous_ = value;
+  const double delta = value - mean_;
+  mean_ += delta / static_cast<double>(count_);
+  m2_ += delta * (value - mean_);
+  median_.add(value);
+  p90_.add(value);
+}
+
+auto StreamingStats::variance() const -> double
+{
+  return count_ > 1 ? m2_ / static_cast<double>(count_ - 1) : 0.0;
+}
+
+auto StreamingStats::stddev() const -> double { return std::sqrt(variance()); }
+
+auto StreamingStats::jitter() const -> double
+{
+  return count_ > 1 ? abs_diff_sum_ / static_cast<double>(count_ - 1) : 0.0;
 }
 } // namespace stats
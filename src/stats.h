@@ -1,11 +1,61 @@
 #pragma once
+#include <stddef.h>  // for size_t
+#include <array>     // for array
 #include <vector>
 
 namespace stats
 {
 // Modernized: trailing return types, descriptive parameter names
 auto average(const std::vector<double>& values) -> double;
-auto median(std::vector<double> values) -> double;
-auto quartile(std::vector<double> values, double percentile) -> double;
+auto median(const std::vector<double>& values) -> double;
+auto quartile(const std::vector<double>& values, double percentile) -> double;
 auto jitter(const std::vector<double>& values) -> double;
+
+// Bounded-memory quantile estimate (P-square algorithm, Jain & Chlamtac 1985).
+// Exact for the first five samples, five markers afterwards.
+class P2Quantile
+{
+public:
+  explicit P2Quantile(double quantile);
+  void add(double value);
+  auto value() const -> double;
+  auto count() const -> size_t { return count_; }
+
+private:
+  static constexpr size_t kMarkers = 5;
+  double quantile_;
+  size_t count_ = 0;
+  std::array<double, kMarkers> heights_{};
+  std::array<double, kMarkers> positions_{};
+  std::array<double, kMarkers> desired_{};
+  std::array<double, kMarkers> increments_{};
+};
+
+// O(1)-memory accumulator updated as each sample arrives: Welford mean/variance, min/max,
+// jitter (mean absolute difference of consecutive samples) and P-square median/p90.
+class StreamingStats
+{
+public:
+  void add(double value);
+  auto count() const -> size_t { return count_; }
+  auto mean() const -> double { return mean_; }
+  auto variance() const -> double; // sample variance (n - 1)
+  auto stddev() const -> double;
+  auto min() const -> double { return count_ ? min_ : 0.0; }
+  auto max() const -> double { return count_ ? max_ : 0.0; }
+  auto jitter() const -> double;
+  auto median() const -> double { return median_.value(); }
+  auto p90() const -> double { return p90_.value(); }
+
+private:
+  size_t count_ = 0;
+  double mean_ = 0.0;
+  double m2_ = 0.0;
+  double min_ = 0.0;
+  double max_ = 0.0;
+  double previous_ = 0.0;
+  double abs_diff_sum_ = 0.0;
+  P2Quantile median_{0.5};
+  P2Quantile p90_{0.9};
+};
 } // namespace stats
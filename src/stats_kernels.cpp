@@ -0,0 +1,354 @@
+#include "stats_kernels.h"
+#include <algorithm>  // for min, max
+#include <cmath>      // for fabs, log
+#if defined(__x86_64__) || defined(__i386__)
+  #include <immintrin.h>  // for __m256d, _mm256_* (AVX2 path is compiled with a target attribute)
+  #include <emmintrin.h>  // for __m128d, _mm_*
+  #define SCF_KERNELS_X86 1
+#elif defined(__aarch64__)
+  #include <arm_neon.h>   // for float64x2_t, vaddq_f64, ...
+  #define SCF_KERNELS_NEON64 1
+#endif
+
+namespace stats::kernels
+{
+
+// Four independent accumulators break the add dependency chain and let the compiler vectorise
+auto sum_scalar(const double* values, size_t count) -> double
+{
+  double acc0 = 0.0;
+  double acc1 = 0.0;
+  double acc2 = 0.0;
+  double acc3 = 0.0;
+  size_t index = 0;
+  for (; index + 4 <= count; index += 4)
+  {
+    acc0 += values[index];
+    acc1 += values[index + 1];
+    acc2 += values[index + 2];
+    acc3 += values[index + 3];
+  }
+  for (; index < count; ++index)
+  {
+    acc0 += values[index];
+  }
+  return (acc0 + acc1) + (acc2 + acc3);
+}
+
+auto min_max_scalar(const double* values, size_t count, double& min_value, double& max_value)
+    -> void
+{
+  if (count == 0)
+  {
+    min_value = 0.0;
+    max_value = 0.0;
+    return;
+  }
+  double low = values[0];
+  double high = values[0];
+  for (size_t index = 1; index < count; ++index)
+  {
+    low = std::min(low, values[index]);
+    high = std::max(high, values[index]);
+  }
+  min_value = low;
+  max_value = high;
+}
+
+auto abs_diff_sum_scalar(const double* values, size_t count) -> double
+{
+  double acc0 = 0.0;
+  double acc1 = 0.0;
+  size_t index = 0;
+  for (; index + 2 < count; index += 2)
+  {
+    acc0 += std::fabs(values[index + 1] - values[index]);
+    acc1 += std::fabs(values[index + 2] - values[index + 1]);
+  }
+  for (; index + 1 < count; ++index)
+  {
+    acc0 += std::fabs(values[index + 1] - values[index]);
+  }
+  return acc0 + acc1;
+}
+
+namespace
+{
+#if defined(SCF_KERNELS_X86)
+auto sum_sse2(const double* values, size_t count) -> double
+{
+  __m128d acc0 = _mm_setzero_pd();
+  __m128d acc1 = _mm_setzero_pd();
+  size_t index = 0;
+  for (; index + 4 <= count; index += 4)
+  {
+    acc0 = _mm_add_pd(acc0, _mm_loadu_pd(values + index));
+    acc1 = _mm_add_pd(acc1, _mm_loadu_pd(values + index + 2));
+  }
+  alignas(16) double lanes[2];
+  _mm_store_pd(lanes, _mm_add_pd(acc0, acc1));
+  double total = lanes[0] + lanes[1];
+  for (; index < count; ++index)
+  {
+    total += values[index];
+  }
+  return total;
+}
+
+auto min_max_sse2(const double* values, size_t count, double& min_value, double& max_value) -> void
+{
+  if (count < 2)
+  {
+    min_max_scalar(values, count, min_value, max_value);
+    return;
+  }
+  __m128d low = _mm_loadu_pd(values);
+  __m128d high = low;
+  size_t index = 2;
+  for (; index + 2 <= count; index += 2)
+  {
+    const __m128d chunk = _mm_loadu_pd(values + index);
+    low = _mm_min_pd(low, chunk);
+    high = _mm_max_pd(high, chunk);
+  }
+  alignas(16) double low_lanes[2];
+  alignas(16) double high_lanes[2];
+  _mm_store_pd(low_lanes, low);
+  _mm_store_pd(high_lanes, high);
+  double tail_low = std::min(low_lanes[0], low_lanes[1]);
+  double tail_high = std::max(high_lanes[0], high_lanes[1]);
+  for (; index < count; ++index)
+  {
+    tail_low = std::min(tail_low, values[index]);
+    tail_high = std::max(tail_high, values[index]);
+  }
+  min_value = tail_low;
+  max_value = tail_high;
+}
+
+auto abs_diff_sum_sse2(const double* values, size_t count) -> double
+{
+  const __m128d abs_mask = _mm_castsi128_pd(_mm_set1_epi64x(0x7fffffffffffffffLL));
+  __m128d acc = _mm_setzero_pd();
+  size_t index = 0;
+  for (; index + 3 <= count; index += 2)
+  {
+    const __m128d current = _mm_loadu_pd(values + index);
+    const __m128d next = _mm_loadu_pd(values + index + 1);
+    acc = _mm_add_pd(acc, _mm_and_pd(_mm_sub_pd(next, current), abs_mask));
+  }
+  alignas(16) double lanes[2];
+  _mm_store_pd(lanes, acc);
+  double total = lanes[0] + lanes[1];
+  for (; index + 1 < count; ++index)
+  {
+    total += std::fabs(values[index + 1] - values[index]);
+  }
+  return total;
+}
+
+__attribute__((target("avx2"))) auto sum_avx2(const double* values, size_t count) -> double
+{
+  __m256d acc0 = _mm256_setzero_pd();
+  __m256d acc1 = _mm256_setzero_pd();
+  size_t index = 0;
+  for (; index + 8 <= count; index += 8)
+  {
+    acc0 = _mm256_add_pd(acc0, _mm256_loadu_pd(values + index));
+    acc1 = _mm256_add_pd(acc1, _mm256_loadu_pd(values + index + 4));
+  }
+  alignas(32) double lanes[4];
+  _mm256_store_pd(lanes, _mm256_add_pd(acc0, acc1));
+  double total = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+  for (; index < count; ++index)
+  {
+    total += values[index];
+  }
+  return total;
+}
+
+__attribute__((target("avx2"))) auto min_max_avx2(const double* values, size_t count,
+                                                  double& min_value, double& max_value) -> void
+{
+  if (count < 4)
+  {
+    min_max_scalar(values, count, min_value, max_value);
+    return;
+  }
+  __m256d low = _mm256_loadu_pd(values);
+  __m256d high = low;
+  size_t index = 4;
+  for (; index + 4 <= count; index += 4)
+  {
+    const __m256d chunk = _mm256_loadu_pd(values + index);
+    low = _mm256_min_pd(low, chunk);
+    high = _mm256_max_pd(high, chunk);
+  }
+  alignas(32) double low_lanes[4];
+  alignas(32) double high_lanes[4];
+  _mm256_store_pd(low_lanes, low);
+  _mm256_store_pd(high_lanes, high);
+  double tail_low =
+      std::min(std::min(low_lanes[0], low_lanes[1]), std::min(low_lanes[2], low_lanes[3]));
+  double tail_high =
+      std::max(std::max(high_lanes[0], high_lanes[1]), std::max(high_lanes[2], high_lanes[3]));
+  for (; index < count; ++index)
+  {
+    tail_low = std::min(tail_low, values[index]);
+    tail_high = std::max(tail_high, values[index]);
+  }
+  min_value = tail_low;
+  max_value = tail_high;
+}
+
+__attribute__((target("avx2"))) auto abs_diff_sum_avx2(const double* values, size_t count)
+    -> double
+{
+  const __m256d abs_mask = _mm256_castsi256_pd(_mm256_set1_epi64x(0x7fffffffffffffffLL));
+  __m256d acc = _mm256_setzero_pd();
+  size_t index = 0;
+  for (; index + 5 <= count; index += 4)
+  {
+    const __m256d current = _mm256_loadu_pd(values + index);
+    const __m256d next = _mm256_loadu_pd(values + index + 1);
+    acc = _mm256_add_pd(acc, _mm256_and_pd(_mm256_sub_pd(next, current), abs_mask));
+  }
+  alignas(32) double lanes[4];
+  _mm256_store_pd(lanes, acc);
+  double total = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+  for (; index + 1 < count; ++index)
+  {
+    total += std::fabs(values[index + 1] - values[index]);
+  }
+  return total;
+}
+#elif defined(SCF_KERNELS_NEON64)
+auto sum_neon(const double* values, size_t count) -> double
+{
+  float64x2_t acc0 = vdupq_n_f64(0.0);
+  float64x2_t acc1 = vdupq_n_f64(0.0);
+  size_t index = 0;
+  for (; index + 4 <= count; index += 4)
+  {
+    acc0 = vaddq_f64(acc0, vld1q_f64(values + index));
+    acc1 = vaddq_f64(acc1, vld1q_f64(values + index + 2));
+  }
+  double total = vaddvq_f64(vaddq_f64(acc0, acc1));
+  for (; index < count; ++index)
+  {
+    total += values[index];
+  }
+  return total;
+}
+
+auto min_max_neon(const double* values, size_t count, double& min_value, double& max_value) -> void
+{
+  if (count < 2)
+  {
+    min_max_scalar(values, count, min_value, max_value);
+    return;
+  }
+  float64x2_t low = vld1q_f64(values);
+  float64x2_t high = low;
+  size_t index = 2;
+  for (; index + 2 <= count; index += 2)
+  {
+    const float64x2_t chunk = vld1q_f64(values + index);
+    low = vminq_f64(low, chunk);
+    high = vmaxq_f64(high, chunk);
+  }
+  double tail_low = vminvq_f64(low);
+  double tail_high = vmaxvq_f64(high);
+  for (; index < count; ++index)
+  {
+    tail_low = std::min(tail_low, values[index]);
+    tail_high = std::max(tail_high, values[index]);
+  }
+  min_value = tail_low;
+  max_value = tail_high;
+}
+
+auto abs_diff_sum_neon(const double* values, size_t count) -> double
+{
+  float64x2_t acc = vdupq_n_f64(0.0);
+  size_t index = 0;
+  for (; index + 3 <= count; index += 2)
+  {
+    acc = vaddq_f64(acc, vabdq_f64(vld1q_f64(values + index + 1), vld1q_f64(values + index)));
+  }
+  double total = vaddvq_f64(acc);
+  for (; index + 1 < count; ++index)
+  {
+    total += std::fabs(values[index + 1] - values[index]);
+  }
+  return total;
+}
+#endif
+
+using SumFn = double (*)(const double*, size_t);
+using MinMaxFn = void (*)(const double*, size_t, double&, double&);
+
+// Resolved once on first use
+struct KernelTable
+{
+  SumFn sum = sum_scalar;
+  MinMaxFn min_max = min_max_scalar;
+  SumFn abs_diff_sum = abs_diff_sum_scalar;
+  const char* isa = "scalar";
+};
+
+auto kernel_table() -> const KernelTable&
+{
+  static const KernelTable table = []()
+  {
+    KernelTable resolved;
+#if defined(SCF_KERNELS_X86)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+    {
+      resolved = KernelTable{sum_avx2, min_max_avx2, abs_diff_sum_avx2, "avx2"};
+    }
+  #if defined(__SSE2__)
+    else
+    {
+      resolved = KernelTable{sum_sse2, min_max_sse2, abs_diff_sum_sse2, "sse2"};
+    }
+  #endif
+#elif defined(SCF_KERNELS_NEON64)
+    resolved = KernelTable{sum_neon, min_max_neon, abs_diff_sum_neon, "neon"};
+#endif
+    return resolved;
+  }();
+  return table;
+}
+} // namespace
+
+auto sum(const double* values, size_t count) -> double { return kernel_table().sum(values, count); }
+
+auto min_max(const double* values, size_t count, double& min_value, double& max_value) -> void
+{
+  kernel_table().min_max(values, count, min_value, max_value);
+}
+
+auto abs_diff_sum(const double* values, size_t count) -> double
+{
+  return kernel_table().abs_diff_sum(values, count);
+}
+
+// Two passes: a branch-free index computation the compiler can vectorise (with libmvec log where
+// available), then the caller's scatter increment. Uses the exact log so bucket assignment never
+// differs from LogHistogram::bucket_index.
+auto log_bucket_indices(const double* values, size_t count, double lowest, double inv_log_growth,
+                        uint16_t max_index, uint16_t* indices) -> void
+{
+  const double max_position = static_cast<double>(max_index);
+  for (size_t index = 0; index < count; ++index)
+  {
+    const double ratio = values[index] > lowest ? values[index] / lowest : 1.0;
+    const double position = std::min(std::log(ratio) * inv_log_growth, max_position);
+    indices[index] = static_cast<uint16_t>(position);
+  }
+}
+
+auto active_isa() -> const char* { return kernel_table().isa; }
+} // namespace stats::kernels
@@ -0,0 +1,23 @@
+#pragma once
+#include <stddef.h>  // for size_t
+#include <stdint.h>  // for uint16_t
+
+// Contiguous-array kernels behind stats:: and LogHistogram.
+// x86: AVX2 when the CPU reports it at runtime, SSE2 otherwise. AArch64: NEON float64x2.
+// ARMv7 has no double-precision SIMD (NEON is float32 only), so it takes the unrolled scalar path.
+namespace stats::kernels
+{
+auto sum(const double* values, size_t count) -> double;
+auto min_max(const double* values, size_t count, double& min_value, double& max_value) -> void;
+auto abs_diff_sum(const double* values, size_t count) -> double; // sum |v[i+1] - v[i]|
+// Log bucket index per value: floor(log(v / lowest) * inv_log_growth), clamped to [0, max_index]
+auto log_bucket_indices(const double* values, size_t count, double lowest, double inv_log_growth,
+                        uint16_t max_index, uint16_t* indices) -> void;
+auto active_isa() -> const char*;
+
+// Portable reference versions (also the fallbacks), exposed for benchmarks
+auto sum_scalar(const double* values, size_t count) -> double;
+auto min_max_scalar(const double* values, size_t count, double& min_value, double& max_value)
+    -> void;
+auto abs_diff_sum_scalar(const double* values, size_t count) -> double;
+} // namespace stats::kernels
@@ -0,0 +1,279 @@
+#include "summary_index.h"
+#include <sys/stat.h>    // for stat, mkdir
+#include <cstdio>        // for rename, remove
+#include <cstring>       // for memcpy
+#include <fstream>       // IWYU pragma: keep  // for ifstream, ofstream
+#include <iterator>      // for istreambuf_iterator
+#include <string>        // for string
+#include <utility>       // for move, pair
+#include <vector>        // for vector
+#include "estimation.h"  // for ConfidenceInterval
+#include "histogram.h"   // for LogHistogram
+
+// Layout (host byte order; the index is a local cache, never exchanged between machines):
+//   "SCFIDX1\n" | u32 version | str histogram scheme | u32 entry count | entries...
+//   entry: str path | u64 size | i64 mtime_ns | str file | str server_city | str ip
+//          | f64 latency, jitter, download, upload | 2 x (f64 estimate, lower, upper)
+//          | 3 x (u32 bucket count | count x (u32 bucket, u32 count))
+//   str: u32 length + bytes
+constexpr char kIndexMagic[8] = {'S', 'C', 'F', 'I', 'D', 'X', '1', '\n'};
+constexpr uint32_t kIndexVersion = 1;
+
+namespace
+{
+class IndexWriter
+{
+public:
+  template <typename T>
+  void pod(const T& value)
+  {
+    const char* bytes = reinterpret_cast<const char*>(&value);
+    buffer_.insert(buffer_.end(), bytes, bytes + sizeof(T));
+  }
+  void str(const std::string& value)
+  {
+    pod(static_cast<uint32_t>(value.size()));
+    buffer_.insert(buffer_.end(), value.begin(), value.end());
+  }
+  void interval(const ConfidenceInterval& value)
+  {
+    pod(value.estimate);
+    pod(value.lower);
+    pod(value.upper);
+  }
+  void buckets(const LogHistogram::SparseBuckets& value)
+  {
+    pod(static_cast<uint32_t>(value.size()));
+    for (const auto& bucket : value)
+    {
+      pod(bucket.first);
+      pod(bucket.second);
+    }
+  }
+  auto buffer() const -> const std::vector<char>& { return buffer_; }
+
+private:
+  std::vector<char> buffer_;
+};
+
+// Bounds-checked cursor; any short read latches ok() to false
+class IndexReader
+{
+public:
+  IndexReader(const char* data, size_t size) : data_(data), size_(size) {}
+  template <typename T>
+  auto pod(T& value) -> bool
+  {
+    if (!take(sizeof(T)))
+    {
+      return false;
+    }
+    std::memcpy(&value, data_ + offset_ - sizeof(T), sizeof(T));
+    return true;
+  }
+  auto str(std::string& value) -> bool
+  {
+    uint32_t length = 0;
+    if (!pod(length) || !take(length))
+    {
+      return false;
+    }
+    value.assign(data_ + offset_ - length, length);
+    return true;
+  }
+  auto interval(ConfidenceInterval& value) -> bool
+  {
+    return pod(value.estimate) && pod(value.lower) && pod(value.upper);
+  }
+  auto buckets(LogHistogram::SparseBuckets& value) -> bool
+  {
+    uint32_t count = 0;
+    if (!pod(count) || count > (size_ - offset_) / (2 * sizeof(uint32_t)))
+    {
+      ok_ = false;
+      return false;
+    }
+    value.resize(count);
+    for (auto& bucket : value)
+    {
+      pod(bucket.first);
+      pod(bucket.second);
+    }
+    return ok_;
+  }
+  auto at_end() const -> bool { return offset_ == size_; }
+
+private:
+  auto take(size_t bytes) -> bool
+  {
+    if (!ok_ || bytes > size_ - offset_)
+    {
+      ok_ = false;
+      return false;
+    }
+    offset_ += bytes;
+    return true;
+  }
+  const char* data_;
+  size_t size_;
+  size_t offset_ = 0;
+  bool ok_ = true;
+};
+} // namespace
+
+auto stat_file_identity(const std::string& path, FileIdentity& identity) -> bool
+{
+  struct stat file_stat
+  {
+  };
+  if (stat(path.c_str(), &file_stat) != 0 || !S_ISREG(file_stat.st_mode))
+  {
+    return false;
+  }
+  identity.size = static_cast<uint64_t>(file_stat.st_size);
+  identity.mtime_ns = static_cast<int64_t>(file_stat.st_mtim.tv_sec) * 1000000000LL +
+                      static_cast<int64_t>(file_stat.st_mtim.tv_nsec);
+  return true;
+}
+
+auto SummaryIndex::load(const std::string& path) -> bool
+{
+  entries_.clear();
+  dirty_ = false;
+  std::ifstream in(path, std::ios::binary);
+  if (!in)
+  {
+    return false;
+  }
+  const std::vector<char> bytes((std::istreambuf_iterator<char>(in)),
+                                std::istreambuf_iterator<char>());
+  if (bytes.size() < sizeof(kIndexMagic) ||
+      std::memcmp(bytes.data(), kIndexMagic, sizeof(kIndexMagic)) != 0)
+  {
+    return false;
+  }
+  IndexReader reader(bytes.data() + sizeof(kIndexMagic), bytes.size() - sizeof(kIndexMagic));
+  uint32_t version = 0;
+  std::string scheme;
+  uint32_t entry_count = 0;
+  if (!reader.pod(version) || version != kIndexVersion || !reader.str(scheme) ||
+      scheme != LogHistogram::kScheme || !reader.pod(entry_count))
+  {
+    return false;
+  }
+  std::unordered_map<std::string, Entry> loaded;
+  loaded.reserve(entry_count);
+  for (uint32_t entry_index = 0; entry_index < entry_count; ++entry_index)
+  {
+    std::string key;
+    Entry entry;
+    SummaryResult& result = entry.result;
+    if (!(reader.str(key) && reader.pod(entry.identity.size) &&
+          reader.pod(entry.identity.mtime_ns) && reader.str(result.file) &&
+          reader.str(result.server_city) && reader.str(result.ip) && reader.pod(result.latency) &&
+          reader.pod(result.jitter) && reader.pod(result.download) && reader.pod(result.upload) &&
+          reader.interval(result.download_ci) && reader.interval(result.upload_ci) &&
+          reader.buckets(result.latency_histogram) && reader.buckets(result.download_histogram) &&
+          reader.buckets(result.upload_histogram)))
+    {
+      // Truncated or corrupt: start over rather than trust a partial index
+      return false;
+    }
+    loaded.emplace(std::move(key), std::move(entry));
+  }
+  if (!reader.at_end())
+  {
+    return false;
+  }
+  entries_ = std::move(loaded);
+  return true;
+}
+
+auto SummaryIndex::save(const std::string& path) -> bool
+{
+  IndexWriter writer;
+  writer.str(LogHistogram::kScheme);
+  writer.pod(static_cast<uint32_t>(entries_.size()));
+  for (const auto& [key, entry] : entries_)
+  {
+    const SummaryResult& result = entry.result;
+    writer.str(key);
+    writer.pod(entry.identity.size);
+    writer.pod(entry.identity.mtime_ns);
+    writer.str(result.file);
+    writer.str(result.server_city);
+    writer.str(result.ip);
+    writer.pod(result.latency);
+    writer.pod(result.jitter);
+    writer.pod(result.download);
+    writer.pod(result.upload);
+    writer.interval(result.download_ci);
+    writer.interval(result.upload_ci);
+    writer.buckets(result.latency_histogram);
+    writer.buckets(result.download_histogram);
+    writer.buckets(result.upload_histogram);
+  }
+  const size_t slash = path.find_last_of('/');
+  if (slash != std::string::npos)
+  {
+    (void)mkdir(path.substr(0, slash).c_str(), 0755);
+  }
+  const std::string tmp_path = path + ".tmp";
+  {
+    std::ofstream out(tmp_path, std::ios::binary | std::ios::trunc);
+    if (!out)
+    {
+      return false;
+    }
+    out.write(kIndexMagic, sizeof(kIndexMagic));
+    out.write(reinterpret_cast<const char*>(&kIndexVersion), sizeof(kIndexVersion));
+    out.write(writer.buffer().data(), static_cast<std::streamsize>(writer.buffer().size()));
+    if (!out)
+    {
+      (void)std::remove(tmp_path.c_str());
+      return false;
+    }
+  }
+  if (std::rename(tmp_path.c_str(), path.c_str()) != 0)
+  {
+    return false;
+  }
+  dirty_ = false;
+  return true;
+}
+
+auto SummaryIndex::find(const std::string& file, const FileIdentity& identity) const
+    -> const SummaryResult*
+{
+  const auto found = entries_.find(file);
+  if (found == entries_.end() || !(found->second.identity == identity))
+  {
+    return nullptr;
+  }
+  return &found->second.result;
+}
+
+void SummaryIndex::store(const std::string& file, const FileIdentity& identity,
+                         const SummaryResult& result)
+{
+  entries_[file] = Entry{identity, result};
+  dirty_ = true;
+}
+
+auto SummaryIndex::prune_missing() -> size_t
+{
+  size_t removed = 0;
+  FileIdentity identity;
+  for (auto entry = entries_.begin(); entry != entries_.end();)
+  {
+    if (!stat_file_identity(entry->first, identity))
+    {
+      entry = entries_.erase(entry);
+      ++removed;
+      continue;
+    }
+    ++entry;
+  }
+  dirty_ = dirty_ || removed > 0;
+  return removed;
+}
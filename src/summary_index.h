@@ -0,0 +1,47 @@
+#pragma once
+#include <stdint.h>       // for int64_t, uint64_t
+#include <string>         // for string
+#include <unordered_map>  // for unordered_map
+#include "types.h"        // for SummaryResult
+
+inline constexpr const char* SUMMARY_INDEX_FILENAME = "summary.index";
+
+// Identity of a result file as seen by stat(); a changed size or mtime invalidates its entry
+struct FileIdentity
+{
+  uint64_t size = 0;
+  int64_t mtime_ns = 0;
+
+  auto operator==(const FileIdentity& other) const -> bool
+  {
+    return size == other.size && mtime_ns == other.mtime_ns;
+  }
+};
+
+// Persistent cache of SummaryResult fields extracted from result files, keyed by path.
+// Stored as a compact binary sidecar next to the results; a missing, truncated or
+// foreign-version file simply yields an empty index.
+class SummaryIndex
+{
+public:
+  auto load(const std::string& path) -> bool;
+  auto save(const std::string& path) -> bool;
+  // Cached result for file if it is indexed with the same identity
+  auto find(const std::string& file, const FileIdentity& identity) const -> const SummaryResult*;
+  void store(const std::string& file, const FileIdentity& identity, const SummaryResult& result);
+  // Drops entries whose file no longer exists; returns the number removed
+  auto prune_missing() -> size_t;
+  auto size() const -> size_t { return entries_.size(); }
+  auto dirty() const -> bool { return dirty_; }
+
+private:
+  struct Entry
+  {
+    FileIdentity identity;
+    SummaryResult result;
+  };
+  std::unordered_map<std::string, Entry> entries_;
+  bool dirty_ = false;
+};
+
+auto stat_file_identity(const std::string& path, FileIdentity& identity) -> bool;
@@ -4,18 +4,22 @@
   // code only for non-cross-compiling builds
   #include <bits/chrono.h>         // for operator-, duration, high_resolution_clock
 #endif
+#include <fcntl.h>                 // for open, O_RDONLY, O_CLOEXEC
 #include <sched.h>                 // for sched_setaffinity, cpu_set_t, CPU_SET
 #include <stdio.h>                 // for fopen, fputs, FILE, fclose
-#include <sys/resource.h>          // for setpriority, PRIO_PROCESS
+#include <sys/resource.h>          // for setpriority, getrusage, PRIO_PROCESS
 #include <sys/utsname.h>           // for utsname, uname
+#include <unistd.h>                // for sysconf, _SC_PAGESIZE, read, close
+#include <algorithm>               // for max
 #include <array>                   // for array
+#include <cstdlib>                 // for strtol
 #include <ctime>                   // for localtime_r, size_t, strftime, time
 #include <fstream>                 // IWYU pragma: keep  // for ifstream
 #include <iomanip>                 // for operator<<, setprecision
 #include <iostream>                // for operator<<, basic_ostream, endl
 #include <memory>                  // for unique_ptr
+#include <sstream>                 // for istringstream
 #include <string>                  // for string, allocator, char_traits
-#include <string_view>             // for string_view
 #include <thread>                  // for sleep_for
 #include "types.h"                 // for TestResults, BUILD_VERSION
 
@@ -26,10 +30,187 @@ constexpr int kNiceValue = 10;
 constexpr int kYieldMs = 10;
 constexpr double kMsPerSecond = 1000.0;
 constexpr double kNsPerMs = 1e6;
+constexpr double kUsPerSecond = 1e6;
+constexpr long kBytesPerKb = 1024;
+constexpr long kKhzPerMhz = 1000;
+constexpr size_t kReadChunkBytes = 16384;
 
 // Modernized: trailing return types, braces, descriptive variable names, auto, nullptr, one
 // declaration per statement, no implicit conversions
 
+namespace
+{
+// Whole file with as few read(2) calls as its size needs; empty when missing. /proc and sysfs
+// files are generated on read, so each is read exactly once per snapshot.
+auto read_file(const std::string& path) -> std::string
+{
+  std::string contents;
+  const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0)
+  {
+    return contents;
+  }
+  std::array<char, kReadChunkBytes> chunk{};
+  ssize_t received = 0;
+  while ((received = read(fd, chunk.data(), chunk.size())) > 0)
+  {
+    contents.append(chunk.data(), static_cast<size_t>(received));
+  }
+  close(fd);
+  return contents;
+}
+
+// Single-line sysfs/sysctl value with runs of whitespace (tcp_rmem uses tabs) folded to a space
+auto read_value(const std::string& path) -> std::string
+{
+  std::string value;
+  for (const char character : read_file(path))
+  {
+    const bool blank = character == ' ' || character == '\t' || character == '\n';
+    if (!blank)
+    {
+      value += character;
+    }
+    else if (!value.empty() && value.back() != ' ')
+    {
+      value += ' ';
+    }
+  }
+  if (!value.empty() && value.back() == ' ')
+  {
+    value.pop_back();
+  }
+  return value;
+}
+
+auto read_number(const std::string& path) -> long
+{
+  const std::string value = read_value(path);
+  char* end = nullptr;
+  const long number = std::strtol(value.c_str(), &end, 10);
+  return end != value.c_str() ? number : 0;
+}
+
+// Interface of the lowest-metric IPv4 default route, else of the IPv6 one
+auto default_route_interface() -> std::string
+{
+  std::istringstream routes(read_file("/proc/net/route"));
+  std::string line;
+  std::string interface;
+  long best_metric = -1;
+  std::getline(routes, line); // header
+  while (std::getline(routes, line))
+  {
+    std::istringstream fields(line);
+    std::string name;
+    std::string destination;
+    std::string gateway;
+    std::string flags;
+    long refcnt = 0;
+    long use = 0;
+    long metric = 0;
+    std::string mask;
+    if (fields >> name >> destination >> gateway >> flags >> refcnt >> use >> metric >> mask &&
+        destination == "00000000" && mask == "00000000" &&
+        (best_metric < 0 || metric < best_metric))
+    {
+      interface = name;
+      best_metric = metric;
+    }
+  }
+  if (!interface.empty())
+  {
+    return interface;
+  }
+  // ipv6_route: dest prefix_len src src_len next_hop metric refcnt use flags interface
+  std::istringstream routes_v6(read_file("/proc/net/ipv6_route"));
+  while (std::getline(routes_v6, line))
+  {
+    std::istringstream fields(line);
+    std::string destination;
+    std::string prefix_length;
+    std::string name;
+    for (std::string field; fields >> field;)
+    {
+      name = field; // the interface is the last column
+    }
+    fields.clear();
+    fields.str(line);
+    if (fields >> destination >> prefix_length && prefix_length == "00" &&
+        destination.find_first_not_of('0') == std::string::npos && name != "lo")
+    {
+      return name;
+    }
+  }
+  return interface;
+}
+
+auto collect_host_tuning() -> HostTuning
+{
+  HostTuning tuning;
+  tuning.interface = default_route_interface();
+  if (!tuning.interface.empty())
+  {
+    const std::string net_dir = "/sys/class/net/" + tuning.interface + "/";
+    // speed reads as -1 (or fails) for links without a fixed rate: Wi-Fi, tunnels, bridges
+    tuning.link_speed_mbps = static_cast<int>(std::max(0L, read_number(net_dir + "speed")));
+    tuning.mtu = static_cast<int>(read_number(net_dir + "mtu"));
+  }
+  tuning.tcp_congestion_control = read_value("/proc/sys/net/ipv4/tcp_congestion_control");
+  tuning.tcp_rmem = read_value("/proc/sys/net/ipv4/tcp_rmem");
+  tuning.tcp_wmem = read_value("/proc/sys/net/ipv4/tcp_wmem");
+  tuning.cpu_governor = read_value("/sys/devices/system/cpu/cpu0/cpufreq/scaling_governor");
+  tuning.cpu_freq_khz = read_number("/sys/devices/system/cpu/cpu0/cpufreq/scaling_cur_freq");
+  return tuning;
+}
+
+auto collect_host_snapshot() -> HostSnapshot
+{
+  HostSnapshot snapshot;
+  struct utsname uts
+  {
+  };
+  if (uname(&uts) == 0)
+  {
+    snapshot.nodename = static_cast<const char*>(uts.nodename);
+    snapshot.arch = static_cast<const char*>(uts.machine);
+    snapshot.kernel = std::string(static_cast<const char*>(uts.sysname)) + " " +
+                      static_cast<const char*>(uts.release);
+  }
+  std::istringstream cpuinfo(read_file("/proc/cpuinfo"));
+  std::string line;
+  while (std::getline(cpuinfo, line))
+  {
+    if (line.find("model name") != std::string::npos)
+    {
+      if (snapshot.cpu_model.empty())
+      {
+        snapshot.cpu_model = line.substr(line.find(':') + 2);
+      }
+      ++snapshot.cpu_cores;
+    }
+  }
+  std::istringstream meminfo(read_file("/proc/meminfo"));
+  while (std::getline(meminfo, line))
+  {
+    if (line.find("MemTotal:") == 0)
+    {
+      snapshot.mem_total = line.substr(line.find(':') + 1);
+      snapshot.mem_total_kb = std::strtol(snapshot.mem_total.c_str(), nullptr, 10);
+      break;
+    }
+  }
+  snapshot.tuning = collect_host_tuning();
+  return snapshot;
+}
+} // namespace
+
+auto host_snapshot() -> const HostSnapshot&
+{
+  static const HostSnapshot snapshot = collect_host_snapshot();
+  return snapshot;
+}
+
 void print_sysinfo(bool mask_sensitive)
 {
   std::array<char, kDatetimeLen> datetime{};
@@ -41,24 +222,10 @@ void print_sysinfo(bool mask_sensitive)
   (void)strftime(datetime.data(), datetime.size(), "%Y-%m-%dT%H:%M:%S%z", &time_info);
   std::cout << "[SYS] Date: " << datetime.data() << std::endl;
   std::cout << "[SYS] Version: " << BUILD_VERSION << std::endl;
-  struct utsname uts
+  const HostSnapshot& snapshot = host_snapshot();
+  if (!snapshot.nodename.empty())
   {
-  };
-  if (uname(&uts) == 0)
-  {
-    std::string_view nodename_sv(
-        static_cast<const char*>(uts.nodename),
-        std::char_traits<char>::length(static_cast<const char*>(uts.nodename)));
-    std::string_view machine_sv(
-        static_cast<const char*>(uts.machine),
-        std::char_traits<char>::length(static_cast<const char*>(uts.machine)));
-    std::string_view sysname_sv(
-        static_cast<const char*>(uts.sysname),
-        std::char_traits<char>::length(static_cast<const char*>(uts.sysname)));
-    std::string_view release_sv(
-        static_cast<const char*>(uts.release),
-        std::char_traits<char>::length(static_cast<const char*>(uts.release)));
-    std::string host(nodename_sv);
+    std::string host = snapshot.nodename;
     if (mask_sensitive && !host.empty())
     {
       const size_t host_len = host.length();
@@ -69,57 +236,56 @@ void print_sysinfo(bool mask_sensitive)
       }
     }
     std::cout << "[SYS] Host: " << host << std::endl;
-    std::cout << "[SYS] Arch: " << std::string(machine_sv) << std::endl;
-    std::cout << "[SYS] Kernel: " << std::string(sysname_sv) << " " << std::string(release_sv)
+    std::cout << "[SYS] Arch: " << snapshot.arch << std::endl;
+    std::cout << "[SYS] Kernel: " << snapshot.kernel << std::endl;
+  }
+  if (!snapshot.cpu_model.empty())
+  {
+    std::cout << "[SYS] CPU: " << snapshot.cpu_model << " (" << snapshot.cpu_cores << " cores)"
               << std::endl;
   }
-  std::ifstream cpuinfo("/proc/cpuinfo");
-  std::string line;
-  std::string model;
-  int core_count = 0;
-  while (std::getline(cpuinfo, line))
+  if (!snapshot.mem_total.empty())
   {
-    if (line.find("model name") != std::string::npos)
+    const double mem_gb = static_cast<double>(snapshot.mem_total_kb) / kMemGBDiv;
+    const double mem_mb = static_cast<double>(snapshot.mem_total_kb) / kMemMBDiv;
+    if (mem_gb >= 1.0)
     {
-      if (model.empty())
-      {
-        model = line.substr(line.find(':') + 2);
-      }
-      ++core_count;
+      std::cout << "[SYS] Mem: " << std::fixed << std::setprecision(1) << mem_gb << " GB"
+                << std::endl;
+    }
+    else
+    {
+      std::cout << "[SYS] Mem: " << std::fixed << std::setprecision(0) << mem_mb << " MB"
+                << std::endl;
     }
   }
-  if (!model.empty())
+  const HostTuning& tuning = snapshot.tuning;
+  if (!tuning.interface.empty())
   {
-    std::cout << "[SYS] CPU: " << model << " (" << core_count << " cores)" << std::endl;
+    std::cout << "[SYS] Net: " << tuning.interface;
+    if (tuning.link_speed_mbps > 0)
+    {
+      std::cout << ", " << tuning.link_speed_mbps << " Mb/s";
+    }
+    if (tuning.mtu > 0)
+    {
+      std::cout << ", MTU " << tuning.mtu;
+    }
+    std::cout << std::endl;
   }
-  std::ifstream meminfo("/proc/meminfo");
-  std::string memline;
-  while (std::getline(meminfo, memline))
+  if (!tuning.tcp_congestion_control.empty())
   {
-    if (memline.find("MemTotal:") == 0)
+    std::cout << "[SYS] TCP: " << tuning.tcp_congestion_control << ", rmem " << tuning.tcp_rmem
+              << ", wmem " << tuning.tcp_wmem << std::endl;
+  }
+  if (!tuning.cpu_governor.empty())
+  {
+    std::cout << "[SYS] CPU freq: " << tuning.cpu_governor;
+    if (tuning.cpu_freq_khz > 0)
     {
-      std::string memval = memline.substr(memline.find(':') + 1);
-      const size_t num_start = memval.find_first_of("0123456789");
-      const size_t num_end = memval.find_first_not_of("0123456789", num_start);
-      long mem_kb = 0;
-      if (num_start != std::string::npos)
-      {
-        mem_kb = std::stol(memval.substr(num_start, num_end - num_start));
-      }
-      const double mem_gb = static_cast<double>(mem_kb) / kMemGBDiv;
-      const double mem_mb = static_cast<double>(mem_kb) / kMemMBDiv;
-      if (mem_gb >= 1.0)
-      {
-        std::cout << "[SYS] Mem: " << std::fixed << std::setprecision(1) << mem_gb << " GB"
-                  << std::endl;
-      }
-      else
-      {
-        std::cout << "[SYS] Mem: " << std::fixed << std::setprecision(0) << mem_mb << " MB"
-                  << std::endl;
-      }
-      break;
+      std::cout << ", " << tuning.cpu_freq_khz / kKhzPerMhz << " MHz";
     }
+    std::cout << std::endl;
   }
 }
 
@@ -158,54 +324,14 @@ void collect_sysinfo(TestResults& res, bool mask_sensitive)
   (void)strftime(datetime.data(), datetime.size(), "%Y-%m-%dT%H:%M:%S%z", &time_info);
   res.sysinfo_date = datetime.data();
   res.version = BUILD_VERSION;
-  struct utsname uts
-  {
-  };
-  if (uname(&uts) == 0)
-  {
-    std::string_view nodename_sv(
-        static_cast<const char*>(uts.nodename),
-        std::char_traits<char>::length(static_cast<const char*>(uts.nodename)));
-    std::string_view machine_sv(
-        static_cast<const char*>(uts.machine),
-        std::char_traits<char>::length(static_cast<const char*>(uts.machine)));
-    std::string_view sysname_sv(
-        static_cast<const char*>(uts.sysname),
-        std::char_traits<char>::length(static_cast<const char*>(uts.sysname)));
-    std::string_view release_sv(
-        static_cast<const char*>(uts.release),
-        std::char_traits<char>::length(static_cast<const char*>(uts.release)));
-    res.host = mask_sensitive ? mask_str(std::string(nodename_sv)) : std::string(nodename_sv);
-    res.arch = std::string(machine_sv);
-    res.kernel = std::string(sysname_sv) + " " + std::string(release_sv);
-  }
-  std::ifstream cpuinfo("/proc/cpuinfo");
-  std::string line;
-  std::string model;
-  int core_count = 0;
-  while (std::getline(cpuinfo, line))
-  {
-    if (line.find("model name") != std::string::npos)
-    {
-      if (model.empty())
-      {
-        model = line.substr(line.find(':') + 2);
-      }
-      ++core_count;
-    }
-  }
-  res.cpu_model = model;
-  res.cpu_cores = core_count;
-  std::ifstream meminfo("/proc/meminfo");
-  std::string memline;
-  while (std::getline(meminfo, memline))
-  {
-    if (memline.find("MemTotal:") == 0)
-    {
-      res.mem_total = memline.substr(memline.find(':') + 1);
-      break;
-    }
-  }
+  const HostSnapshot& snapshot = host_snapshot();
+  res.host = mask_sensitive ? mask_str(snapshot.nodename) : snapshot.nodename;
+  res.arch = snapshot.arch;
+  res.kernel = snapshot.kernel;
+  res.cpu_model = snapshot.cpu_model;
+  res.cpu_cores = snapshot.cpu_cores;
+  res.mem_total = snapshot.mem_total;
+  res.host_tuning = snapshot.tuning;
 }
 
 auto get_time_ms() -> double
@@ -239,3 +365,27 @@ void pin_to_core(int core_id)
 void set_nice() { setpriority(PRIO_PROCESS, 0, kNiceValue); }
 
 void yield_cpu() { std::this_thread::sleep_for(std::chrono::milliseconds(kYieldMs)); }
+
+auto get_self_usage() -> SelfUsage
+{
+  SelfUsage usage;
+  struct rusage self_usage
+  {
+  };
+  if (getrusage(RUSAGE_SELF, &self_usage) == 0)
+  {
+    usage.cpu_seconds =
+        static_cast<double>(self_usage.ru_utime.tv_sec + self_usage.ru_stime.tv_sec) +
+        static_cast<double>(self_usage.ru_utime.tv_usec + self_usage.ru_stime.tv_usec) /
+            kUsPerSecond;
+    usage.max_rss_bytes = self_usage.ru_maxrss * kBytesPerKb;
+  }
+  std::ifstream statm("/proc/self/statm");
+  long total_pages = 0;
+  long resident_pages = 0;
+  if (statm >> total_pages >> resident_pages)
+  {
+    usage.rss_bytes = resident_pages * sysconf(_SC_PAGESIZE);
+  }
+  return usage;
+}
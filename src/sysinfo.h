@@ -3,8 +3,42 @@
 
 struct TestResults;
 
+// Network stack and CPU frequency settings that bound what a run can reach; empty strings and
+// zeros mean the value was not readable (containers, VMs, non-Linux kernels)
+struct HostTuning
+{
+  std::string interface;       // carries the default route
+  int link_speed_mbps = 0;     // /sys/class/net/IF/speed; 0 for Wi-Fi, tunnels and virtual links
+  int mtu = 0;
+  std::string tcp_congestion_control;
+  std::string tcp_rmem;        // "min default max" in bytes
+  std::string tcp_wmem;
+  std::string cpu_governor;    // cpu0 scaling_governor
+  long cpu_freq_khz = 0;       // cpu0 scaling_cur_freq when the snapshot was taken
+};
+
+// Everything print_sysinfo and collect_sysinfo report, read once per process
+struct HostSnapshot
+{
+  std::string nodename, arch, kernel, cpu_model;
+  std::string mem_total; // MemTotal value as /proc/meminfo prints it ("  16314504 kB")
+  long mem_total_kb = 0;
+  int cpu_cores = 0;
+  HostTuning tuning;
+};
+
+// Resource usage of this process (getrusage + /proc/self/statm)
+struct SelfUsage
+{
+  double cpu_seconds = 0;  // user + system
+  long rss_bytes = 0;      // current resident set
+  long max_rss_bytes = 0;  // peak resident set
+};
+
 // System info helpers
 // Modernized: trailing return types, descriptive parameter names
+// Collected on first use; later calls return the same snapshot without touching /proc or /sys
+auto host_snapshot() -> const HostSnapshot&;
 auto print_sysinfo(bool mask_sensitive) -> void;
 auto collect_sysinfo(TestResults& results, bool mask_sensitive) -> void;
 auto mask_str(const std::string& input) -> std::string;
@@ -13,3 +47,4 @@ auto set_nice() -> void;
 auto drop_caches() -> void;
 auto get_time_ms() -> double;
 auto yield_cpu() -> void;
+auto get_self_usage() -> SelfUsage;
@@ -0,0 +1,287 @@
+#include "test_plan.h"
+#include <yyjson.h>    // for yyjson_read, yyjson_obj_get, yyjson_arr_foreach, etc.
+#include <cmath>       // for isfinite
+#include <cstdint>     // for uint64_t
+#include <fstream>     // IWYU pragma: keep  // for ifstream
+#include <iterator>    // for istreambuf_iterator, size
+#include <limits>      // for numeric_limits
+#include <string>      // for string, to_string
+#include <utility>     // for move
+#include <vector>      // for vector
+
+// Lighter matrix for quick checks: ~22 MB down, ~4.5 MB up
+constexpr PhaseSpec kQuickPlanPhases[] = {
+    {TransferDirection::download, 101000, 5, 0, 0, 0, "100kB"},
+    {TransferDirection::download, 1001000, 4, 0, 0, 0, "1MB"},
+    {TransferDirection::download, 10001000, 2, 0, 0, 0, "10MB"},
+    {TransferDirection::upload, 101000, 5, 0, 0, 0, "100kB"},
+    {TransferDirection::upload, 1001000, 4, 0, 0, 0, "1MB"},
+};
+
+// Low-RAM / low-CPU routers: strictly sequential, no transfer above 10 MB, time-boxed sizes
+constexpr PhaseSpec kRouterSafePlanPhases[] = {
+    {TransferDirection::download, 101000, 6, 0, 1, 1, "100kB"},
+    {TransferDirection::download, 1001000, 6, 5000, 1, 0, "1MB"},
+    {TransferDirection::download, 10001000, 3, 15000, 1, 0, "10MB"},
+    {TransferDirection::upload, 11000, 6, 0, 1, 1, "11kB"},
+    {TransferDirection::upload, 101000, 6, 5000, 1, 0, "100kB"},
+    {TransferDirection::upload, 1001000, 4, 10000, 1, 0, "1MB"},
+};
+
+struct PresetPlan
+{
+  const char* name;
+  const PhaseSpec* phases;
+  size_t count;
+};
+
+constexpr PresetPlan kPresetPlans[] = {
+    {"full", kDefaultPlanPhases, std::size(kDefaultPlanPhases)},
+    {"quick", kQuickPlanPhases, std::size(kQuickPlanPhases)},
+    {"router-safe", kRouterSafePlanPhases, std::size(kRouterSafePlanPhases)},
+};
+
+static auto to_phase(const PhaseSpec& spec) -> PlanPhase
+{
+  return PlanPhase{spec.direction,   spec.num_bytes, spec.num_iterations, spec.duration_ms,
+                   spec.concurrency, spec.warmup,    spec.label};
+}
+
+auto direction_name(TransferDirection direction) -> const char*
+{
+  return direction == TransferDirection::upload ? "upload" : "download";
+}
+
+auto format_transfer_size(int num_bytes) -> std::string
+{
+  // Cloudflare sizes carry a small overhead (101000 for "100kB"), so round down
+  if (num_bytes >= 1000 * 1000)
+  {
+    return std::to_string(num_bytes / (1000 * 1000)) + "MB";
+  }
+  if (num_bytes >= 1000)
+  {
+    return std::to_string(num_bytes / 1000) + "kB";
+  }
+  return std::to_string(num_bytes) + "B";
+}
+
+auto default_test_plan() -> TestPlan
+{
+  TestPlan plan;
+  make_preset_plan(kDefaultTestPlan, plan);
+  return plan;
+}
+
+auto make_preset_plan(std::string_view name, TestPlan& plan) -> bool
+{
+  for (const auto& preset : kPresetPlans)
+  {
+    if (name == preset.name)
+    {
+      plan.name = preset.name;
+      plan.phases.clear();
+      plan.phases.reserve(preset.count);
+      for (size_t phase_index = 0; phase_index < preset.count; ++phase_index)
+      {
+        plan.phases.push_back(to_phase(preset.phases[phase_index]));
+      }
+      return true;
+    }
+  }
+  return false;
+}
+
+auto preset_plan_names() -> std::vector<std::string>
+{
+  std::vector<std::string> names;
+  for (const auto& preset : kPresetPlans)
+  {
+    names.emplace_back(preset.name);
+  }
+  return names;
+}
+
+// Missing fields keep value. A present field must be an integer that fits in int: a plain cast
+// would wrap 4294967297 to 1, and 1.5 or "10" would silently fall back to the default
+static auto read_int(yyjson_val* obj, const char* key, const std::string& where, int& value,
+                     std::string& error) -> bool
+{
+  yyjson_val* field = yyjson_obj_get(obj, key);
+  if (field == nullptr)
+  {
+    return true;
+  }
+  constexpr int kMin = std::numeric_limits<int>::min();
+  constexpr int kMax = std::numeric_limits<int>::max();
+  const bool fits = yyjson_is_uint(field)
+                        ? yyjson_get_uint(field) <= static_cast<uint64_t>(kMax)
+                        : yyjson_is_sint(field) && yyjson_get_sint(field) >= kMin &&
+                              yyjson_get_sint(field) <= kMax;
+  if (!fits)
+  {
+    error = where + ": \"" + key + "\" must be an integer within " + std::to_string(kMin) + ".." +
+            std::to_string(kMax);
+    return false;
+  }
+  value = yyjson_is_uint(field) ? static_cast<int>(yyjson_get_uint(field))
+                                : static_cast<int>(yyjson_get_sint(field));
+  return true;
+}
+
+static auto read_phase(yyjson_val* obj, size_t phase_index, PlanPhase& phase, std::string& error)
+    -> bool
+{
+  const std::string where = "phase " + std::to_string(phase_index);
+  if (!yyjson_is_obj(obj))
+  {
+    error = where + ": not an object";
+    return false;
+  }
+  yyjson_val* direction = yyjson_obj_get(obj, "direction");
+  const std::string direction_str = yyjson_is_str(direction) ? yyjson_get_str(direction) : "";
+  if (direction_str == "download")
+  {
+    phase.direction = TransferDirection::download;
+  }
+  else if (direction_str == "upload")
+  {
+    phase.direction = TransferDirection::upload;
+  }
+  else
+  {
+    error = where + ": \"direction\" must be \"download\" or \"upload\"";
+    return false;
+  }
+  phase.num_bytes = 0;
+  phase.num_iterations = 0;
+  phase.concurrency = 0;
+  phase.warmup = 0;
+  if (!read_int(obj, "bytes", where, phase.num_bytes, error) ||
+      !read_int(obj, "iterations", where, phase.num_iterations, error) ||
+      !read_int(obj, "concurrency", where, phase.concurrency, error) ||
+      !read_int(obj, "warmup", where, phase.warmup, error))
+  {
+    return false;
+  }
+  yyjson_val* duration = yyjson_obj_get(obj, "duration_ms");
+  if (duration != nullptr && !(yyjson_is_num(duration) && std::isfinite(yyjson_get_num(duration))))
+  {
+    error = where + ": \"duration_ms\" must be a number";
+    return false;
+  }
+  phase.duration_ms = duration != nullptr ? yyjson_get_num(duration) : 0.0;
+  yyjson_val* label = yyjson_obj_get(obj, "label");
+  phase.label = yyjson_is_str(label) ? std::string(yyjson_get_str(label), yyjson_get_len(label))
+                                     : format_transfer_size(phase.num_bytes);
+  if (phase.num_bytes <= 0 || phase.num_bytes > kMaxPlanPhaseBytes)
+  {
+    error = where + ": \"bytes\" must be in 1.." + std::to_string(kMaxPlanPhaseBytes);
+  }
+  else if (phase.num_iterations < 0 || phase.duration_ms < 0)
+  {
+    error = where + ": \"iterations\" and \"duration_ms\" must not be negative";
+  }
+  else if (phase.num_iterations > kMaxPlanIterations)
+  {
+    error = where + ": \"iterations\" must be at most " + std::to_string(kMaxPlanIterations);
+  }
+  else if (phase.num_iterations == 0 && phase.duration_ms <= 0)
+  {
+    error = where + ": needs \"iterations\" or \"duration_ms\"";
+  }
+  else if (phase.concurrency < 0 || phase.concurrency > kMaxPlanConcurrency)
+  {
+    error = where + ": \"concurrency\" must be in 0.." + std::to_string(kMaxPlanConcurrency);
+  }
+  else if (phase.warmup < 0 || phase.warmup > kMaxPlanIterations)
+  {
+    error = where + ": \"warmup\" must be in 0.." + std::to_string(kMaxPlanIterations);
+  }
+  return error.empty();
+}
+
+// Plan file format:
+//   {"name": "nightly", "phases": [{"direction": "download", "bytes": 10001000,
+//     "iterations": 6, "duration_ms": 0, "concurrency": 0, "warmup": 0, "label": "10MB"}, ...]}
+auto load_test_plan_file(const std::string& path, TestPlan& plan, std::string& error) -> bool
+{
+  std::ifstream in(path);
+  if (!in)
+  {
+    error = "cannot open " + path;
+    return false;
+  }
+  const std::string json((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+  yyjson_doc* doc = yyjson_read(json.c_str(), json.size(), 0);
+  if (doc == nullptr)
+  {
+    error = path + ": invalid JSON";
+    return false;
+  }
+  yyjson_val* root = yyjson_doc_get_root(doc);
+  yyjson_val* phases = yyjson_is_obj(root) ? yyjson_obj_get(root, "phases") : nullptr;
+  if (!yyjson_is_arr(phases) || yyjson_arr_size(phases) == 0)
+  {
+    error = path + ": expected an object with a non-empty \"phases\" array";
+    yyjson_doc_free(doc);
+    return false;
+  }
+  TestPlan loaded;
+  yyjson_val* name = yyjson_obj_get(root, "name");
+  loaded.name = yyjson_is_str(name) ? yyjson_get_str(name) : path;
+  loaded.phases.reserve(yyjson_arr_size(phases));
+  size_t phase_index = 0;
+  size_t phase_max = 0;
+  yyjson_val* phase_val = nullptr;
+  yyjson_arr_foreach(phases, phase_index, phase_max, phase_val)
+  {
+    PlanPhase phase;
+    if (!read_phase(phase_val, phase_index, phase, error))
+    {
+      error = path + ": " + error;
+      yyjson_doc_free(doc);
+      return false;
+    }
+    loaded.phases.push_back(std::move(phase));
+  }
+  yyjson_doc_free(doc);
+  plan = std::move(loaded);
+  return true;
+}
+
+auto resolve_test_plan(const std::string& name_or_path, TestPlan& plan, std::string& error)
+    -> bool
+{
+  if (make_preset_plan(name_or_path.empty() ? kDefaultTestPlan : name_or_path, plan))
+  {
+    return true;
+  }
+  if (name_or_path.find('/') == std::string::npos &&
+      name_or_path.find(".json") == std::string::npos)
+  {
+    std::string known;
+    for (const auto& preset_name : preset_plan_names())
+    {
+      known += preset_name + ", ";
+    }
+    error = "unknown test plan '" + name_or_path + "' (presets: " + known +
+            "or a path to a .json plan file)";
+    return false;
+  }
+  return load_test_plan_file(name_or_path, plan, error);
+}
+
+auto planned_transfer_bytes(const TestPlan& plan) -> size_t
+{
+  size_t total = 0;
+  for (const auto& phase : plan.phases)
+  {
+    if (phase.num_iterations == 0)
+    {
+      return 0;
+    }
+    total += static_cast<size_t>(phase.num_bytes) * (phase.num_iterations + phase.warmup);
+  }
+  return total;
+}
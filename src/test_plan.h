@@ -0,0 +1,72 @@
+#pragma once
+#include <stddef.h>     // for size_t
+#include <string>       // for string
+#include <string_view>  // for string_view
+#include <vector>       // for vector
+
+enum class TransferDirection
+{
+  download,
+  upload
+};
+
+// One step of a test plan: a fixed transfer size repeated for a number of iterations and/or a
+// wall-clock budget. With both set, the phase stops at whichever limit is reached first.
+struct PlanPhase
+{
+  TransferDirection direction = TransferDirection::download;
+  int num_bytes = 0;
+  int num_iterations = 0;  // 0 = bounded by duration_ms only
+  double duration_ms = 0;  // 0 = bounded by num_iterations only
+  int concurrency = 0;     // 0 = auto (2 with --parallel, else 1), otherwise fixed
+  int warmup = 0;          // unrecorded transfers before the measured ones
+  std::string label;       // e.g. "10MB"; derived from num_bytes when empty
+};
+
+struct TestPlan
+{
+  std::string name;
+  std::vector<PlanPhase> phases;
+};
+
+// Literal form of a phase for the built-in presets (constexpr tables)
+struct PhaseSpec
+{
+  TransferDirection direction;
+  int num_bytes;
+  int num_iterations;
+  double duration_ms;
+  int concurrency;
+  int warmup;
+  const char* label;
+};
+
+inline constexpr const char* kDefaultTestPlan = "full";
+inline constexpr int kMaxPlanConcurrency = 16;
+inline constexpr int kMaxPlanPhaseBytes = 1000 * 1000 * 1000;
+inline constexpr int kMaxDurationIterations = 1000; // safety cap for duration-only phases
+inline constexpr int kMaxPlanIterations = 100000;   // per phase; sample columns are sized up front
+
+// The historical test matrix; also the "full" preset
+inline constexpr PhaseSpec kDefaultPlanPhases[] = {
+    {TransferDirection::download, 101000, 10, 0, 0, 0, "100kB"},
+    {TransferDirection::download, 1001000, 8, 0, 0, 0, "1MB"},
+    {TransferDirection::download, 10001000, 6, 0, 0, 0, "10MB"},
+    {TransferDirection::download, 25001000, 4, 0, 0, 0, "25MB"},
+    {TransferDirection::download, 100001000, 1, 0, 0, 0, "100MB"},
+    {TransferDirection::upload, 11000, 10, 0, 0, 0, "11kB"},
+    {TransferDirection::upload, 101000, 10, 0, 0, 0, "100kB"},
+    {TransferDirection::upload, 1001000, 8, 0, 0, 0, "1MB"},
+};
+
+// Test plan construction
+auto default_test_plan() -> TestPlan;
+auto make_preset_plan(std::string_view name, TestPlan& plan) -> bool;
+auto preset_plan_names() -> std::vector<std::string>;
+auto load_test_plan_file(const std::string& path, TestPlan& plan, std::string& error) -> bool;
+// Accepts a preset name or a path to a JSON plan file
+auto resolve_test_plan(const std::string& name_or_path, TestPlan& plan, std::string& error)
+    -> bool;
+auto direction_name(TransferDirection direction) -> const char*;
+auto format_transfer_size(int num_bytes) -> std::string;
+auto planned_transfer_bytes(const TestPlan& plan) -> size_t; // 0 when any phase is duration-only
@@ -0,0 +1,266 @@
+#include "trace.h"
+#include <unistd.h>    // for getpid
+#include <atomic>      // for atomic, memory_order
+#include <cstdio>      // for snprintf
+#include <cstring>     // for memcpy, strlen
+#include <fstream>     // for ofstream
+#include <iostream>    // for cerr, clog, endl
+#include <memory>      // for unique_ptr, make_unique
+#include <mutex>       // for mutex, lock_guard
+#include <string>      // for string
+#include <vector>      // for vector
+#include "sysinfo.h"   // for get_time_ms
+#include "utf8.h"      // for utf8_prefix_length
+
+namespace
+{
+constexpr size_t kEventsPerChunk = 64; // about 5 KB; a transfer thread rarely needs more
+constexpr double kUsPerMs = 1000.0;
+
+struct TraceEvent
+{
+  char name[kTraceNameBytes];
+  const char* category;
+  double start_ms;
+  double duration_ms;
+  unsigned connection_id;
+};
+
+// Written by its owning thread only; count is published with release so write_trace sees
+// complete events
+struct TraceChunk
+{
+  TraceEvent events[kEventsPerChunk];
+  std::atomic<size_t> count{0};
+  std::atomic<TraceChunk*> next{nullptr};
+};
+
+struct ThreadTrace
+{
+  unsigned index = 0;
+  TraceChunk first;
+  TraceChunk* tail = &first;
+  std::vector<std::unique_ptr<TraceChunk>> overflow; // owns the chunks after first
+};
+
+struct TraceRegistry
+{
+  std::atomic<bool> enabled{false};
+  std::string path;
+  double origin_ms = 0;
+  std::mutex mutex; // guards threads; taken once per thread and by write_trace
+  std::vector<std::unique_ptr<ThreadTrace>> threads;
+};
+
+// Never destroyed: a transfer thread may still be unwinding when exit handlers run
+auto registry() -> TraceRegistry&
+{
+  static auto* const instance = new TraceRegistry;
+  return *instance;
+}
+
+thread_local ThreadTrace* t_trace = nullptr;
+
+auto thread_trace() -> ThreadTrace&
+{
+  if (t_trace == nullptr)
+  {
+    auto& traces = registry();
+    std::lock_guard<std::mutex> lock(traces.mutex);
+    traces.threads.push_back(std::make_unique<ThreadTrace>());
+    t_trace = traces.threads.back().get();
+    t_trace->index = static_cast<unsigned>(traces.threads.size() - 1);
+  }
+  return *t_trace;
+}
+
+void record_event(const TraceEvent& event)
+{
+  ThreadTrace& trace = thread_trace();
+  TraceChunk* chunk = trace.tail;
+  size_t count = chunk->count.load(std::memory_order_relaxed);
+  if (count == kEventsPerChunk)
+  {
+    trace.overflow.push_back(std::make_unique<TraceChunk>());
+    chunk->next.store(trace.overflow.back().get(), std::memory_order_release);
+    chunk = trace.tail = trace.overflow.back().get();
+    count = 0;
+  }
+  chunk->events[count] = event;
+  chunk->count.store(count + 1, std::memory_order_release);
+}
+
+// Writes source at offset, cut on a UTF-8 boundary to fit, and terminates; returns the new length
+auto append_name(char (&target)[kTraceNameBytes], size_t offset, const char* source,
+                 size_t length) -> size_t
+{
+  length = utf8_prefix_length(source, length, kTraceNameBytes - 1 - offset);
+  std::memcpy(target + offset, source, length);
+  target[offset + length] = '\0';
+  return offset + length;
+}
+
+void copy_name(char (&target)[kTraceNameBytes], const char* source, size_t length)
+{
+  (void)append_name(target, 0, source, length);
+}
+
+void write_json_string(std::ostream& out, const char* text)
+{
+  out << '"';
+  for (const char* cursor = text; *cursor != '\0'; ++cursor)
+  {
+    const auto byte = static_cast<unsigned char>(*cursor);
+    if (byte == '"' || byte == '\\')
+    {
+      out << '\\' << *cursor;
+    }
+    else if (byte < 0x20)
+    {
+      char escaped[8];
+      (void)std::snprintf(escaped, sizeof(escaped), "\\u%04x", byte);
+      out << escaped;
+    }
+    else
+    {
+      out << *cursor;
+    }
+  }
+  out << '"';
+}
+} // namespace
+
+auto enable_tracing(const std::string& path) -> void
+{
+  auto& traces = registry();
+  traces.path = path;
+  traces.origin_ms = get_time_ms();
+  (void)thread_trace(); // the enabling thread is tid 0, named "main"
+  traces.enabled.store(true, std::memory_order_release);
+}
+
+auto tracing_enabled() -> bool
+{
+  return registry().enabled.load(std::memory_order_relaxed);
+}
+
+auto record_trace_span(const char* category, const std::string& name, double start_ms,
+                       double duration_ms) -> void
+{
+  if (!tracing_enabled())
+  {
+    return;
+  }
+  TraceEvent event{};
+  copy_name(event.name, name.c_str(), name.size());
+  event.category = category;
+  event.start_ms = start_ms;
+  event.duration_ms = duration_ms;
+  record_event(event);
+}
+
+// {"traceEvents":[...]} with process/thread name metadata first, then every span in thread order
+auto write_trace() -> void
+{
+  auto& traces = registry();
+  if (!traces.enabled.exchange(false))
+  {
+    return;
+  }
+  std::ofstream out(traces.path, std::ios::trunc);
+  const int pid = static_cast<int>(getpid());
+  out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+  out << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" << pid
+      << ",\"tid\":0,\"args\":{\"name\":\"SpeedCloudflareCli\"}}";
+  size_t event_count = 0;
+  std::lock_guard<std::mutex> lock(traces.mutex);
+  for (const auto& trace : traces.threads)
+  {
+    out << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" << pid << ",\"tid\":" << trace->index
+        << ",\"args\":{\"name\":\""
+        << (trace->index == 0 ? std::string("main") : "worker " + std::to_string(trace->index))
+        << "\"}}";
+  }
+  out.setf(std::ios::fixed);
+  out.precision(1);
+  for (const auto& trace : traces.threads)
+  {
+    for (const TraceChunk* chunk = &trace->first; chunk != nullptr;
+         chunk = chunk->next.load(std::memory_order_acquire))
+    {
+      const size_t count = chunk->count.load(std::memory_order_acquire);
+      for (size_t index = 0; index < count; ++index)
+      {
+        const TraceEvent& event = chunk->events[index];
+        out << ",\n{\"name\":";
+        write_json_string(out, event.name);
+        out << ",\"cat\":\"" << event.category << "\",\"ph\":\"X\",\"pid\":" << pid
+            << ",\"tid\":" << trace->index
+            << ",\"ts\":" << (event.start_ms - traces.origin_ms) * kUsPerMs
+            << ",\"dur\":" << event.duration_ms * kUsPerMs;
+        if (event.connection_id != 0)
+        {
+          out << ",\"args\":{\"connection\":" << event.connection_id << "}";
+        }
+        out << "}";
+        ++event_count;
+      }
+    }
+  }
+  out << "\n]}\n";
+  out.close();
+  if (!out)
+  {
+    std::cerr << "[ERROR] Could not write trace " << traces.path << std::endl;
+    return;
+  }
+  std::clog << "[TRACE] " << event_count << " events from " << traces.threads.size()
+            << " threads written to " << traces.path << std::endl;
+}
+
+TraceScope::TraceScope(const char* category, const char* name)
+    : category_(category), active_(tracing_enabled())
+{
+  if (active_)
+  {
+    copy_name(name_, name, std::strlen(name));
+    start_ms_ = get_time_ms();
+  }
+}
+
+TraceScope::TraceScope(const char* category, const std::string& name)
+    : category_(category), active_(tracing_enabled())
+{
+  if (active_)
+  {
+    copy_name(name_, name.c_str(), name.size());
+    start_ms_ = get_time_ms();
+  }
+}
+
+TraceScope::TraceScope(const char* category, const char* prefix, const std::string& detail)
+    : category_(category), active_(tracing_enabled())
+{
+  if (active_)
+  {
+    size_t length = append_name(name_, 0, prefix, std::strlen(prefix));
+    length = append_name(name_, length, " ", 1);
+    (void)append_name(name_, length, detail.c_str(), detail.size());
+    start_ms_ = get_time_ms();
+  }
+}
+
+TraceScope::~TraceScope()
+{
+  if (!active_ || !tracing_enabled())
+  {
+    return;
+  }
+  TraceEvent event{};
+  std::memcpy(event.name, name_, sizeof(name_));
+  event.category = category_;
+  event.start_ms = start_ms_;
+  event.duration_ms = get_time_ms() - start_ms_;
+  event.connection_id = connection_id_;
+  record_event(event);
+}
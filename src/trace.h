@@ -0,0 +1,42 @@
+#pragma once
+#include <stddef.h>  // for size_t
+#include <string>    // for string
+
+// Timeline tracing (--trace): test phases and the steps of every HTTP request (resolve, connect,
+// handshake, write, first byte, body) as Chrome trace-event JSON, viewable in Perfetto or
+// chrome://tracing. Each thread appends complete ("X") events to its own chunked buffer without
+// locking; the buffers are only read by write_trace, after the transfer threads are gone.
+// While tracing is off a TraceScope costs one relaxed atomic load.
+auto enable_tracing(const std::string& path) -> void;
+auto tracing_enabled() -> bool;
+// Writes every recorded event to the path given to enable_tracing (registered with atexit)
+auto write_trace() -> void;
+// A span whose times were already taken with get_time_ms (test phases)
+auto record_trace_span(const char* category, const std::string& name, double start_ms,
+                       double duration_ms) -> void;
+
+inline constexpr size_t kTraceNameBytes = 48; // longer names are truncated
+
+// One span from construction to destruction on the calling thread
+class TraceScope
+{
+public:
+  TraceScope(const char* category, const char* name);
+  TraceScope(const char* category, const std::string& name);
+  // Named prefix + " " + detail, e.g. ("GET", path); joined only while tracing, so per-request
+  // spans allocate nothing when it is off
+  TraceScope(const char* category, const char* prefix, const std::string& detail);
+  ~TraceScope();
+  TraceScope(const TraceScope&) = delete;
+  auto operator=(const TraceScope&) -> TraceScope& = delete;
+
+  // Shown as args.connection; for spans that end on a known connection
+  void set_connection(unsigned connection_id) { connection_id_ = connection_id; }
+
+private:
+  const char* category_;
+  double start_ms_ = 0;
+  unsigned connection_id_ = 0;
+  bool active_;
+  char name_[kTraceNameBytes];
+};
@@ -1,10 +1,25 @@
 #pragma once
 #include <string>
 #include <vector>
+#include "estimation.h"
+#include "histogram.h"
+#include "host_monitor.h"
+#include "instrumentation.h"
+#include "interface_counters.h"
+#include "sample_store.h"
+#include "sysinfo.h"
+#include "test_plan.h"
 
 inline constexpr const char* BUILD_VERSION = __DATE__ " " __TIME__;
 inline constexpr const char* SUMMARY_JSON_FILENAME = "summary.json";
 
+// One executed test plan phase; its samples are TestResults::samples.phase_samples(index)
+struct PhaseResult
+{
+  PlanPhase phase;
+  double elapsed_ms = 0;
+};
+
 // Struct to hold all results for JSON output
 struct TestResults
 {
@@ -12,14 +27,42 @@ struct TestResults
   std::string sysinfo_date;
   std::string version; // Build version string
   int cpu_cores = 0;
-  std::vector<double> latency, download_100kB, download_1MB, download_10MB, download_25MB,
-      download_100MB;
-  std::vector<double> upload_11kB, upload_100kB, upload_1MB;
-  std::vector<double> all_downloads, all_uploads;
+  HostTuning host_tuning;
+  std::vector<double> latency;
+  // Executed test plan and every transfer sample; per-size and per-direction JSON arrays
+  // (download_100kB, all_downloads, ...) are views into the sample store
+  std::string test_plan;
+  std::vector<PhaseResult> phases;
+  SampleStore samples;
   double total_time_ms = 0;
+  // Per-phase wall-clock timings and failed transfers
+  double bootstrap_ms = 0, latency_ms = 0, download_ms = 0, upload_ms = 0;
+  int download_failures = 0, upload_failures = 0;
+  // The tool's own cost per phase (CPU, RSS, allocations, context switches, hardware counters)
+  std::vector<PhaseOverhead> overhead;
+  // Host-wide CPU, load and pressure per phase (empty without /proc/stat)
+  std::vector<PhaseContention> contention;
+  // Interface byte counters against the tool's own bytes, per transfer phase
+  std::vector<PhaseTraffic> traffic;
+  // Mergeable sample distributions (latency in ms, throughput in Mbps)
+  LogHistogram latency_histogram, download_histogram, upload_histogram;
+  // Robust estimates with bootstrap confidence intervals over the filtered samples
+  std::string sample_filter;
+  SampleEstimate download_estimate, upload_estimate;
   std::vector<std::string> flags;
 };
 
+// Headline figures derived from TestResults (shared by JSON and metrics output)
+struct ResultMetrics
+{
+  double latency_avg = 0;
+  double jitter = 0;
+  double download_50pct = 0;
+  double download_90pct = 0;
+  double upload_50pct = 0;
+  double upload_90pct = 0;
+};
+
 struct SummaryResult
 {
   std::string file;
@@ -29,4 +72,8 @@ struct SummaryResult
   double jitter;
   double download;
   double upload;
+  // Bootstrap confidence interval of download/upload p90 (zero for older files)
+  ConfidenceInterval download_ci, upload_ci;
+  // Sparse histogram buckets from the result file (empty for older files)
+  LogHistogram::SparseBuckets latency_histogram, download_histogram, upload_histogram;
 };
@@ -0,0 +1,26 @@
+#include "utf8.h"
+
+namespace
+{
+constexpr unsigned kContinuationMask = 0xC0;
+constexpr unsigned kContinuationPattern = 0x80;
+constexpr size_t kMaxContinuationBytes = 3; // a 4-byte sequence; longer runs are not UTF-8
+} // namespace
+
+auto utf8_prefix_length(const char* text, size_t length, size_t max_bytes) -> size_t
+{
+  if (length <= max_bytes)
+  {
+    return length;
+  }
+  // text[max_bytes] is the first byte left out; while it continues a sequence, so does the cut
+  size_t cut = max_bytes;
+  for (size_t step = 0; step < kMaxContinuationBytes && cut > 0 &&
+                        (static_cast<unsigned char>(text[cut]) & kContinuationMask) ==
+                            kContinuationPattern;
+       ++step)
+  {
+    --cut;
+  }
+  return cut;
+}
@@ -0,0 +1,8 @@
+#pragma once
+#include <stddef.h>  // for size_t
+
+// Byte-limited text fields (trace span names, event labels, history records) are cut with this,
+// so a multi-byte character is dropped whole instead of leaving a broken sequence behind.
+// Returns the longest prefix of text[0, length) of at most max_bytes that does not end inside a
+// UTF-8 sequence; a cut that would split one moves back to the sequence's lead byte.
+auto utf8_prefix_length(const char* text, size_t length, size_t max_bytes) -> size_t;
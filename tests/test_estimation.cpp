@@ -0,0 +1,31 @@
+// Checks the rank test and multiple-comparison correction behind --matrix verdicts.
+#include <cmath>          // for fabs
+#include <string>         // for string
+#include <vector>         // for vector
+#include "estimation.h"   // for holm_adjust, mann_whitney_test
+#include "tests.h"        // for check, test_estimation
+
+namespace
+{
+auto near(double value, double expected) -> bool
+{
+  return std::fabs(value - expected) < 1e-9;
+}
+} // namespace
+
+auto test_estimation() -> void
+{
+  // Sorted 0.01 < 0.02 < 0.03 < 0.04 are scaled by 4, 3, 2, 1, then made monotone
+  const std::vector<double> adjusted = holm_adjust({0.04, 0.01, 0.03, 0.02});
+  check(adjusted.size() == 4, "holm_adjust keeps every p-value");
+  check(near(adjusted[1], 0.04) && near(adjusted[3], 0.06) && near(adjusted[2], 0.06) &&
+            near(adjusted[0], 0.06),
+        "holm_adjust scales by the remaining count and keeps the order");
+  check(near(holm_adjust({0.5, 0.9})[0], 1.0), "adjusted p-values are capped at 1");
+  check(holm_adjust({}).empty(), "an empty family stays empty");
+
+  const RankTest separated = mann_whitney_test({10, 11, 12, 13, 14, 15}, {1, 2, 3, 4, 5, 6});
+  check(separated.z > 0 && separated.p_value < 0.05, "fully separated samples are significant");
+  const RankTest empty = mann_whitney_test({}, {1, 2, 3});
+  check(near(empty.p_value, 1.0), "an empty sample is never significant");
+}
@@ -0,0 +1,110 @@
+// Checks LogHistogram: batched and single records agree bucket for bucket, dense and sparse merges
+// agree, quantiles stay within the documented 1%, and out-of-range inputs are handled.
+#include <algorithm>      // for sort
+#include <cmath>          // for ceil, fabs, pow
+#include <limits>         // for numeric_limits
+#include <random>         // for mt19937, lognormal_distribution, uniform_real_distribution
+#include <string>         // for string, to_string
+#include <vector>         // for vector
+#include "histogram.h"    // for LogHistogram
+#include "tests.h"        // for check, test_histogram
+
+namespace
+{
+constexpr size_t kSampleCount = 20000;
+constexpr double kMaxRelativeError = 0.01; // the header's documented bound
+constexpr double kHighest = 1e6;           // top of the covered range
+
+auto same_buckets(const LogHistogram& lhs, const LogHistogram& rhs) -> bool
+{
+  return lhs.total() == rhs.total() && lhs.sparse() == rhs.sparse();
+}
+
+// Exact nearest-rank quantile, the definition LogHistogram::quantile approximates
+auto exact_quantile(std::vector<double> values, double quantile) -> double
+{
+  std::sort(values.begin(), values.end());
+  auto rank = static_cast<size_t>(std::ceil(quantile * static_cast<double>(values.size())));
+  rank = rank == 0 ? 1 : rank;
+  return values[rank - 1];
+}
+
+auto test_values() -> std::vector<double>
+{
+  std::mt19937 rng(7);
+  std::lognormal_distribution<double> throughput(4.0, 1.5);
+  std::uniform_real_distribution<double> exponent(-3.0, 6.0);
+  std::vector<double> values;
+  values.reserve(kSampleCount);
+  for (size_t index = 0; index < kSampleCount / 2; ++index)
+  {
+    values.push_back(throughput(rng));
+    values.push_back(std::pow(10.0, exponent(rng))); // the whole covered range
+  }
+  // Bucket boundaries, where a rounding difference between the two paths would show
+  for (size_t index = 1; index < LogHistogram::kBuckets; index += 7)
+  {
+    values.push_back(LogHistogram::kLowest *
+                     std::pow(LogHistogram::kGrowth, static_cast<double>(index)));
+  }
+  return values;
+}
+} // namespace
+
+auto test_histogram() -> void
+{
+  const std::vector<double> values = test_values();
+
+  LogHistogram batched;
+  batched.record_all(values);
+  LogHistogram single;
+  for (const double value : values)
+  {
+    single.record(value);
+  }
+  check(same_buckets(batched, single), "record_all and record fill the same buckets");
+  size_t mismatches = 0;
+  for (const double value : values)
+  {
+    LogHistogram one;
+    one.record_all({value});
+    const auto buckets = one.sparse();
+    mismatches += buckets.size() != 1 || buckets[0].first != LogHistogram::bucket_index(value);
+  }
+  check(mismatches == 0, std::to_string(mismatches) + " values land in another bucket batched");
+
+  // Dense and sparse merges of the same two halves
+  LogHistogram first_half;
+  LogHistogram second_half;
+  first_half.record_all(std::vector<double>(values.begin(), values.begin() + values.size() / 2));
+  second_half.record_all(std::vector<double>(values.begin() + values.size() / 2, values.end()));
+  LogHistogram dense = first_half;
+  dense.merge(second_half);
+  LogHistogram sparse = first_half;
+  sparse.merge(second_half.sparse());
+  check(same_buckets(dense, sparse), "dense and sparse merge agree");
+  check(same_buckets(dense, batched), "merged halves equal the whole");
+
+  for (const double quantile : {0.01, 0.1, 0.5, 0.9, 0.99, 1.0})
+  {
+    const double exact = exact_quantile(values, quantile);
+    const double reported = batched.quantile(quantile);
+    check(std::fabs(reported - exact) / exact < kMaxRelativeError,
+          "q=" + std::to_string(quantile) + ": " + std::to_string(reported) + " vs exact " +
+              std::to_string(exact));
+  }
+
+  // 0 and negatives go to bucket 0, above the range to the last bucket, NaN and inf are dropped
+  LogHistogram edges;
+  edges.record_all({0.0, -5.0, std::numeric_limits<double>::quiet_NaN(),
+                    std::numeric_limits<double>::infinity(), 10 * kHighest});
+  edges.record(-std::numeric_limits<double>::infinity());
+  edges.record(std::numeric_limits<double>::quiet_NaN());
+  edges.record(0.0);
+  const LogHistogram::SparseBuckets expected = {{0, 3}, {LogHistogram::kBuckets - 1, 1}};
+  check(edges.total() == 4 && edges.sparse() == expected,
+        "0, negative and >1e6 are bucketed, NaN and infinities are dropped");
+  check(LogHistogram::bucket_index(10 * kHighest) == LogHistogram::kBuckets - 1,
+        "values above the range clamp to the last bucket");
+  check(LogHistogram().quantile(0.5) == 0.0, "an empty histogram reports 0");
+}
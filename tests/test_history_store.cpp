@@ -0,0 +1,78 @@
+// Checks that an append repairs a torn tail but refuses to truncate over a corrupt block header.
+#include <stdio.h>           // for remove
+#include <unistd.h>          // for getpid
+#include <fstream>           // for fstream, ofstream
+#include <string>            // for string, to_string
+#include <vector>            // for vector
+#include "history_store.h"   // for append_history_record, read_history_records, HistoryRecord
+#include "tests.h"           // for check, test_history_store
+
+namespace
+{
+constexpr int kRecordCount = 130; // three blocks of at most 64 records
+constexpr std::streamoff kFirstBlockOffset = 16; // after the file header
+
+auto append_records(const std::string& path, int count) -> bool
+{
+  for (int index = 0; index < count; ++index)
+  {
+    HistoryRecord record;
+    record.wall_ms = 1760000000000 + index * 1000;
+    record.colo = "ZRH";
+    std::string error;
+    if (!append_history_record(path, record, error))
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+auto record_count(const std::string& path) -> size_t
+{
+  std::vector<HistoryRecord> records;
+  std::string error;
+  (void)read_history_records(path, HistoryRange{}, records, error);
+  return records.size();
+}
+
+auto file_size(const std::string& path) -> std::streamoff
+{
+  std::ifstream in(path, std::ios::binary | std::ios::ate);
+  return in.tellg();
+}
+} // namespace
+
+auto test_history_store() -> void
+{
+  const std::string path = "/tmp/speedcloudflare-history-" + std::to_string(getpid()) + ".bin";
+  (void)remove(path.c_str());
+  check(append_records(path, kRecordCount), "records append");
+  check(record_count(path) == kRecordCount, "all records read back");
+
+  // An interrupted append leaves a few bytes past the last block; the next append drops them
+  {
+    std::ofstream tail(path, std::ios::binary | std::ios::app);
+    tail << "torn";
+  }
+  check(append_records(path, 1), "append after a torn tail succeeds");
+  check(record_count(path) == kRecordCount + 1, "the torn tail is dropped, no record lost");
+
+  // A flipped bit in the first block's header, with later blocks behind it
+  const std::streamoff size_before = file_size(path);
+  {
+    std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+    file.seekg(kFirstBlockOffset);
+    const char magic = static_cast<char>(file.get());
+    file.seekp(kFirstBlockOffset);
+    file.put(static_cast<char>(magic ^ 0x01));
+  }
+  HistoryRecord record;
+  std::string error;
+  check(!append_history_record(path, record, error), "append refuses a corrupt header");
+  check(error.find("corrupt block header") != std::string::npos,
+        "the corruption is reported: " + error);
+  check(file_size(path) == size_before, "the blocks after the corrupt header are kept");
+  (void)remove(path.c_str());
+  (void)remove((path + ".lock").c_str());
+}
@@ -0,0 +1,313 @@
+// Checks the metrics export against the Prometheus text exposition format 0.0.4, which is what
+// the node_exporter textfile collector and a /metrics scrape parse.
+#include <cstdlib>        // for strtod
+#include <map>            // for map
+#include <set>            // for set
+#include <sstream>        // for istringstream
+#include <string>         // for string, operator+
+#include <vector>         // for vector
+#include "metrics.h"      // for record_run_metrics, render_prometheus_text
+#include "sample_store.h" // for SampleRecord
+#include "tests.h"        // for check, test_metrics
+#include "types.h"        // for TestResults
+
+namespace
+{
+auto is_name_char(char c, bool first, bool allow_colon) -> bool
+{
+  const bool letter = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+  const bool digit = c >= '0' && c <= '9';
+  return letter || (allow_colon && c == ':') || (!first && digit);
+}
+
+auto is_valid_name(const std::string& name, bool allow_colon) -> bool
+{
+  if (name.empty())
+  {
+    return false;
+  }
+  for (size_t index = 0; index < name.size(); ++index)
+  {
+    if (!is_name_char(name[index], index == 0, allow_colon))
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+auto is_valid_value(const std::string& text) -> bool
+{
+  if (text == "NaN" || text == "+Inf" || text == "-Inf")
+  {
+    return true;
+  }
+  char* end = nullptr;
+  (void)std::strtod(text.c_str(), &end);
+  return !text.empty() && end == text.c_str() + text.size();
+}
+
+struct Family
+{
+  std::string type;
+  bool has_help = false;
+  bool has_samples = false;
+  bool closed = false; // another family's samples followed; this one may not resume
+};
+
+// Parses text by the 0.0.4 rules and returns one message per violation: HELP/TYPE at most once
+// per name and before its samples, known types only, sample names that equal their TYPE name
+// (summary/histogram suffixes aside), grouped families, valid names, escapes and values, and
+// quantile/le only where the type defines them
+auto prometheus_text_errors(const std::string& text) -> std::vector<std::string>
+{
+  static const std::set<std::string> kTypes = {"counter", "gauge", "histogram", "summary",
+                                               "untyped"};
+  std::vector<std::string> errors;
+  std::map<std::string, Family> families;
+  std::set<std::string> series;
+  std::string current_family;
+  std::istringstream lines(text);
+  std::string line;
+  int line_number = 0;
+  while (std::getline(lines, line))
+  {
+    ++line_number;
+    const std::string where = "line " + std::to_string(line_number) + ": ";
+    if (line.empty())
+    {
+      continue;
+    }
+    if (line[0] == '#')
+    {
+      std::istringstream words(line.substr(1));
+      std::string keyword;
+      std::string name;
+      std::string rest;
+      words >> keyword >> name;
+      std::getline(words >> std::ws, rest);
+      if (keyword != "HELP" && keyword != "TYPE")
+      {
+        continue;
+      }
+      if (!is_valid_name(name, true))
+      {
+        errors.push_back(where + "invalid metric name '" + name + "'");
+        continue;
+      }
+      Family& family = families[name];
+      if (keyword == "HELP")
+      {
+        if (family.has_help)
+        {
+          errors.push_back(where + "second HELP for " + name);
+        }
+        family.has_help = true;
+      }
+      else
+      {
+        if (!family.type.empty() || family.has_samples)
+        {
+          errors.push_back(where + "TYPE for " + name + " repeated or after its samples");
+        }
+        if (kTypes.count(rest) == 0)
+        {
+          errors.push_back(where + "unknown type '" + rest + "'");
+        }
+        family.type = rest;
+      }
+      continue;
+    }
+
+    size_t cursor = 0;
+    while (cursor < line.size() && line[cursor] != '{' && line[cursor] != ' ')
+    {
+      ++cursor;
+    }
+    const std::string name = line.substr(0, cursor);
+    if (!is_valid_name(name, true))
+    {
+      errors.push_back(where + "invalid metric name '" + name + "'");
+      continue;
+    }
+    std::string labels;
+    std::set<std::string> label_names;
+    if (cursor < line.size() && line[cursor] == '{')
+    {
+      ++cursor;
+      while (cursor < line.size() && line[cursor] != '}')
+      {
+        const size_t equals = line.find('=', cursor);
+        if (equals == std::string::npos || equals + 1 >= line.size() || line[equals + 1] != '"')
+        {
+          errors.push_back(where + "malformed label");
+          break;
+        }
+        const std::string label = line.substr(cursor, equals - cursor);
+        if (!is_valid_name(label, false) || label.compare(0, 2, "__") == 0 ||
+            !label_names.insert(label).second)
+        {
+          errors.push_back(where + "invalid or repeated label name '" + label + "'");
+        }
+        cursor = equals + 2;
+        std::string value;
+        while (cursor < line.size() && line[cursor] != '"')
+        {
+          if (line[cursor] == '\\')
+          {
+            const char escaped = cursor + 1 < line.size() ? line[cursor + 1] : '\0';
+            if (escaped != '\\' && escaped != '"' && escaped != 'n')
+            {
+              errors.push_back(where + "invalid escape in label value");
+            }
+            value += escaped;
+            cursor += 2;
+            continue;
+          }
+          value += line[cursor++];
+        }
+        ++cursor; // closing quote
+        labels += label + "=" + value + ",";
+        if (cursor < line.size() && line[cursor] == ',')
+        {
+          ++cursor;
+        }
+      }
+      ++cursor; // closing brace
+    }
+    std::istringstream fields(cursor < line.size() ? line.substr(cursor) : std::string());
+    std::string value;
+    std::string timestamp;
+    std::string extra;
+    fields >> value >> timestamp >> extra;
+    if (!is_valid_value(value) || !extra.empty())
+    {
+      errors.push_back(where + "invalid sample value in '" + line + "'");
+    }
+
+    // Which family the sample belongs to: its own name, or a summary/histogram it extends
+    std::string family_name = name;
+    for (const char* suffix : {"_sum", "_count", "_bucket"})
+    {
+      const std::string tail = suffix;
+      if (name.size() > tail.size() &&
+          name.compare(name.size() - tail.size(), tail.size(), tail) == 0)
+      {
+        const auto base = families.find(name.substr(0, name.size() - tail.size()));
+        const bool extends = base != families.end() &&
+                             (base->second.type == "histogram" ||
+                              (base->second.type == "summary" && tail != "_bucket"));
+        if (extends)
+        {
+          family_name = base->first;
+        }
+      }
+    }
+    Family& family = families[family_name];
+    if (family.type.empty())
+    {
+      errors.push_back(where + name + " has no TYPE line naming it");
+    }
+    if (family.closed)
+    {
+      errors.push_back(where + family_name + " samples are not grouped together");
+    }
+    if (current_family != family_name && families.count(current_family) != 0)
+    {
+      families[current_family].closed = true;
+    }
+    current_family = family_name;
+    family.has_samples = true;
+    if (label_names.count("quantile") != 0 && family.type != "summary")
+    {
+      errors.push_back(where + "quantile label on a " + family.type);
+    }
+    if (label_names.count("le") != 0 && family.type != "histogram")
+    {
+      errors.push_back(where + "le label on a " + family.type);
+    }
+    if (!series.insert(name + "{" + labels + "}").second)
+    {
+      errors.push_back(where + "duplicate series " + name);
+    }
+  }
+  return errors;
+}
+
+auto check_valid(const std::string& text, const std::string& what) -> void
+{
+  for (const std::string& error : prometheus_text_errors(text))
+  {
+    check(false, what + ": " + error);
+  }
+}
+
+auto sample_line(const std::string& text, const std::string& prefix) -> bool
+{
+  return text.compare(0, prefix.size(), prefix) == 0 ||
+         text.find("\n" + prefix) != std::string::npos;
+}
+
+auto synthetic_results() -> TestResults
+{
+  TestResults results;
+  results.city = "Zürich \"Kloten\"";
+  results.colo = "ZRH\\1";
+  results.latency = {9.0, 31.0, 12.5, 11.0, 2.5};
+  results.bootstrap_ms = 120;
+  results.latency_ms = 900;
+  results.download_ms = 8000;
+  results.upload_ms = 6000;
+  results.total_time_ms = 15020;
+  results.download_failures = 2;
+  for (const TransferDirection direction :
+       {TransferDirection::download, TransferDirection::upload})
+  {
+    std::vector<SampleRecord> records(10);
+    for (size_t index = 0; index < records.size(); ++index)
+    {
+      records[index].mbps = 100.0 + static_cast<double>(index);
+      records[index].bytes = 1000000;
+      records[index].direction = direction;
+    }
+    results.samples.add_phase(direction, records, SampleFilter::none);
+  }
+  return results;
+}
+} // namespace
+
+auto test_metrics() -> void
+{
+  // The checker must reject what the old exporter wrote, or passing it proves nothing
+  check(!prometheus_text_errors("# TYPE speedcloudflare_server info\n"
+                                "speedcloudflare_server_info{colo=\"FRA\"} 1\n")
+             .empty(),
+        "checker rejects the info type");
+  check(!prometheus_text_errors("# TYPE speedcloudflare_runs counter\n"
+                                "speedcloudflare_runs_total 1\n")
+             .empty(),
+        "checker rejects a counter TYPE without _total when the sample has it");
+  check(!prometheus_text_errors("# TYPE speedcloudflare_download_mbps gauge\n"
+                                "speedcloudflare_download_mbps{quantile=\"0.9\"} 1\n")
+             .empty(),
+        "checker rejects quantile on a gauge");
+
+  const std::string before_run = render_prometheus_text();
+  check_valid(before_run, "before any run");
+  check(sample_line(before_run, "speedcloudflare_runs_total 0"), "runs_total starts at 0");
+
+  record_run_metrics(synthetic_results());
+  record_run_failure();
+  const std::string after_run = render_prometheus_text();
+  check_valid(after_run, "after a run");
+  check(sample_line(after_run, "speedcloudflare_server_info{colo=\"ZRH\\\\1\","
+                               "city=\"Zürich \\\"Kloten\\\"\"} 1"),
+        "server_info is an escaped gauge sample with value 1");
+  check(sample_line(after_run, "speedcloudflare_download_mbps{percentile=\"p90\"} "),
+        "download p90 uses the percentile label");
+  check(sample_line(after_run, "speedcloudflare_runs_total 1"), "runs_total counts the run");
+  check(sample_line(after_run, "speedcloudflare_run_failures_total 1"),
+        "run_failures_total counts the failure");
+  check(sample_line(after_run, "speedcloudflare_request_failures_total{direction=\"download\"} 2"),
+        "request failures are counted per direction");
+}
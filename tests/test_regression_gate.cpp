@@ -0,0 +1,83 @@
+// Checks the --baseline/--check verdicts, in particular runs whose transfers all failed.
+#include <limits>             // for numeric_limits
+#include <string>             // for string
+#include <vector>             // for vector
+#include "regression_gate.h"  // for evaluate_gate, GateVerdict, GateTolerances
+#include "tests.h"            // for check, test_regression_gate
+#include "types.h"            // for SummaryResult
+
+namespace
+{
+auto summary(double download, double upload, double latency, double jitter) -> SummaryResult
+{
+  SummaryResult result{};
+  result.server_city = "Frankfurt";
+  result.download = download;
+  result.upload = upload;
+  result.latency = latency;
+  result.jitter = jitter;
+  return result;
+}
+
+auto baseline_runs() -> std::vector<SummaryResult>
+{
+  std::vector<SummaryResult> baseline;
+  for (int run = 0; run < 10; ++run)
+  {
+    const double spread = static_cast<double>(run % 3);
+    baseline.push_back(summary(400 + spread, 90 + spread, 12 + spread, 2 + spread / 10));
+  }
+  return baseline;
+}
+
+auto find_metric(const GateVerdict& verdict, const std::string& name) -> const GateMetric*
+{
+  for (const GateMetric& metric : verdict.metrics)
+  {
+    if (name == metric.name)
+    {
+      return &metric;
+    }
+  }
+  return nullptr;
+}
+} // namespace
+
+auto test_regression_gate() -> void
+{
+  const GateTolerances tolerances;
+  const std::vector<SummaryResult> baseline = baseline_runs();
+
+  const GateVerdict usual = evaluate_gate(summary(398, 89, 13, 2.1), baseline, tolerances);
+  check(!usual.regression, "a run within the baseline spread passes");
+  check(usual.scope == "server", "ten same-city runs give a per-server baseline");
+
+  const GateVerdict slow = evaluate_gate(summary(200, 89, 13, 2.1), baseline, tolerances);
+  const GateMetric* slow_download = find_metric(slow, "download");
+  check(slow.regression && slow_download != nullptr && slow_download->regressed &&
+            !slow_download->failed,
+        "half the usual download is a regression");
+
+  // Every transfer failed: p90 of nothing is 0, latency still measured
+  const GateVerdict all_failed = evaluate_gate(summary(0, 0, 13, 2.1), baseline, tolerances);
+  const GateMetric* failed_download = find_metric(all_failed, "download");
+  const GateMetric* failed_upload = find_metric(all_failed, "upload");
+  check(all_failed.regression, "an all-failed run is a regression");
+  check(failed_download != nullptr && failed_download->failed && failed_download->regressed &&
+            !failed_download->skipped,
+        "download p90 of 0 is failed, not skipped");
+  check(failed_upload != nullptr && failed_upload->failed, "upload p90 of 0 is failed");
+
+  const double nan = std::numeric_limits<double>::quiet_NaN();
+  const GateVerdict not_a_number = evaluate_gate(summary(398, 89, nan, 2.1), baseline, tolerances);
+  const GateMetric* nan_latency = find_metric(not_a_number, "latency");
+  check(not_a_number.regression && nan_latency != nullptr && nan_latency->failed,
+        "a NaN latency is failed");
+
+  // Without baseline values there is nothing to judge against
+  std::vector<SummaryResult> empty_baseline(6, summary(0, 0, 0, 0));
+  const GateVerdict unjudged = evaluate_gate(summary(0, 0, 13, 2.1), empty_baseline, tolerances);
+  const GateMetric* unjudged_download = find_metric(unjudged, "download");
+  check(!unjudged.regression && unjudged_download != nullptr && unjudged_download->skipped,
+        "a metric without baseline values is skipped");
+}
@@ -0,0 +1,129 @@
+// Checks StreamingStats against two-pass references: P-square quantiles against exact
+// nth_element ranks, and Welford mean/stddev, jitter, min and max against direct formulas.
+#include <algorithm>   // for nth_element, min_element, max_element, count_if
+#include <cmath>       // for fabs, sqrt
+#include <random>      // for mt19937, lognormal_distribution
+#include <string>      // for string, to_string
+#include <utility>     // for make_pair
+#include <vector>      // for vector
+#include "stats.h"     // for StreamingStats, P2Quantile, quartile
+#include "tests.h"     // for check, test_stats
+
+namespace
+{
+constexpr size_t kSampleCount = 10000;
+// P-square's estimate may sit off the exact quantile by this fraction of the sample ranks
+constexpr double kRankTolerance = 0.01;
+constexpr double kRelativeTolerance = 1e-9; // Welford vs two-pass, floating point only
+
+auto exact_quantile(std::vector<double> values, double quantile) -> double
+{
+  const auto rank = static_cast<size_t>(quantile * static_cast<double>(values.size() - 1));
+  std::nth_element(values.begin(), values.begin() + static_cast<long>(rank), values.end());
+  return values[rank];
+}
+
+// Fraction of values below estimate, to compare against the quantile it stands for
+auto rank_fraction(const std::vector<double>& values, double estimate) -> double
+{
+  const auto below =
+      std::count_if(values.begin(), values.end(), [&](double value) { return value < estimate; });
+  return static_cast<double>(below) / static_cast<double>(values.size());
+}
+
+auto close_to(double actual, double expected) -> bool
+{
+  return std::fabs(actual - expected) <= kRelativeTolerance * std::max(1.0, std::fabs(expected));
+}
+
+// Two-pass reference for everything StreamingStats keeps
+auto check_against_reference(const std::vector<double>& values, const std::string& what) -> void
+{
+  stats::StreamingStats streaming;
+  for (const double value : values)
+  {
+    streaming.add(value);
+  }
+  const size_t count = values.size();
+  double mean = 0.0;
+  for (const double value : values)
+  {
+    mean += value;
+  }
+  mean = count > 0 ? mean / static_cast<double>(count) : 0.0;
+  double squares = 0.0;
+  double abs_diffs = 0.0;
+  for (size_t index = 0; index < count; ++index)
+  {
+    squares += (values[index] - mean) * (values[index] - mean);
+    if (index > 0)
+    {
+      abs_diffs += std::fabs(values[index] - values[index - 1]);
+    }
+  }
+  const double stddev = count > 1 ? std::sqrt(squares / static_cast<double>(count - 1)) : 0.0;
+  const double jitter = count > 1 ? abs_diffs / static_cast<double>(count - 1) : 0.0;
+  const double min = count > 0 ? *std::min_element(values.begin(), values.end()) : 0.0;
+  const double max = count > 0 ? *std::max_element(values.begin(), values.end()) : 0.0;
+
+  check(streaming.count() == count, what + ": count");
+  check(close_to(streaming.mean(), mean), what + ": mean");
+  check(close_to(streaming.stddev(), stddev), what + ": stddev");
+  check(close_to(streaming.jitter(), jitter), what + ": jitter");
+  check(streaming.min() == min, what + ": min");
+  check(streaming.max() == max, what + ": max");
+}
+} // namespace
+
+auto test_stats() -> void
+{
+  check_against_reference({}, "0 samples");
+  check_against_reference({42.0}, "1 sample");
+  const std::vector<double> five = {12.0, 3.5, 80.25, 7.0, 3.5};
+  check_against_reference(five, "5 samples");
+
+  // Up to five samples P-square is exact and matches stats::quartile
+  stats::StreamingStats small;
+  for (const double value : five)
+  {
+    small.add(value);
+  }
+  check(small.median() == stats::quartile(five, 0.5), "5 samples: exact median");
+  check(small.p90() == stats::quartile(five, 0.9), "5 samples: exact p90");
+  check(stats::StreamingStats().median() == 0.0, "0 samples: median is 0");
+
+  // Throughput-like skewed data and an ascending ramp, which moves the markers the most
+  std::mt19937 rng(42);
+  std::lognormal_distribution<double> throughput(4.0, 0.6);
+  std::vector<double> skewed(kSampleCount);
+  for (double& value : skewed)
+  {
+    value = throughput(rng);
+  }
+  std::vector<double> ramp(kSampleCount);
+  for (size_t index = 0; index < ramp.size(); ++index)
+  {
+    ramp[index] = static_cast<double>(index);
+  }
+  for (const auto& [name, values] :
+       {std::make_pair("lognormal", &skewed), std::make_pair("ramp", &ramp)})
+  {
+    const std::string what = std::string(name) + " n=" + std::to_string(kSampleCount);
+    check_against_reference(*values, what);
+    stats::StreamingStats streaming;
+    for (const double value : *values)
+    {
+      streaming.add(value);
+    }
+    for (const auto& [quantile, estimate] :
+         {std::make_pair(0.5, streaming.median()), std::make_pair(0.9, streaming.p90())})
+    {
+      const double exact = exact_quantile(*values, quantile);
+      const double rank = rank_fraction(*values, estimate);
+      check(std::fabs(rank - quantile) <= kRankTolerance,
+            what + ": P-square q=" + std::to_string(quantile) + " estimate " +
+                std::to_string(estimate) + " vs exact " + std::to_string(exact) + " (rank " +
+                std::to_string(rank) + ")");
+    }
+  }
+}
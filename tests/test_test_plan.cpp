@@ -0,0 +1,75 @@
+// Checks that plan files with out-of-range or mistyped fields are rejected with the field named.
+#include <stdlib.h>      // for mkstemp
+#include <unistd.h>      // for close, write, unlink
+#include <string>        // for string
+#include "test_plan.h"   // for load_test_plan_file, TestPlan
+#include "tests.h"       // for check, test_test_plan
+
+namespace
+{
+// Loads a plan from a temporary file holding json; error is empty on success
+auto load_plan_text(const std::string& json, TestPlan& plan) -> std::string
+{
+  char path[] = "/tmp/speedcloudflare-plan-XXXXXX";
+  const int fd = mkstemp(path);
+  if (fd < 0)
+  {
+    return "cannot create temporary plan file";
+  }
+  const bool written = write(fd, json.data(), json.size()) == static_cast<ssize_t>(json.size());
+  close(fd);
+  std::string error;
+  if (!written)
+  {
+    error = "cannot write temporary plan file";
+  }
+  else if (!load_test_plan_file(path, plan, error) && error.empty())
+  {
+    error = "rejected without a message";
+  }
+  unlink(path);
+  return error;
+}
+
+auto phase_json(const std::string& fields) -> std::string
+{
+  return R"({"name": "t", "phases": [{"direction": "download", )" + fields + "}]}";
+}
+
+auto rejected_naming(const std::string& fields, const std::string& field) -> bool
+{
+  TestPlan plan;
+  const std::string error = load_plan_text(phase_json(fields), plan);
+  return error.find("\"" + field + "\"") != std::string::npos;
+}
+} // namespace
+
+auto test_test_plan() -> void
+{
+  TestPlan plan;
+  check(load_plan_text(phase_json(R"("bytes": 1000000, "iterations": 4, "warmup": 1)"), plan)
+            .empty(),
+        "a valid phase loads");
+  check(plan.phases.size() == 1 && plan.phases[0].num_bytes == 1000000 &&
+            plan.phases[0].num_iterations == 4 && plan.phases[0].warmup == 1,
+        "a valid phase keeps its values");
+
+  // 2^32 + 1 wrapped to 1 through static_cast<int> and passed every range check
+  check(rejected_naming(R"("bytes": 4294967297, "iterations": 4)", "bytes"),
+        "bytes beyond int range is rejected");
+  check(rejected_naming(R"("bytes": 1000, "iterations": 4294967297)", "iterations"),
+        "iterations beyond int range is rejected");
+  check(rejected_naming(R"("bytes": 1000, "iterations": 4, "warmup": -4294967297)", "warmup"),
+        "a negative warmup beyond int range is rejected");
+  check(rejected_naming(R"("bytes": 1000.5, "iterations": 4)", "bytes"),
+        "a fractional byte count is rejected");
+  check(rejected_naming(R"("bytes": "1000", "iterations": 4)", "bytes"),
+        "a byte count given as a string is rejected");
+  check(rejected_naming(R"("bytes": 0, "iterations": 4)", "bytes"), "zero bytes is rejected");
+  check(rejected_naming(R"("bytes": 1000, "iterations": 1000000)", "iterations"),
+        "iterations above the plan cap are rejected");
+  check(rejected_naming(R"("bytes": 1000, "iterations": 4, "concurrency": 17)", "concurrency"),
+        "concurrency above the cap is rejected");
+  check(rejected_naming(R"("bytes": 1000, "duration_ms": "5s")", "duration_ms"),
+        "a duration given as a string is rejected");
+}
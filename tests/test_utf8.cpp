@@ -0,0 +1,26 @@
+// Checks the shared UTF-8-safe truncation used for span names, event labels and history fields.
+#include <cstring>   // for strlen
+#include <string>    // for string
+#include "tests.h"   // for check, test_utf8
+#include "utf8.h"    // for utf8_prefix_length
+
+namespace
+{
+auto cut(const char* text, size_t max_bytes) -> std::string
+{
+  return std::string(text, utf8_prefix_length(text, std::strlen(text), max_bytes));
+}
+} // namespace
+
+auto test_utf8() -> void
+{
+  check(cut("Zurich", 64) == "Zurich", "short text is kept whole");
+  check(cut("Zurich", 3) == "Zur", "ASCII is cut at the limit");
+  check(cut("Zürich", 3) == "Zü", "a cut right after a 2-byte character keeps it");
+  check(cut("Zürich", 2) == "Z", "a cut inside a 2-byte character drops it whole");
+  check(cut("a東京", 3) == "a", "a cut inside a 3-byte character drops it whole");
+  check(cut("a\xF0\x9F\x8C\x8D", 4) == "a", "a cut inside a 4-byte character drops it whole");
+  check(cut("\xF0\x9F\x8C\x8D", 3).empty(), "a lone 4-byte character that does not fit is empty");
+  check(cut("a\x80\x80\x80\x80\x80", 4).size() == 1,
+        "a run of stray continuation bytes backs up at most three bytes");
+}
@@ -0,0 +1,16 @@
+#pragma once
+#include <string>  // for string
+
+// Test entry points dispatched by tests_main.cpp; failures are reported through check()
+auto test_estimation() -> void;
+auto test_histogram() -> void;
+auto test_history_store() -> void;
+auto test_metrics() -> void;
+auto test_regression_gate() -> void;
+auto test_stats() -> void;
+auto test_test_plan() -> void;
+auto test_utf8() -> void;
+
+// Reports a failed expectation on stderr and counts it; returns condition
+auto check(bool condition, const std::string& what) -> bool;
+auto failed_checks() -> int;
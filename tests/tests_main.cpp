@@ -0,0 +1,77 @@
+// Usage: SpeedCloudflareCli_tests [NAME]
+// No NAME runs every test; the exit code is 1 when any check failed.
+#include <cstring>   // for strcmp
+#include <iostream>  // for cout, cerr
+#include "tests.h"   // for test_estimation, test_metrics, check
+
+namespace
+{
+struct TestEntry
+{
+  const char* name;
+  void (*run)();
+};
+
+constexpr TestEntry kTests[] = {
+    {"estimation", test_estimation},
+    {"histogram", test_histogram},
+    {"history-store", test_history_store},
+    {"metrics", test_metrics},
+    {"regression-gate", test_regression_gate},
+    {"stats", test_stats},
+    {"test-plan", test_test_plan},
+    {"utf8", test_utf8},
+};
+
+int g_failed_checks = 0;
+
+auto run_test(const TestEntry& entry) -> int
+{
+  const int failed_before = g_failed_checks;
+  entry.run();
+  const bool passed = g_failed_checks == failed_before;
+  std::cout << (passed ? "[PASS] " : "[FAIL] ") << entry.name << "\n";
+  return passed ? 0 : 1;
+}
+} // namespace
+
+auto check(bool condition, const std::string& what) -> bool
+{
+  if (!condition)
+  {
+    ++g_failed_checks;
+    std::cerr << "[ERROR] Check failed: " << what << std::endl;
+  }
+  return condition;
+}
+
+auto failed_checks() -> int
+{
+  return g_failed_checks;
+}
+
+auto main(int argc, char* argv[]) -> int
+{
+  if (argc < 2)
+  {
+    int status = 0;
+    for (const auto& entry : kTests)
+    {
+      status |= run_test(entry);
+    }
+    return status;
+  }
+  for (const auto& entry : kTests)
+  {
+    if (std::strcmp(argv[1], entry.name) == 0)
+    {
+      return run_test(entry);
+    }
+  }
+  std::cerr << "Unknown test '" << argv[1] << "'. Available:\n";
+  for (const auto& entry : kTests)
+  {
+    std::cerr << "  " << entry.name << "\n";
+  }
+  return 1;
+}